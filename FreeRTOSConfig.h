@@ -103,11 +103,45 @@
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+/* Run time and task stats gathering related definitions. The run-time
+ * counter and the context switch counts are kept by task_stats.c.
+ */
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+extern void task_stats_timer_init(void);
+extern uint32_t task_stats_counter(void);
+extern void task_stats_switched_in(uint32_t task_number);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() task_stats_timer_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()        task_stats_counter()
+
+/* Trace recorder hooks, see trace.h. The records refer to the tasks by the
+ * numbers set with vTaskSetTaskNumber() and to the queues by the numbers set
+ * with vQueueSetQueueNumber(): trace_queue_t, given when the application
+ * creates them, and to the timer command queue when the kernel registers it.
+ */
+#if defined(TRACE_ENABLED) && (TRACE_ENABLED)
+extern void trace_task_switched_in(void);
+extern void trace_notify(uint32_t task_number);
+extern void trace_notify_take(void);
+extern void trace_queue_send(uint32_t queue_number);
+extern void trace_queue_receive(uint32_t queue_number);
+extern void trace_queue_registered(void *queue, const char *name);
+#define traceTASK_SWITCHED_IN()                 do { task_stats_switched_in(pxCurrentTCB->uxTCBNumber); \
+                                                     trace_task_switched_in(); } while(0)
+#define traceTASK_NOTIFY(uxIndexToNotify)       trace_notify(pxTCB->uxTaskNumber)
+#define traceTASK_NOTIFY_FROM_ISR(uxIndexToNotify) trace_notify(pxTCB->uxTaskNumber)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR(uxIndexToNotify) trace_notify(pxTCB->uxTaskNumber)
+#define traceTASK_NOTIFY_TAKE(uxIndexToWait)    trace_notify_take()
+#define traceQUEUE_SEND(pxQueue)                trace_queue_send((pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)       trace_queue_send((pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE(pxQueue)             trace_queue_receive((pxQueue)->uxQueueNumber)
+#define traceQUEUE_REGISTRY_ADD(xQueue, pcQueueName) trace_queue_registered((xQueue), (pcQueueName))
+#else
+#define traceTASK_SWITCHED_IN()                 task_stats_switched_in(pxCurrentTCB->uxTCBNumber)
+#endif /* TRACE_ENABLED */
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -139,7 +173,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
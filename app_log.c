@@ -0,0 +1,208 @@
+/******************************************************************************
+* File Name:   app_log.c
+*
+* Description: This file contains the deferred logging. Log calls copy a
+* fixed size record into a ring buffer; a task at the lowest priority turns
+* the records into text and prints them. Records that do not fit in the ring
+* are dropped and counted, so logging never blocks the network paths.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header files */
+#include <string.h>
+#include <inttypes.h>
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Ring buffer header file. */
+#include "ring_buffer.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Log record. The format string is referenced, not copied. */
+typedef struct
+{
+    uint32_t tick;                          /* FreeRTOS tick count (ms). */
+    const char *fmt;
+    uint8_t level;
+    uint8_t nargs;
+    uint16_t reserved;
+    app_log_arg_t args[APP_LOG_MAX_ARGS];
+} app_log_record_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void app_log_task(void *arg);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+volatile uint32_t app_log_level = APP_LOG_LEVEL_DEFAULT;
+
+/* Log ring buffer. Producers are serialized by a critical section; the log
+ * task is the only consumer.
+ */
+static ring_buffer_t log_ring;
+static uint8_t log_storage[APP_LOG_BUFFER_SIZE];
+
+/* Records dropped on a full ring. */
+static volatile uint32_t dropped_count;
+
+/* Log task handle. */
+static TaskHandle_t log_task_handle;
+STATIC_ALLOC_TASK_DEFINE(log_task, APP_LOG_TASK_STACK_SIZE);
+
+static const char level_tags[] = { '-', 'E', 'W', 'I', 'D' };
+
+/*******************************************************************************
+ * Function Name: app_log_init
+ *******************************************************************************
+ * Summary:
+ *  Creates the log task. Log calls made before are kept in the ring and
+ *  printed once the scheduler runs.
+ *
+ *******************************************************************************/
+void app_log_init(void)
+{
+    ring_buffer_init(&log_ring, log_storage, sizeof(log_storage));
+
+    if(STATIC_ALLOC_TASK_CREATE(log_task, app_log_task, "Log task", APP_LOG_TASK_STACK_SIZE, NULL,
+                                tskIDLE_PRIORITY, &log_task_handle) != pdPASS)
+    {
+        printf("Failed to create the log task\n");
+    }
+}
+
+/*******************************************************************************
+ * Function Name: app_log_write
+ *******************************************************************************
+ * Summary:
+ *  Stores a log record. Use the APP_LOG() macros rather than this function.
+ *
+ * Parameters:
+ *  uint32_t level: Level of the message
+ *  const char *fmt: printf() format of the message
+ *  const app_log_arg_t *args: Arguments of the message
+ *  uint32_t nargs: Number of arguments, extra arguments are ignored
+ *
+ *******************************************************************************/
+void app_log_write(uint32_t level, const char *fmt, const app_log_arg_t *args, uint32_t nargs)
+{
+    app_log_record_t record;
+    bool was_empty;
+    bool written;
+
+    if(nargs > APP_LOG_MAX_ARGS)
+    {
+        nargs = APP_LOG_MAX_ARGS;
+    }
+
+    record.tick = (uint32_t)xTaskGetTickCount();
+    record.fmt = fmt;
+    record.level = (uint8_t)level;
+    record.nargs = (uint8_t)nargs;
+    record.reserved = 0;
+    memcpy(record.args, args, nargs * sizeof(app_log_arg_t));
+    memset(&record.args[nargs], 0, (APP_LOG_MAX_ARGS - nargs) * sizeof(app_log_arg_t));
+
+    taskENTER_CRITICAL();
+    was_empty = (ring_buffer_used(&log_ring) == 0);
+    written = ring_buffer_write(&log_ring, &record, sizeof(record));
+    if(!written)
+    {
+        dropped_count++;
+    }
+    taskEXIT_CRITICAL();
+
+    /* The log task drains the ring before it blocks again. */
+    if(written && was_empty && (log_task_handle != NULL))
+    {
+        xTaskNotifyGive(log_task_handle);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: app_log_set_level
+ *******************************************************************************
+ * Summary:
+ *  Sets the most verbose level logged. Levels above APP_LOG_LEVEL_MAX are
+ *  not compiled in and stay silent.
+ *
+ *******************************************************************************/
+void app_log_set_level(uint32_t level)
+{
+    app_log_level = level;
+}
+
+/*******************************************************************************
+ * Function Name: app_log_dropped
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of log records dropped on a full ring buffer.
+ *
+ *******************************************************************************/
+uint32_t app_log_dropped(void)
+{
+    return dropped_count;
+}
+
+/*******************************************************************************
+ * Function Name: app_log_task
+ *******************************************************************************
+ * Summary:
+ *  Prints the log records, each prefixed with its time in milliseconds and
+ *  its level, and reports the records dropped since the last ones printed.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused)
+ *
+ *******************************************************************************/
+static void app_log_task(void *arg)
+{
+    app_log_record_t record;
+    uint32_t dropped_reported = 0;
+    uint32_t dropped;
+
+    while(true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while(ring_buffer_read(&log_ring, &record, sizeof(record)) == sizeof(record))
+        {
+            printf("[%10"PRIu32"] %c ", record.tick,
+                   level_tags[(record.level < sizeof(level_tags)) ? record.level : 0]);
+            printf(record.fmt, record.args[0], record.args[1], record.args[2],
+                   record.args[3], record.args[4], record.args[5], record.args[6],
+                   record.args[7]);
+            printf("\n");
+        }
+
+        dropped = dropped_count;
+        if(dropped != dropped_reported)
+        {
+            printf("[%10"PRIu32"] W %"PRIu32" log records dropped\n",
+                   (uint32_t)xTaskGetTickCount(), dropped - dropped_reported);
+            dropped_reported = dropped;
+        }
+    }
+}
+
+/* [] END OF FILE */
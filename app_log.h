@@ -0,0 +1,116 @@
+/******************************************************************************
+* File Name:   app_log.h
+*
+* Description: This file contains declaration of the deferred logging used on
+* the network paths. APP_LOG() stores a compact binary record (format string
+* pointer, arguments and timestamp) in a ring buffer; the records are
+* formatted and printed later by a task running at the lowest priority, so
+* the caller never waits for the debug UART.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef APP_LOG_H_
+#define APP_LOG_H_
+
+/* Standard C header files */
+#include <inttypes.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Log levels. */
+#define APP_LOG_LEVEL_OFF                         (0u)
+#define APP_LOG_LEVEL_ERROR                       (1u)
+#define APP_LOG_LEVEL_WARNING                     (2u)
+#define APP_LOG_LEVEL_INFO                        (3u)
+#define APP_LOG_LEVEL_DEBUG                       (4u)
+
+/* Most verbose level compiled in. Calls above it compile to nothing. */
+#ifndef APP_LOG_LEVEL_MAX
+#define APP_LOG_LEVEL_MAX                         APP_LOG_LEVEL_INFO
+#endif
+
+/* Level in effect after start up; changed with app_log_set_level(). */
+#ifndef APP_LOG_LEVEL_DEFAULT
+#define APP_LOG_LEVEL_DEFAULT                     APP_LOG_LEVEL_INFO
+#endif
+
+/* Maximum number of arguments of a log call. */
+#define APP_LOG_MAX_ARGS                          (8u)
+
+/* Size of the log ring buffer in bytes. Must be a power of two. */
+#ifndef APP_LOG_BUFFER_SIZE
+#define APP_LOG_BUFFER_SIZE                       (2048u)
+#endif
+
+/* Log task. */
+#define APP_LOG_TASK_STACK_SIZE                   (1024 * 2)
+
+/* Logs a message. 'fmt' must be a string literal, without the trailing
+ * newline, and the arguments integers of up to 32 bits or constant strings
+ * passed with APP_LOG_STR(). The message is formatted by the log task after
+ * the call returns, so buffers on the stack must not be logged. Must not be
+ * called from an interrupt handler.
+ *
+ * Every argument is stored and passed to printf() as an app_log_arg_t, so
+ * only pointer-width conversions may be used: "%"PRIuPTR, "%"PRIxPTR and
+ * "%"PRIdPTR for integers (a signed one cast to int32_t first), %s with
+ * APP_LOG_STR() and %p with APP_LOG_PTR(). %u, %c or "%"PRIu32 would read
+ * an argument of the wrong width where pointers are 64 bits wide.
+ */
+#define APP_LOG(level, fmt, ...)                                                    \
+    do                                                                              \
+    {                                                                               \
+        if(((level) <= APP_LOG_LEVEL_MAX) && ((level) <= app_log_level))            \
+        {                                                                           \
+            const app_log_arg_t app_log_args_[] = { 0, ##__VA_ARGS__ };             \
+            app_log_write((level), (fmt), &app_log_args_[1],                        \
+                          (sizeof(app_log_args_) / sizeof(app_log_arg_t)) - 1u);    \
+        }                                                                           \
+    } while(0)
+
+#define APP_LOG_ERROR(fmt, ...)                   APP_LOG(APP_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define APP_LOG_WARNING(fmt, ...)                 APP_LOG(APP_LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define APP_LOG_INFO(fmt, ...)                    APP_LOG(APP_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define APP_LOG_DEBUG(fmt, ...)                   APP_LOG(APP_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+/* Argument of a constant string, for %s. */
+#define APP_LOG_STR(str)                          ((app_log_arg_t)(const char *)(str))
+
+/* Argument of a pointer, for %p. */
+#define APP_LOG_PTR(ptr)                          ((app_log_arg_t)(const void *)(ptr))
+
+/* Format and arguments of an IPv4 address given in network byte order, as
+ * stored in cy_socket_sockaddr_t.
+ */
+#define APP_LOG_IPV4_FMT                          "%"PRIuPTR".%"PRIuPTR".%"PRIuPTR".%"PRIuPTR
+#define APP_LOG_IPV4(addr)                        ((addr) & 0xFFu), (((addr) >> 8) & 0xFFu), \
+                                                  (((addr) >> 16) & 0xFFu), (((addr) >> 24) & 0xFFu)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Argument of a log record, wide enough for a pointer. */
+typedef uintptr_t app_log_arg_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Current log level. */
+extern volatile uint32_t app_log_level;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void app_log_init(void);
+void app_log_write(uint32_t level, const char *fmt, const app_log_arg_t *args, uint32_t nargs);
+void app_log_set_level(uint32_t level);
+uint32_t app_log_dropped(void);
+
+#endif /* APP_LOG_H_ */
@@ -0,0 +1,132 @@
+/******************************************************************************
+* File Name:   app_memory_budget.c
+*
+* Description: This file contains the fit check of the memory budget. The RAM
+* of the lwIP settings derived in app_memory_budget.h is added to that of the
+* connection table and of the malloc() size classes, as built, and the build
+* fails if the total exceeds APP_RAM_BUDGET_BYTES. It also fails if an lwIP
+* setting in effect differs from the derived one, as it would if lwipopts.h
+* did not apply the budget. At startup, the derived lwIP settings are printed
+* next to those in effect.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* Standard C header files */
+#include <inttypes.h>
+
+/* lwIP options header file. */
+#include "lwip/opt.h"
+
+/* Memory budget header file. */
+#include "app_memory_budget.h"
+
+/* Connection table header file. */
+#include "tcp_conn.h"
+
+/* Fixed-block pool header file. */
+#include "mem_pool.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* RAM of the connection table, the entries and their free stack. */
+#define APP_BUDGET_CONN_RAM                       (TCP_CONN_MAX_CLIENTS * (sizeof(tcp_conn_t) + sizeof(uint16_t)))
+
+/* RAM of the malloc() size classes, see mem_pool_config.h. */
+#if(MEM_POOL_MALLOC_ENABLED)
+#define APP_BUDGET_MALLOC_POOL_RAM                ((MEM_POOL_SMALL_BLOCKS * (MEM_POOL_BLOCK_SIZE(MEM_POOL_SMALL_BLOCK_SIZE) + \
+                                                                           sizeof(uint16_t))) + \
+                                                   (MEM_POOL_LARGE_BLOCKS * (MEM_POOL_BLOCK_SIZE(MEM_POOL_LARGE_BLOCK_SIZE) + \
+                                                                           sizeof(uint16_t))))
+#else
+#define APP_BUDGET_MALLOC_POOL_RAM                (0u)
+#endif /* MEM_POOL_MALLOC_ENABLED */
+
+#define APP_BUDGET_TOTAL_RAM                      (APP_BUDGET_LWIP_RAM + APP_BUDGET_CONN_RAM + APP_BUDGET_MALLOC_POOL_RAM)
+
+/* The lwIP options in effect must be those the budget is computed from,
+ * i.e. configs/lwipopts.h must apply app_memory_budget.h. lwIP defines them
+ * all in lwip/opt.h; the host build has no lwIP and skips the check.
+ */
+#if defined(TCP_MSS) && (TCP_MSS != APP_BUDGET_TCP_MSS)
+#error "TCP_MSS differs from APP_BUDGET_TCP_MSS: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(TCP_WND) && (TCP_WND != APP_BUDGET_TCP_WND)
+#error "TCP_WND differs from APP_BUDGET_TCP_WND: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(TCP_SND_BUF) && (TCP_SND_BUF != APP_BUDGET_TCP_SND_BUF)
+#error "TCP_SND_BUF differs from APP_BUDGET_TCP_SND_BUF: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(TCP_SND_QUEUELEN) && (TCP_SND_QUEUELEN != APP_BUDGET_TCP_SND_QUEUELEN)
+#error "TCP_SND_QUEUELEN differs from APP_BUDGET_TCP_SND_QUEUELEN: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(MEMP_NUM_TCP_PCB) && (MEMP_NUM_TCP_PCB != APP_BUDGET_MEMP_NUM_TCP_PCB)
+#error "MEMP_NUM_TCP_PCB differs from APP_BUDGET_MEMP_NUM_TCP_PCB: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(MEMP_NUM_TCP_PCB_LISTEN) && (MEMP_NUM_TCP_PCB_LISTEN != APP_BUDGET_MEMP_NUM_TCP_PCB_LISTEN)
+#error "MEMP_NUM_TCP_PCB_LISTEN differs from APP_BUDGET_MEMP_NUM_TCP_PCB_LISTEN: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(MEMP_NUM_TCP_SEG) && (MEMP_NUM_TCP_SEG != APP_BUDGET_MEMP_NUM_TCP_SEG)
+#error "MEMP_NUM_TCP_SEG differs from APP_BUDGET_MEMP_NUM_TCP_SEG: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(PBUF_POOL_SIZE) && (PBUF_POOL_SIZE != APP_BUDGET_PBUF_POOL_SIZE)
+#error "PBUF_POOL_SIZE differs from APP_BUDGET_PBUF_POOL_SIZE: lwipopts.h does not apply app_memory_budget.h"
+#endif
+#if defined(MEM_SIZE) && (MEM_SIZE != APP_BUDGET_MEM_SIZE)
+#error "MEM_SIZE differs from APP_BUDGET_MEM_SIZE: lwipopts.h does not apply app_memory_budget.h"
+#endif
+
+_Static_assert(APP_BUDGET_TOTAL_RAM <= APP_RAM_BUDGET_BYTES,
+               "The network path does not fit in APP_RAM_BUDGET_BYTES: lower TCP_CONN_MAX_CLIENTS, "
+               "APP_BUDGET_TCP_WND_SEGMENTS or APP_BUDGET_TCP_SND_SEGMENTS, or raise the budget");
+
+/*******************************************************************************
+* Function Name: app_memory_budget_print
+*******************************************************************************
+* Summary:
+*  Prints the memory budget: the RAM of each part, and the derived lwIP
+*  settings next to those in effect, where lwIP is built.
+*
+*******************************************************************************/
+void app_memory_budget_print(void)
+{
+    printf("\r\n********** Memory Budget **********\r\n");
+    printf("Clients                     : %"PRIu32"\r\n", (uint32_t)TCP_CONN_MAX_CLIENTS);
+    printf("lwIP pbuf pool              : %"PRIu32" bytes\r\n", (uint32_t)APP_BUDGET_LWIP_PBUF_RAM);
+    printf("lwIP heap                   : %"PRIu32" bytes\r\n", (uint32_t)APP_BUDGET_LWIP_HEAP_RAM);
+    printf("lwIP control blocks         : %"PRIu32" bytes\r\n", (uint32_t)APP_BUDGET_LWIP_PCB_RAM);
+    printf("Connection table            : %"PRIu32" bytes\r\n", (uint32_t)APP_BUDGET_CONN_RAM);
+    printf("malloc() size classes       : %"PRIu32" bytes\r\n", (uint32_t)APP_BUDGET_MALLOC_POOL_RAM);
+    printf("Total                       : %"PRIu32" of %"PRIu32" bytes\r\n",
+           (uint32_t)APP_BUDGET_TOTAL_RAM, (uint32_t)APP_RAM_BUDGET_BYTES);
+
+    printf("Setting                         budget  in effect\r\n");
+#if defined(TCP_WND)
+#define APP_BUDGET_PRINT_SETTING(name) \
+    printf("%-28s %9"PRIu32" %10"PRIu32"\r\n", #name, (uint32_t)APP_BUDGET_##name, (uint32_t)(name))
+#else
+#define APP_BUDGET_PRINT_SETTING(name) \
+    printf("%-28s %9"PRIu32" %10s\r\n", #name, (uint32_t)APP_BUDGET_##name, "-")
+#endif /* TCP_WND */
+    APP_BUDGET_PRINT_SETTING(TCP_MSS);
+    APP_BUDGET_PRINT_SETTING(TCP_WND);
+    APP_BUDGET_PRINT_SETTING(TCP_SND_BUF);
+    APP_BUDGET_PRINT_SETTING(TCP_SND_QUEUELEN);
+    APP_BUDGET_PRINT_SETTING(MEMP_NUM_TCP_PCB);
+    APP_BUDGET_PRINT_SETTING(MEMP_NUM_TCP_PCB_LISTEN);
+    APP_BUDGET_PRINT_SETTING(MEMP_NUM_TCP_SEG);
+    APP_BUDGET_PRINT_SETTING(PBUF_POOL_SIZE);
+    APP_BUDGET_PRINT_SETTING(MEM_SIZE);
+#undef APP_BUDGET_PRINT_SETTING
+    printf("***********************************\r\n\n");
+}
+
+/* [] END OF FILE */
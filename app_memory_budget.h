@@ -0,0 +1,197 @@
+/******************************************************************************
+* File Name:   app_memory_budget.h
+*
+* Description: This file contains the memory budget of the network path. It
+* states how many clients the server is sized for, and how much each of them
+* may have in flight: the TCP receive window and send buffer in segments, and
+* the depths of the queues of the connection table. The lwIP window, pbuf
+* pool and MEMP counts, and the sizes of the connection table, are derived
+* from them, so that one setting right-sizes the whole path, e.g.
+* 'make DEFINES="TCP_CONN_MAX_CLIENTS=32 APP_BUDGET_TCP_WND_SEGMENTS=2"'.
+*
+* app_memory_budget.c adds up the RAM this takes and fails the build if it
+* exceeds APP_RAM_BUDGET_BYTES.
+*
+* The lwIP options take effect through configs/lwipopts.h, which ends with
+*
+*   #define APP_BUDGET_LWIP_OPTIONS
+*   #include "app_memory_budget.h"
+*
+* app_memory_budget.c fails the build if an option in effect differs.
+*
+* The lwIP object sizes below are estimates for a 32-bit target; the sizes
+* printed at startup and the lwIP statistics of the metrics endpoint show
+* what is in use.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef APP_MEMORY_BUDGET_H_
+#define APP_MEMORY_BUDGET_H_
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* RAM given to the network path: the lwIP buffers and control blocks, the
+ * connection table and the malloc() size classes. The stacks, the Wi-Fi
+ * driver and the rest of the image are not counted.
+ */
+#ifndef APP_RAM_BUDGET_BYTES
+#define APP_RAM_BUDGET_BYTES                      (256u * 1024u)
+#endif
+
+/* Target concurrency: maximum number of TCP clients served at the same
+ * time.
+ */
+#ifndef TCP_CONN_MAX_CLIENTS
+#define TCP_CONN_MAX_CLIENTS                      (4u)
+#endif
+
+/* TCP maximum segment size. */
+#ifndef APP_BUDGET_TCP_MSS
+#define APP_BUDGET_TCP_MSS                        (1460u)
+#endif
+
+/* Receive window of each connection, in segments. Every client may have a
+ * full window buffered in the pbuf pool.
+ */
+#ifndef APP_BUDGET_TCP_WND_SEGMENTS
+#define APP_BUDGET_TCP_WND_SEGMENTS               (4u)
+#endif
+
+/* Send buffer of each connection, in segments, taken from the lwIP heap. */
+#ifndef APP_BUDGET_TCP_SND_SEGMENTS
+#define APP_BUDGET_TCP_SND_SEGMENTS               (2u)
+#endif
+
+/* Listening sockets: the TCP server, the metrics endpoint and the trace
+ * recorder.
+ */
+#ifndef APP_BUDGET_LISTENERS
+#define APP_BUDGET_LISTENERS                      (3u)
+#endif
+
+/* Connections beyond the clients: a metrics scrape, a trace download, and
+ * those in TIME_WAIT.
+ */
+#ifndef APP_BUDGET_SPARE_PCBS
+#define APP_BUDGET_SPARE_PCBS                     (4u)
+#endif
+
+/* Pool buffers beyond the receive windows, for the frames the Wi-Fi driver
+ * has yet to hand to lwIP.
+ */
+#ifndef APP_BUDGET_SPARE_PBUFS
+#define APP_BUDGET_SPARE_PBUFS                    (8u)
+#endif
+
+/* lwIP heap beyond the send buffers: ARP, DHCP, DNS and the control
+ * messages.
+ */
+#ifndef APP_BUDGET_SPARE_HEAP_BYTES
+#define APP_BUDGET_SPARE_HEAP_BYTES               (4096u)
+#endif
+
+/* Per-connection queues of the connection table, see tcp_conn.h. The ring
+ * sizes and the command window must be powers of two.
+ */
+#ifndef TCP_CONN_RX_BUFFER_SIZE
+#define TCP_CONN_RX_BUFFER_SIZE                   (128u)
+#endif
+
+#ifndef TCP_CONN_TX_BUFFER_SIZE
+#define TCP_CONN_TX_BUFFER_SIZE                   (256u)
+#endif
+
+#ifndef TCP_CONN_MAX_INFLIGHT
+#define TCP_CONN_MAX_INFLIGHT                     (8u)
+#endif
+
+#ifndef TCP_CONN_MAX_TX_REFS
+#define TCP_CONN_MAX_TX_REFS                      (4u)
+#endif
+
+/* Estimated sizes of the lwIP objects: a pool pbuf with room for a full
+ * segment and the link headers, a TCP control block and a queued segment.
+ */
+#ifndef APP_BUDGET_PBUF_BYTES
+#define APP_BUDGET_PBUF_BYTES                     (APP_BUDGET_TCP_MSS + 140u)
+#endif
+
+#ifndef APP_BUDGET_TCP_PCB_BYTES
+#define APP_BUDGET_TCP_PCB_BYTES                  (192u)
+#endif
+
+#ifndef APP_BUDGET_TCP_SEG_BYTES
+#define APP_BUDGET_TCP_SEG_BYTES                  (32u)
+#endif
+
+/* Derived lwIP settings. The send queue length and the segment count follow
+ * the lwIP sanity checks: four pbufs per segment of the send buffer, and the
+ * send queues of all the clients in the segment pool.
+ */
+#define APP_BUDGET_TCP_WND                        (APP_BUDGET_TCP_WND_SEGMENTS * APP_BUDGET_TCP_MSS)
+#define APP_BUDGET_TCP_SND_BUF                    (APP_BUDGET_TCP_SND_SEGMENTS * APP_BUDGET_TCP_MSS)
+#define APP_BUDGET_TCP_SND_QUEUELEN               (4u * APP_BUDGET_TCP_SND_SEGMENTS)
+#define APP_BUDGET_MEMP_NUM_TCP_PCB               (TCP_CONN_MAX_CLIENTS + APP_BUDGET_SPARE_PCBS)
+#define APP_BUDGET_MEMP_NUM_TCP_PCB_LISTEN        (APP_BUDGET_LISTENERS)
+#define APP_BUDGET_MEMP_NUM_TCP_SEG               (TCP_CONN_MAX_CLIENTS * APP_BUDGET_TCP_SND_QUEUELEN)
+#define APP_BUDGET_PBUF_POOL_SIZE                 ((TCP_CONN_MAX_CLIENTS * APP_BUDGET_TCP_WND_SEGMENTS) + \
+                                                   APP_BUDGET_SPARE_PBUFS)
+#define APP_BUDGET_MEM_SIZE                       ((TCP_CONN_MAX_CLIENTS * APP_BUDGET_TCP_SND_BUF) + \
+                                                   APP_BUDGET_SPARE_HEAP_BYTES)
+
+/* RAM of the lwIP settings above. */
+#define APP_BUDGET_LWIP_PBUF_RAM                  (APP_BUDGET_PBUF_POOL_SIZE * APP_BUDGET_PBUF_BYTES)
+#define APP_BUDGET_LWIP_HEAP_RAM                  (APP_BUDGET_MEM_SIZE)
+#define APP_BUDGET_LWIP_PCB_RAM                   (((APP_BUDGET_MEMP_NUM_TCP_PCB + APP_BUDGET_MEMP_NUM_TCP_PCB_LISTEN) * \
+                                                    APP_BUDGET_TCP_PCB_BYTES) + \
+                                                   (APP_BUDGET_MEMP_NUM_TCP_SEG * APP_BUDGET_TCP_SEG_BYTES))
+#define APP_BUDGET_LWIP_RAM                       (APP_BUDGET_LWIP_PBUF_RAM + APP_BUDGET_LWIP_HEAP_RAM + \
+                                                   APP_BUDGET_LWIP_PCB_RAM)
+
+#if((APP_BUDGET_TCP_WND_SEGMENTS < 2u) || (APP_BUDGET_TCP_SND_SEGMENTS < 2u))
+#error "The TCP window and send buffer must hold at least two segments"
+#endif
+
+#if(APP_BUDGET_TCP_WND > 65535u)
+#error "APP_BUDGET_TCP_WND needs window scaling"
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void app_memory_budget_print(void);
+
+#endif /* APP_MEMORY_BUDGET_H_ */
+
+/* lwIP options, applied when included from lwipopts.h; they replace those of
+ * the SDK defaults.
+ */
+#if defined(APP_BUDGET_LWIP_OPTIONS) && !defined(APP_BUDGET_LWIP_OPTIONS_APPLIED)
+#define APP_BUDGET_LWIP_OPTIONS_APPLIED
+
+#undef TCP_MSS
+#undef TCP_WND
+#undef TCP_SND_BUF
+#undef TCP_SND_QUEUELEN
+#undef MEMP_NUM_TCP_PCB
+#undef MEMP_NUM_TCP_PCB_LISTEN
+#undef MEMP_NUM_TCP_SEG
+#undef PBUF_POOL_SIZE
+#undef MEM_SIZE
+
+#define TCP_MSS                                   (APP_BUDGET_TCP_MSS)
+#define TCP_WND                                   (APP_BUDGET_TCP_WND)
+#define TCP_SND_BUF                               (APP_BUDGET_TCP_SND_BUF)
+#define TCP_SND_QUEUELEN                          (APP_BUDGET_TCP_SND_QUEUELEN)
+#define MEMP_NUM_TCP_PCB                          (APP_BUDGET_MEMP_NUM_TCP_PCB)
+#define MEMP_NUM_TCP_PCB_LISTEN                   (APP_BUDGET_MEMP_NUM_TCP_PCB_LISTEN)
+#define MEMP_NUM_TCP_SEG                          (APP_BUDGET_MEMP_NUM_TCP_SEG)
+#define PBUF_POOL_SIZE                            (APP_BUDGET_PBUF_POOL_SIZE)
+#define MEM_SIZE                                  (APP_BUDGET_MEM_SIZE)
+#endif /* APP_BUDGET_LWIP_OPTIONS */
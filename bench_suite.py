@@ -0,0 +1,453 @@
+#******************************************************************************
+# File Name:   bench_suite.py
+#
+# Description: Benchmark suite for the TCP server. Runs a fixed set of
+# scenarios against a server, normally the host build on the loopback
+# interface, and compares their throughput and latency figures with the
+# baselines committed in bench_baseline.json. Exits with status 1 if any
+# figure regressed by more than the threshold.
+#
+# Scenarios:
+#   connect_churn     connect, HELLO, close, one client after another
+#   command_storm     PING commands as fast as the window allows, on several
+#                     connections
+#   large_acks        ACK frames with a full payload, sent in bulk
+#   idle_connections  PING latency of one client next to many idle ones
+#   disconnect_storm  all clients close at once; time until the server
+#                     freed every connection, then reconnect latency
+#
+# When the server is built with PERF_PROBE_ENABLED=1, the mean time spent in
+# tcp_connection_handler() and tcp_receive_msg_handler() during each scenario
+# is read from the metrics endpoint and compared as well. The baselines were
+# recorded with
+#   make -C host DEFINES="TCP_CONN_MAX_CLIENTS=16 PERF_PROBE_ENABLED=1"
+#   python3 bench_suite.py --server host/build/tcp_server --clients 16 --update
+#
+#******************************************************************************
+# $ Copyright 2021-2023 Cypress Semiconductor $
+#******************************************************************************
+
+#!/usr/bin/env python3
+import asyncio
+import json
+import optparse
+import os
+import re
+import socket
+import statistics
+import subprocess
+import sys
+import time
+import urllib.request
+
+from tcp_client import (PROTO_OP_HELLO, PROTO_OP_ACK, PROTO_STATUS_OK,
+                        encode_frame, decode_frames)
+from tcp_loadgen import PROTO_OP_PING, percentile
+
+BUFFER_SIZE          = 65536
+DEFAULT_BASELINE     = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'bench_baseline.json')
+DEFAULT_METRICS_PORT = 50080
+PROTO_MAX_PAYLOAD    = 32                # TCP_PROTO_MAX_PAYLOAD in tcp_proto.h
+
+# How each figure is compared with its baseline, by name suffix: whether
+# higher is better, and the change below which a figure counts as noise
+# whatever the threshold, in its own unit.
+COMPARISON_RULES = [
+    ('_per_s',  True,  0.0),
+    ('_ms',     False, 0.25),
+    ('_us',     False, 25.0),
+    ('_ns',     False, 100.0),
+    ('_errors', False, 0.0),
+    ('_per_byte', False, 0.05),
+]
+
+class Connection:
+    """Protocol v2 client connection."""
+
+    def __init__(self, reader, writer):
+        self.reader = reader
+        self.writer = writer
+        self.buffer = b''
+        self.seq = 0
+
+    @classmethod
+    async def open(cls, options):
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(options.ip, options.port), options.timeout)
+        conn = cls(reader, writer)
+        await conn.request(PROTO_OP_HELLO, b'', options.timeout)
+        return conn
+
+    def next_seq(self):
+        self.seq = (self.seq + 1) & 0xFFFF or 1
+        return self.seq
+
+    def send(self, opcode, payload=b'', seq=None):
+        seq = self.next_seq() if seq is None else seq
+        self.writer.write(encode_frame(opcode, seq, payload, False))
+        return seq
+
+    async def frames(self):
+        """Returns the next frames received."""
+        while True:
+            data = await self.reader.read(BUFFER_SIZE)
+            if not data:
+                raise ConnectionResetError("Connection closed by the TCP server")
+            frames, self.buffer = decode_frames(self.buffer + data)
+            if frames:
+                return frames
+
+    async def request(self, opcode, payload, timeout):
+        """Sends a frame and waits for its acknowledgement."""
+        seq = self.send(opcode, payload)
+        async def wait_ack():
+            while True:
+                for frame_op, frame_seq, frame_payload in await self.frames():
+                    if frame_op == PROTO_OP_ACK and frame_seq == seq:
+                        if frame_payload and frame_payload[0] != PROTO_STATUS_OK:
+                            raise ValueError("Command refused: status %d" % frame_payload[0])
+                        return
+        await asyncio.wait_for(wait_ack(), timeout)
+
+    async def close(self):
+        self.writer.close()
+        try:
+            await self.writer.wait_closed()
+        except OSError:
+            pass
+
+def ms(seconds):
+    return round(seconds * 1000.0, 3)
+
+def latency_figures(prefix, samples):
+    samples = sorted(samples)
+    return {
+        prefix + '_p50_ms': ms(percentile(samples, 0.50)),
+        prefix + '_p99_ms': ms(percentile(samples, 0.99)),
+    }
+
+async def scenario_connect_churn(options):
+    latencies = []
+    errors = 0
+    start = time.monotonic()
+    for _ in range(options.churn):
+        t0 = time.monotonic()
+        try:
+            conn = await Connection.open(options)
+        except (OSError, ValueError, asyncio.TimeoutError):
+            errors += 1
+            continue
+        latencies.append(time.monotonic() - t0)
+        await conn.close()
+    elapsed = time.monotonic() - start
+
+    figures = {'connects_per_s': round(len(latencies) / elapsed, 1), 'connect_errors': errors}
+    figures.update(latency_figures('connect', latencies))
+    return figures
+
+async def scenario_command_storm(options):
+    conns = [await Connection.open(options) for _ in range(min(options.clients, 8))]
+    latencies = []
+    lost = 0
+    stop_at = time.monotonic() + options.duration
+
+    async def storm(conn):
+        nonlocal lost
+        outstanding = {}
+        while time.monotonic() < stop_at or outstanding:
+            while time.monotonic() < stop_at and len(outstanding) < options.window:
+                outstanding[conn.send(PROTO_OP_PING)] = time.monotonic()
+            try:
+                frames = await asyncio.wait_for(conn.frames(), options.timeout)
+            except asyncio.TimeoutError:
+                lost += len(outstanding)
+                return
+            now = time.monotonic()
+            for opcode, seq, _ in frames:
+                if opcode == PROTO_OP_ACK and seq in outstanding:
+                    latencies.append(now - outstanding.pop(seq))
+
+    start = time.monotonic()
+    await asyncio.gather(*[storm(conn) for conn in conns])
+    elapsed = time.monotonic() - start
+    for conn in conns:
+        await conn.close()
+
+    figures = {'acks_per_s': round(len(latencies) / elapsed, 1), 'lost_ack_errors': lost}
+    figures.update(latency_figures('ack', latencies))
+    return figures
+
+async def scenario_large_acks(options):
+    conn = await Connection.open(options)
+    payload = bytes([PROTO_STATUS_OK]) + bytes(PROTO_MAX_PAYLOAD - 1)
+    # Unsolicited acknowledgements are parsed and counted as unmatched; the
+    # PING closing each batch is answered once the whole batch was handled.
+    batch = b''.join(encode_frame(PROTO_OP_ACK, 0, payload, False) for _ in range(options.batch))
+    latencies = []
+    start = time.monotonic()
+    for _ in range(options.batches):
+        t0 = time.monotonic()
+        conn.writer.write(batch)
+        await conn.request(PROTO_OP_PING, b'', options.timeout)
+        latencies.append(time.monotonic() - t0)
+    elapsed = time.monotonic() - start
+    await conn.close()
+
+    frames = options.batch * options.batches
+    figures = {
+        '_frames': frames,
+        'frames_per_s': round(frames / elapsed, 1),
+        'mbytes_per_s': round(len(batch) * options.batches / elapsed / 1e6, 3),
+    }
+    figures.update(latency_figures('batch', latencies))
+    return figures
+
+async def scenario_idle_connections(options):
+    idle = [await Connection.open(options) for _ in range(max(options.clients - 2, 0))]
+    active = await Connection.open(options)
+    latencies = []
+    errors = 0
+    next_send = time.monotonic()
+    stop_at = next_send + options.duration
+    while next_send < stop_at:
+        t0 = time.monotonic()
+        try:
+            await active.request(PROTO_OP_PING, b'', options.timeout)
+            latencies.append(time.monotonic() - t0)
+        except asyncio.TimeoutError:
+            errors += 1
+        next_send += 1.0 / options.rate
+        await asyncio.sleep(max(0.0, next_send - time.monotonic()))
+
+    # Every idle client must still be connected.
+    clients = scrape_metrics(options).get('tcp_server_clients')
+    if clients is not None and clients < len(idle) + 1:
+        errors += len(idle) + 1 - int(clients)
+
+    for conn in idle + [active]:
+        await conn.close()
+
+    figures = {'idle_clients': len(idle), 'ping_errors': errors}
+    figures.update(latency_figures('ping', latencies))
+    return figures
+
+async def scenario_disconnect_storm(options):
+    if scrape_metrics(options).get('tcp_server_clients') is None:
+        raise RuntimeError("needs the metrics endpoint to see the connections freed")
+
+    conns = [await Connection.open(options) for _ in range(max(options.clients - 1, 1))]
+    t0 = time.monotonic()
+    for conn in conns:
+        conn.writer.close()
+    while True:
+        clients = scrape_metrics(options).get('tcp_server_clients')
+        if clients == 0:
+            break
+        if time.monotonic() - t0 > options.timeout:
+            raise RuntimeError("%d connections still open after the disconnect storm" % clients)
+        await asyncio.sleep(0.002)
+    teardown = time.monotonic() - t0
+
+    t0 = time.monotonic()
+    conn = await Connection.open(options)
+    reconnect = time.monotonic() - t0
+    await conn.close()
+
+    return {'teardown_ms': ms(teardown), 'reconnect_ms': ms(reconnect)}
+
+SCENARIOS = [
+    ('connect_churn',    scenario_connect_churn),
+    ('command_storm',    scenario_command_storm),
+    ('large_acks',       scenario_large_acks),
+    ('idle_connections', scenario_idle_connections),
+    ('disconnect_storm', scenario_disconnect_storm),
+]
+
+METRIC_LINE = re.compile(r'^([a-z_]+)(?:\{probe="([a-z_]+)"\})? ([0-9.]+)$')
+
+def scrape_metrics(options):
+    """Returns the server metrics used by the suite, or {} if unreachable."""
+    try:
+        url = 'http://%s:%d/metrics' % (options.ip, options.metrics_port)
+        with urllib.request.urlopen(url, timeout=options.timeout) as response:
+            text = response.read().decode('ascii', 'replace')
+    except OSError:
+        return {}
+    metrics = {}
+    for line in text.splitlines():
+        match = METRIC_LINE.match(line)
+        if not match:
+            continue
+        name, probe, value = match.groups()
+        if name in ('tcp_server_clients', 'tcp_server_rx_bytes_total', 'tcp_server_rx_copied_bytes_total'):
+            metrics[name] = int(value)
+        elif probe and name in ('perf_probe_calls_total', 'perf_probe_seconds_total'):
+            metrics[(name, probe)] = float(value)
+    return metrics
+
+def handler_figures(before, after, frames):
+    """Returns the mean time of the probed handlers between two scrapes. The
+    receive handler time is given per frame if the scenario counted them, as
+    the data handled per call varies from run to run.
+    """
+    figures = {}
+    for probe in ('connection_handler', 'receive_handler'):
+        calls = after.get(('perf_probe_calls_total', probe), 0) - before.get(('perf_probe_calls_total', probe), 0)
+        seconds = after.get(('perf_probe_seconds_total', probe), 0) - before.get(('perf_probe_seconds_total', probe), 0)
+        if probe == 'receive_handler' and frames:
+            figures['server_%s_frame_ns' % probe] = round(seconds / frames * 1e9, 1)
+        elif calls > 0:
+            figures['server_%s_us' % probe] = round(seconds / calls * 1e6, 2)
+    return figures
+
+def copy_figures(before, after):
+    """Returns the bytes the message parsers copied per byte received
+    between two scrapes, on top of the copy out of the socket.
+    """
+    received = after.get('tcp_server_rx_bytes_total', 0) - before.get('tcp_server_rx_bytes_total', 0)
+    copied = (after.get('tcp_server_rx_copied_bytes_total', 0) -
+              before.get('tcp_server_rx_copied_bytes_total', 0))
+    if received <= 0 or 'tcp_server_rx_copied_bytes_total' not in after:
+        return {}
+    return {'rx_copies_per_byte': round(copied / received, 3)}
+
+def run_scenario(options, name, function):
+    """Runs a scenario options.repeat times; returns the median figures."""
+    runs = []
+    for _ in range(options.repeat):
+        before = scrape_metrics(options)
+        figures = asyncio.run(function(options))
+        frames = figures.pop('_frames', 0)
+        after = scrape_metrics(options)
+        figures.update(handler_figures(before, after, frames))
+        figures.update(copy_figures(before, after))
+        runs.append(figures)
+        # Let the server free the connections of the run.
+        time.sleep(options.settle)
+    return {key: round(statistics.median(run[key] for run in runs if key in run), 3)
+            for key in runs[0]}
+
+def compare(name, value, base, threshold):
+    """Returns the relative change and whether it is a regression."""
+    for suffix, higher_is_better, noise in COMPARISON_RULES:
+        if name.endswith(suffix):
+            break
+    else:
+        return None, False
+    change = (value - base) / base if base else (0.0 if value == base else float('inf'))
+    worse = (base - value) if higher_is_better else (value - base)
+    if suffix == '_errors':
+        return change, worse > 0
+    return change, worse > noise and worse > abs(base) * threshold
+
+def wait_for_server(options, deadline):
+    while True:
+        try:
+            socket.create_connection((options.ip, options.port), 0.5).close()
+            return
+        except OSError:
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.1)
+
+parser = optparse.OptionParser()
+parser.add_option('-a', '--address', dest='ip', default='127.0.0.1',
+                  help='IP address of the TCP server [default: %default]')
+parser.add_option('-p', '--port', dest='port', type='int', default=50007,
+                  help='port of the TCP server [default: %default]')
+parser.add_option('--metrics-port', dest='metrics_port', type='int', default=DEFAULT_METRICS_PORT,
+                  help='metrics port of the TCP server [default: %default]')
+parser.add_option('--server', dest='server',
+                  help='start this server binary for the run, e.g. host/build/tcp_server')
+parser.add_option('-s', '--scenario', dest='scenarios', action='append',
+                  help='run only this scenario; may be repeated')
+parser.add_option('-b', '--baseline', dest='baseline', default=DEFAULT_BASELINE,
+                  help='baseline file [default: %default]')
+parser.add_option('-u', '--update', dest='update', action='store_true', default=False,
+                  help='store the figures as the new baselines instead of comparing')
+parser.add_option('-t', '--threshold', dest='threshold', type='float', default=0.25,
+                  help='relative change counted as a regression [default: %default]')
+parser.add_option('-c', '--clients', dest='clients', type='int', default=4,
+                  help='TCP_CONN_MAX_CLIENTS of the server [default: %default]')
+parser.add_option('-n', '--repeat', dest='repeat', type='int', default=5,
+                  help='runs of each scenario; the median is kept [default: %default]')
+parser.add_option('-d', '--duration', dest='duration', type='float', default=2,
+                  help='seconds of the timed scenarios [default: %default]')
+parser.add_option('--churn', dest='churn', type='int', default=200,
+                  help='connections of connect_churn [default: %default]')
+parser.add_option('-w', '--window', dest='window', type='int', default=16,
+                  help='unacknowledged commands per connection in command_storm [default: %default]')
+parser.add_option('--batch', dest='batch', type='int', default=1000,
+                  help='frames per batch in large_acks [default: %default]')
+parser.add_option('--batches', dest='batches', type='int', default=200,
+                  help='batches in large_acks [default: %default]')
+parser.add_option('-r', '--rate', dest='rate', type='float', default=200,
+                  help='commands per second in idle_connections [default: %default]')
+parser.add_option('--timeout', dest='timeout', type='float', default=5,
+                  help='connect and acknowledgement timeout in seconds [default: %default]')
+parser.add_option('--settle', dest='settle', type='float', default=0.2,
+                  help='pause between runs in seconds [default: %default]')
+
+if __name__ == '__main__':
+    (options, args) = parser.parse_args()
+    selected = [s for s in SCENARIOS if not options.scenarios or s[0] in options.scenarios]
+    if not selected:
+        parser.error("no scenario named %s" % ', '.join(options.scenarios))
+
+    config = {'clients': options.clients, 'duration_s': options.duration, 'churn': options.churn,
+              'window': options.window, 'batch': options.batch, 'batches': options.batches,
+              'rate': options.rate}
+    baseline = {'config': config, 'scenarios': {}}
+    if os.path.exists(options.baseline):
+        with open(options.baseline) as f:
+            baseline = json.load(f)
+    if not options.update and baseline['config'] != config:
+        print("Baselines were recorded with %s; run with the same options or --update" % baseline['config'])
+        sys.exit(2)
+
+    server = None
+    if options.server:
+        server = subprocess.Popen([os.path.abspath(options.server)], stdout=subprocess.DEVNULL,
+                                  stderr=subprocess.DEVNULL, cwd=os.path.dirname(os.path.abspath(options.server)))
+    regressions = 0
+    try:
+        wait_for_server(options, time.monotonic() + 10)
+        for name, function in selected:
+            try:
+                figures = run_scenario(options, name, function)
+            except (OSError, ValueError, RuntimeError, asyncio.TimeoutError) as e:
+                print("%s: failed: %s" % (name, e))
+                regressions += 1
+                continue
+
+            base = baseline['scenarios'].get(name, {})
+            print(name)
+            for key, value in figures.items():
+                line = "  %-32s %12s" % (key, value)
+                if not options.update and key in base:
+                    change, regressed = compare(key, value, base[key], options.threshold)
+                    if change is not None:
+                        line += " %12s %+8.1f%%%s" % (base[key], change * 100.0 if change != float('inf') else 999.9,
+                                                      "  REGRESSION" if regressed else "")
+                        regressions += regressed
+                print(line)
+            if options.update:
+                baseline['scenarios'][name] = figures
+    finally:
+        if server:
+            server.terminate()
+            server.wait()
+
+    if options.update:
+        baseline['config'] = config
+        with open(options.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print("Baselines written to %s" % options.baseline)
+        sys.exit(0)
+
+    print("%d regression(s) past %.0f%%" % (regressions, options.threshold * 100.0) if regressions
+          else "No regression past %.0f%%" % (options.threshold * 100.0))
+    sys.exit(1 if regressions else 0)
+
+# [] END OF FILE
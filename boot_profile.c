@@ -0,0 +1,265 @@
+/******************************************************************************
+* File Name:   boot_profile.c
+*
+* Description: This file contains the startup profiler. Each startup stage
+* is time stamped with the cycle counter, started first thing in main(); the
+* 32-bit counter is extended from one stage to the next, with the tick count
+* taking over for stages long enough for it to wrap (26 s at 160 MHz), such
+* as Wi-Fi connection retries. The stage times of the last boot and the best
+* time to ready are kept in a CY_NOINIT section, which survives the resets
+* that keep the RAM powered, so every boot is compared with the previous one.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_utils.h"
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header files */
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Startup profiler header file. */
+#include "boot_profile.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Protocol header file, for the CRC. */
+#include "tcp_proto.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BOOT_HISTORY_MAGIC                        (0x424F4F54u)   /* "BOOT" */
+
+/* Stages longer than this, in ms, are timed with the tick count: half the
+ * wrap period of the timestamps.
+ */
+#define BOOT_TIMESTAMP_SAFE_MS                    ((uint32_t)((1000ull << 31) / TIMESTAMP_HZ))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Startup history kept across resets. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t boot_count;
+    uint32_t best_ready_us;
+    uint32_t stage_us[BOOT_STAGE_COUNT];    /* Of the last boot that got ready. */
+    uint16_t crc;
+} boot_history_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static uint16_t history_crc(const boot_history_t *h);
+static void print_us(const char *label, uint32_t us);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+CY_NOINIT static boot_history_t history;
+
+/* History found at startup, if valid. */
+static boot_history_t previous;
+static bool previous_valid;
+
+/* Time of every stage since main(), in microseconds. */
+static uint32_t stage_us[BOOT_STAGE_COUNT];
+static uint32_t stages_marked;
+
+/* Last mark, to extend the timestamps. */
+static uint32_t last_timestamp;
+static TickType_t last_tick;
+static uint64_t last_ns;
+
+static const char *const stage_names[BOOT_STAGE_COUNT] =
+{
+    "main()",
+    "cybsp_init",
+    "retarget-io",
+    "scheduler",
+    "cy_wcm_init",
+    "Wi-Fi",
+    "cy_socket_init",
+    "socket create",
+    "listen"
+};
+
+/*******************************************************************************
+ * Function Name: boot_profile_start
+ *******************************************************************************
+ * Summary:
+ *  Starts the cycle counter and takes the time origin. Called first thing in
+ *  main(), before anything is printed.
+ *
+ *******************************************************************************/
+void boot_profile_start(void)
+{
+    timestamp_init();
+    last_timestamp = timestamp_now();
+    last_tick = xTaskGetTickCount();
+    last_ns = 0;
+
+    previous_valid = (history.magic == BOOT_HISTORY_MAGIC) && (history.crc == history_crc(&history));
+    if(previous_valid)
+    {
+        previous = history;
+    }
+    else
+    {
+        memset(&history, 0, sizeof(history));
+        history.magic = BOOT_HISTORY_MAGIC;
+    }
+
+    history.boot_count++;
+    history.crc = history_crc(&history);
+
+    stage_us[BOOT_STAGE_MAIN] = 0;
+    stages_marked = 1u << BOOT_STAGE_MAIN;
+}
+
+/*******************************************************************************
+ * Function Name: boot_profile_mark
+ *******************************************************************************
+ * Summary:
+ *  Records the completion of a startup stage.
+ *
+ * Parameters:
+ *  boot_stage_t stage: Completed stage
+ *
+ *******************************************************************************/
+void boot_profile_mark(boot_stage_t stage)
+{
+    uint32_t now = timestamp_now();
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t elapsed_ms = (uint32_t)(tick - last_tick) * portTICK_PERIOD_MS;
+
+    if(elapsed_ms < BOOT_TIMESTAMP_SAFE_MS)
+    {
+        last_ns += ((uint64_t)(uint32_t)(now - last_timestamp) * 1000000000u) / TIMESTAMP_HZ;
+    }
+    else
+    {
+        last_ns += (uint64_t)elapsed_ms * 1000000u;
+    }
+    last_timestamp = now;
+    last_tick = tick;
+
+    stage_us[stage] = (uint32_t)(last_ns / 1000u);
+    stages_marked |= 1u << stage;
+}
+
+/*******************************************************************************
+ * Function Name: boot_profile_ready
+ *******************************************************************************
+ * Summary:
+ *  Marks the server ready, prints the startup profile against the previous
+ *  boot and saves it for the next one.
+ *
+ *******************************************************************************/
+void boot_profile_ready(void)
+{
+    uint32_t prev_stage = 0;
+    uint32_t ready_us;
+
+    boot_profile_mark(BOOT_STAGE_LISTEN);
+    ready_us = stage_us[BOOT_STAGE_LISTEN];
+
+    printf("===============================================================\n");
+    printf("Startup profile, boot %"PRIu32" (ms since main)\n", history.boot_count);
+    printf("  Stage                 at   stage previous\n");
+
+    for(uint32_t i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        if((stages_marked & (1u << i)) == 0)
+        {
+            continue;
+        }
+
+        printf("  %-16s %5"PRIu32".%"PRIu32" %5"PRIu32".%"PRIu32,
+               stage_names[i], stage_us[i] / 1000u, (stage_us[i] / 100u) % 10u,
+               (stage_us[i] - prev_stage) / 1000u, ((stage_us[i] - prev_stage) / 100u) % 10u);
+        if(previous_valid && (i > 0) && (previous.stage_us[i] > 0))
+        {
+            printf("  %5"PRIu32".%"PRIu32,
+                   (previous.stage_us[i] - previous.stage_us[i - 1u]) / 1000u,
+                   ((previous.stage_us[i] - previous.stage_us[i - 1u]) / 100u) % 10u);
+        }
+        printf("\n");
+        prev_stage = stage_us[i];
+    }
+
+    print_us("Time to first listen", ready_us);
+    if(previous_valid && (previous.stage_us[BOOT_STAGE_LISTEN] > 0))
+    {
+        print_us("Previous boot", previous.stage_us[BOOT_STAGE_LISTEN]);
+        print_us("Best boot", previous.best_ready_us);
+    }
+    printf("===============================================================\n");
+
+    memcpy(history.stage_us, stage_us, sizeof(history.stage_us));
+    if((history.best_ready_us == 0) || (ready_us < history.best_ready_us))
+    {
+        history.best_ready_us = ready_us;
+    }
+    history.crc = history_crc(&history);
+}
+
+/*******************************************************************************
+ * Function Name: boot_profile_get
+ *******************************************************************************
+ * Summary:
+ *  Returns the startup figures.
+ *
+ * Parameters:
+ *  boot_profile_summary_t *summary: Set to the startup figures
+ *
+ *******************************************************************************/
+void boot_profile_get(boot_profile_summary_t *summary)
+{
+    summary->boot_count = history.boot_count;
+    summary->ready_us = ((stages_marked & (1u << BOOT_STAGE_LISTEN)) != 0) ?
+                        stage_us[BOOT_STAGE_LISTEN] : 0;
+    summary->previous_ready_us = previous_valid ? previous.stage_us[BOOT_STAGE_LISTEN] : 0;
+    summary->best_ready_us = history.best_ready_us;
+}
+
+/*******************************************************************************
+ * Function Name: history_crc
+ *******************************************************************************
+ * Summary:
+ *  Returns the CRC of the startup history, which tells a kept history from
+ *  the random content of the RAM after a power-up.
+ *
+ *******************************************************************************/
+static uint16_t history_crc(const boot_history_t *h)
+{
+    return tcp_proto_crc16((const uint8_t *)h, offsetof(boot_history_t, crc));
+}
+
+/*******************************************************************************
+ * Function Name: print_us
+ *******************************************************************************
+ * Summary:
+ *  Prints a labelled time in milliseconds.
+ *
+ *******************************************************************************/
+static void print_us(const char *label, uint32_t us)
+{
+    printf("%s: %"PRIu32".%03"PRIu32" ms\n", label, us / 1000u, us % 1000u);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/******************************************************************************
+* File Name:   boot_profile.h
+*
+* Description: This file contains declaration of the startup profiler, which
+* time stamps the stages from main() to the first cy_socket_listen() and
+* keeps the time to ready of the previous boots across resets.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef BOOT_PROFILE_H_
+#define BOOT_PROFILE_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Startup stages, in order. Each is marked when it completes. */
+typedef enum
+{
+    BOOT_STAGE_MAIN = 0,            /* main() entered; the time origin. */
+    BOOT_STAGE_BSP_INIT,            /* cybsp_init() */
+    BOOT_STAGE_RETARGET_IO,         /* cy_retarget_io_init() */
+    BOOT_STAGE_SCHEDULER,           /* The TCP server task started. */
+    BOOT_STAGE_WCM_INIT,            /* cy_wcm_init() */
+    BOOT_STAGE_WIFI,                /* connect_to_wifi_ap() or softap_start() */
+    BOOT_STAGE_SOCKET_INIT,         /* cy_socket_init() */
+    BOOT_STAGE_SOCKET_CREATE,       /* create_tcp_server_socket() */
+    BOOT_STAGE_LISTEN,              /* cy_socket_listen(); the server is ready. */
+    BOOT_STAGE_COUNT
+} boot_stage_t;
+
+/* Startup figures. */
+typedef struct
+{
+    uint32_t boot_count;            /* Boots since the history was last lost. */
+    uint32_t ready_us;              /* Time to ready of this boot; 0 until ready. */
+    uint32_t previous_ready_us;     /* Time to ready of the previous boot; 0 if unknown. */
+    uint32_t best_ready_us;         /* Shortest time to ready recorded; 0 if none. */
+} boot_profile_summary_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void boot_profile_start(void);
+void boot_profile_mark(boot_stage_t stage);
+void boot_profile_ready(void);
+void boot_profile_get(boot_profile_summary_t *summary);
+
+#endif /* BOOT_PROFILE_H_ */
@@ -0,0 +1,146 @@
+/******************************************************************************
+* File Name:   cmd_latency.c
+*
+* Description: This file contains the latency histograms of the LED commands.
+* Each stage of a command is timed with timestamp_now() and recorded in
+* nanoseconds into a fixed size histogram, so that the percentiles can be
+* read at run time without storing the samples.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* Standard C header file */
+#include <inttypes.h>
+
+/* Command latency header file. */
+#include "cmd_latency.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* One histogram per stage. Each histogram is recorded from one task only:
+ * CMD_LATENCY_ISR_TO_TASK by the TCP server task and the other stages by the
+ * receive handler, when the acknowledgement arrives.
+ */
+static latency_hist_t stage_hist[CMD_LATENCY_STAGE_COUNT];
+
+static const char *const stage_names[CMD_LATENCY_STAGE_COUNT] =
+{
+    "ISR to task",
+    "Task to sent",
+    "Sent to ack",
+    "ISR to ack"
+};
+
+/*******************************************************************************
+ * Function Name: cmd_latency_init
+ *******************************************************************************
+ * Summary:
+ *  Starts the timestamp counter and clears the histograms.
+ *
+ *******************************************************************************/
+void cmd_latency_init(void)
+{
+    timestamp_init();
+
+    for(uint32_t i = 0; i < CMD_LATENCY_STAGE_COUNT; i++)
+    {
+        latency_hist_reset(&stage_hist[i]);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cmd_latency_record
+ *******************************************************************************
+ * Summary:
+ *  Records the duration of a stage of a LED command.
+ *
+ * Parameters:
+ *  cmd_latency_stage_t stage: Stage of the command
+ *  uint32_t start: Timestamp at the start of the stage
+ *  uint32_t end: Timestamp at the end of the stage
+ *
+ *******************************************************************************/
+void cmd_latency_record(cmd_latency_stage_t stage, uint32_t start, uint32_t end)
+{
+    latency_hist_record(&stage_hist[stage], timestamp_to_ns(end - start));
+}
+
+/*******************************************************************************
+ * Function Name: cmd_latency_summary
+ *******************************************************************************
+ * Summary:
+ *  Returns the summary of a stage, in nanoseconds.
+ *
+ * Parameters:
+ *  cmd_latency_stage_t stage: Stage of the command
+ *  latency_summary_t *summary: Summary of the stage
+ *
+ *******************************************************************************/
+void cmd_latency_summary(cmd_latency_stage_t stage, latency_summary_t *summary)
+{
+    latency_hist_summary(&stage_hist[stage], summary);
+}
+
+/*******************************************************************************
+ * Function Name: cmd_latency_hist
+ *******************************************************************************
+ * Summary:
+ *  Returns the histogram of a stage, in nanoseconds, for readers needing more
+ *  than the summary. It is recorded without a lock, see latency_hist_t.
+ *
+ *******************************************************************************/
+const latency_hist_t *cmd_latency_hist(cmd_latency_stage_t stage)
+{
+    return &stage_hist[stage];
+}
+
+/*******************************************************************************
+ * Function Name: cmd_latency_stage_name
+ *******************************************************************************
+ * Summary:
+ *  Returns the name of a stage.
+ *
+ *******************************************************************************/
+const char *cmd_latency_stage_name(cmd_latency_stage_t stage)
+{
+    return stage_names[stage];
+}
+
+/*******************************************************************************
+ * Function Name: cmd_latency_print
+ *******************************************************************************
+ * Summary:
+ *  Logs the summary of every stage, in microseconds.
+ *
+ *******************************************************************************/
+void cmd_latency_print(void)
+{
+    latency_summary_t summary;
+
+    APP_LOG_INFO("Command latency (us)     count      min      p50      p99     p999      max");
+
+    for(uint32_t i = 0; i < CMD_LATENCY_STAGE_COUNT; i++)
+    {
+        cmd_latency_summary((cmd_latency_stage_t)i, &summary);
+        APP_LOG_INFO("  %-16s %10"PRIuPTR" %8"PRIuPTR" %8"PRIuPTR" %8"PRIuPTR" %8"PRIuPTR" %8"PRIuPTR,
+                     APP_LOG_STR(stage_names[i]), summary.count, summary.min / 1000u,
+                     summary.p50 / 1000u, summary.p99 / 1000u, summary.p999 / 1000u,
+                     summary.max / 1000u);
+    }
+}
+
+/* [] END OF FILE */
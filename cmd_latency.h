@@ -0,0 +1,47 @@
+/******************************************************************************
+* File Name:   cmd_latency.h
+*
+* Description: This file contains declaration of the latency histograms of
+* the LED commands, from the user button interrupt to the acknowledgement of
+* the TCP client.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CMD_LATENCY_H_
+#define CMD_LATENCY_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/* Latency histogram header file. */
+#include "latency_hist.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Measured stages of a LED command. */
+typedef enum
+{
+    CMD_LATENCY_ISR_TO_TASK = 0,    /* Button interrupt to TCP server task wakeup. */
+    CMD_LATENCY_TASK_TO_SENT,       /* Task wakeup to cy_socket_send() return. */
+    CMD_LATENCY_SENT_TO_ACK,        /* cy_socket_send() return to ack receipt. */
+    CMD_LATENCY_ISR_TO_ACK,         /* Button interrupt to ack receipt. */
+    CMD_LATENCY_STAGE_COUNT
+} cmd_latency_stage_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void cmd_latency_init(void);
+void cmd_latency_record(cmd_latency_stage_t stage, uint32_t start, uint32_t end);
+void cmd_latency_summary(cmd_latency_stage_t stage, latency_summary_t *summary);
+const latency_hist_t *cmd_latency_hist(cmd_latency_stage_t stage);
+const char *cmd_latency_stage_name(cmd_latency_stage_t stage);
+void cmd_latency_print(void);
+
+#endif /* CMD_LATENCY_H_ */
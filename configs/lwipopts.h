@@ -0,0 +1,89 @@
+/******************************************************************************
+* File Name:   lwipopts.h
+*
+* Description: lwIP configuration of the TCP server. The general options are
+* those of the lwipopts.h template of the ModusToolbox Wi-Fi middleware; the
+* sizes of the TCP path (window, send buffer, pbuf pool, heap and control
+* blocks) are derived from the client count in app_memory_budget.h, applied
+* at the end of this file.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#pragma once
+
+/* Standard C header files */
+#include <stdlib.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Platform and protocols. */
+#define MEM_ALIGNMENT                             (4)
+
+#define LWIP_RAW                                  (1)
+#define LWIP_IPV4                                 (1)
+#define LWIP_IPV6                                 (1)
+#define LWIP_ICMP                                 (1)
+#define LWIP_TCP                                  (1)
+#define LWIP_UDP                                  (1)
+#define LWIP_IGMP                                 (1)
+#define LWIP_DHCP                                 (1)
+#define LWIP_DNS                                  (1)
+#define LWIP_IPV6_MLD                             (1)
+#define LWIP_IPV6_AUTOCONFIG                      (1)
+#define LWIP_DHCP_DOES_ACD_CHECK                  (0)
+
+#define LWIP_NETIF_API                            (1)
+#define LWIP_NETIF_STATUS_CALLBACK                (1)
+#define LWIP_NETIF_LINK_CALLBACK                  (1)
+#define LWIP_NETIF_REMOVE_CALLBACK                (1)
+#define LWIP_NETIF_HOSTNAME                       (1)
+#define LWIP_NETIF_TX_SINGLE_PBUF                 (1)
+#define LWIP_NUM_NETIF_CLIENT_DATA                (1)
+#define ETHARP_SUPPORT_STATIC_ENTRIES             (1)
+
+#define LWIP_CHKSUM_ALGORITHM                     (3)
+#define LWIP_RAND()                               rand()
+
+/* Sequential API, used by the secure sockets library. */
+#define LWIP_NETCONN                              (1)
+#define LWIP_SOCKET                               (0)
+#define LWIP_SO_RCVTIMEO                          (1)
+#define LWIP_SO_SNDTIMEO                          (1)
+#define LWIP_SO_RCVBUF                            (1)
+#define LWIP_TCP_KEEPALIVE                        (1)
+#define LWIP_TIMEVAL_PRIVATE                      (0)
+#define SO_REUSE                                  (1)
+
+/* TCP/IP thread. */
+#define TCPIP_THREAD_STACKSIZE                    (4 * 1024)
+#define TCPIP_THREAD_PRIO                         (4)
+#define TCPIP_MBOX_SIZE                           (16)
+#define DEFAULT_RAW_RECVMBOX_SIZE                 (12)
+#define DEFAULT_UDP_RECVMBOX_SIZE                 (12)
+#define DEFAULT_TCP_RECVMBOX_SIZE                 (12)
+#define DEFAULT_ACCEPTMBOX_SIZE                   (8)
+#define LWIP_TCPIP_CORE_LOCKING                   (1)
+#define LWIP_TCPIP_CORE_LOCKING_INPUT             (1)
+
+/* Pools not sized by the budget. A netconn is taken per TCP control block,
+ * plus the DHCP and DNS UDP ones.
+ */
+#define MEMP_NUM_UDP_PCB                          (8)
+#define MEMP_NUM_NETBUF                           (8)
+#define MEMP_NUM_NETCONN                          (MEMP_NUM_TCP_PCB + MEMP_NUM_TCP_PCB_LISTEN + 4)
+#define MEMP_NUM_SYS_TIMEOUT                      (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 8)
+
+/* TCP path sizes, from app_memory_budget.h. Keep these last: they replace
+ * any value above, and app_memory_budget.c fails the build if lwIP is built
+ * with other values.
+ */
+#define APP_BUDGET_LWIP_OPTIONS
+#include "app_memory_budget.h"
+
+/* [] END OF FILE */
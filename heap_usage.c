@@ -5,6 +5,30 @@
 *              Supports only GCC_ARM compiler. Define PRINT_HEAP_USAGE for
 *              printing the heap usage numbers.
 *
+*              With HEAP_PROFILE_ENABLED, it also contains a heap profiler.
+*              The allocator functions are wrapped with the linker
+*              (-Wl,--wrap), and every allocation is recorded against its
+*              call site, the return address of the allocation call. Named
+*              phase snapshots of the live bytes of each site show where the
+*              heap grows between two points of the program.
+*
+*              With HEAP_GUARD_ENABLED, the same wrappers count the
+*              allocations made once heap_guard_arm() was called, when the
+*              server is listening, and log the first of them; with
+*              HEAP_GUARD_TRAP they stop the program instead.
+*
+*              With MEM_POOL_MALLOC_ENABLED, the wrappers serve the small
+*              allocations from the fixed-block pools (see mem_pool.h) and
+*              pass the others on to the heap. The profiler records both;
+*              the guard counts only those reaching the heap.
+*
+*              With HEAP_TLSF_ENABLED, the heap the wrappers pass the
+*              allocations on to is a TLSF heap (see tlsf_heap.h) over a
+*              static area, taken in a critical section, whose malloc() and
+*              free() take a bounded time. The allocations it cannot serve,
+*              and those newlib makes internally with _malloc_r(), go to
+*              the newlib heap; free() tells the two apart by address.
+*
 * Related Document: See README.md
 *
 *
@@ -15,9 +39,32 @@
 /*******************************************************************************
  * Header file includes
  ******************************************************************************/
+#include <stdbool.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
+
+/* Heap usage header file. */
+#include "heap_usage.h"
+
+/* Fixed-block pool header file. */
+#include "mem_pool.h"
+
+/* TLSF heap header file. */
+#include "tlsf_heap.h"
+
+#if(HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED)
+/* Header file includes */
+#include "cy_utils.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Deferred logging header file. */
+#include "app_log.h"
+#endif /* HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED */
 
 /* ARM compiler also defines __GNUC__ */
 #if defined (__GNUC__) && !defined(__ARMCC_VERSION)
@@ -30,6 +77,132 @@
  ******************************************************************************/
 #define TO_KB(size_bytes)  ((float)(size_bytes)/1024)
 
+#define RETURN_ADDRESS()   ((uintptr_t)__builtin_return_address(0))
+
+/* The allocator functions are wrapped for the profiler, for the guard and
+ * for the pools; the parts of those that are not built reduce to nothing.
+ */
+#if(!HEAP_PROFILE_ENABLED)
+#define record_alloc(ptr, size, site)             ((void)0)
+#define record_free(ptr)                          ((void)0)
+#endif /* !HEAP_PROFILE_ENABLED */
+
+#if(!HEAP_GUARD_ENABLED)
+#define guard_check(size, site)                   ((void)0)
+#endif /* !HEAP_GUARD_ENABLED */
+
+#if(HEAP_PROFILE_ENABLED)
+#define LIVE_INDEX_MASK    (HEAP_PROFILE_MAX_LIVE - 1u)
+#define LIVE_TABLE_LIMIT   ((HEAP_PROFILE_MAX_LIVE * 3u) / 4u)
+
+
+/*******************************************************************************
+ * Data Structures
+ ******************************************************************************/
+/* Live allocation. */
+typedef struct
+{
+    uintptr_t ptr;                      /* 0 - free entry. */
+    uint32_t size;
+    uint32_t site;                      /* Index into the site table. */
+} heap_profile_block_t;
+
+/* Named snapshot of the live bytes of every site. */
+typedef struct
+{
+    const char *name;                   /* NULL - free entry. */
+    uint32_t seq;                       /* Order of the snapshots. */
+    uint32_t live_bytes;
+    uint32_t live_blocks;
+    uint32_t site_live[HEAP_PROFILE_MAX_SITES];
+} heap_profile_phase_t;
+#endif /* HEAP_PROFILE_ENABLED */
+
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+#if(HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED)
+/* Real allocator functions and their wrappers, see -Wl,--wrap. */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void __wrap_free(void *ptr);
+void *__wrap_pvPortMalloc(size_t size);
+void __wrap_vPortFree(void *ptr);
+
+static void *heap_alloc(size_t size, uintptr_t site);
+static void heap_free(void *ptr);
+static size_t heap_block_size(const void *ptr);
+static bool heap_resize(void *ptr, size_t size, size_t block_size);
+static void *tlsf_alloc(size_t size);
+static bool tlsf_free(void *ptr);
+#endif /* HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED */
+
+#if(HEAP_TLSF_ENABLED)
+static bool tlsf_setup(void);
+#endif /* HEAP_TLSF_ENABLED */
+
+#if(HEAP_PROFILE_ENABLED)
+static uint32_t find_site(uintptr_t site);
+static uint32_t live_index(uintptr_t ptr);
+static void record_alloc(void *ptr, size_t size, uintptr_t site);
+static void record_free(void *ptr);
+static heap_profile_phase_t *find_phase(const char *name);
+static void log_phase_diff(const heap_profile_phase_t *from, const heap_profile_phase_t *to);
+#endif /* HEAP_PROFILE_ENABLED */
+
+#if(HEAP_GUARD_ENABLED)
+static void guard_check(size_t size, uintptr_t site);
+#endif /* HEAP_GUARD_ENABLED */
+
+
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+#if(HEAP_PROFILE_ENABLED)
+/* Allocation sites; entry 0 collects the sites past the table. Updated in a
+ * critical section.
+ */
+static heap_profile_site_t sites[HEAP_PROFILE_MAX_SITES];
+static uint32_t site_count = 1;
+
+/* Live allocations, an open addressing hash table on the pointer. */
+static heap_profile_block_t live_blocks[HEAP_PROFILE_MAX_LIVE];
+static uint32_t live_count;
+static uint32_t live_bytes;
+static uint32_t peak_bytes;
+static uint32_t untracked_allocs;       /* Not recorded, the table was full. */
+static uint32_t unknown_frees;          /* Pointers not allocated by a wrapper. */
+
+/* Number of allocations by size class. */
+static uint32_t size_classes[HEAP_PROFILE_SIZE_CLASSES];
+
+/* Phase snapshots; taken with the scheduler suspended. */
+static heap_profile_phase_t phases[HEAP_PROFILE_MAX_PHASES];
+static uint32_t phase_seq;
+#endif /* HEAP_PROFILE_ENABLED */
+
+#if(HEAP_GUARD_ENABLED)
+/* Set once the server listens; allocations from then on are counted. */
+static volatile bool guard_armed;
+static uint32_t guard_allocs;
+static uintptr_t guard_first_site;
+#endif /* HEAP_GUARD_ENABLED */
+
+#if(HEAP_TLSF_ENABLED)
+/* TLSF heap; set up by the first allocation, which may come before main(). */
+static tlsf_heap_t tlsf_heap;
+static uint8_t tlsf_area[HEAP_TLSF_SIZE] __attribute__((aligned(TLSF_HEAP_ALIGN)));
+static bool tlsf_ready;
+static uint32_t tlsf_fallbacks;
+#endif /* HEAP_TLSF_ENABLED */
+
 
 /*******************************************************************************
  * Function Definitions
@@ -65,8 +238,947 @@ void print_heap_usage(char *msg)
     printf("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap\r\n",
             mall_info.uordblks, TO_KB(mall_info.uordblks), ((float) mall_info.uordblks * 100u)/heap_size);
 
+    mem_pool_print();
+
+#if(HEAP_TLSF_ENABLED)
+    {
+        heap_free_stats_t free_stats;
+
+        heap_usage_get_free(&free_stats);
+        printf("TLSF heap free              : %"PRIu32" bytes in %"PRIu32" blocks, largest %"PRIu32" bytes\r\n",
+               free_stats.free_bytes, free_stats.free_blocks, free_stats.largest_free);
+        printf("TLSF fallbacks to newlib    : %"PRIu32"\r\n", free_stats.fallbacks);
+    }
+#endif /* HEAP_TLSF_ENABLED */
+
     printf("********************************\r\n\n");
 #endif /* #if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION) */
+
+#if(HEAP_PROFILE_ENABLED)
+    /* The message names the phase; it is kept, so it must be a constant. */
+    heap_profile_phase(msg);
+#endif /* HEAP_PROFILE_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_get
+********************************************************************************
+* Summary:
+* Returns the heap in use and the heap taken from the system so far, which
+* newlib never gives back, from mallinfo(). Both are 0 on compilers without
+* mallinfo(). With HEAP_TLSF_ENABLED, the TLSF heap is added, all of it
+* taken.
+*
+* Parameters:
+*  uint32_t *in_use: Set to the bytes allocated
+*  uint32_t *arena: Set to the bytes taken from the system
+*
+*******************************************************************************/
+void heap_usage_get(uint32_t *in_use, uint32_t *arena)
+{
+    /* ARM compiler also defines __GNUC__ */
+#if defined (__GNUC__) && !defined(__ARMCC_VERSION)
+    struct mallinfo mall_info = mallinfo();
+
+    *in_use = (uint32_t)mall_info.uordblks;
+    *arena = (uint32_t)mall_info.arena;
+#else
+    *in_use = 0;
+    *arena = 0;
+#endif /* #if defined (__GNUC__) && !defined(__ARMCC_VERSION) */
+
+#if(HEAP_TLSF_ENABLED)
+    taskENTER_CRITICAL();
+    *in_use += tlsf_heap.used_bytes;
+    taskEXIT_CRITICAL();
+    *arena += HEAP_TLSF_SIZE;
+#endif /* HEAP_TLSF_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_get_free
+********************************************************************************
+* Summary:
+* Returns the free memory of the heap serving malloc(): that of the TLSF heap
+* with HEAP_TLSF_ENABLED, else that of newlib from mallinfo(). The largest
+* free block against the free bytes tells how fragmented the heap is; newlib
+* only gives the number of free blocks.
+*
+* Parameters:
+*  heap_free_stats_t *stats: Set to the free memory statistics
+*
+*******************************************************************************/
+void heap_usage_get_free(heap_free_stats_t *stats)
+{
+#if(HEAP_TLSF_ENABLED)
+    tlsf_heap_stats_t tlsf_stats;
+
+    taskENTER_CRITICAL();
+    (void)tlsf_setup();
+    tlsf_heap_get_stats(&tlsf_heap, &tlsf_stats);
+    stats->fallbacks = tlsf_fallbacks;
+    taskEXIT_CRITICAL();
+
+    stats->free_bytes = tlsf_stats.free_bytes;
+    stats->free_blocks = tlsf_stats.free_blocks;
+    stats->largest_free = tlsf_stats.largest_free;
+#elif defined (__GNUC__) && !defined(__ARMCC_VERSION)
+    struct mallinfo mall_info = mallinfo();
+
+    stats->free_bytes = (uint32_t)mall_info.fordblks;
+    stats->free_blocks = (uint32_t)mall_info.ordblks;
+    stats->largest_free = 0;
+    stats->fallbacks = 0;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif /* HEAP_TLSF_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_profile_phase
+********************************************************************************
+* Summary:
+* Takes a snapshot of the live bytes of every allocation site under a name,
+* and logs how they changed since the previous snapshot of the same name, or
+* else since the latest snapshot. Taking a snapshot at the same point of a
+* repeated operation, e.g. when a client connects, shows the sites that grow
+* from one repetition to the next. The oldest snapshot is replaced when all
+* HEAP_PROFILE_MAX_PHASES are taken. Does not block; callable from the socket
+* callbacks.
+*
+* Parameters:
+*  const char *name: Name of the phase, a string constant
+*
+*******************************************************************************/
+void heap_profile_phase(const char *name)
+{
+#if(HEAP_PROFILE_ENABLED)
+    heap_profile_phase_t snapshot;
+    heap_profile_phase_t *previous;
+    heap_profile_phase_t *slot;
+
+    vTaskSuspendAll();
+
+    snapshot.name = name;
+    snapshot.seq = ++phase_seq;
+
+    taskENTER_CRITICAL();
+    snapshot.live_bytes = live_bytes;
+    snapshot.live_blocks = live_count;
+    for(uint32_t i = 0; i < HEAP_PROFILE_MAX_SITES; i++)
+    {
+        snapshot.site_live[i] = sites[i].live_bytes;
+    }
+    taskEXIT_CRITICAL();
+
+    /* Replace the snapshot of the same name, else the oldest, or a free one
+     * (sequence number 0).
+     */
+    previous = find_phase(name);
+    slot = previous;
+    if(previous == NULL)
+    {
+        slot = &phases[0];
+        for(uint32_t i = 0; i < HEAP_PROFILE_MAX_PHASES; i++)
+        {
+            if((phases[i].name != NULL) && ((previous == NULL) || (phases[i].seq > previous->seq)))
+            {
+                previous = &phases[i];
+            }
+            if(phases[i].seq < slot->seq)
+            {
+                slot = &phases[i];
+            }
+        }
+    }
+
+    if(previous != NULL)
+    {
+        log_phase_diff(previous, &snapshot);
+    }
+    else
+    {
+        APP_LOG_INFO("Heap phase '%s': %"PRIuPTR" bytes in %"PRIuPTR" allocations",
+                     APP_LOG_STR(name), snapshot.live_bytes, snapshot.live_blocks);
+    }
+
+    *slot = snapshot;
+
+    xTaskResumeAll();
+#endif /* HEAP_PROFILE_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_profile_diff
+********************************************************************************
+* Summary:
+* Logs how the live bytes of every allocation site changed between two phase
+* snapshots.
+*
+* Parameters:
+*  const char *from: Name of the earlier phase
+*  const char *to: Name of the later phase
+*
+*******************************************************************************/
+void heap_profile_diff(const char *from, const char *to)
+{
+#if(HEAP_PROFILE_ENABLED)
+    const heap_profile_phase_t *from_phase;
+    const heap_profile_phase_t *to_phase;
+
+    vTaskSuspendAll();
+
+    from_phase = find_phase(from);
+    to_phase = find_phase(to);
+    if((from_phase != NULL) && (to_phase != NULL))
+    {
+        log_phase_diff(from_phase, to_phase);
+    }
+    else
+    {
+        APP_LOG_WARNING("Heap phase '%s' or '%s' not found", APP_LOG_STR(from), APP_LOG_STR(to));
+    }
+
+    xTaskResumeAll();
+#endif /* HEAP_PROFILE_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_profile_print
+********************************************************************************
+* Summary:
+* Logs the allocations of every site and the size class histogram. The site
+* addresses are return addresses; arm-none-eabi-addr2line resolves them to
+* source lines.
+*
+*******************************************************************************/
+void heap_profile_print(void)
+{
+#if(HEAP_PROFILE_ENABLED)
+    static heap_profile_site_t site_copy[HEAP_PROFILE_MAX_SITES];
+    uint32_t classes[HEAP_PROFILE_SIZE_CLASSES];
+    uint32_t count;
+    uint32_t totals[5];
+
+    vTaskSuspendAll();
+
+    taskENTER_CRITICAL();
+    count = site_count;
+    memcpy(site_copy, sites, sizeof(site_copy));
+    memcpy(classes, size_classes, sizeof(classes));
+    totals[0] = live_bytes;
+    totals[1] = peak_bytes;
+    totals[2] = live_count;
+    totals[3] = untracked_allocs;
+    totals[4] = unknown_frees;
+    taskEXIT_CRITICAL();
+
+    APP_LOG_INFO("Heap profile: %"PRIuPTR" bytes live in %"PRIuPTR" allocations, peak %"PRIuPTR" bytes",
+                 totals[0], totals[2], totals[1]);
+    APP_LOG_INFO("  %"PRIuPTR" allocations untracked, %"PRIuPTR" unknown frees", totals[3], totals[4]);
+    APP_LOG_INFO("  Site                 allocs      frees       live       peak");
+    for(uint32_t i = 0; i < count; i++)
+    {
+        if(site_copy[i].allocs > 0)
+        {
+            APP_LOG_INFO("  %-18p %8"PRIuPTR" %10"PRIuPTR" %10"PRIuPTR" %10"PRIuPTR,
+                         APP_LOG_PTR(site_copy[i].site), site_copy[i].allocs, site_copy[i].frees,
+                         site_copy[i].live_bytes, site_copy[i].peak_bytes);
+        }
+    }
+
+    APP_LOG_INFO("  Size class    allocs");
+    for(uint32_t i = 0; i < HEAP_PROFILE_SIZE_CLASSES; i++)
+    {
+        APP_LOG_INFO("  %s%6"PRIuPTR"  %8"PRIuPTR,
+                     APP_LOG_STR((i < (HEAP_PROFILE_SIZE_CLASSES - 1u)) ? "<= " : " > "),
+                     HEAP_PROFILE_MIN_CLASS_SIZE << ((i < (HEAP_PROFILE_SIZE_CLASSES - 1u)) ? i : (i - 1u)),
+                     classes[i]);
+    }
+
+    xTaskResumeAll();
+#endif /* HEAP_PROFILE_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_guard_arm
+********************************************************************************
+* Summary:
+* Starts counting the heap allocations. Called once the server listens: from
+* then on, the application itself allocates nothing, so every allocation
+* counted comes from a library, such as the socket of an accepted client.
+*
+*******************************************************************************/
+void heap_guard_arm(void)
+{
+#if(HEAP_GUARD_ENABLED)
+    guard_armed = true;
+#endif /* HEAP_GUARD_ENABLED */
+}
+
+/*******************************************************************************
+* Function Name: heap_guard_get
+********************************************************************************
+* Summary:
+* Returns the heap allocations counted since heap_guard_arm().
+*
+* Parameters:
+*  uintptr_t *first_site: Set to the return address of the first allocation
+*  call counted, 0 if none; may be NULL
+*
+* Return:
+*  uint32_t: Number of allocations, 0 without HEAP_GUARD_ENABLED
+*
+*******************************************************************************/
+uint32_t heap_guard_get(uintptr_t *first_site)
+{
+#if(HEAP_GUARD_ENABLED)
+    if(first_site != NULL)
+    {
+        *first_site = guard_first_site;
+    }
+
+    return __atomic_load_n(&guard_allocs, __ATOMIC_RELAXED);
+#else
+    if(first_site != NULL)
+    {
+        *first_site = 0;
+    }
+
+    return 0;
+#endif /* HEAP_GUARD_ENABLED */
+}
+
+#if(HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED)
+/*******************************************************************************
+* Function Name: __wrap_malloc
+********************************************************************************
+* Summary:
+* Allocates memory and records it against the call site.
+*
+*******************************************************************************/
+void *__wrap_malloc(size_t size)
+{
+    void *ptr;
+
+    ptr = heap_alloc(size, RETURN_ADDRESS());
+    record_alloc(ptr, size, RETURN_ADDRESS());
+
+    return ptr;
+}
+
+/*******************************************************************************
+* Function Name: __wrap_calloc
+********************************************************************************
+* Summary:
+* Allocates zeroed memory and records it against the call site.
+*
+*******************************************************************************/
+void *__wrap_calloc(size_t count, size_t size)
+{
+    void *ptr;
+
+    if((size != 0) && (count > (SIZE_MAX / size)))
+    {
+        return NULL;
+    }
+
+    ptr = mem_pool_malloc(count * size);
+    if(ptr == NULL)
+    {
+        guard_check(count * size, RETURN_ADDRESS());
+        ptr = tlsf_alloc(count * size);
+    }
+
+    if(ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+    else
+    {
+        ptr = __real_calloc(count, size);
+    }
+    record_alloc(ptr, count * size, RETURN_ADDRESS());
+
+    return ptr;
+}
+
+/*******************************************************************************
+* Function Name: __wrap_realloc
+********************************************************************************
+* Summary:
+* Resizes an allocation. The new block is recorded against the call site of
+* realloc(), the old one is released from its site. A pool block keeps its
+* place while the new size fits in it, and a TLSF block while it can shrink
+* or grow in place; they are otherwise copied to a new allocation, from a
+* pool or from the heap.
+*
+*******************************************************************************/
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    void *new_ptr;
+    size_t block_size;
+
+    if(ptr == NULL)
+    {
+        new_ptr = heap_alloc(size, RETURN_ADDRESS());
+        record_alloc(new_ptr, size, RETURN_ADDRESS());
+        return new_ptr;
+    }
+
+    block_size = heap_block_size(ptr);
+    if(block_size > 0)
+    {
+        if((size > 0) && heap_resize(ptr, size, block_size))
+        {
+            record_free(ptr);
+            record_alloc(ptr, size, RETURN_ADDRESS());
+            return ptr;
+        }
+
+        new_ptr = (size > 0) ? heap_alloc(size, RETURN_ADDRESS()) : NULL;
+        if((new_ptr == NULL) && (size > 0))
+        {
+            return NULL;
+        }
+        if(new_ptr != NULL)
+        {
+            memcpy(new_ptr, ptr, (size < block_size) ? size : block_size);
+        }
+        record_free(ptr);
+        heap_free(ptr);
+        record_alloc(new_ptr, size, RETURN_ADDRESS());
+
+        return new_ptr;
+    }
+
+    if(size > 0)
+    {
+        guard_check(size, RETURN_ADDRESS());
+    }
+    new_ptr = __real_realloc(ptr, size);
+
+    /* The old block stays allocated if realloc() fails. */
+    if((new_ptr != NULL) || (size == 0))
+    {
+        record_free(ptr);
+        record_alloc(new_ptr, size, RETURN_ADDRESS());
+    }
+
+    return new_ptr;
+}
+
+/*******************************************************************************
+* Function Name: __wrap_free
+********************************************************************************
+* Summary:
+* Releases an allocation from its site and frees it.
+*
+*******************************************************************************/
+void __wrap_free(void *ptr)
+{
+    /* Forget the block first; it may be reallocated once freed. */
+    record_free(ptr);
+    heap_free(ptr);
+}
+
+/*******************************************************************************
+* Function Name: __wrap_pvPortMalloc
+********************************************************************************
+* Summary:
+* The FreeRTOS allocator of heap_3.c, calling the real malloc(). Wrapping it
+* records the FreeRTOS objects against the function creating them, and not
+* all against pvPortMalloc(). The FreeRTOS objects live as long as the
+* program, so they are not taken from the pools.
+*
+*******************************************************************************/
+void *__wrap_pvPortMalloc(size_t size)
+{
+    void *ptr;
+
+    guard_check(size, RETURN_ADDRESS());
+
+    vTaskSuspendAll();
+    ptr = __real_malloc(size);
+    record_alloc(ptr, size, RETURN_ADDRESS());
+    traceMALLOC(ptr, size);
+    (void)xTaskResumeAll();
+
+#if(configUSE_MALLOC_FAILED_HOOK == 1)
+    if(ptr == NULL)
+    {
+        extern void vApplicationMallocFailedHook(void);
+        vApplicationMallocFailedHook();
+    }
+#endif /* configUSE_MALLOC_FAILED_HOOK */
+
+    return ptr;
+}
+
+/*******************************************************************************
+* Function Name: __wrap_vPortFree
+********************************************************************************
+* Summary:
+* The FreeRTOS deallocator of heap_3.c, calling the real free().
+*
+*******************************************************************************/
+void __wrap_vPortFree(void *ptr)
+{
+    if(ptr != NULL)
+    {
+        vTaskSuspendAll();
+        record_free(ptr);
+        __real_free(ptr);
+        traceFREE(ptr, 0);
+        (void)xTaskResumeAll();
+    }
+}
+
+/*******************************************************************************
+* Function Name: heap_alloc
+********************************************************************************
+* Summary:
+* Allocates from the pools if a size class can serve the request, else from
+* the TLSF heap or the newlib heap, counting the allocation for the guard.
+*
+* Parameters:
+*  size_t size: Requested size in bytes
+*  uintptr_t site: Return address of the allocation call
+*
+*******************************************************************************/
+static void *heap_alloc(size_t size, uintptr_t site)
+{
+    void *ptr = mem_pool_malloc(size);
+
+    if(ptr == NULL)
+    {
+        guard_check(size, site);
+        ptr = tlsf_alloc(size);
+    }
+
+    if(ptr == NULL)
+    {
+        ptr = __real_malloc(size);
+    }
+
+    return ptr;
+}
+
+/*******************************************************************************
+* Function Name: heap_free
+********************************************************************************
+* Summary:
+* Returns a block to its pool, to the TLSF heap, or to the newlib heap.
+*
+*******************************************************************************/
+static void heap_free(void *ptr)
+{
+    if((ptr != NULL) && !mem_pool_malloc_free(ptr) && !tlsf_free(ptr))
+    {
+        __real_free(ptr);
+    }
+}
+
+/*******************************************************************************
+* Function Name: heap_block_size
+********************************************************************************
+* Summary:
+* Returns the usable size of a pool or TLSF block, 0 if the pointer comes
+* from the newlib heap.
+*
+*******************************************************************************/
+static size_t heap_block_size(const void *ptr)
+{
+    size_t block_size = mem_pool_malloc_size(ptr);
+
+#if(HEAP_TLSF_ENABLED)
+    if((block_size == 0) && tlsf_heap_owns(&tlsf_heap, ptr))
+    {
+        block_size = tlsf_heap_block_size(ptr);
+    }
+#endif /* HEAP_TLSF_ENABLED */
+
+    return block_size;
+}
+
+/*******************************************************************************
+* Function Name: heap_resize
+********************************************************************************
+* Summary:
+* Resizes a pool or TLSF block in place, if it can be.
+*
+* Parameters:
+*  void *ptr: Block to resize
+*  size_t size: New size in bytes
+*  size_t block_size: Usable size of the block, see heap_block_size()
+*
+* Return:
+*  bool: false if the block must be moved
+*
+*******************************************************************************/
+static bool heap_resize(void *ptr, size_t size, size_t block_size)
+{
+#if(HEAP_TLSF_ENABLED)
+    bool resized;
+
+    if(tlsf_heap_owns(&tlsf_heap, ptr))
+    {
+        taskENTER_CRITICAL();
+        resized = tlsf_heap_resize(&tlsf_heap, ptr, size);
+        taskEXIT_CRITICAL();
+
+        return resized;
+    }
+#endif /* HEAP_TLSF_ENABLED */
+
+    return (size <= block_size);
+}
+
+/*******************************************************************************
+* Function Name: tlsf_alloc
+********************************************************************************
+* Summary:
+* Allocates from the TLSF heap, setting it up on the first call.
+*
+* Return:
+*  void *: Block, or NULL if the TLSF heap is full, or without
+*  HEAP_TLSF_ENABLED
+*
+*******************************************************************************/
+static void *tlsf_alloc(size_t size)
+{
+#if(HEAP_TLSF_ENABLED)
+    void *ptr = NULL;
+
+    taskENTER_CRITICAL();
+    if(tlsf_setup())
+    {
+        ptr = tlsf_heap_alloc(&tlsf_heap, size);
+    }
+    if(ptr == NULL)
+    {
+        tlsf_fallbacks++;
+    }
+    taskEXIT_CRITICAL();
+
+    return ptr;
+#else
+    (void)size;
+
+    return NULL;
+#endif /* HEAP_TLSF_ENABLED */
+}
+
+#if(HEAP_TLSF_ENABLED)
+/*******************************************************************************
+* Function Name: tlsf_setup
+********************************************************************************
+* Summary:
+* Sets up the TLSF heap on first use. Must be called in a critical section.
+*
+* Return:
+*  bool: false if the heap could not be set up
+*
+*******************************************************************************/
+static bool tlsf_setup(void)
+{
+    if(!tlsf_ready)
+    {
+        tlsf_ready = tlsf_heap_init(&tlsf_heap, tlsf_area, sizeof(tlsf_area));
+    }
+
+    return tlsf_ready;
+}
+#endif /* HEAP_TLSF_ENABLED */
+
+/*******************************************************************************
+* Function Name: tlsf_free
+********************************************************************************
+* Summary:
+* Returns a block to the TLSF heap.
+*
+* Return:
+*  bool: false if the pointer does not come from the TLSF heap, and was not
+*  released
+*
+*******************************************************************************/
+static bool tlsf_free(void *ptr)
+{
+#if(HEAP_TLSF_ENABLED)
+    if(tlsf_heap_owns(&tlsf_heap, ptr))
+    {
+        taskENTER_CRITICAL();
+        tlsf_heap_free(&tlsf_heap, ptr);
+        taskEXIT_CRITICAL();
+
+        return true;
+    }
+#endif /* HEAP_TLSF_ENABLED */
+
+    (void)ptr;
+
+    return false;
+}
+#endif /* HEAP_PROFILE_ENABLED || HEAP_GUARD_ENABLED || MEM_POOL_MALLOC_ENABLED || HEAP_TLSF_ENABLED */
+
+#if(HEAP_PROFILE_ENABLED)
+/*******************************************************************************
+* Function Name: find_site
+********************************************************************************
+* Summary:
+* Returns the index of a call site in the site table, adding it if needed.
+* Must be called in a critical section.
+*
+* Parameters:
+*  uintptr_t site: Return address of the allocation call
+*
+* Return:
+*  uint32_t: Index of the site, 0 if the table is full
+*
+*******************************************************************************/
+static uint32_t find_site(uintptr_t site)
+{
+    for(uint32_t i = 1; i < site_count; i++)
+    {
+        if(sites[i].site == site)
+        {
+            return i;
+        }
+    }
+
+    if(site_count >= HEAP_PROFILE_MAX_SITES)
+    {
+        return 0;
+    }
+
+    sites[site_count].site = site;
+
+    return site_count++;
+}
+
+/*******************************************************************************
+* Function Name: live_index
+********************************************************************************
+* Summary:
+* Returns the home entry of a pointer in the live allocation table
+* (Fibonacci hashing of the pointer without its alignment bits).
+*
+*******************************************************************************/
+static uint32_t live_index(uintptr_t ptr)
+{
+    return (((uint32_t)(ptr >> 3) * 2654435769u) >> 16) & LIVE_INDEX_MASK;
+}
+
+/*******************************************************************************
+* Function Name: record_alloc
+********************************************************************************
+* Summary:
+* Records an allocation against its call site.
+*
+* Parameters:
+*  void *ptr: Allocated block, NULL if the allocation failed
+*  size_t size: Requested size in bytes
+*  uintptr_t site: Return address of the allocation call
+*
+*******************************************************************************/
+static void record_alloc(void *ptr, size_t size, uintptr_t site)
+{
+    uint32_t index;
+    uint32_t site_index;
+    uint32_t size_class = 0;
+
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+    while((size > (HEAP_PROFILE_MIN_CLASS_SIZE << size_class)) &&
+          (size_class < (HEAP_PROFILE_SIZE_CLASSES - 1u)))
+    {
+        size_class++;
+    }
+
+    taskENTER_CRITICAL();
+
+    site_index = find_site(site);
+    sites[site_index].allocs++;
+    size_classes[size_class]++;
+
+    if(live_count < LIVE_TABLE_LIMIT)
+    {
+        index = live_index((uintptr_t)ptr);
+        while(live_blocks[index].ptr != 0)
+        {
+            index = (index + 1u) & LIVE_INDEX_MASK;
+        }
+        live_blocks[index].ptr = (uintptr_t)ptr;
+        live_blocks[index].size = (uint32_t)size;
+        live_blocks[index].site = site_index;
+        live_count++;
+
+        live_bytes += (uint32_t)size;
+        if(live_bytes > peak_bytes)
+        {
+            peak_bytes = live_bytes;
+        }
+        sites[site_index].live_bytes += (uint32_t)size;
+        if(sites[site_index].live_bytes > sites[site_index].peak_bytes)
+        {
+            sites[site_index].peak_bytes = sites[site_index].live_bytes;
+        }
+    }
+    else
+    {
+        untracked_allocs++;
+    }
+
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+* Function Name: record_free
+********************************************************************************
+* Summary:
+* Releases a block from the site that allocated it. The entry is removed from
+* the live allocation table by shifting back the entries after it that are
+* not in their home entry (linear probing deletion without tombstones).
+*
+* Parameters:
+*  void *ptr: Block being freed, may be NULL
+*
+*******************************************************************************/
+static void record_free(void *ptr)
+{
+    uint32_t index;
+    uint32_t next;
+    uint32_t home;
+    heap_profile_block_t *block;
+
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+
+    index = live_index((uintptr_t)ptr);
+    while((live_blocks[index].ptr != 0) && (live_blocks[index].ptr != (uintptr_t)ptr))
+    {
+        index = (index + 1u) & LIVE_INDEX_MASK;
+    }
+
+    block = &live_blocks[index];
+    if(block->ptr == 0)
+    {
+        unknown_frees++;
+        taskEXIT_CRITICAL();
+        return;
+    }
+
+    sites[block->site].frees++;
+    sites[block->site].live_bytes -= block->size;
+    live_bytes -= block->size;
+    live_count--;
+
+    next = index;
+    while(true)
+    {
+        live_blocks[index].ptr = 0;
+        do
+        {
+            next = (next + 1u) & LIVE_INDEX_MASK;
+            if(live_blocks[next].ptr == 0)
+            {
+                taskEXIT_CRITICAL();
+                return;
+            }
+            home = live_index(live_blocks[next].ptr);
+        }
+        /* The entry stays if its home lies cyclically in (index, next]. */
+        while(((next - home) & LIVE_INDEX_MASK) < ((next - index) & LIVE_INDEX_MASK));
+
+        live_blocks[index] = live_blocks[next];
+        index = next;
+    }
+}
+
+/*******************************************************************************
+* Function Name: find_phase
+********************************************************************************
+* Summary:
+* Returns the snapshot of a phase, NULL if there is none.
+*
+*******************************************************************************/
+static heap_profile_phase_t *find_phase(const char *name)
+{
+    for(uint32_t i = 0; i < HEAP_PROFILE_MAX_PHASES; i++)
+    {
+        if((phases[i].name != NULL) && (strcmp(phases[i].name, name) == 0))
+        {
+            return &phases[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: log_phase_diff
+********************************************************************************
+* Summary:
+* Logs the change of the live bytes in total and of every site that changed
+* between two snapshots.
+*
+*******************************************************************************/
+static void log_phase_diff(const heap_profile_phase_t *from, const heap_profile_phase_t *to)
+{
+    APP_LOG_INFO("Heap phase '%s': %"PRIuPTR" bytes in %"PRIuPTR" allocations, %+"PRIdPTR" bytes since '%s'",
+                 APP_LOG_STR(to->name), to->live_bytes, to->live_blocks,
+                 (int32_t)(to->live_bytes - from->live_bytes), APP_LOG_STR(from->name));
+
+    for(uint32_t i = 0; i < HEAP_PROFILE_MAX_SITES; i++)
+    {
+        if(to->site_live[i] != from->site_live[i])
+        {
+            APP_LOG_INFO("  site %p: %+"PRIdPTR" bytes, %"PRIuPTR" live",
+                         APP_LOG_PTR(sites[i].site), (int32_t)(to->site_live[i] - from->site_live[i]),
+                         to->site_live[i]);
+        }
+    }
+}
+#endif /* HEAP_PROFILE_ENABLED */
+
+#if(HEAP_GUARD_ENABLED)
+/*******************************************************************************
+* Function Name: guard_check
+********************************************************************************
+* Summary:
+* Counts an allocation made after heap_guard_arm(). The first one is logged
+* with its call site; with HEAP_GUARD_TRAP the program stops on it instead,
+* with the site in guard_first_site for the debugger.
+*
+* Parameters:
+*  size_t size: Requested size in bytes
+*  uintptr_t site: Return address of the allocation call
+*
+*******************************************************************************/
+static void guard_check(size_t size, uintptr_t site)
+{
+    if(!guard_armed)
+    {
+        return;
+    }
+
+    if(__atomic_fetch_add(&guard_allocs, 1u, __ATOMIC_RELAXED) == 0)
+    {
+        guard_first_site = site;
+#if(HEAP_GUARD_TRAP)
+        CY_ASSERT(0);
+#endif /* HEAP_GUARD_TRAP */
+        APP_LOG_WARNING("Heap allocation of %"PRIuPTR" bytes after the server started listening, from %p",
+                        size, APP_LOG_PTR(site));
+    }
 }
+#endif /* HEAP_GUARD_ENABLED */
 
 /* [] END OF FILE */
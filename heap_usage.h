@@ -0,0 +1,121 @@
+/******************************************************************************
+* File Name:   heap_usage.h
+*
+* Description: This file contains declaration of the heap usage report, of
+* the allocation-site heap profiler, of the heap guard and of the TLSF heap
+* backend.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef HEAP_USAGE_H_
+#define HEAP_USAGE_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 1 to profile the heap by allocation site. 'make HEAP_PROFILE=1' sets
+ * it and wraps malloc(), calloc(), realloc(), free(), pvPortMalloc(), and
+ * vPortFree() with the linker, which the profiler needs.
+ */
+#ifndef HEAP_PROFILE_ENABLED
+#define HEAP_PROFILE_ENABLED                      (0)
+#endif
+
+/* Set to 1 to count the heap allocations made once the server listens.
+ * 'make STATIC_ALLOC=1' sets it, with the allocator functions wrapped as for
+ * the profiler. Set HEAP_GUARD_TRAP to 1 as well to stop on the first one.
+ */
+#ifndef HEAP_GUARD_ENABLED
+#define HEAP_GUARD_ENABLED                        (0)
+#endif
+
+#ifndef HEAP_GUARD_TRAP
+#define HEAP_GUARD_TRAP                           (0)
+#endif
+
+/* Set to 1, e.g. with 'make TLSF=1', to serve malloc() from a TLSF heap of
+ * HEAP_TLSF_SIZE bytes reserved at build time, ahead of the newlib heap. The
+ * make variable wraps the allocator functions as for the profiler. The
+ * allocations the TLSF heap cannot serve fall back to newlib, and are
+ * counted.
+ */
+#ifndef HEAP_TLSF_ENABLED
+#define HEAP_TLSF_ENABLED                         (0)
+#endif
+
+#ifndef HEAP_TLSF_SIZE
+#define HEAP_TLSF_SIZE                            (64u * 1024u)
+#endif
+
+/* Number of allocation sites told apart. Allocations from further sites are
+ * recorded under site 0.
+ */
+#ifndef HEAP_PROFILE_MAX_SITES
+#define HEAP_PROFILE_MAX_SITES                    (32u)
+#endif
+
+/* Number of live allocations tracked. Must be a power of two. The table is
+ * kept at most 3/4 full; allocations beyond that are counted as untracked.
+ */
+#ifndef HEAP_PROFILE_MAX_LIVE
+#define HEAP_PROFILE_MAX_LIVE                     (256u)
+#endif
+
+/* Number of named phase snapshots kept. */
+#ifndef HEAP_PROFILE_MAX_PHASES
+#define HEAP_PROFILE_MAX_PHASES                   (8u)
+#endif
+
+/* Size classes of the allocation histogram: up to 16, 32, ..., 2048 bytes,
+ * and larger.
+ */
+#define HEAP_PROFILE_SIZE_CLASSES                 (9u)
+#define HEAP_PROFILE_MIN_CLASS_SIZE               (16u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Allocations made from one call site. */
+typedef struct
+{
+    uintptr_t site;                     /* Return address of the allocation call. */
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+} heap_profile_site_t;
+
+/* Free memory of the heap serving malloc(). */
+typedef struct
+{
+    uint32_t free_bytes;
+    uint32_t free_blocks;
+    uint32_t largest_free;              /* 0 with newlib, which does not report it. */
+    uint32_t fallbacks;                 /* Allocations the TLSF heap passed to newlib. */
+} heap_free_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void print_heap_usage(char *msg);
+void heap_usage_get(uint32_t *in_use, uint32_t *arena);
+void heap_usage_get_free(heap_free_stats_t *stats);
+
+/* Allocation-site heap profiler, see HEAP_PROFILE_ENABLED. */
+void heap_profile_phase(const char *name);
+void heap_profile_diff(const char *from, const char *to);
+void heap_profile_print(void);
+
+/* Heap guard, see HEAP_GUARD_ENABLED. */
+void heap_guard_arm(void);
+uint32_t heap_guard_get(uintptr_t *first_site);
+
+#endif /* HEAP_USAGE_H_ */
@@ -0,0 +1,71 @@
+/******************************************************************************
+* File Name:   FreeRTOS.h
+*
+* Description: Host build stand-in for the FreeRTOS kernel. Tasks, timers,
+* queues and semaphores are implemented on top of POSIX threads; task
+* priorities are recorded but scheduling is left to the host OS.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Application specific configuration. */
+#include "FreeRTOSConfig.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint16_t configSTACK_DEPTH_TYPE;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                                   ((BaseType_t)0)
+#define pdTRUE                                    ((BaseType_t)1)
+#define pdPASS                                    (pdTRUE)
+#define pdFAIL                                    (pdFALSE)
+#define errQUEUE_EMPTY                            ((BaseType_t)0)
+#define errQUEUE_FULL                             ((BaseType_t)0)
+
+#define portMAX_DELAY                             ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS                        ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)                         ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(x)                     ((void)(x))
+#define portEND_SWITCHING_ISR(x)                  ((void)(x))
+
+/* Critical sections are a process-wide recursive lock. */
+void host_rtos_enter_critical(void);
+void host_rtos_exit_critical(void);
+
+#define taskENTER_CRITICAL()                      host_rtos_enter_critical()
+#define taskEXIT_CRITICAL()                       host_rtos_exit_critical()
+#define taskENTER_CRITICAL_FROM_ISR()             (host_rtos_enter_critical(), (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)             ((void)(x), host_rtos_exit_critical())
+#define taskDISABLE_INTERRUPTS()                  do { } while(0)
+#define taskENABLE_INTERRUPTS()                   do { } while(0)
+
+/* Trace hooks. */
+#ifndef traceMALLOC
+#define traceMALLOC(addr, size)
+#endif
+#ifndef traceFREE
+#define traceFREE(addr, size)
+#endif
+
+/* Static allocation buffers; the host build only needs them to be large
+ * enough to hold the object handles.
+ */
+typedef struct { void *dummy[32]; } StaticTask_t;
+typedef struct { void *dummy[32]; } StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+typedef struct { void *dummy[32]; } StaticTimer_t;
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,27 @@
+/******************************************************************************
+* File Name:   cy_result.h
+*
+* Description: Host build stand-in for the ModusToolbox result type.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_RESULT_H_
+#define CY_RESULT_H_
+
+#include <stdint.h>
+
+typedef uint32_t cy_rslt_t;
+
+#define CY_RSLT_SUCCESS                           ((cy_rslt_t)0x00000000U)
+
+#define CY_RSLT_TYPE_INFO                         (0U)
+#define CY_RSLT_TYPE_WARNING                      (1U)
+#define CY_RSLT_TYPE_ERROR                        (2U)
+#define CY_RSLT_TYPE_FATAL                        (3U)
+
+#endif /* CY_RESULT_H_ */
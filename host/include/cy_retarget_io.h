@@ -0,0 +1,25 @@
+/******************************************************************************
+* File Name:   cy_retarget_io.h
+*
+* Description: Host build stand-in for retarget-io. Standard output is used as
+* the debug UART.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_RETARGET_IO_H_
+#define CY_RETARGET_IO_H_
+
+#include <stdio.h>
+
+#include "cyhal.h"
+
+#define CY_RETARGET_IO_BAUDRATE                   (115200)
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate);
+
+#endif /* CY_RETARGET_IO_H_ */
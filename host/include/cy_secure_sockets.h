@@ -0,0 +1,116 @@
+/******************************************************************************
+* File Name:   cy_secure_sockets.h
+*
+* Description: Host build stand-in for the subset of the secure sockets API
+* used by the application. Sockets map to BSD sockets; the connect, receive
+* and disconnect callbacks are called from one socket worker thread, like the
+* secure sockets library does on the target.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_SECURE_SOCKETS_H_
+#define CY_SECURE_SOCKETS_H_
+
+#include <stdint.h>
+
+#include "cy_result.h"
+
+typedef void *cy_socket_t;
+
+#define CY_SOCKET_INVALID_HANDLE                  ((cy_socket_t)NULL)
+
+typedef cy_rslt_t (*cy_socket_callback_t)(cy_socket_t socket_handle, void *arg);
+
+typedef struct cy_socket_opt_callback
+{
+    cy_socket_callback_t callback;
+    void *arg;
+} cy_socket_opt_callback_t;
+
+typedef enum
+{
+    CY_SOCKET_IP_VER_V4 = 4,
+    CY_SOCKET_IP_VER_V6 = 6
+} cy_socket_ip_version_t;
+
+typedef struct cy_socket_ip_address
+{
+    cy_socket_ip_version_t version;
+    union
+    {
+        uint32_t v4;
+        uint32_t v6[4];
+    } ip;
+} cy_socket_ip_address_t;
+
+typedef struct cy_socket_sockaddr
+{
+    uint16_t port;
+    cy_socket_ip_address_t ip_address;
+} cy_socket_sockaddr_t;
+
+/* Socket domain, type and protocol. */
+#define CY_SOCKET_DOMAIN_AF_INET                  (0x02)
+#define CY_SOCKET_TYPE_STREAM                     (0x01)
+#define CY_SOCKET_IPPROTO_TCP                     (0x01)
+
+/* Socket option levels. */
+#define CY_SOCKET_SOL_SOCKET                      (1)
+#define CY_SOCKET_SOL_TCP                         (2)
+#define CY_SOCKET_SOL_TLS                         (3)
+
+/* Socket options. */
+#define CY_SOCKET_SO_RCVTIMEO                     (0)
+#define CY_SOCKET_SO_SNDTIMEO                     (1)
+#define CY_SOCKET_SO_NONBLOCK                     (2)
+#define CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE         (3)
+#define CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL       (4)
+#define CY_SOCKET_SO_TCP_KEEPALIVE_COUNT          (5)
+#define CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME      (6)
+#define CY_SOCKET_SO_RECEIVE_CALLBACK             (7)
+#define CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK     (8)
+#define CY_SOCKET_SO_DISCONNECT_CALLBACK          (9)
+#define CY_SOCKET_SO_TCP_NODELAY                  (10)
+#define CY_SOCKET_SO_BYTES_AVAILABLE              (11)
+#define CY_SOCKET_SO_REUSEADDR                    (12)
+
+/* Send and receive flags. */
+#define CY_SOCKET_FLAGS_NONE                      (0x0)
+
+/* Secure sockets error codes. */
+#define CY_RSLT_MODULE_SECURE_SOCKETS_BASE        ((cy_rslt_t)0x02000000U)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_BADARG      (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 2)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM       (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 4)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_OPTION_NOT_SUPPORTED (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 7)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 10)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_ADDRESS_IN_USE (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 12)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT     (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 13)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED      (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 15)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_WOULDBLOCK  (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 16)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_ERROR       (CY_RSLT_MODULE_SECURE_SOCKETS_BASE + 22)
+
+cy_rslt_t cy_socket_init(void);
+cy_rslt_t cy_socket_deinit(void);
+cy_rslt_t cy_socket_create(int domain, int type, int protocol, cy_socket_t *handle);
+cy_rslt_t cy_socket_setsockopt(cy_socket_t handle, int level, int optname,
+                               const void *optval, uint32_t optlen);
+cy_rslt_t cy_socket_getsockopt(cy_socket_t handle, int level, int optname,
+                               void *optval, uint32_t *optlen);
+cy_rslt_t cy_socket_bind(cy_socket_t handle, cy_socket_sockaddr_t *address,
+                         uint32_t address_length);
+cy_rslt_t cy_socket_listen(cy_socket_t handle, int backlog);
+cy_rslt_t cy_socket_accept(cy_socket_t handle, cy_socket_sockaddr_t *address,
+                           uint32_t *address_length, cy_socket_t *socket);
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *buffer, uint32_t length,
+                         int flags, uint32_t *bytes_sent);
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t length,
+                         int flags, uint32_t *bytes_received);
+cy_rslt_t cy_socket_disconnect(cy_socket_t handle, uint32_t timeout);
+cy_rslt_t cy_socket_delete(cy_socket_t handle);
+
+#endif /* CY_SECURE_SOCKETS_H_ */
@@ -0,0 +1,31 @@
+/******************************************************************************
+* File Name:   cy_utils.h
+*
+* Description: Host build stand-in for the ModusToolbox utility macros.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_UTILS_H_
+#define CY_UTILS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cy_result.h"
+
+#define CY_UNUSED_PARAMETER(x)                    ((void)(x))
+
+#define CY_HALT()                                 abort()
+
+#define CY_ASSERT(x)                              do { if(!(x)) { \
+                                                      fprintf(stderr, "CY_ASSERT failed: %s:%d\n", __FILE__, __LINE__); \
+                                                      CY_HALT(); } } while(0)
+
+#define CY_NOINIT                                 __attribute__((section(".noinit")))
+
+#endif /* CY_UTILS_H_ */
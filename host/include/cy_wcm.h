@@ -0,0 +1,96 @@
+/******************************************************************************
+* File Name:   cy_wcm.h
+*
+* Description: Host build stand-in for the Wi-Fi connection manager. Joining
+* an AP or starting a Soft AP succeeds immediately and reports the host
+* address selected with HOST_SIM_IP (127.0.0.1 by default).
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_WCM_H_
+#define CY_WCM_H_
+
+#include <stdint.h>
+
+#include "cy_result.h"
+#include "cy_wcm_error.h"
+
+#define CY_WCM_MAX_SSID_LEN                       (32)
+#define CY_WCM_MAX_PASSPHRASE_LEN                 (64)
+
+typedef enum
+{
+    CY_WCM_INTERFACE_TYPE_STA = 0,
+    CY_WCM_INTERFACE_TYPE_AP,
+    CY_WCM_INTERFACE_TYPE_AP_STA
+} cy_wcm_interface_t;
+
+typedef enum
+{
+    CY_WCM_SECURITY_OPEN = 0,
+    CY_WCM_SECURITY_WPA2_AES_PSK,
+    CY_WCM_SECURITY_WPA3_SAE
+} cy_wcm_security_t;
+
+typedef enum
+{
+    CY_WCM_IP_VER_V4 = 4,
+    CY_WCM_IP_VER_V6 = 6
+} cy_wcm_ip_version_t;
+
+typedef struct
+{
+    cy_wcm_interface_t interface;
+} cy_wcm_config_t;
+
+typedef struct
+{
+    cy_wcm_ip_version_t version;
+    union
+    {
+        uint32_t v4;
+        uint32_t v6[4];
+    } ip;
+} cy_wcm_ip_address_t;
+
+typedef struct
+{
+    uint8_t SSID[CY_WCM_MAX_SSID_LEN + 1];
+    uint8_t password[CY_WCM_MAX_PASSPHRASE_LEN + 1];
+    cy_wcm_security_t security;
+} cy_wcm_ap_credentials_t;
+
+typedef struct
+{
+    cy_wcm_ap_credentials_t ap_credentials;
+    uint8_t BSSID[6];
+    void *static_ip_settings;
+    uint32_t band;
+} cy_wcm_connect_params_t;
+
+typedef struct
+{
+    cy_wcm_ip_address_t ip_address;
+    cy_wcm_ip_address_t gateway;
+    cy_wcm_ip_address_t netmask;
+} cy_wcm_ip_setting_t;
+
+typedef struct
+{
+    cy_wcm_ap_credentials_t ap_credentials;
+    uint8_t channel;
+    cy_wcm_ip_setting_t ip_settings;
+    void *ie_info;
+} cy_wcm_ap_config_t;
+
+cy_rslt_t cy_wcm_init(cy_wcm_config_t *config);
+cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params,
+                            cy_wcm_ip_address_t *ip_addr);
+cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config);
+
+#endif /* CY_WCM_H_ */
@@ -0,0 +1,23 @@
+/******************************************************************************
+* File Name:   cy_wcm_error.h
+*
+* Description: Host build stand-in for the Wi-Fi connection manager error
+* codes.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CY_WCM_ERROR_H_
+#define CY_WCM_ERROR_H_
+
+#include "cy_result.h"
+
+#define CY_RSLT_WCM_ERR_BASE                      ((cy_rslt_t)0x04000000U)
+#define CY_RSLT_WCM_BAD_SSID_LEN                  (CY_RSLT_WCM_ERR_BASE + 13)
+#define CY_RSLT_WCM_BAD_PASSPHRASE_LEN            (CY_RSLT_WCM_ERR_BASE + 14)
+
+#endif /* CY_WCM_ERROR_H_ */
@@ -0,0 +1,31 @@
+/******************************************************************************
+* File Name:   cybsp.h
+*
+* Description: Host build stand-in for the CYW943907AEVAL1F board support
+* package.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CYBSP_H_
+#define CYBSP_H_
+
+#include "cyhal.h"
+
+#define CYBSP_SW1                                 ((cyhal_gpio_t)1)
+#define CYBSP_USER_LED                            ((cyhal_gpio_t)2)
+#define CYBSP_DEBUG_UART_TX                       ((cyhal_gpio_t)3)
+#define CYBSP_DEBUG_UART_RX                       ((cyhal_gpio_t)4)
+
+#define CYBSP_BTN_OFF                             (1U)
+#define CYBSP_BTN_PRESSED                         (0U)
+#define CYBSP_LED_STATE_ON                        (0U)
+#define CYBSP_LED_STATE_OFF                       (1U)
+
+cy_rslt_t cybsp_init(void);
+
+#endif /* CYBSP_H_ */
@@ -0,0 +1,74 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: Host build stand-in for the subset of the HAL GPIO driver used
+* by the application. The user button is simulated, see host_sim.h.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef CYHAL_H_
+#define CYHAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_result.h"
+#include "cy_utils.h"
+
+typedef uint32_t cyhal_gpio_t;
+
+typedef enum
+{
+    CYHAL_GPIO_DIR_INPUT,
+    CYHAL_GPIO_DIR_OUTPUT,
+    CYHAL_GPIO_DIR_BIDIRECTIONAL
+} cyhal_gpio_direction_t;
+
+typedef enum
+{
+    CYHAL_GPIO_DRIVE_NONE,
+    CYHAL_GPIO_DRIVE_ANALOG,
+    CYHAL_GPIO_DRIVE_PULLUP,
+    CYHAL_GPIO_DRIVE_PULLDOWN,
+    CYHAL_GPIO_DRIVE_OPENDRAINDRIVESLOW,
+    CYHAL_GPIO_DRIVE_OPENDRAINDRIVESHIGH,
+    CYHAL_GPIO_DRIVE_STRONG,
+    CYHAL_GPIO_DRIVE_PULLUPDOWN
+} cyhal_gpio_drive_mode_t;
+
+typedef enum
+{
+    CYHAL_GPIO_IRQ_NONE = 0,
+    CYHAL_GPIO_IRQ_RISE = 1 << 0,
+    CYHAL_GPIO_IRQ_FALL = 1 << 1,
+    CYHAL_GPIO_IRQ_BOTH = (1 << 0) | (1 << 1)
+} cyhal_gpio_event_t;
+
+typedef void (*cyhal_gpio_event_callback_t)(void *callback_arg, cyhal_gpio_event_t event);
+
+typedef struct cyhal_gpio_callback_data_s
+{
+    cyhal_gpio_event_callback_t callback;
+    void *callback_arg;
+    struct cyhal_gpio_callback_data_s *next;
+    cyhal_gpio_t pin;
+} cyhal_gpio_callback_data_t;
+
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction,
+                          cyhal_gpio_drive_mode_t drive_mode, bool init_val);
+void cyhal_gpio_free(cyhal_gpio_t pin);
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value);
+bool cyhal_gpio_read(cyhal_gpio_t pin);
+void cyhal_gpio_register_callback(cyhal_gpio_t pin, cyhal_gpio_callback_data_t *callback_data);
+void cyhal_gpio_enable_event(cyhal_gpio_t pin, cyhal_gpio_event_t event,
+                             uint8_t intr_priority, bool enable);
+
+#define __enable_irq()                            do { } while(0)
+#define __disable_irq()                           do { } while(0)
+
+#endif /* CYHAL_H_ */
@@ -0,0 +1,27 @@
+/******************************************************************************
+* File Name:   host_sim.h
+*
+* Description: Control interface of the host build. Lets a test or benchmark
+* drive the simulated user button.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+#include <stdint.h>
+
+/* Presses and releases the simulated user button. The falling edge interrupt
+ * callback runs on the simulated interrupt thread.
+ */
+void host_sim_button_press(void);
+
+/* Milliseconds since the simulation started. */
+uint32_t host_sim_time_ms(void);
+
+#endif /* HOST_SIM_H_ */
@@ -0,0 +1,29 @@
+/******************************************************************************
+* File Name:   ip_addr.h
+*
+* Description: Host build stand-in for the lwIP IPv4 address helpers used by
+* the application.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef IP_ADDR_H_
+#define IP_ADDR_H_
+
+#include <stdint.h>
+
+typedef uint32_t u32_t;
+
+/* IPv4 address in network byte order, as in lwIP. */
+typedef struct ip4_addr
+{
+    u32_t addr;
+} ip4_addr_t;
+
+char *ip4addr_ntoa(const ip4_addr_t *addr);
+
+#endif /* IP_ADDR_H_ */
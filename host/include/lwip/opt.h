@@ -0,0 +1,21 @@
+/******************************************************************************
+* File Name:   opt.h
+*
+* Description: Host build stand-in for the lwIP options. There is no lwIP in
+* the host build, so its statistics are off.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef LWIP_HDR_OPT_H
+#define LWIP_HDR_OPT_H
+
+#define LWIP_STATS                                0
+#define MEM_STATS                                 0
+#define MEMP_STATS                                0
+
+#endif /* LWIP_HDR_OPT_H */
@@ -0,0 +1,37 @@
+/******************************************************************************
+* File Name:   malloc.h
+*
+* Description: Host build stand-in for the newlib mallinfo() used by the
+* application. glibc deprecates mallinfo() for mallinfo2(), whose fields do
+* not overflow; the application gets the newlib layout filled from it.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef HOST_MALLOC_H_
+#define HOST_MALLOC_H_
+
+#include_next <malloc.h>
+
+static inline struct mallinfo host_mallinfo(void)
+{
+    struct mallinfo2 info2 = mallinfo2();
+    struct mallinfo info = { 0 };
+
+    info.arena = (int)info2.arena;
+    info.ordblks = (int)info2.ordblks;
+    info.hblkhd = (int)info2.hblkhd;
+    info.uordblks = (int)info2.uordblks;
+    info.fordblks = (int)info2.fordblks;
+    info.keepcost = (int)info2.keepcost;
+
+    return info;
+}
+
+#define mallinfo()                                host_mallinfo()
+
+#endif /* HOST_MALLOC_H_ */
@@ -0,0 +1,18 @@
+/******************************************************************************
+* File Name:   platform_config.h
+*
+* Description: Host build stand-in for the CYW43907 platform configuration.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef PLATFORM_CONFIG_H_
+#define PLATFORM_CONFIG_H_
+
+#define PLATFORM_APPSCR4_REGBASE(offset)          (offset)
+
+#endif /* PLATFORM_CONFIG_H_ */
@@ -0,0 +1,32 @@
+/******************************************************************************
+* File Name:   queue.h
+*
+* Description: Host build stand-in for the FreeRTOS queue API.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *queue_buffer);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+
+#define xQueueSendToBack(q, item, ticks)          xQueueSend((q), (item), (ticks))
+#define xQueueSendFromISR(q, item, woken)         ((void)(woken), xQueueSend((q), (item), 0))
+#define vQueueSetQueueNumber(q, number)           ((void)(q), (void)(number))
+
+#endif /* INC_QUEUE_H */
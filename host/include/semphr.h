@@ -0,0 +1,47 @@
+/******************************************************************************
+* File Name:   semphr.h
+*
+* Description: Host build stand-in for the FreeRTOS semaphore API.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+typedef struct host_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t host_sem_create(int recursive, UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t host_sem_take(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t host_sem_give(SemaphoreHandle_t sem);
+void host_sem_delete(SemaphoreHandle_t sem);
+
+/* The host semaphores are always allocated; the static buffer is unused. */
+static inline SemaphoreHandle_t host_sem_create_static(StaticSemaphore_t *buffer, int recursive,
+                                                       UBaseType_t max_count, UBaseType_t initial_count)
+{
+    (void)buffer;
+    return host_sem_create(recursive, max_count, initial_count);
+}
+
+#define xSemaphoreCreateMutex()                   host_sem_create(0, 1, 1)
+#define xSemaphoreCreateRecursiveMutex()          host_sem_create(1, 1, 1)
+#define xSemaphoreCreateBinary()                  host_sem_create(0, 1, 0)
+#define xSemaphoreCreateCounting(max, init)       host_sem_create(0, (max), (init))
+#define xSemaphoreCreateMutexStatic(buf)          host_sem_create_static((buf), 0, 1, 1)
+#define xSemaphoreCreateRecursiveMutexStatic(buf) host_sem_create_static((buf), 1, 1, 1)
+#define xSemaphoreCreateBinaryStatic(buf)         host_sem_create_static((buf), 0, 1, 0)
+#define xSemaphoreTake(sem, ticks)                host_sem_take((sem), (ticks))
+#define xSemaphoreGive(sem)                       host_sem_give(sem)
+#define xSemaphoreTakeRecursive(sem, ticks)       host_sem_take((sem), (ticks))
+#define xSemaphoreGiveRecursive(sem)              host_sem_give(sem)
+#define xSemaphoreGiveFromISR(sem, woken)         ((void)(woken), host_sem_give(sem))
+#define vSemaphoreDelete(sem)                     host_sem_delete(sem)
+
+#endif /* SEMAPHORE_H */
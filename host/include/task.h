@@ -0,0 +1,101 @@
+/******************************************************************************
+* File Name:   task.h
+*
+* Description: Host build stand-in for the FreeRTOS task API.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum
+{
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef struct xTASK_STATUS
+{
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;
+} TaskStatus_t;
+
+#define tskIDLE_PRIORITY                          ((UBaseType_t)0U)
+
+#define taskSCHEDULER_SUSPENDED                   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED                 ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING                     ((BaseType_t)2)
+
+#define taskYIELD()                               host_rtos_yield()
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name,
+                       configSTACK_DEPTH_TYPE stack_depth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created_task);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t task_code, const char *name,
+                               uint32_t stack_depth, void *params,
+                               UBaseType_t priority, StackType_t *stack_buffer,
+                               StaticTask_t *task_buffer);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake_time, TickType_t time_increment);
+void vTaskStartScheduler(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status_array, UBaseType_t array_size,
+                                 uint32_t *total_run_time);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+UBaseType_t uxTaskGetTaskNumber(TaskHandle_t task);
+void vTaskSetTaskNumber(TaskHandle_t task, UBaseType_t number);
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              uint32_t *previous_value);
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit,
+                           uint32_t *notification_value, TickType_t ticks_to_wait);
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+#define xTaskNotify(task, value, action)          xTaskGenericNotify((task), (value), (action), NULL)
+#define xTaskNotifyGive(task)                     xTaskGenericNotify((task), 0, eIncrement, NULL)
+#define xTaskNotifyFromISR(task, value, action, woken) \
+                                                  (((void)(woken)), xTaskGenericNotify((task), (value), (action), NULL))
+#define vTaskNotifyGiveFromISR(task, woken)       ((void)(woken), (void)xTaskGenericNotify((task), 0, eIncrement, NULL))
+
+void host_rtos_yield(void);
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,45 @@
+/******************************************************************************
+* File Name:   timers.h
+*
+* Description: Host build stand-in for the FreeRTOS software timer API. All
+* timer callbacks run on one timer service thread, as in FreeRTOS.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct host_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+typedef void (*PendedFunction_t)(void *, uint32_t);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *timer_id, TimerCallbackFunction_t callback);
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t auto_reload,
+                                 void *timer_id, TimerCallbackFunction_t callback,
+                                 StaticTimer_t *timer_buffer);
+BaseType_t host_timer_start(TimerHandle_t timer, TickType_t period);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void *pvTimerGetTimerID(TimerHandle_t timer);
+BaseType_t xTimerPendFunctionCall(PendedFunction_t function, void *param1,
+                                  uint32_t param2, TickType_t ticks_to_wait);
+
+#define xTimerStart(t, ticks)                     ((void)(ticks), host_timer_start((t), 0))
+#define xTimerReset(t, ticks)                     ((void)(ticks), host_timer_start((t), 0))
+#define xTimerChangePeriod(t, period, ticks)      ((void)(ticks), host_timer_start((t), (period)))
+#define xTimerStartFromISR(t, woken)              ((void)(woken), host_timer_start((t), 0))
+#define xTimerResetFromISR(t, woken)              ((void)(woken), host_timer_start((t), 0))
+#define xTimerStopFromISR(t, woken)               ((void)(woken), xTimerStop((t), 0))
+#define xTimerPendFunctionCallFromISR(f, p1, p2, woken) \
+                                                  ((void)(woken), xTimerPendFunctionCall((f), (p1), (p2), 0))
+
+#endif /* TIMERS_H */
@@ -0,0 +1,968 @@
+/******************************************************************************
+* File Name:   freertos_posix.c
+*
+* Description: Host build implementation of the FreeRTOS primitives used by
+* the application, on top of POSIX threads. Each task is a thread; tasks
+* created before vTaskStartScheduler() wait until it is called.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+
+#include "host_sim.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t code;
+    void *params;
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    UBaseType_t number;
+    UBaseType_t trace_number;           /* Set by vTaskSetTaskNumber(). */
+    uint32_t stack_depth;
+
+    /* Task notification state. */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct host_sem
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int recursive;
+    UBaseType_t count;
+    UBaseType_t max_count;
+    pthread_t owner;
+    UBaseType_t depth;
+};
+
+struct host_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct host_timer
+{
+    struct host_timer *next;
+    const char *name;
+    TickType_t period;
+    UBaseType_t auto_reload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    bool active;
+    TickType_t expiry;
+};
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+#define HOST_MAX_TASKS                            (32)
+
+static struct host_task *task_list[HOST_MAX_TASKS];
+static UBaseType_t task_count;
+static __thread struct host_task *current_task;
+
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_cond = PTHREAD_COND_INITIALIZER;
+static bool scheduler_running;
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond = PTHREAD_COND_INITIALIZER;
+static struct host_timer *timer_list;
+static bool timer_thread_started;
+
+static struct timespec start_time;
+static pthread_once_t start_time_once = PTHREAD_ONCE_INIT;
+
+/*******************************************************************************
+* Time
+********************************************************************************/
+static void init_start_time(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+uint32_t host_sim_time_ms(void)
+{
+    struct timespec now;
+
+    pthread_once(&start_time_once, init_start_time);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec - start_time.tv_sec) * 1000 +
+                      (now.tv_nsec - start_time.tv_nsec) / 1000000);
+}
+
+static void abs_deadline(struct timespec *ts, TickType_t ticks)
+{
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += (time_t)(ms / 1000);
+    ts->tv_nsec += (long)((ms % 1000) * 1000000);
+    if(ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void init_cond(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/* Waits on a condition for at most 'ticks'. Returns false on timeout. */
+static bool cond_wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock,
+                            const struct timespec *deadline, TickType_t ticks)
+{
+    if(ticks == portMAX_DELAY)
+    {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_sim_time_ms() / portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+/*******************************************************************************
+* Critical sections
+********************************************************************************/
+static void init_critical_lock(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void host_rtos_enter_critical(void)
+{
+    pthread_once(&critical_once, init_critical_lock);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void host_rtos_exit_critical(void)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+void vTaskSuspendAll(void)
+{
+    host_rtos_enter_critical();
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    host_rtos_exit_critical();
+    return pdFALSE;
+}
+
+/* Provided by the SDK on the target; called when pvPortMalloc() fails. */
+void vApplicationMallocFailedHook(void)
+{
+    fprintf(stderr, "pvPortMalloc() failed: out of memory\n");
+    abort();
+}
+
+void host_rtos_yield(void)
+{
+    sched_yield();
+}
+
+/*******************************************************************************
+* Tasks
+********************************************************************************/
+static void *task_entry(void *arg)
+{
+    struct host_task *task = (struct host_task *)arg;
+
+    current_task = task;
+
+    pthread_mutex_lock(&sched_lock);
+    while(!scheduler_running)
+    {
+        pthread_cond_wait(&sched_cond, &sched_lock);
+    }
+    pthread_mutex_unlock(&sched_lock);
+
+    task->code(task->params);
+
+    return NULL;
+}
+
+static struct host_task *task_new(TaskFunction_t task_code, const char *name,
+                                  uint32_t stack_depth, void *params, UBaseType_t priority)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+
+    if(task == NULL)
+    {
+        return NULL;
+    }
+
+    task->code = task_code;
+    task->params = params;
+    task->priority = priority;
+    task->stack_depth = stack_depth;
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    pthread_mutex_init(&task->lock, NULL);
+    init_cond(&task->cond);
+
+    pthread_mutex_lock(&sched_lock);
+    task->number = ++task_count;
+    if(task_count <= HOST_MAX_TASKS)
+    {
+        task_list[task_count - 1] = task;
+    }
+    pthread_mutex_unlock(&sched_lock);
+
+    if(pthread_create(&task->thread, NULL, task_entry, task) != 0)
+    {
+        return NULL;
+    }
+    pthread_detach(task->thread);
+
+    return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name,
+                       configSTACK_DEPTH_TYPE stack_depth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created_task)
+{
+    struct host_task *task = task_new(task_code, name, stack_depth, params, priority);
+
+    if(created_task != NULL)
+    {
+        *created_task = task;
+    }
+
+    return (task != NULL) ? pdPASS : pdFAIL;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t task_code, const char *name,
+                               uint32_t stack_depth, void *params,
+                               UBaseType_t priority, StackType_t *stack_buffer,
+                               StaticTask_t *task_buffer)
+{
+    (void)stack_buffer;
+    (void)task_buffer;
+
+    return task_new(task_code, name, stack_depth, params, priority);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if((task == NULL) || (task == current_task))
+    {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts;
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)((ms % 1000) * 1000000);
+    while(nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake_time, TickType_t time_increment)
+{
+    TickType_t wake = *previous_wake_time + time_increment;
+    TickType_t now = xTaskGetTickCount();
+
+    if((int32_t)(wake - now) > 0)
+    {
+        vTaskDelay(wake - now);
+    }
+    *previous_wake_time = wake;
+}
+
+void vTaskStartScheduler(void)
+{
+    pthread_mutex_lock(&sched_lock);
+    scheduler_running = true;
+    pthread_cond_broadcast(&sched_cond);
+    pthread_mutex_unlock(&sched_lock);
+
+    /* The main thread takes the role of the idle task. */
+    for(;;)
+    {
+        pause();
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return scheduler_running ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    task = (task != NULL) ? task : current_task;
+    return (task != NULL) ? task->name : "main";
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    return task_count;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    /* Thread stacks are managed by the host OS. */
+    task = (task != NULL) ? task : current_task;
+    return (task != NULL) ? task->stack_depth : 0;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    task = (task != NULL) ? task : current_task;
+    return (task != NULL) ? task->priority : tskIDLE_PRIORITY;
+}
+
+UBaseType_t uxTaskGetTaskNumber(TaskHandle_t task)
+{
+    return (task != NULL) ? task->trace_number : 0;
+}
+
+void vTaskSetTaskNumber(TaskHandle_t task, UBaseType_t number)
+{
+    if(task != NULL)
+    {
+        task->trace_number = number;
+    }
+}
+
+static uint32_t thread_cpu_time_us(pthread_t thread)
+{
+    clockid_t clock;
+    struct timespec ts;
+
+    if((pthread_getcpuclockid(thread, &clock) != 0) || (clock_gettime(clock, &ts) != 0))
+    {
+        return 0;
+    }
+
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status_array, UBaseType_t array_size,
+                                 uint32_t *total_run_time)
+{
+    UBaseType_t n = 0;
+
+    pthread_mutex_lock(&sched_lock);
+    for(UBaseType_t i = 0; (i < task_count) && (i < HOST_MAX_TASKS) && (n < array_size); i++)
+    {
+        struct host_task *task = task_list[i];
+
+        memset(&status_array[n], 0, sizeof(status_array[n]));
+        status_array[n].xHandle = task;
+        status_array[n].pcTaskName = task->name;
+        status_array[n].xTaskNumber = task->number;
+        status_array[n].eCurrentState = eBlocked;
+        status_array[n].uxCurrentPriority = task->priority;
+        status_array[n].uxBasePriority = task->priority;
+        status_array[n].usStackHighWaterMark = (configSTACK_DEPTH_TYPE)task->stack_depth;
+        status_array[n].ulRunTimeCounter = thread_cpu_time_us(task->thread);
+        n++;
+    }
+    pthread_mutex_unlock(&sched_lock);
+
+    /* Run time is counted in microseconds: thread CPU time against wall time. */
+    if(total_run_time != NULL)
+    {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        *total_run_time = (uint32_t)((uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u);
+    }
+
+    return n;
+}
+
+/*******************************************************************************
+* Task notifications
+********************************************************************************/
+BaseType_t xTaskGenericNotify(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              uint32_t *previous_value)
+{
+    BaseType_t result = pdPASS;
+
+    pthread_mutex_lock(&task->lock);
+
+    if(previous_value != NULL)
+    {
+        *previous_value = task->notify_value;
+    }
+
+    switch(action)
+    {
+        case eSetBits:
+            task->notify_value |= value;
+            break;
+        case eIncrement:
+            task->notify_value++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notify_value = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if(task->notify_pending)
+            {
+                result = pdFAIL;
+            }
+            else
+            {
+                task->notify_value = value;
+            }
+            break;
+        case eNoAction:
+        default:
+            break;
+    }
+
+    task->notify_pending = true;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+
+    return result;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit,
+                           uint32_t *notification_value, TickType_t ticks_to_wait)
+{
+    struct host_task *task = current_task;
+    struct timespec deadline;
+    BaseType_t result = pdTRUE;
+
+    abs_deadline(&deadline, ticks_to_wait);
+    pthread_mutex_lock(&task->lock);
+
+    if(!task->notify_pending)
+    {
+        task->notify_value &= ~bits_to_clear_on_entry;
+    }
+
+    while(!task->notify_pending)
+    {
+        if((ticks_to_wait == 0) ||
+           !cond_wait_ticks(&task->cond, &task->lock, &deadline, ticks_to_wait))
+        {
+            break;
+        }
+    }
+
+    if(notification_value != NULL)
+    {
+        *notification_value = task->notify_value;
+    }
+
+    if(task->notify_pending)
+    {
+        task->notify_value &= ~bits_to_clear_on_exit;
+        task->notify_pending = false;
+    }
+    else
+    {
+        result = pdFALSE;
+    }
+
+    pthread_mutex_unlock(&task->lock);
+
+    return result;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task = current_task;
+    struct timespec deadline;
+    uint32_t value;
+
+    abs_deadline(&deadline, ticks_to_wait);
+    pthread_mutex_lock(&task->lock);
+
+    while(task->notify_value == 0)
+    {
+        if((ticks_to_wait == 0) ||
+           !cond_wait_ticks(&task->cond, &task->lock, &deadline, ticks_to_wait))
+        {
+            break;
+        }
+    }
+
+    value = task->notify_value;
+    if(value != 0)
+    {
+        task->notify_value = clear_count_on_exit ? 0 : value - 1;
+    }
+    task->notify_pending = false;
+
+    pthread_mutex_unlock(&task->lock);
+
+    return value;
+}
+
+/*******************************************************************************
+* Semaphores and mutexes
+********************************************************************************/
+SemaphoreHandle_t host_sem_create(int recursive, UBaseType_t max_count, UBaseType_t initial_count)
+{
+    struct host_sem *sem = calloc(1, sizeof(*sem));
+
+    if(sem != NULL)
+    {
+        pthread_mutex_init(&sem->lock, NULL);
+        init_cond(&sem->cond);
+        sem->recursive = recursive;
+        sem->max_count = max_count;
+        sem->count = initial_count;
+    }
+
+    return sem;
+}
+
+BaseType_t host_sem_take(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    BaseType_t result = pdTRUE;
+
+    abs_deadline(&deadline, ticks_to_wait);
+    pthread_mutex_lock(&sem->lock);
+
+    if(sem->recursive && (sem->depth > 0) && pthread_equal(sem->owner, pthread_self()))
+    {
+        sem->depth++;
+        pthread_mutex_unlock(&sem->lock);
+        return pdTRUE;
+    }
+
+    while(sem->count == 0)
+    {
+        if((ticks_to_wait == 0) ||
+           !cond_wait_ticks(&sem->cond, &sem->lock, &deadline, ticks_to_wait))
+        {
+            result = pdFALSE;
+            break;
+        }
+    }
+
+    if(result == pdTRUE)
+    {
+        sem->count--;
+        sem->owner = pthread_self();
+        sem->depth = 1;
+    }
+
+    pthread_mutex_unlock(&sem->lock);
+
+    return result;
+}
+
+BaseType_t host_sem_give(SemaphoreHandle_t sem)
+{
+    BaseType_t result = pdTRUE;
+
+    pthread_mutex_lock(&sem->lock);
+
+    if(sem->recursive && (sem->depth > 1))
+    {
+        sem->depth--;
+    }
+    else if(sem->count < sem->max_count)
+    {
+        sem->depth = 0;
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+    }
+    else
+    {
+        result = pdFALSE;
+    }
+
+    pthread_mutex_unlock(&sem->lock);
+
+    return result;
+}
+
+void host_sem_delete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->lock);
+    pthread_cond_destroy(&sem->cond);
+    free(sem);
+}
+
+/*******************************************************************************
+* Queues
+********************************************************************************/
+static QueueHandle_t queue_init(struct host_queue *queue, UBaseType_t length,
+                                UBaseType_t item_size, uint8_t *storage)
+{
+    pthread_mutex_init(&queue->lock, NULL);
+    init_cond(&queue->cond);
+    queue->storage = storage;
+    queue->length = length;
+    queue->item_size = item_size;
+
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+    uint8_t *storage = calloc(length, item_size);
+
+    if((queue == NULL) || (storage == NULL))
+    {
+        free(queue);
+        free(storage);
+        return NULL;
+    }
+
+    return queue_init(queue, length, item_size, storage);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *queue_buffer)
+{
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+
+    (void)queue_buffer;
+
+    return (queue != NULL) ? queue_init(queue, length, item_size, storage) : NULL;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    BaseType_t result = pdTRUE;
+
+    abs_deadline(&deadline, ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+
+    while(queue->count == queue->length)
+    {
+        if((ticks_to_wait == 0) ||
+           !cond_wait_ticks(&queue->cond, &queue->lock, &deadline, ticks_to_wait))
+        {
+            result = errQUEUE_FULL;
+            break;
+        }
+    }
+
+    if(result == pdTRUE)
+    {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+
+        memcpy(&queue->storage[tail * queue->item_size], item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return result;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    BaseType_t result = pdTRUE;
+
+    abs_deadline(&deadline, ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+
+    while(queue->count == 0)
+    {
+        if((ticks_to_wait == 0) ||
+           !cond_wait_ticks(&queue->cond, &queue->lock, &deadline, ticks_to_wait))
+        {
+            result = errQUEUE_EMPTY;
+            break;
+        }
+    }
+
+    if(result == pdTRUE)
+    {
+        memcpy(item, &queue->storage[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return result;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    UBaseType_t count;
+
+    pthread_mutex_lock(&queue->lock);
+    count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue);
+}
+
+/*******************************************************************************
+* Software timers
+********************************************************************************/
+static void *timer_service(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&timer_lock);
+
+    for(;;)
+    {
+        struct host_timer *due = NULL;
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+
+        for(struct host_timer *t = timer_list; t != NULL; t = t->next)
+        {
+            if(!t->active)
+            {
+                continue;
+            }
+            if((int32_t)(t->expiry - now) <= 0)
+            {
+                due = t;
+                break;
+            }
+            if((TickType_t)(t->expiry - now) < wait)
+            {
+                wait = t->expiry - now;
+            }
+        }
+
+        if(due != NULL)
+        {
+            if(due->auto_reload)
+            {
+                due->expiry += due->period;
+            }
+            else
+            {
+                due->active = false;
+            }
+
+            pthread_mutex_unlock(&timer_lock);
+            due->callback(due);
+            pthread_mutex_lock(&timer_lock);
+        }
+        else
+        {
+            struct timespec deadline;
+
+            abs_deadline(&deadline, wait);
+            cond_wait_ticks(&timer_cond, &timer_lock, &deadline, wait);
+        }
+    }
+
+    return NULL;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *timer_id, TimerCallbackFunction_t callback)
+{
+    struct host_timer *timer = calloc(1, sizeof(*timer));
+
+    if(timer == NULL)
+    {
+        return NULL;
+    }
+
+    timer->name = name;
+    timer->period = period;
+    timer->auto_reload = auto_reload;
+    timer->id = timer_id;
+    timer->callback = callback;
+
+    pthread_mutex_lock(&timer_lock);
+    if(!timer_thread_started)
+    {
+        pthread_t thread;
+
+        init_cond(&timer_cond);
+        pthread_create(&thread, NULL, timer_service, NULL);
+        pthread_detach(thread);
+        timer_thread_started = true;
+    }
+    timer->next = timer_list;
+    timer_list = timer;
+    pthread_mutex_unlock(&timer_lock);
+
+    return timer;
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t auto_reload,
+                                 void *timer_id, TimerCallbackFunction_t callback,
+                                 StaticTimer_t *timer_buffer)
+{
+    (void)timer_buffer;
+
+    return xTimerCreate(name, period, auto_reload, timer_id, callback);
+}
+
+BaseType_t host_timer_start(TimerHandle_t timer, TickType_t period)
+{
+    pthread_mutex_lock(&timer_lock);
+    if(period != 0)
+    {
+        timer->period = period;
+    }
+    timer->expiry = xTaskGetTickCount() + timer->period;
+    timer->active = true;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+
+    pthread_mutex_lock(&timer_lock);
+    timer->active = false;
+    pthread_mutex_unlock(&timer_lock);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    BaseType_t active;
+
+    pthread_mutex_lock(&timer_lock);
+    active = timer->active ? pdTRUE : pdFALSE;
+    pthread_mutex_unlock(&timer_lock);
+
+    return active;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+/* Pended function calls are run on their own detached thread. */
+struct pended_call
+{
+    PendedFunction_t function;
+    void *param1;
+    uint32_t param2;
+};
+
+static void *pended_call_entry(void *arg)
+{
+    struct pended_call call = *(struct pended_call *)arg;
+
+    free(arg);
+    call.function(call.param1, call.param2);
+
+    return NULL;
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t function, void *param1,
+                                  uint32_t param2, TickType_t ticks_to_wait)
+{
+    struct pended_call *call = malloc(sizeof(*call));
+    pthread_t thread;
+
+    (void)ticks_to_wait;
+
+    if(call == NULL)
+    {
+        return pdFAIL;
+    }
+
+    call->function = function;
+    call->param1 = param1;
+    call->param2 = param2;
+    if(pthread_create(&thread, NULL, pended_call_entry, call) != 0)
+    {
+        free(call);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+
+    return pdPASS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,222 @@
+/******************************************************************************
+* File Name:   hal_posix.c
+*
+* Description: Host build implementation of the board support package, the
+* GPIO driver, retarget-io and the lwIP address helpers. The user button is
+* simulated: it is pressed by host_sim_button_press(), by sending SIGUSR1 to
+* the process, or periodically when HOST_SIM_BUTTON_PERIOD_MS is set.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cybsp.h"
+#include "cy_retarget_io.h"
+#include "ip_addr.h"
+
+#include "host_sim.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* How long the simulated button is held down; longer than the debounce time. */
+#define HOST_SIM_BUTTON_HOLD_MS                   (100u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static cyhal_gpio_callback_data_t *button_callback;
+static volatile bool button_event_enabled;
+static volatile bool button_level = CYBSP_BTN_OFF;
+static pthread_mutex_t button_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Posted by the SIGUSR1 handler; sem_post() is async-signal-safe. */
+static sem_t button_request;
+
+/*******************************************************************************
+* Simulated user button
+********************************************************************************/
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { (time_t)(ms / 1000), (long)((ms % 1000) * 1000000) };
+
+    nanosleep(&ts, NULL);
+}
+
+void host_sim_button_press(void)
+{
+    pthread_mutex_lock(&button_lock);
+
+    button_level = CYBSP_BTN_PRESSED;
+    if(button_event_enabled && (button_callback != NULL))
+    {
+        /* Runs in the role of the GPIO interrupt. */
+        button_callback->callback(button_callback->callback_arg, CYHAL_GPIO_IRQ_FALL);
+    }
+
+    pthread_mutex_unlock(&button_lock);
+
+    sleep_ms(HOST_SIM_BUTTON_HOLD_MS);
+    button_level = CYBSP_BTN_OFF;
+}
+
+static void on_sigusr1(int sig)
+{
+    (void)sig;
+    sem_post(&button_request);
+}
+
+/* Simulated interrupt thread: presses the button on request or periodically. */
+static void *button_thread(void *arg)
+{
+    const char *period_env = getenv("HOST_SIM_BUTTON_PERIOD_MS");
+    uint32_t period_ms = (period_env != NULL) ? (uint32_t)strtoul(period_env, NULL, 0) : 0;
+
+    (void)arg;
+
+    for(;;)
+    {
+        if(period_ms == 0)
+        {
+            while(sem_wait(&button_request) != 0)
+            {
+            }
+        }
+        else
+        {
+            struct timespec deadline;
+
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += (time_t)(period_ms / 1000);
+            deadline.tv_nsec += (long)((period_ms % 1000) * 1000000);
+            if(deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            (void)sem_timedwait(&button_request, &deadline);
+        }
+
+        host_sim_button_press();
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Board support package
+********************************************************************************/
+cy_rslt_t cybsp_init(void)
+{
+    pthread_t thread;
+    struct sigaction sa = { 0 };
+
+    (void)host_sim_time_ms();
+
+    sem_init(&button_request, 0, 0);
+    sa.sa_handler = on_sigusr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if(pthread_create(&thread, NULL, button_thread, NULL) != 0)
+    {
+        return (cy_rslt_t)1;
+    }
+    pthread_detach(thread);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_retarget_io_init(cyhal_gpio_t tx, cyhal_gpio_t rx, uint32_t baudrate)
+{
+    (void)tx;
+    (void)rx;
+    (void)baudrate;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* GPIO
+********************************************************************************/
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, cyhal_gpio_direction_t direction,
+                          cyhal_gpio_drive_mode_t drive_mode, bool init_val)
+{
+    (void)direction;
+    (void)drive_mode;
+
+    if(pin == CYBSP_SW1)
+    {
+        button_level = init_val;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cyhal_gpio_free(cyhal_gpio_t pin)
+{
+    (void)pin;
+}
+
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value)
+{
+    (void)pin;
+    (void)value;
+}
+
+bool cyhal_gpio_read(cyhal_gpio_t pin)
+{
+    return (pin == CYBSP_SW1) ? button_level : false;
+}
+
+void cyhal_gpio_register_callback(cyhal_gpio_t pin, cyhal_gpio_callback_data_t *callback_data)
+{
+    if(pin == CYBSP_SW1)
+    {
+        pthread_mutex_lock(&button_lock);
+        button_callback = callback_data;
+        pthread_mutex_unlock(&button_lock);
+    }
+}
+
+void cyhal_gpio_enable_event(cyhal_gpio_t pin, cyhal_gpio_event_t event,
+                             uint8_t intr_priority, bool enable)
+{
+    (void)event;
+    (void)intr_priority;
+
+    if(pin == CYBSP_SW1)
+    {
+        button_event_enabled = enable;
+    }
+}
+
+/*******************************************************************************
+* lwIP address helpers
+********************************************************************************/
+char *ip4addr_ntoa(const ip4_addr_t *addr)
+{
+    static __thread char str[INET_ADDRSTRLEN];
+    struct in_addr in = { .s_addr = addr->addr };
+
+    return (char *)inet_ntop(AF_INET, &in, str, sizeof(str));
+}
+
+/* [] END OF FILE */
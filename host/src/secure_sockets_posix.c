@@ -0,0 +1,604 @@
+/******************************************************************************
+* File Name:   secure_sockets_posix.c
+*
+* Description: Host build implementation of the secure sockets API over BSD
+* sockets. A worker thread polls the sockets that have callbacks registered
+* and calls the connect request, receive and disconnect callbacks, so the
+* callbacks run on one thread as they do on the target.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define HOST_MAX_SOCKETS                          (1024)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+typedef struct host_socket
+{
+    int fd;
+    bool listening;
+    bool deleted;
+    bool peer_closed;
+    uint32_t rcv_timeout_ms;
+    uint32_t snd_timeout_ms;
+    cy_socket_opt_callback_t connect_cb;
+    cy_socket_opt_callback_t receive_cb;
+    cy_socket_opt_callback_t disconnect_cb;
+} host_socket_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static host_socket_t *sockets[HOST_MAX_SOCKETS];
+static pthread_mutex_t sockets_lock = PTHREAD_MUTEX_INITIALIZER;
+static int wake_pipe[2] = { -1, -1 };
+static bool worker_started;
+
+/*******************************************************************************
+* Worker thread
+********************************************************************************/
+static void wake_worker(void)
+{
+    char c = 0;
+
+    if(wake_pipe[1] >= 0)
+    {
+        (void)write(wake_pipe[1], &c, 1);
+    }
+}
+
+/* Frees deleted sockets. Called by the worker with sockets_lock held, when no
+ * callback is running.
+ */
+static void reap_sockets(void)
+{
+    for(int i = 0; i < HOST_MAX_SOCKETS; i++)
+    {
+        if((sockets[i] != NULL) && sockets[i]->deleted)
+        {
+            free(sockets[i]);
+            sockets[i] = NULL;
+        }
+    }
+}
+
+static void *socket_worker(void *arg)
+{
+    static struct pollfd fds[HOST_MAX_SOCKETS + 1];
+    static host_socket_t *polled[HOST_MAX_SOCKETS + 1];
+
+    (void)arg;
+
+    for(;;)
+    {
+        nfds_t nfds = 1;
+
+        fds[0].fd = wake_pipe[0];
+        fds[0].events = POLLIN;
+
+        pthread_mutex_lock(&sockets_lock);
+        reap_sockets();
+        for(int i = 0; i < HOST_MAX_SOCKETS; i++)
+        {
+            host_socket_t *sock = sockets[i];
+
+            if((sock == NULL) || sock->peer_closed)
+            {
+                continue;
+            }
+            if((sock->listening && (sock->connect_cb.callback != NULL)) ||
+               (!sock->listening && ((sock->receive_cb.callback != NULL) ||
+                                     (sock->disconnect_cb.callback != NULL))))
+            {
+                fds[nfds].fd = sock->fd;
+                fds[nfds].events = POLLIN | POLLRDHUP;
+                polled[nfds] = sock;
+                nfds++;
+            }
+        }
+        pthread_mutex_unlock(&sockets_lock);
+
+        if(poll(fds, nfds, -1) < 0)
+        {
+            continue;
+        }
+
+        if(fds[0].revents & POLLIN)
+        {
+            char drain[64];
+
+            while(read(wake_pipe[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        for(nfds_t i = 1; i < nfds; i++)
+        {
+            host_socket_t *sock = polled[i];
+            short revents = fds[i].revents;
+
+            if((revents == 0) || sock->deleted)
+            {
+                continue;
+            }
+
+            if(sock->listening)
+            {
+                sock->connect_cb.callback(sock, sock->connect_cb.arg);
+                continue;
+            }
+
+            if(revents & POLLIN)
+            {
+                int available = 0;
+
+                ioctl(sock->fd, FIONREAD, &available);
+                if(available > 0)
+                {
+                    if(sock->receive_cb.callback != NULL)
+                    {
+                        sock->receive_cb.callback(sock, sock->receive_cb.arg);
+                    }
+                    continue;
+                }
+            }
+
+            if((revents & (POLLRDHUP | POLLHUP | POLLERR | POLLIN)) && !sock->deleted)
+            {
+                sock->peer_closed = true;
+                if(sock->disconnect_cb.callback != NULL)
+                {
+                    sock->disconnect_cb.callback(sock, sock->disconnect_cb.arg);
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static cy_rslt_t errno_to_result(int err)
+{
+    switch(err)
+    {
+        case EAGAIN:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+        case EPIPE:
+        case ECONNRESET:
+        case ENOTCONN:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+        case EADDRINUSE:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_ADDRESS_IN_USE;
+        case ENOMEM:
+        case ENOBUFS:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM;
+        case EBADF:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+        default:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_ERROR;
+    }
+}
+
+static void set_timeout(int fd, int optname, uint32_t timeout_ms)
+{
+    struct timeval tv;
+
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, optname, &tv, sizeof(tv));
+}
+
+/* Reads an int socket option, scaled to the unit of the secure sockets. */
+static cy_rslt_t get_int_option(int fd, int level, int optname, uint32_t scale,
+                                void *optval, uint32_t *optlen)
+{
+    int value = 0;
+    socklen_t len = sizeof(value);
+
+    if(getsockopt(fd, level, optname, &value, &len) != 0)
+    {
+        return errno_to_result(errno);
+    }
+    *(uint32_t *)optval = (uint32_t)value * scale;
+    *optlen = sizeof(uint32_t);
+
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t add_socket(int fd, cy_socket_t *handle)
+{
+    host_socket_t *sock = calloc(1, sizeof(*sock));
+
+    if(sock == NULL)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM;
+    }
+    sock->fd = fd;
+
+    pthread_mutex_lock(&sockets_lock);
+    for(int i = 0; i < HOST_MAX_SOCKETS; i++)
+    {
+        if(sockets[i] == NULL)
+        {
+            sockets[i] = sock;
+            pthread_mutex_unlock(&sockets_lock);
+            *handle = sock;
+            wake_worker();
+            return CY_RSLT_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&sockets_lock);
+
+    free(sock);
+    return CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM;
+}
+
+/*******************************************************************************
+* Secure sockets API
+********************************************************************************/
+cy_rslt_t cy_socket_init(void)
+{
+    pthread_t thread;
+
+    if(worker_started)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if(pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_ERROR;
+    }
+    if(pthread_create(&thread, NULL, socket_worker, NULL) != 0)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM;
+    }
+    pthread_detach(thread);
+    worker_started = true;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_deinit(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_create(int domain, int type, int protocol, cy_socket_t *handle)
+{
+    int fd;
+    int one = 1;
+
+    (void)domain;
+    (void)type;
+    (void)protocol;
+
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if(fd < 0)
+    {
+        return errno_to_result(errno);
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    return add_socket(fd, handle);
+}
+
+cy_rslt_t cy_socket_setsockopt(cy_socket_t handle, int level, int optname,
+                               const void *optval, uint32_t optlen)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    int value;
+    int rc = 0;
+
+    (void)level;
+    (void)optlen;
+
+    if((sock == NULL) || sock->deleted)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+
+    switch(optname)
+    {
+        case CY_SOCKET_SO_RCVTIMEO:
+            sock->rcv_timeout_ms = *(const uint32_t *)optval;
+            set_timeout(sock->fd, SO_RCVTIMEO, sock->rcv_timeout_ms);
+            break;
+        case CY_SOCKET_SO_SNDTIMEO:
+            sock->snd_timeout_ms = *(const uint32_t *)optval;
+            set_timeout(sock->fd, SO_SNDTIMEO, sock->snd_timeout_ms);
+            break;
+        case CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE:
+            value = *(const int *)optval;
+            rc = setsockopt(sock->fd, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(value));
+            break;
+        case CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL:
+            value = (int)((*(const uint32_t *)optval + 999) / 1000);
+            rc = setsockopt(sock->fd, IPPROTO_TCP, TCP_KEEPINTVL, &value, sizeof(value));
+            break;
+        case CY_SOCKET_SO_TCP_KEEPALIVE_COUNT:
+            value = (int)*(const uint32_t *)optval;
+            rc = setsockopt(sock->fd, IPPROTO_TCP, TCP_KEEPCNT, &value, sizeof(value));
+            break;
+        case CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME:
+            value = (int)((*(const uint32_t *)optval + 999) / 1000);
+            rc = setsockopt(sock->fd, IPPROTO_TCP, TCP_KEEPIDLE, &value, sizeof(value));
+            break;
+        case CY_SOCKET_SO_TCP_NODELAY:
+            value = *(const int *)optval;
+            rc = setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+            break;
+        case CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK:
+            sock->connect_cb = *(const cy_socket_opt_callback_t *)optval;
+            wake_worker();
+            break;
+        case CY_SOCKET_SO_RECEIVE_CALLBACK:
+            sock->receive_cb = *(const cy_socket_opt_callback_t *)optval;
+            wake_worker();
+            break;
+        case CY_SOCKET_SO_DISCONNECT_CALLBACK:
+            sock->disconnect_cb = *(const cy_socket_opt_callback_t *)optval;
+            wake_worker();
+            break;
+        default:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_OPTION_NOT_SUPPORTED;
+    }
+
+    return (rc == 0) ? CY_RSLT_SUCCESS : errno_to_result(errno);
+}
+
+cy_rslt_t cy_socket_getsockopt(cy_socket_t handle, int level, int optname,
+                               void *optval, uint32_t *optlen)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    int available = 0;
+
+    (void)level;
+
+    if((sock == NULL) || sock->deleted)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+
+    switch(optname)
+    {
+        case CY_SOCKET_SO_BYTES_AVAILABLE:
+            if(ioctl(sock->fd, FIONREAD, &available) != 0)
+            {
+                return errno_to_result(errno);
+            }
+            *(uint32_t *)optval = (uint32_t)available;
+            *optlen = sizeof(uint32_t);
+            return CY_RSLT_SUCCESS;
+        case CY_SOCKET_SO_RCVTIMEO:
+            *(uint32_t *)optval = sock->rcv_timeout_ms;
+            *optlen = sizeof(uint32_t);
+            return CY_RSLT_SUCCESS;
+        case CY_SOCKET_SO_SNDTIMEO:
+            *(uint32_t *)optval = sock->snd_timeout_ms;
+            *optlen = sizeof(uint32_t);
+            return CY_RSLT_SUCCESS;
+        case CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE:
+            return get_int_option(sock->fd, SOL_SOCKET, SO_KEEPALIVE, 1, optval, optlen);
+        case CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL:
+            return get_int_option(sock->fd, IPPROTO_TCP, TCP_KEEPINTVL, 1000, optval, optlen);
+        case CY_SOCKET_SO_TCP_KEEPALIVE_COUNT:
+            return get_int_option(sock->fd, IPPROTO_TCP, TCP_KEEPCNT, 1, optval, optlen);
+        case CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME:
+            return get_int_option(sock->fd, IPPROTO_TCP, TCP_KEEPIDLE, 1000, optval, optlen);
+        case CY_SOCKET_SO_TCP_NODELAY:
+            return get_int_option(sock->fd, IPPROTO_TCP, TCP_NODELAY, 1, optval, optlen);
+        default:
+            return CY_RSLT_MODULE_SECURE_SOCKETS_OPTION_NOT_SUPPORTED;
+    }
+}
+
+cy_rslt_t cy_socket_bind(cy_socket_t handle, cy_socket_sockaddr_t *address,
+                         uint32_t address_length)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    struct sockaddr_in addr;
+
+    (void)address_length;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(address->port);
+    addr.sin_addr.s_addr = address->ip_address.ip.v4;
+
+    if(bind(sock->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        return errno_to_result(errno);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_listen(cy_socket_t handle, int backlog)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+
+    if(listen(sock->fd, backlog) != 0)
+    {
+        return errno_to_result(errno);
+    }
+    sock->listening = true;
+    wake_worker();
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_accept(cy_socket_t handle, cy_socket_sockaddr_t *address,
+                           uint32_t *address_length, cy_socket_t *socket)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    host_socket_t *client;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    cy_rslt_t result;
+    int fd;
+
+    fd = accept4(sock->fd, (struct sockaddr *)&addr, &len, SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+        return errno_to_result(errno);
+    }
+
+    address->port = ntohs(addr.sin_port);
+    address->ip_address.version = CY_SOCKET_IP_VER_V4;
+    address->ip_address.ip.v4 = addr.sin_addr.s_addr;
+    *address_length = sizeof(*address);
+
+    result = add_socket(fd, socket);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        close(fd);
+        return result;
+    }
+
+    /* Accepted sockets inherit the callbacks and timeouts of the listener. */
+    client = (host_socket_t *)*socket;
+    client->receive_cb = sock->receive_cb;
+    client->disconnect_cb = sock->disconnect_cb;
+    client->rcv_timeout_ms = sock->rcv_timeout_ms;
+    set_timeout(fd, SO_RCVTIMEO, client->rcv_timeout_ms);
+    wake_worker();
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *buffer, uint32_t length,
+                         int flags, uint32_t *bytes_sent)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    uint32_t sent = 0;
+
+    (void)flags;
+
+    if((sock == NULL) || sock->deleted)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+
+    while(sent < length)
+    {
+        ssize_t n = send(sock->fd, (const uint8_t *)buffer + sent, length - sent, MSG_NOSIGNAL);
+
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            *bytes_sent = sent;
+            return errno_to_result(errno);
+        }
+        sent += (uint32_t)n;
+    }
+
+    *bytes_sent = sent;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t length,
+                         int flags, uint32_t *bytes_received)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+    ssize_t n;
+
+    (void)flags;
+
+    *bytes_received = 0;
+
+    if((sock == NULL) || sock->deleted)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+
+    do
+    {
+        n = recv(sock->fd, buffer, length, 0);
+    } while((n < 0) && (errno == EINTR));
+
+    if(n == 0)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+    }
+    if(n < 0)
+    {
+        return errno_to_result(errno);
+    }
+
+    *bytes_received = (uint32_t)n;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_disconnect(cy_socket_t handle, uint32_t timeout)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+
+    (void)timeout;
+
+    if((sock == NULL) || sock->deleted)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+    shutdown(sock->fd, SHUT_RDWR);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_delete(cy_socket_t handle)
+{
+    host_socket_t *sock = (host_socket_t *)handle;
+
+    if(sock == NULL)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+
+    pthread_mutex_lock(&sockets_lock);
+    if(sock->deleted)
+    {
+        pthread_mutex_unlock(&sockets_lock);
+        return CY_RSLT_MODULE_SECURE_SOCKETS_INVALID_SOCKET;
+    }
+    sock->deleted = true;
+    close(sock->fd);
+    sock->fd = -1;
+    pthread_mutex_unlock(&sockets_lock);
+
+    /* The worker frees the socket once no callback can reference it. */
+    wake_worker();
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* [] END OF FILE */
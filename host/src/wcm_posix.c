@@ -0,0 +1,58 @@
+/******************************************************************************
+* File Name:   wcm_posix.c
+*
+* Description: Host build implementation of the Wi-Fi connection manager. No
+* radio is involved: the server binds to the address given by HOST_SIM_IP, or
+* to the loopback address.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+
+#include "cy_wcm.h"
+
+static uint32_t host_ip_address(void)
+{
+    const char *ip = getenv("HOST_SIM_IP");
+    struct in_addr addr;
+
+    if((ip == NULL) || (inet_pton(AF_INET, ip, &addr) != 1))
+    {
+        inet_pton(AF_INET, "127.0.0.1", &addr);
+    }
+
+    return addr.s_addr;
+}
+
+cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
+{
+    (void)config;
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params,
+                            cy_wcm_ip_address_t *ip_addr)
+{
+    (void)connect_params;
+
+    ip_addr->version = CY_WCM_IP_VER_V4;
+    ip_addr->ip.v4 = host_ip_address();
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config)
+{
+    (void)ap_config;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* [] END OF FILE */
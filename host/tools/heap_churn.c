@@ -0,0 +1,485 @@
+/******************************************************************************
+* File Name:   heap_churn.c
+*
+* Description: Host benchmark of heap fragmentation under connection churn.
+* A seeded random workload modelled on the server opens and closes client
+* connections, each allocating a socket context, a connection record, a
+* receive buffer and a few small objects for its lifetime, while short-lived
+* messages of mixed sizes are allocated and freed around them. A tenth of the
+* connections live ten times longer, pinning their blocks in place. The same
+* sequence runs on a TLSF heap (tlsf_heap.c) of a fixed size and on the
+* system allocator, side by side, and the free memory of both is reported at
+* intervals: the free block count, and for TLSF the largest free block, for
+* the system allocator the memory taken from the system. The time of every
+* malloc() and free() is recorded; the summary gives their percentiles.
+*
+* The system allocator is glibc here; like newlib, it derives from Doug
+* Lea's malloc, and mallinfo() reports the same figures. Its thread cache,
+* fast bins and memory mapped allocations, which newlib does not have, are
+* turned off.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tlsf_heap.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define MAX_CONNECTIONS                           (256u)
+#define OBJECTS_PER_CONNECTION                    (6u)
+#define MAX_MESSAGES                              (1024u)
+
+/* Time histogram: 10 ns buckets up to 100 us, and the rest. */
+#define HIST_STEP_NS                              (10u)
+#define HIST_BUCKETS                              (10001u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Allocation made on both heaps. */
+typedef struct
+{
+    void *tlsf;                         /* NULL if the TLSF heap was full. */
+    void *sys;
+    uint32_t size;
+} churn_block_t;
+
+typedef struct
+{
+    bool open;
+    uint64_t close_at;                  /* Event the connection closes at. */
+    churn_block_t objects[OBJECTS_PER_CONNECTION];
+} churn_conn_t;
+
+typedef struct
+{
+    uint64_t free_at;
+    churn_block_t block;
+} churn_msg_t;
+
+/* Times of the calls to one allocator function. */
+typedef struct
+{
+    uint64_t count;
+    uint64_t max_ns;
+    uint64_t hist[HIST_BUCKETS];
+} churn_timing_t;
+
+typedef struct
+{
+    churn_timing_t alloc;
+    churn_timing_t free;
+    uint64_t failures;
+} churn_heap_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static tlsf_heap_t heap;
+static churn_conn_t conns[MAX_CONNECTIONS];
+static churn_msg_t msgs[MAX_MESSAGES];
+static uint32_t msg_count;
+static churn_heap_t tlsf_result;
+static churn_heap_t sys_result;
+static uint64_t live_bytes;
+static uint64_t peak_live_bytes;
+static uint32_t rng_state;
+
+/*******************************************************************************
+* Function Name: rng
+********************************************************************************
+* Summary:
+* Returns the next number of a xorshift generator.
+*
+*******************************************************************************/
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+
+    return rng_state;
+}
+
+/*******************************************************************************
+* Function Name: rng_range
+********************************************************************************
+* Summary:
+* Returns a number between lo and hi, both included.
+*
+*******************************************************************************/
+static uint32_t rng_range(uint32_t lo, uint32_t hi)
+{
+    return lo + (rng() % (hi - lo + 1u));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static void record_time(churn_timing_t *timing, uint64_t ns)
+{
+    uint64_t bucket = ns / HIST_STEP_NS;
+
+    timing->count++;
+    timing->hist[(bucket < HIST_BUCKETS) ? bucket : (HIST_BUCKETS - 1u)]++;
+    if(ns > timing->max_ns)
+    {
+        timing->max_ns = ns;
+    }
+}
+
+static uint64_t percentile_ns(const churn_timing_t *timing, double fraction)
+{
+    uint64_t rank = (uint64_t)((double)timing->count * fraction);
+    uint64_t seen = 0;
+
+    for(uint32_t i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += timing->hist[i];
+        if(seen > rank)
+        {
+            return (uint64_t)(i + 1u) * HIST_STEP_NS;
+        }
+    }
+
+    return timing->max_ns;
+}
+
+/*******************************************************************************
+* Function Name: block_alloc
+********************************************************************************
+* Summary:
+* Allocates a block of the given size on both heaps, timing each call.
+*
+*******************************************************************************/
+static void block_alloc(churn_block_t *block, uint32_t size)
+{
+    uint64_t t0;
+
+    block->size = size;
+
+    t0 = now_ns();
+    block->tlsf = tlsf_heap_alloc(&heap, size);
+    record_time(&tlsf_result.alloc, now_ns() - t0);
+    if(block->tlsf == NULL)
+    {
+        tlsf_result.failures++;
+    }
+
+    t0 = now_ns();
+    block->sys = malloc(size);
+    record_time(&sys_result.alloc, now_ns() - t0);
+    if(block->sys == NULL)
+    {
+        sys_result.failures++;
+    }
+
+    live_bytes += size;
+    if(live_bytes > peak_live_bytes)
+    {
+        peak_live_bytes = live_bytes;
+    }
+}
+
+static void block_free(churn_block_t *block)
+{
+    uint64_t t0;
+
+    if(block->tlsf != NULL)
+    {
+        t0 = now_ns();
+        tlsf_heap_free(&heap, block->tlsf);
+        record_time(&tlsf_result.free, now_ns() - t0);
+    }
+
+    if(block->sys != NULL)
+    {
+        t0 = now_ns();
+        free(block->sys);
+        record_time(&sys_result.free, now_ns() - t0);
+    }
+
+    live_bytes -= block->size;
+    memset(block, 0, sizeof(*block));
+}
+
+/*******************************************************************************
+* Function Name: conn_open
+********************************************************************************
+* Summary:
+* Opens a connection: the objects the server and the libraries allocate for
+* an accepted client.
+*
+*******************************************************************************/
+static void conn_open(churn_conn_t *conn, uint64_t event, uint32_t lifetime)
+{
+    conn->open = true;
+    conn->close_at = event + rng_range(lifetime / 2u, lifetime + (lifetime / 2u));
+    if((rng() % 10u) == 0)
+    {
+        conn->close_at += 10u * lifetime;
+    }
+
+    block_alloc(&conn->objects[0], rng_range(200, 280));       /* Socket context. */
+    block_alloc(&conn->objects[1], rng_range(96, 128));        /* Connection record. */
+    block_alloc(&conn->objects[2], rng_range(1024, 1600));     /* Receive buffer. */
+    for(uint32_t i = 3; i < OBJECTS_PER_CONNECTION; i++)
+    {
+        block_alloc(&conn->objects[i], rng_range(16, 64));
+    }
+}
+
+static void conn_close(churn_conn_t *conn)
+{
+    /* Released in the order the libraries do: the buffers last. */
+    for(uint32_t i = OBJECTS_PER_CONNECTION; i > 0; i--)
+    {
+        block_free(&conn->objects[i - 1u]);
+    }
+    conn->open = false;
+}
+
+/*******************************************************************************
+* Function Name: msg_alloc
+********************************************************************************
+* Summary:
+* Allocates a message: mostly small, sometimes up to a segment.
+*
+*******************************************************************************/
+static void msg_alloc(uint64_t event)
+{
+    uint32_t pick = rng() % 100u;
+    uint32_t size;
+
+    if(msg_count == MAX_MESSAGES)
+    {
+        return;
+    }
+
+    if(pick < 70u)
+    {
+        size = rng_range(16, 96);
+    }
+    else if(pick < 95u)
+    {
+        size = rng_range(100, 600);
+    }
+    else
+    {
+        size = rng_range(600, 1600);
+    }
+
+    msgs[msg_count].free_at = event + rng_range(1, 64);
+    block_alloc(&msgs[msg_count].block, size);
+    msg_count++;
+}
+
+static void msgs_expire(uint64_t event)
+{
+    for(uint32_t i = 0; i < msg_count;)
+    {
+        if(msgs[i].free_at <= event)
+        {
+            block_free(&msgs[i].block);
+            msgs[i] = msgs[--msg_count];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: print_row
+********************************************************************************
+* Summary:
+* Prints the free memory of both heaps.
+*
+*******************************************************************************/
+static void print_row(uint64_t event, uint32_t open)
+{
+    tlsf_heap_stats_t stats;
+    struct mallinfo2 info = mallinfo2();
+    double fragmentation;
+
+    tlsf_heap_get_stats(&heap, &stats);
+    fragmentation = (stats.free_bytes > 0) ?
+                    (100.0 * (1.0 - ((double)stats.largest_free / (double)stats.free_bytes))) : 0.0;
+
+    printf("%10"PRIu64" %5"PRIu32" %8.1f | %7"PRIu32" %8.1f %8.1f %6.1f%% %8"PRIu64" | %7zu %8.1f %8.1f\n",
+           event, open, (double)live_bytes / 1024.0,
+           stats.free_blocks, (double)stats.free_bytes / 1024.0, (double)stats.largest_free / 1024.0,
+           fragmentation, tlsf_result.failures,
+           info.ordblks, (double)info.fordblks / 1024.0, (double)(info.arena + info.hblkhd) / 1024.0);
+}
+
+static void print_timing(const char *name, const churn_heap_t *result)
+{
+    printf("%-6s malloc p50 %5"PRIu64" p99 %5"PRIu64" p99.9 %6"PRIu64" max %8"PRIu64" ns | "
+           "free p50 %5"PRIu64" p99 %5"PRIu64" p99.9 %6"PRIu64" max %8"PRIu64" ns\n",
+           name,
+           percentile_ns(&result->alloc, 0.50), percentile_ns(&result->alloc, 0.99),
+           percentile_ns(&result->alloc, 0.999), result->alloc.max_ns,
+           percentile_ns(&result->free, 0.50), percentile_ns(&result->free, 0.99),
+           percentile_ns(&result->free, 0.999), result->free.max_ns);
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [-n events] [-c connections] [-l lifetime] [-m messages] [-p pool_kb] "
+            "[-i interval] [-s seed] [-v]\n"
+            "  -n  events to run [default: 10000000]\n"
+            "  -c  connections open at most [default: 32]\n"
+            "  -l  mean lifetime of a connection, in events [default: 2000]\n"
+            "  -m  messages allocated per event, in percent [default: 60]\n"
+            "  -p  size of the TLSF heap in KB [default: 160]\n"
+            "  -i  events between two reports [default: 1000000]\n"
+            "  -s  seed of the workload [default: 1]\n"
+            "  -v  check the TLSF heap at every report\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t events = 10000000u;
+    uint32_t max_conns = 32u;
+    uint32_t lifetime = 2000u;
+    uint32_t msg_rate = 60u;
+    uint32_t pool_kb = 160u;
+    uint64_t interval = 1000000u;
+    bool verify = false;
+    uint32_t open = 0;
+    uint8_t *pool;
+    int opt;
+
+    rng_state = 1u;
+
+    while((opt = getopt(argc, argv, "n:c:l:m:p:i:s:v")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': events = strtoull(optarg, NULL, 0); break;
+            case 'c': max_conns = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'l': lifetime = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'm': msg_rate = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'p': pool_kb = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'i': interval = strtoull(optarg, NULL, 0); break;
+            case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'v': verify = true; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+
+    if((max_conns == 0) || (max_conns > MAX_CONNECTIONS) || (lifetime < 2u) || (msg_rate > 100u) ||
+       (interval == 0) || (rng_state == 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* As newlib: no per-thread cache, set before the first allocation, so
+     * by running again; no fast bins, no memory mapped allocations, and the
+     * heap grown by the size needed only.
+     */
+    if(getenv("GLIBC_TUNABLES") == NULL)
+    {
+        setenv("GLIBC_TUNABLES", "glibc.malloc.tcache_count=0", 1);
+        execv("/proc/self/exe", argv);
+    }
+    mallopt(M_MXFAST, 0);
+    mallopt(M_MMAP_MAX, 0);
+    mallopt(M_TOP_PAD, 0);
+
+    /* Mapped apart, so that it does not count in the system heap. */
+    pool = mmap(NULL, (size_t)pool_kb * 1024u, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if((pool == MAP_FAILED) || !tlsf_heap_init(&heap, pool, (size_t)pool_kb * 1024u))
+    {
+        fprintf(stderr, "Cannot set up a TLSF heap of %"PRIu32" KB\n", pool_kb);
+        return 1;
+    }
+
+    printf("%10s %5s %8s | %7s %8s %8s %7s %8s | %7s %8s %8s\n",
+           "", "", "live", "TLSF", "free", "largest", "", "", "system", "free", "arena");
+    printf("%10s %5s %8s | %7s %8s %8s %7s %8s | %7s %8s %8s\n",
+           "event", "conns", "KB", "blocks", "KB", "KB", "frag", "failed", "blocks", "KB", "KB");
+
+    for(uint64_t event = 1; event <= events; event++)
+    {
+        msgs_expire(event);
+
+        for(uint32_t i = 0; i < max_conns; i++)
+        {
+            if(conns[i].open && (conns[i].close_at <= event))
+            {
+                conn_close(&conns[i]);
+                open--;
+            }
+        }
+
+        /* Connections are opened as fast as they close, keeping the table
+         * about full.
+         */
+        if((open < max_conns) && ((rng() % 4u) == 0))
+        {
+            for(uint32_t i = 0; i < max_conns; i++)
+            {
+                if(!conns[i].open)
+                {
+                    conn_open(&conns[i], event, lifetime);
+                    open++;
+                    break;
+                }
+            }
+        }
+
+        if((rng() % 100u) < msg_rate)
+        {
+            msg_alloc(event);
+        }
+
+        if((event % interval) == 0)
+        {
+            print_row(event, open);
+            if(verify && !tlsf_heap_check(&heap))
+            {
+                fprintf(stderr, "TLSF heap corrupted at event %"PRIu64"\n", event);
+                return 1;
+            }
+        }
+    }
+
+    printf("\nPeak live %.1f KB; TLSF heap %"PRIu32" KB, %"PRIu64" allocations failed\n",
+           (double)peak_live_bytes / 1024.0, pool_kb, tlsf_result.failures);
+    print_timing("TLSF", &tlsf_result);
+    print_timing("system", &sys_result);
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,367 @@
+/******************************************************************************
+* File Name:   tx_ref_check.c
+*
+* Description: Host check of the buffers queued by reference on a client
+* connection (tcp_conn_enqueue_static() in tcp_conn.c). It stands in for the
+* TCP writer task, draining the send queue of a connection entry with
+* tcp_conn_tx_peek() and tcp_conn_tx_consume() in short partial sends, and
+* checks that:
+*  - the buffers go out in order with the bytes of the send queue around
+*    them, including those queued while a buffer is being sent, and the
+*    head and tail of tcp_conn_enqueue_static_framed();
+*  - a buffer larger than the send queue goes out whole;
+*  - each buffer is completed as sent once its last byte is consumed;
+*  - a full descriptor queue, or a send queue without room for the head and
+*    the tail, drops the message without queueing any part of it;
+*  - the buffers still queued when the connection is released are completed
+*    as unsent, once each, and none is taken on a closing connection.
+*
+* Run with 'make -C host check'; the exit status is 1 if a check failed.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tcp_conn.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Most bytes handed to the "socket" at a time, so that the send queue and
+ * the buffers are sent in several parts.
+ */
+#define SEND_CHUNK                                (13u)
+
+#define OUTPUT_SIZE                               (8192u)
+#define BIG_BUFFER_SIZE                           (TCP_CONN_TX_BUFFER_SIZE * 4u + 3u)
+
+#define CHECK(cond)                               check((cond), #cond, __LINE__)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Completion of a buffer queued by reference. */
+typedef struct
+{
+    uint32_t calls;
+    bool sent;
+    uint32_t output_len;                /* Bytes sent when it was completed. */
+} completion_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static uint8_t output[OUTPUT_SIZE];
+static uint32_t output_len;
+
+static uint8_t expected[OUTPUT_SIZE];
+static uint32_t expected_len;
+
+static uint8_t big_buffer[BIG_BUFFER_SIZE];
+static uint8_t small_buffer[50];
+
+static uint32_t checks;
+static uint32_t failures;
+
+/*******************************************************************************
+* Function Name: check
+********************************************************************************/
+static void check(bool cond, const char *text, int line)
+{
+    checks++;
+    if(!cond)
+    {
+        failures++;
+        printf("FAILED line %d: %s\n", line, text);
+    }
+}
+
+/*******************************************************************************
+* Function Name: sent_callback
+********************************************************************************
+* Summary:
+*  Completion callback; records the call in the completion_t argument.
+*
+*******************************************************************************/
+static void sent_callback(const void *data, bool sent, void *arg)
+{
+    completion_t *completion = (completion_t *)arg;
+
+    (void)data;
+    completion->calls++;
+    completion->sent = sent;
+    completion->output_len = output_len;
+}
+
+/*******************************************************************************
+* Function Name: expect
+********************************************************************************
+* Summary:
+*  Appends bytes to the expected output.
+*
+*******************************************************************************/
+static void expect(const void *data, uint32_t len)
+{
+    memcpy(&expected[expected_len], data, len);
+    expected_len += len;
+}
+
+/*******************************************************************************
+* Function Name: drain
+********************************************************************************
+* Summary:
+*  Sends up to 'max_sends' blocks of the send queue, each of at most
+*  SEND_CHUNK bytes, as the TCP writer task does.
+*
+* Return:
+*  uint32_t: Number of blocks sent
+*
+*******************************************************************************/
+static uint32_t drain(tcp_conn_t *conn, uint32_t max_sends)
+{
+    const uint8_t *span;
+    uint32_t len;
+    uint32_t sends = 0;
+
+    while((sends < max_sends) && ((len = tcp_conn_tx_peek(conn, &span)) > 0))
+    {
+        if(len > SEND_CHUNK)
+        {
+            len = SEND_CHUNK;
+        }
+        if((output_len + len) > OUTPUT_SIZE)
+        {
+            break;
+        }
+
+        memcpy(&output[output_len], span, len);
+        output_len += len;
+        tcp_conn_tx_consume(conn, len);
+        sends++;
+    }
+
+    return sends;
+}
+
+/*******************************************************************************
+* Function Name: open_conn
+********************************************************************************/
+static tcp_conn_t *open_conn(void)
+{
+    cy_socket_sockaddr_t peer_addr;
+
+    memset(&peer_addr, 0, sizeof(peer_addr));
+    output_len = 0;
+    expected_len = 0;
+
+    return tcp_conn_alloc((cy_socket_t)&peer_addr, &peer_addr);
+}
+
+/*******************************************************************************
+* Function Name: check_order
+********************************************************************************
+* Summary:
+*  Buffers and send queue bytes interleaved, a buffer larger than the send
+*  queue, a framed buffer, and bytes queued while a buffer is being sent.
+*
+*******************************************************************************/
+static void check_order(void)
+{
+    static const uint8_t head[] = "<head>";
+    static const uint8_t tail[] = "<tail>";
+    completion_t small_done = { 0 };
+    completion_t big_done = { 0 };
+    completion_t framed_done = { 0 };
+    uint32_t small_end;
+    uint32_t big_end;
+    uint32_t framed_end;
+    tcp_conn_t *conn = open_conn();
+
+    CHECK(conn != NULL);
+    if(conn == NULL)
+    {
+        return;
+    }
+
+    CHECK(tcp_conn_enqueue(conn, "first message;", 14));
+    expect("first message;", 14);
+
+    CHECK(tcp_conn_enqueue_static(conn, small_buffer, sizeof(small_buffer), sent_callback, &small_done));
+    expect(small_buffer, sizeof(small_buffer));
+    small_end = expected_len;
+
+    CHECK(tcp_conn_enqueue(conn, "second message;", 15));
+    expect("second message;", 15);
+
+    CHECK(sizeof(big_buffer) > TCP_CONN_TX_BUFFER_SIZE);
+    CHECK(tcp_conn_enqueue_static(conn, big_buffer, sizeof(big_buffer), sent_callback, &big_done));
+    expect(big_buffer, sizeof(big_buffer));
+    big_end = expected_len;
+
+    /* Part of the big buffer is sent before the next messages are queued. */
+    drain(conn, 10);
+    CHECK(small_done.calls == 1);
+    CHECK(big_done.calls == 0);
+
+    CHECK(tcp_conn_enqueue(conn, "queued during;", 14));
+    expect("queued during;", 14);
+
+    CHECK(tcp_conn_enqueue_static_framed(conn, head, sizeof(head) - 1u, small_buffer, sizeof(small_buffer),
+                                         tail, sizeof(tail) - 1u, sent_callback, &framed_done));
+    expect(head, sizeof(head) - 1u);
+    expect(small_buffer, sizeof(small_buffer));
+    framed_end = expected_len;
+    expect(tail, sizeof(tail) - 1u);
+
+    CHECK(tcp_conn_enqueue(conn, "last message", 12));
+    expect("last message", 12);
+
+    drain(conn, UINT32_MAX);
+
+    CHECK(output_len == expected_len);
+    CHECK(memcmp(output, expected, expected_len) == 0);
+    CHECK(tcp_conn_tx_depth(conn) == 0);
+
+    /* Each completed once, as sent, when its last byte went out. */
+    CHECK((small_done.calls == 1) && small_done.sent && (small_done.output_len == small_end));
+    CHECK((big_done.calls == 1) && big_done.sent && (big_done.output_len == big_end));
+    CHECK((framed_done.calls == 1) && framed_done.sent && (framed_done.output_len == framed_end));
+    CHECK(conn->tx_dropped == 0);
+
+    tcp_conn_close(conn);
+    tcp_conn_free(conn);
+    CHECK(small_done.calls == 1);
+    CHECK(big_done.calls == 1);
+    CHECK(framed_done.calls == 1);
+}
+
+/*******************************************************************************
+* Function Name: check_drops
+********************************************************************************
+* Summary:
+*  Messages dropped on a full descriptor queue, or for want of room for the
+*  head and the tail in the send queue, leave nothing queued.
+*
+*******************************************************************************/
+static void check_drops(void)
+{
+    static uint8_t filler[TCP_CONN_TX_BUFFER_SIZE];
+    completion_t done[TCP_CONN_MAX_TX_REFS + 1u];
+    completion_t framed_done = { 0 };
+    uint32_t depth;
+    tcp_conn_t *conn = open_conn();
+
+    CHECK(conn != NULL);
+    if(conn == NULL)
+    {
+        return;
+    }
+
+    memset(done, 0, sizeof(done));
+    for(uint32_t i = 0; i < TCP_CONN_MAX_TX_REFS; i++)
+    {
+        CHECK(tcp_conn_enqueue_static(conn, small_buffer, sizeof(small_buffer), sent_callback, &done[i]));
+    }
+    CHECK(!tcp_conn_enqueue_static(conn, small_buffer, sizeof(small_buffer), sent_callback,
+                                   &done[TCP_CONN_MAX_TX_REFS]));
+    CHECK(conn->tx_dropped == 1);
+
+    drain(conn, UINT32_MAX);
+    CHECK(output_len == (TCP_CONN_MAX_TX_REFS * sizeof(small_buffer)));
+    for(uint32_t i = 0; i < TCP_CONN_MAX_TX_REFS; i++)
+    {
+        CHECK((done[i].calls == 1) && done[i].sent);
+    }
+    CHECK(done[TCP_CONN_MAX_TX_REFS].calls == 0);
+
+    /* No room for the head and the tail: nothing of the frame is queued. */
+    CHECK(tcp_conn_enqueue(conn, filler, TCP_CONN_TX_BUFFER_SIZE - 4u));
+    depth = tcp_conn_tx_depth(conn);
+    CHECK(!tcp_conn_enqueue_static_framed(conn, "head", 4, big_buffer, sizeof(big_buffer), "tl", 2,
+                                          sent_callback, &framed_done));
+    CHECK(tcp_conn_tx_depth(conn) == depth);
+    CHECK(conn->tx_dropped == 2);
+
+    output_len = 0;
+    drain(conn, UINT32_MAX);
+    CHECK(output_len == depth);
+    CHECK(framed_done.calls == 0);
+
+    tcp_conn_close(conn);
+    tcp_conn_free(conn);
+    CHECK(framed_done.calls == 0);
+}
+
+/*******************************************************************************
+* Function Name: check_early_close
+********************************************************************************
+* Summary:
+*  Buffers still queued when the connection is released, one of them sent
+*  in part, are completed as unsent.
+*
+*******************************************************************************/
+static void check_early_close(void)
+{
+    completion_t big_done = { 0 };
+    completion_t small_done = { 0 };
+    completion_t late_done = { 0 };
+    tcp_conn_t *conn = open_conn();
+
+    CHECK(conn != NULL);
+    if(conn == NULL)
+    {
+        return;
+    }
+
+    CHECK(tcp_conn_enqueue(conn, "message;", 8));
+    CHECK(tcp_conn_enqueue_static(conn, big_buffer, sizeof(big_buffer), sent_callback, &big_done));
+    CHECK(tcp_conn_enqueue_static(conn, small_buffer, sizeof(small_buffer), sent_callback, &small_done));
+
+    drain(conn, 5);
+    CHECK((output_len > 8u) && (output_len < (8u + sizeof(big_buffer))));
+    CHECK(big_done.calls == 0);
+
+    tcp_conn_close(conn);
+    CHECK(!tcp_conn_enqueue_static(conn, small_buffer, sizeof(small_buffer), sent_callback, &late_done));
+
+    tcp_conn_free(conn);
+    CHECK((big_done.calls == 1) && !big_done.sent);
+    CHECK((small_done.calls == 1) && !small_done.sent);
+    CHECK(late_done.calls == 0);
+}
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************/
+int main(void)
+{
+    for(uint32_t i = 0; i < sizeof(big_buffer); i++)
+    {
+        big_buffer[i] = (uint8_t)(i * 7u + 1u);
+    }
+    for(uint32_t i = 0; i < sizeof(small_buffer); i++)
+    {
+        small_buffer[i] = (uint8_t)('a' + (i % 26u));
+    }
+
+    tcp_conn_table_init();
+
+    check_order();
+    check_drops();
+    check_early_close();
+
+    printf("tx_ref_check: %"PRIu32" checks, %"PRIu32" failed\n", checks, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
+
+/* [] END OF FILE */
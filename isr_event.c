@@ -0,0 +1,130 @@
+/******************************************************************************
+* File Name:   isr_event.c
+*
+* Description: This file contains the event ring carrying timestamped events
+* from interrupt handlers to the TCP server task. The ring is a lock-free
+* single-producer, single-consumer ring buffer of fixed size records, so no
+* event is lost while the task is busy, as long as the ring does not fill up.
+* The consumer task is notified only when the ring goes from empty to
+* non-empty, and drains all the events queued by then in one wakeup.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Interrupt event ring header file. */
+#include "isr_event.h"
+
+/* Ring buffer header file. */
+#include "ring_buffer.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Event ring. The producer is the interrupt handler, the consumer the task
+ * given to isr_event_init().
+ */
+static ring_buffer_t event_ring;
+static isr_event_t event_storage[ISR_EVENT_RING_LEN];
+
+/* Task notified of new events. */
+static TaskHandle_t consumer_task;
+
+/* Events lost on a full ring. */
+static volatile uint32_t overflow_count;
+
+/*******************************************************************************
+ * Function Name: isr_event_init
+ *******************************************************************************
+ * Summary:
+ *  Empties the event ring. Must be called before the interrupts posting
+ *  events are enabled.
+ *
+ * Parameters:
+ *  TaskHandle_t consumer: Task reading the events
+ *
+ *******************************************************************************/
+void isr_event_init(TaskHandle_t consumer)
+{
+    ring_buffer_init(&event_ring, (uint8_t *)event_storage, sizeof(event_storage));
+    consumer_task = consumer;
+    overflow_count = 0;
+}
+
+/*******************************************************************************
+ * Function Name: isr_event_post_from_isr
+ *******************************************************************************
+ * Summary:
+ *  Posts an event to the ring from an interrupt handler. If the ring is full
+ *  the event is dropped and counted.
+ *
+ * Parameters:
+ *  isr_event_type_t type: Type of the event
+ *  uint16_t data: Event specific data
+ *  uint32_t timestamp: Time of the event, see timestamp.h
+ *  BaseType_t *higher_priority_task_woken: Set to pdTRUE if the consumer task
+ *  was woken up and a context switch is needed
+ *
+ *******************************************************************************/
+void isr_event_post_from_isr(isr_event_type_t type, uint16_t data, uint32_t timestamp,
+                             BaseType_t *higher_priority_task_woken)
+{
+    isr_event_t event =
+    {
+        .timestamp = timestamp,
+        .type      = (uint8_t)type,
+        .reserved  = 0,
+        .data      = data
+    };
+    bool was_empty = (ring_buffer_used(&event_ring) == 0);
+
+    if(!ring_buffer_write(&event_ring, &event, sizeof(event)))
+    {
+        overflow_count++;
+        return;
+    }
+
+    /* A non-empty ring is drained by the consumer before it blocks again. */
+    if(was_empty)
+    {
+        vTaskNotifyGiveFromISR(consumer_task, higher_priority_task_woken);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: isr_event_read
+ *******************************************************************************
+ * Summary:
+ *  Reads a batch of events from the ring. Called by the consumer task only,
+ *  until it returns 0, before waiting for the next notification.
+ *
+ * Parameters:
+ *  isr_event_t *events: Destination of the events
+ *  uint32_t max_events: Maximum number of events to read
+ *
+ * Return:
+ *  uint32_t: Number of events read
+ *
+ *******************************************************************************/
+uint32_t isr_event_read(isr_event_t *events, uint32_t max_events)
+{
+    return ring_buffer_read(&event_ring, events, max_events * sizeof(isr_event_t)) /
+           sizeof(isr_event_t);
+}
+
+/*******************************************************************************
+ * Function Name: isr_event_overflow_count
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of events dropped on a full ring.
+ *
+ *******************************************************************************/
+uint32_t isr_event_overflow_count(void)
+{
+    return overflow_count;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,60 @@
+/******************************************************************************
+* File Name:   isr_event.h
+*
+* Description: This file contains declaration of the event ring carrying
+* timestamped events from interrupt handlers to the TCP server task.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef ISR_EVENT_H_
+#define ISR_EVENT_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of events the ring holds. Must be a power of two. */
+#ifndef ISR_EVENT_RING_LEN
+#define ISR_EVENT_RING_LEN                        (16u)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Event types. */
+typedef enum
+{
+    ISR_EVENT_BUTTON_PRESS = 0      /* Falling edge of the user button. */
+} isr_event_type_t;
+
+/* Event, as posted by the interrupt handler. */
+typedef struct
+{
+    uint32_t timestamp;             /* timestamp_now() at interrupt entry. */
+    uint8_t type;                   /* isr_event_type_t */
+    uint8_t reserved;
+    uint16_t data;                  /* Event specific. */
+} isr_event_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void isr_event_init(TaskHandle_t consumer);
+void isr_event_post_from_isr(isr_event_type_t type, uint16_t data, uint32_t timestamp,
+                             BaseType_t *higher_priority_task_woken);
+uint32_t isr_event_read(isr_event_t *events, uint32_t max_events);
+uint32_t isr_event_overflow_count(void);
+
+#endif /* ISR_EVENT_H_ */
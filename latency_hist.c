@@ -0,0 +1,214 @@
+/******************************************************************************
+* File Name:   latency_hist.c
+*
+* Description: This file contains fixed size, log-linear latency histograms.
+* A value is counted in the bucket given by its highest set bit and the
+* LATENCY_HIST_SUB_BITS bits below it, so recording is a count leading zeros
+* and a few shifts, and percentiles are read with a bounded relative error
+* over the whole 32-bit range from a histogram of under 2 KB.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Standard C header file */
+#include <string.h>
+
+/* Latency histogram header file. */
+#include "latency_hist.h"
+
+/*******************************************************************************
+ * Function Name: bucket_index
+ *******************************************************************************
+ * Summary:
+ *  Returns the bucket of a value.
+ *
+ *******************************************************************************/
+static inline uint32_t bucket_index(uint32_t value)
+{
+    uint32_t shift;
+
+    if(value < (2u * LATENCY_HIST_SUB_BUCKETS))
+    {
+        return value;
+    }
+
+    /* Position of the highest set bit, minus the sub-bucket bits. */
+    shift = (31u - (uint32_t)__builtin_clz(value)) - LATENCY_HIST_SUB_BITS;
+
+    return ((shift + 1u) << LATENCY_HIST_SUB_BITS) + (value >> shift) - LATENCY_HIST_SUB_BUCKETS;
+}
+
+/*******************************************************************************
+ * Function Name: bucket_highest_value
+ *******************************************************************************
+ * Summary:
+ *  Returns the highest value counted in a bucket.
+ *
+ *******************************************************************************/
+static uint32_t bucket_highest_value(uint32_t index)
+{
+    uint32_t shift;
+    uint32_t sub;
+
+    if(index < (2u * LATENCY_HIST_SUB_BUCKETS))
+    {
+        return index;
+    }
+
+    shift = (index >> LATENCY_HIST_SUB_BITS) - 1u;
+    sub = (index & (LATENCY_HIST_SUB_BUCKETS - 1u)) + LATENCY_HIST_SUB_BUCKETS;
+
+    return (uint32_t)((((uint64_t)sub + 1u) << shift) - 1u);
+}
+
+/*******************************************************************************
+ * Function Name: latency_hist_reset
+ *******************************************************************************
+ * Summary:
+ *  Clears a histogram.
+ *
+ *******************************************************************************/
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT32_MAX;
+}
+
+/*******************************************************************************
+ * Function Name: latency_hist_record
+ *******************************************************************************
+ * Summary:
+ *  Counts a value in a histogram.
+ *
+ * Parameters:
+ *  latency_hist_t *hist: Histogram
+ *  uint32_t value: Value to count
+ *
+ *******************************************************************************/
+void latency_hist_record(latency_hist_t *hist, uint32_t value)
+{
+    hist->buckets[bucket_index(value)]++;
+    hist->sum += value;
+    if(value < hist->min)
+    {
+        hist->min = value;
+    }
+    if(value > hist->max)
+    {
+        hist->max = value;
+    }
+    hist->count++;
+}
+
+/*******************************************************************************
+ * Function Name: latency_hist_percentile
+ *******************************************************************************
+ * Summary:
+ *  Returns a percentile of the values of a histogram. The result is the
+ *  highest value of the bucket holding the percentile, capped at the largest
+ *  value recorded, so it never understates the latency.
+ *
+ * Parameters:
+ *  const latency_hist_t *hist: Histogram
+ *  uint32_t ppm: Percentile in parts per million, e.g. LATENCY_HIST_P99
+ *
+ * Return:
+ *  uint32_t: Value of the percentile, 0 if the histogram is empty
+ *
+ *******************************************************************************/
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t ppm)
+{
+    uint32_t count = hist->count;
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint32_t value;
+
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    /* Rank of the percentile, rounded up, at least 1. */
+    rank = (((uint64_t)count * ppm) + 999999u) / 1000000u;
+    if(rank == 0)
+    {
+        rank = 1;
+    }
+
+    for(uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if(seen >= rank)
+        {
+            value = bucket_highest_value(i);
+            return (value > hist->max) ? hist->max : value;
+        }
+    }
+
+    return hist->max;
+}
+
+/*******************************************************************************
+ * Function Name: latency_hist_count_at_most
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of values of a histogram known to be at most a limit,
+ *  i.e. those in the buckets whose highest value does not exceed it, for
+ *  cumulative bucket counts. Values in the bucket straddling the limit are
+ *  not counted.
+ *
+ * Parameters:
+ *  const latency_hist_t *hist: Histogram
+ *  uint32_t value: Limit
+ *
+ * Return:
+ *  uint32_t: Number of values at most the limit
+ *
+ *******************************************************************************/
+uint32_t latency_hist_count_at_most(const latency_hist_t *hist, uint32_t value)
+{
+    uint32_t count = 0;
+
+    for(uint32_t i = 0; (i < LATENCY_HIST_BUCKETS) && (bucket_highest_value(i) <= value); i++)
+    {
+        count += hist->buckets[i];
+    }
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: latency_hist_summary
+ *******************************************************************************
+ * Summary:
+ *  Returns the count, minimum, maximum, mean, p50, p99 and p999 of a
+ *  histogram.
+ *
+ * Parameters:
+ *  const latency_hist_t *hist: Histogram
+ *  latency_summary_t *summary: Summary of the histogram
+ *
+ *******************************************************************************/
+void latency_hist_summary(const latency_hist_t *hist, latency_summary_t *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+
+    summary->count = hist->count;
+    if(summary->count == 0)
+    {
+        return;
+    }
+
+    summary->min = hist->min;
+    summary->max = hist->max;
+    summary->mean = (uint32_t)(hist->sum / summary->count);
+    summary->p50 = latency_hist_percentile(hist, LATENCY_HIST_P50);
+    summary->p99 = latency_hist_percentile(hist, LATENCY_HIST_P99);
+    summary->p999 = latency_hist_percentile(hist, LATENCY_HIST_P999);
+}
+
+/* [] END OF FILE */
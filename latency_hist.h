@@ -0,0 +1,77 @@
+/******************************************************************************
+* File Name:   latency_hist.h
+*
+* Description: This file contains declaration of fixed size, log-linear
+* latency histograms (HDR histogram layout).
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef LATENCY_HIST_H_
+#define LATENCY_HIST_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Every power of two range of values is split into 2^LATENCY_HIST_SUB_BITS
+ * buckets, so a value is known to within 1/2^LATENCY_HIST_SUB_BITS of itself
+ * (6.25% with the default). Values below 2^(LATENCY_HIST_SUB_BITS + 1) have
+ * a bucket each.
+ */
+#ifndef LATENCY_HIST_SUB_BITS
+#define LATENCY_HIST_SUB_BITS                     (4u)
+#endif
+
+#define LATENCY_HIST_SUB_BUCKETS                  (1u << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_BUCKETS                      ((33u - LATENCY_HIST_SUB_BITS) * LATENCY_HIST_SUB_BUCKETS)
+
+/* Percentiles, in parts per million, for latency_hist_percentile(). */
+#define LATENCY_HIST_P50                          (500000u)
+#define LATENCY_HIST_P99                          (990000u)
+#define LATENCY_HIST_P999                         (999000u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Histogram of 32-bit values. Recording takes no lock, so each histogram must
+ * be recorded from a single task; readers in other tasks may see a sample
+ * counted in 'count' but not yet in its bucket.
+ */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+} latency_hist_t;
+
+/* Summary of a histogram. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+} latency_summary_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void latency_hist_reset(latency_hist_t *hist);
+void latency_hist_record(latency_hist_t *hist, uint32_t value);
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t ppm);
+uint32_t latency_hist_count_at_most(const latency_hist_t *hist, uint32_t value);
+void latency_hist_summary(const latency_hist_t *hist, latency_summary_t *summary);
+
+#endif /* LATENCY_HIST_H_ */
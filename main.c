@@ -23,6 +23,15 @@
 /* TCP server task header file. */
 #include "tcp_server.h"
 
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Startup profiler header file. */
+#include "boot_profile.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
@@ -39,6 +48,7 @@ volatile int uxTopUsedPriority;
 
 /* TCP server task handle. */
 TaskHandle_t server_task_handle;
+STATIC_ALLOC_TASK_DEFINE(server_task, TCP_SERVER_TASK_STACK_SIZE);
 
 /*******************************************************************************
 * Function Name: main
@@ -57,11 +67,15 @@ TaskHandle_t server_task_handle;
 *******************************************************************************/
 int main(void)
 {
+    /* Take the time origin of the startup profile. */
+    boot_profile_start();
+
     /* This enables RTOS aware debugging in OpenOCD. */
     uxTopUsedPriority = configMAX_PRIORITIES - 1 ;
 
     /* Initialize the board support package. */
     CY_ASSERT(CY_RSLT_SUCCESS == cybsp_init()) ;
+    boot_profile_mark(BOOT_STAGE_BSP_INIT);
     
     /* Enable global interrupts. */
     __enable_irq();
@@ -69,6 +83,7 @@ int main(void)
     /* Initialize retarget-io to use the debug UART port. */
     cy_retarget_io_init(CYBSP_DEBUG_UART_TX, CYBSP_DEBUG_UART_RX, 
                         CY_RETARGET_IO_BAUDRATE);
+    boot_profile_mark(BOOT_STAGE_RETARGET_IO);
 
     /* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen. */
     printf("\x1b[2J\x1b[;H");
@@ -76,9 +91,12 @@ int main(void)
     printf("****************** "
            "CYW43907 TCP Server"
            "****************** \r\n\n");
+    /* Start the task printing the log of the network callbacks. */
+    app_log_init();
+
    /* Create the task to establish a connection to a TCP client. */
-    xTaskCreate(tcp_server_task, "Network task", TCP_SERVER_TASK_STACK_SIZE, NULL, 
-               TCP_SERVER_TASK_PRIORITY, &server_task_handle);
+    STATIC_ALLOC_TASK_CREATE(server_task, tcp_server_task, "Network task", TCP_SERVER_TASK_STACK_SIZE, NULL,
+                             TCP_SERVER_TASK_PRIORITY, &server_task_handle);
 
     /* Start the FreeRTOS scheduler. */
     vTaskStartScheduler();
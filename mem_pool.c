@@ -0,0 +1,363 @@
+/******************************************************************************
+* File Name:   mem_pool.c
+*
+* Description: This file contains the fixed-block pools. Allocation and
+* release take a short critical section and no search: a block is either the
+* next one never allocated or the last one freed, which is the most likely
+* to still be in the cache. The block index of a pointer is found by
+* division, so a free is checked to belong to the pool at no extra cost.
+*
+* With MEM_POOL_MALLOC_ENABLED, the wrappers of the allocator functions (see
+* heap_usage.c) serve the small malloc() calls from the size classes of
+* mem_pool_config.h, ahead of the heap.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_utils.h"
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header files */
+#include <string.h>
+#include <inttypes.h>
+
+/* Fixed-block pool header file. */
+#include "mem_pool.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Pools registered for the statistics. */
+static mem_pool_t *registered_pools;
+
+#if(MEM_POOL_MALLOC_ENABLED)
+/* Size classes serving malloc(), smallest first. */
+MEM_POOL_DEFINE(small_pool, "malloc_small", MEM_POOL_SMALL_BLOCK_SIZE, MEM_POOL_SMALL_BLOCKS);
+MEM_POOL_DEFINE(large_pool, "malloc_large", MEM_POOL_LARGE_BLOCK_SIZE, MEM_POOL_LARGE_BLOCKS);
+
+static mem_pool_t *const malloc_pools[] = { &small_pool, &large_pool };
+
+#define MALLOC_POOL_COUNT                         (sizeof(malloc_pools) / sizeof(malloc_pools[0]))
+#else
+#define MALLOC_POOL_COUNT                         (0u)
+#endif /* MEM_POOL_MALLOC_ENABLED */
+
+/*******************************************************************************
+ * Function Name: mem_pool_init
+ *******************************************************************************
+ * Summary:
+ *  Sets up a pool over caller-provided memory, with all its blocks free, and
+ *  registers it for the statistics. The blocks are not written to.
+ *
+ * Parameters:
+ *  mem_pool_t *pool: Pool to set up
+ *  const char *name: Name of the pool, a string constant
+ *  void *blocks: Memory of block_count blocks of block_size bytes
+ *  uint16_t *free_stack: Array of block_count entries
+ *  uint32_t block_size: Size of a block in bytes
+ *  uint32_t block_count: Number of blocks, at most 65536
+ *
+ *******************************************************************************/
+void mem_pool_init(mem_pool_t *pool, const char *name, void *blocks, uint16_t *free_stack,
+                   uint32_t block_size, uint32_t block_count)
+{
+    CY_ASSERT((block_size > 0) && (block_count <= 65536u));
+
+    taskENTER_CRITICAL();
+    pool->name = name;
+    pool->blocks = (uint8_t *)blocks;
+    pool->free_stack = free_stack;
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->free_top = 0;
+    pool->fresh = 0;
+    pool->in_use = 0;
+    pool->high_water = 0;
+    pool->failures = 0;
+    taskEXIT_CRITICAL();
+
+    mem_pool_register(pool);
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_register
+ *******************************************************************************
+ * Summary:
+ *  Lists a pool in the statistics, once.
+ *
+ *******************************************************************************/
+void mem_pool_register(mem_pool_t *pool)
+{
+    taskENTER_CRITICAL();
+    if(!pool->registered)
+    {
+        pool->registered = true;
+        pool->next = registered_pools;
+        registered_pools = pool;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_alloc
+ *******************************************************************************
+ * Summary:
+ *  Takes a block of a pool. The content of the block is undefined.
+ *
+ * Parameters:
+ *  mem_pool_t *pool: Pool to allocate from
+ *
+ * Return:
+ *  void *: Block, or NULL if all the blocks are in use
+ *
+ *******************************************************************************/
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+    uint32_t index;
+
+    taskENTER_CRITICAL();
+
+    if(pool->free_top > 0)
+    {
+        index = pool->free_stack[--pool->free_top];
+    }
+    else if(pool->fresh < pool->block_count)
+    {
+        index = pool->fresh++;
+    }
+    else
+    {
+        pool->failures++;
+        taskEXIT_CRITICAL();
+        return NULL;
+    }
+
+    if(++pool->in_use > pool->high_water)
+    {
+        pool->high_water = pool->in_use;
+    }
+
+    taskEXIT_CRITICAL();
+
+    return &pool->blocks[index * pool->block_size];
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_free
+ *******************************************************************************
+ * Summary:
+ *  Returns a block to its pool.
+ *
+ * Parameters:
+ *  mem_pool_t *pool: Pool the block was allocated from
+ *  void *block: Block to release, may be NULL
+ *
+ *******************************************************************************/
+void mem_pool_free(mem_pool_t *pool, void *block)
+{
+    uint32_t offset;
+
+    if(block == NULL)
+    {
+        return;
+    }
+
+    CY_ASSERT(mem_pool_owns(pool, block));
+    offset = (uint32_t)((uint8_t *)block - pool->blocks);
+    CY_ASSERT((offset % pool->block_size) == 0);
+
+    taskENTER_CRITICAL();
+    CY_ASSERT(pool->in_use > 0);
+    pool->free_stack[pool->free_top++] = (uint16_t)(offset / pool->block_size);
+    pool->in_use--;
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_owns
+ *******************************************************************************
+ * Summary:
+ *  Returns whether a pointer lies in the memory of a pool.
+ *
+ *******************************************************************************/
+bool mem_pool_owns(const mem_pool_t *pool, const void *ptr)
+{
+    return ((const uint8_t *)ptr >= pool->blocks) &&
+           ((const uint8_t *)ptr < (pool->blocks + (pool->block_count * pool->block_size)));
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Returns the statistics of a pool: the malloc() size classes come first,
+ *  then the registered pools, latest first.
+ *
+ * Parameters:
+ *  uint32_t index: Index of the pool
+ *  mem_pool_stats_t *stats: Set to the statistics of the pool
+ *
+ * Return:
+ *  bool: false if there is no pool at that index
+ *
+ *******************************************************************************/
+bool mem_pool_get_stats(uint32_t index, mem_pool_stats_t *stats)
+{
+    const mem_pool_t *pool = NULL;
+
+    taskENTER_CRITICAL();
+
+#if(MEM_POOL_MALLOC_ENABLED)
+    if(index < MALLOC_POOL_COUNT)
+    {
+        pool = malloc_pools[index];
+    }
+    else
+#endif /* MEM_POOL_MALLOC_ENABLED */
+    {
+        index -= MALLOC_POOL_COUNT;
+        for(pool = registered_pools; (pool != NULL) && (index > 0); pool = pool->next)
+        {
+            index--;
+        }
+    }
+
+    if(pool != NULL)
+    {
+        stats->name = pool->name;
+        stats->block_size = pool->block_size;
+        stats->block_count = pool->block_count;
+        stats->in_use = pool->in_use;
+        stats->high_water = pool->high_water;
+        stats->failures = pool->failures;
+    }
+
+    taskEXIT_CRITICAL();
+
+    return (pool != NULL);
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_print
+ *******************************************************************************
+ * Summary:
+ *  Prints the statistics of every pool.
+ *
+ *******************************************************************************/
+void mem_pool_print(void)
+{
+    mem_pool_stats_t stats;
+
+    printf("Pool            block  blocks  in use    peak  failed\r\n");
+    for(uint32_t i = 0; mem_pool_get_stats(i, &stats); i++)
+    {
+        printf("%-14s %6"PRIu32" %7"PRIu32" %7"PRIu32" %7"PRIu32" %7"PRIu32"\r\n",
+               stats.name, stats.block_size, stats.block_count,
+               stats.in_use, stats.high_water, stats.failures);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_malloc
+ *******************************************************************************
+ * Summary:
+ *  Allocates from the smallest size class that fits, falling back to the next
+ *  one when it is exhausted.
+ *
+ * Parameters:
+ *  size_t size: Requested size in bytes
+ *
+ * Return:
+ *  void *: Block, or NULL if no size class can serve the request; always
+ *  NULL without MEM_POOL_MALLOC_ENABLED
+ *
+ *******************************************************************************/
+void *mem_pool_malloc(size_t size)
+{
+#if(MEM_POOL_MALLOC_ENABLED)
+    void *ptr;
+
+    for(uint32_t i = 0; i < MALLOC_POOL_COUNT; i++)
+    {
+        if(size <= malloc_pools[i]->block_size)
+        {
+            ptr = mem_pool_alloc(malloc_pools[i]);
+            if(ptr != NULL)
+            {
+                return ptr;
+            }
+        }
+    }
+#endif /* MEM_POOL_MALLOC_ENABLED */
+
+    (void)size;
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_malloc_size
+ *******************************************************************************
+ * Summary:
+ *  Returns the block size of a pointer allocated by mem_pool_malloc(), 0 if
+ *  the pointer comes from the heap.
+ *
+ *******************************************************************************/
+uint32_t mem_pool_malloc_size(const void *ptr)
+{
+#if(MEM_POOL_MALLOC_ENABLED)
+    for(uint32_t i = 0; i < MALLOC_POOL_COUNT; i++)
+    {
+        if(mem_pool_owns(malloc_pools[i], ptr))
+        {
+            return malloc_pools[i]->block_size;
+        }
+    }
+#endif /* MEM_POOL_MALLOC_ENABLED */
+
+    (void)ptr;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Function Name: mem_pool_malloc_free
+ *******************************************************************************
+ * Summary:
+ *  Releases a pointer allocated by mem_pool_malloc().
+ *
+ * Parameters:
+ *  void *ptr: Pointer to release
+ *
+ * Return:
+ *  bool: false if the pointer comes from the heap, and was not released
+ *
+ *******************************************************************************/
+bool mem_pool_malloc_free(void *ptr)
+{
+#if(MEM_POOL_MALLOC_ENABLED)
+    for(uint32_t i = 0; i < MALLOC_POOL_COUNT; i++)
+    {
+        if(mem_pool_owns(malloc_pools[i], ptr))
+        {
+            mem_pool_free(malloc_pools[i], ptr);
+            return true;
+        }
+    }
+#endif /* MEM_POOL_MALLOC_ENABLED */
+
+    (void)ptr;
+
+    return false;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,103 @@
+/******************************************************************************
+* File Name:   mem_pool.h
+*
+* Description: This file contains declaration of the fixed-block pools. A
+* pool hands out blocks of one size from memory reserved at build time, in
+* constant time: the blocks never allocated are taken in order, and the freed
+* ones are kept on a stack of block indexes, so that a free block is never
+* written to. Each pool counts its blocks in use, their high-water mark and
+* the allocations it failed.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef MEM_POOL_H_
+#define MEM_POOL_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pool sizing header file. */
+#include "mem_pool_config.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Alignment of the blocks of the pools defined with MEM_POOL_DEFINE(), that
+ * of malloc().
+ */
+#define MEM_POOL_ALIGN                            (_Alignof(max_align_t))
+#define MEM_POOL_BLOCK_SIZE(size)                 ((((size) + MEM_POOL_ALIGN - 1u) / MEM_POOL_ALIGN) * MEM_POOL_ALIGN)
+
+/* Defines a pool of 'count' blocks of at least 'size' bytes at file scope,
+ * usable without mem_pool_init(). Such a pool is not listed by
+ * mem_pool_get_stats() unless registered with mem_pool_register().
+ */
+#define MEM_POOL_DEFINE(pool, label, size, count)                                   \
+    static uint8_t pool##_blocks[(count) * MEM_POOL_BLOCK_SIZE(size)]               \
+        __attribute__((aligned(MEM_POOL_ALIGN)));                                   \
+    static uint16_t pool##_free[(count)];                                           \
+    static mem_pool_t pool =                                                        \
+    {                                                                               \
+        .name = (label),                                                            \
+        .blocks = pool##_blocks,                                                    \
+        .free_stack = pool##_free,                                                  \
+        .block_size = MEM_POOL_BLOCK_SIZE(size),                                    \
+        .block_count = (count)                                                      \
+    }
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Fixed-block pool. */
+typedef struct mem_pool
+{
+    const char *name;
+    uint8_t *blocks;
+    uint16_t *free_stack;               /* Indexes of the freed blocks. */
+    uint32_t block_size;
+    uint32_t block_count;               /* At most 65536. */
+    uint32_t free_top;                  /* Freed blocks on the stack. */
+    uint32_t fresh;                     /* Blocks from this index on were never allocated. */
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t failures;
+    bool registered;
+    struct mem_pool *next;              /* Registered pools. */
+} mem_pool_t;
+
+/* Statistics of a pool. */
+typedef struct
+{
+    const char *name;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t failures;
+} mem_pool_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void mem_pool_init(mem_pool_t *pool, const char *name, void *blocks, uint16_t *free_stack,
+                   uint32_t block_size, uint32_t block_count);
+void mem_pool_register(mem_pool_t *pool);
+void *mem_pool_alloc(mem_pool_t *pool);
+void mem_pool_free(mem_pool_t *pool, void *block);
+bool mem_pool_owns(const mem_pool_t *pool, const void *ptr);
+bool mem_pool_get_stats(uint32_t index, mem_pool_stats_t *stats);
+void mem_pool_print(void);
+
+/* Size classes serving malloc(), see MEM_POOL_MALLOC_ENABLED. */
+void *mem_pool_malloc(size_t size);
+uint32_t mem_pool_malloc_size(const void *ptr);
+bool mem_pool_malloc_free(void *ptr);
+
+#endif /* MEM_POOL_H_ */
@@ -0,0 +1,70 @@
+/******************************************************************************
+* File Name:   mem_pool_config.h
+*
+* Description: This file contains the sizing of the fixed-block pools. The
+* connection records are pooled in the connection table itself, one block per
+* client (see tcp_conn.c). With MEM_POOL_MALLOC_ENABLED, the malloc() calls
+* of up to MEM_POOL_LARGE_BLOCK_SIZE bytes are served from the two size
+* classes below, and only the larger ones, or those finding their class
+* exhausted, reach the heap. The size class histogram of the heap profiler
+* ('make HEAP_PROFILE=1') shows the sizes to tune them to.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef MEM_POOL_CONFIG_H_
+#define MEM_POOL_CONFIG_H_
+
+/* Connection table header file, for the number of clients. */
+#include "tcp_conn.h"
+
+/* Protocol header file, for the frame length. */
+#include "tcp_proto.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 1, e.g. with 'make MEM_POOL=1', to serve the small malloc() calls
+ * from the pools. The make variable wraps the allocator functions with the
+ * linker, as for the heap profiler.
+ */
+#ifndef MEM_POOL_MALLOC_ENABLED
+#define MEM_POOL_MALLOC_ENABLED                   (0)
+#endif
+
+/* Small size class: a protocol frame, and the objects the libraries
+ * allocate for every accepted client and every deferred socket callback,
+ * which are all up to 64 bytes.
+ */
+#ifndef MEM_POOL_SMALL_BLOCK_SIZE
+#define MEM_POOL_SMALL_BLOCK_SIZE                 (64u)
+#endif
+
+#ifndef MEM_POOL_SMALL_BLOCKS
+#define MEM_POOL_SMALL_BLOCKS                     ((4u * TCP_CONN_MAX_CLIENTS) + 16u)
+#endif
+
+/* Large size class: the socket contexts and the other per-client objects of
+ * the libraries.
+ */
+#ifndef MEM_POOL_LARGE_BLOCK_SIZE
+#define MEM_POOL_LARGE_BLOCK_SIZE                 (256u)
+#endif
+
+#ifndef MEM_POOL_LARGE_BLOCKS
+#define MEM_POOL_LARGE_BLOCKS                     (TCP_CONN_MAX_CLIENTS + 8u)
+#endif
+
+#if(MEM_POOL_SMALL_BLOCK_SIZE < TCP_PROTO_MAX_FRAME_LEN)
+#error "MEM_POOL_SMALL_BLOCK_SIZE must hold a protocol frame"
+#endif
+
+#if(MEM_POOL_LARGE_BLOCK_SIZE <= MEM_POOL_SMALL_BLOCK_SIZE)
+#error "MEM_POOL_LARGE_BLOCK_SIZE must be larger than MEM_POOL_SMALL_BLOCK_SIZE"
+#endif
+
+#endif /* MEM_POOL_CONFIG_H_ */
@@ -0,0 +1,925 @@
+/******************************************************************************
+* File Name:   metrics.c
+*
+* Description: This file contains the server health counters and the metrics
+* endpoint. The counters are updated with relaxed atomic adds where the
+* events happen. A second listening socket accepts HTTP requests; the
+* accepted sockets are handed to the metrics task, which renders the counters,
+* the command latency histograms, and the heap and lwIP pool usage in the
+* Prometheus text exposition format and sends them in small chunks, so that
+* a scrape neither holds the socket callbacks nor needs a large buffer.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/* Standard C header files */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* lwIP options header file, for the lwIP statistics. */
+#include "lwip/opt.h"
+#if(LWIP_STATS && (MEM_STATS || MEMP_STATS))
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#endif /* LWIP_STATS && (MEM_STATS || MEMP_STATS) */
+
+/* Metrics header file. */
+#include "metrics.h"
+
+/* Connection table header file. */
+#include "tcp_conn.h"
+
+/* Command latency measurement header file. */
+#include "cmd_latency.h"
+
+/* Heap usage header file. */
+#include "heap_usage.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Timing probe header file. */
+#include "perf_probe.h"
+
+/* Startup profiler header file. */
+#include "boot_profile.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/* Fixed-block pool header file. */
+#include "mem_pool.h"
+
+#if(METRICS_ENABLED)
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define METRICS_LISTEN_BACKLOG                    (2u)
+
+/* Accepted scrapes waiting for the metrics task. */
+#define METRICS_ACCEPT_QUEUE_LEN                  (2u)
+
+#define METRICS_RECV_TIMEOUT_MS                   (1000u)
+#define METRICS_SEND_TIMEOUT_MS                   (1000u)
+
+/* Size of the chunks the response is sent in. */
+#define METRICS_CHUNK_SIZE                        (512u)
+
+/* Longest request line kept, e.g. "GET /metrics HTTP/1.1". */
+#define METRICS_REQUEST_LINE_LEN                  (48u)
+
+#define NS_PER_SECOND                             (1000000000u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Errors of one cy_rslt_t code. A slot is free while 'result' is 0, which is
+ * CY_RSLT_SUCCESS and never counted.
+ */
+typedef struct
+{
+    cy_rslt_t result;
+    uint32_t count;
+} metrics_error_slot_t;
+
+/* Response being sent to a scraper. */
+typedef struct
+{
+    cy_socket_t handle;
+    cy_rslt_t result;                   /* First send error. */
+    uint32_t len;
+    char buf[METRICS_CHUNK_SIZE];
+} metrics_writer_t;
+
+/* Field of the memory pool statistics, of lwIP and of the application. */
+typedef enum
+{
+    POOL_USED = 0,
+    POOL_MAX,
+    POOL_AVAIL,
+    POOL_ERR
+} pool_field_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static cy_rslt_t metrics_connection_handler(cy_socket_t socket_handle, void *arg);
+static void metrics_task(void *arg);
+static void serve_client(cy_socket_t handle);
+static bool read_request_line(cy_socket_t handle, char *line, uint32_t line_size);
+static void emit(metrics_writer_t *w, const char *fmt, ...);
+static void emit_header(metrics_writer_t *w, const char *name, const char *type, const char *help);
+static void flush(metrics_writer_t *w);
+static const char *u64_to_str(uint64_t value, char *buf);
+static void render_metrics(metrics_writer_t *w);
+static void render_latency(metrics_writer_t *w);
+static void render_lwip(metrics_writer_t *w);
+static void render_pools(metrics_writer_t *w);
+static void render_boot(metrics_writer_t *w);
+#if(PERF_PROBE_ENABLED)
+static void render_probes(metrics_writer_t *w);
+#endif /* PERF_PROBE_ENABLED */
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+uint64_t metrics_counters[METRICS_COUNTER_COUNT];
+
+/* Socket errors by operation and code; 'errors_other' counts the codes
+ * past METRICS_MAX_ERROR_CODES.
+ */
+static metrics_error_slot_t error_slots[METRICS_OP_COUNT][METRICS_MAX_ERROR_CODES];
+static uint32_t errors_other[METRICS_OP_COUNT];
+
+static cy_socket_t metrics_handle;
+static QueueHandle_t accept_queue;
+STATIC_ALLOC_QUEUE_DEFINE(accept_queue, METRICS_ACCEPT_QUEUE_LEN, sizeof(cy_socket_t));
+STATIC_ALLOC_TASK_DEFINE(metrics_task, METRICS_TASK_STACK_SIZE);
+
+/* Only used by the metrics task. */
+static metrics_writer_t writer;
+
+static const char *const op_names[METRICS_OP_COUNT] =
+{
+    "accept",
+    "recv",
+    "send"
+};
+
+static const char *const stage_labels[CMD_LATENCY_STAGE_COUNT] =
+{
+    "isr_to_task",
+    "task_to_sent",
+    "sent_to_ack",
+    "isr_to_ack"
+};
+
+/* Upper bounds of the latency histogram buckets. */
+static const struct
+{
+    uint32_t ns;
+    const char *le;
+} latency_buckets[] =
+{
+    { 100000u,    "0.0001"  },
+    { 250000u,    "0.00025" },
+    { 500000u,    "0.0005"  },
+    { 1000000u,   "0.001"   },
+    { 2500000u,   "0.0025"  },
+    { 5000000u,   "0.005"   },
+    { 10000000u,  "0.01"    },
+    { 25000000u,  "0.025"   },
+    { 50000000u,  "0.05"    },
+    { 100000000u, "0.1"     },
+    { 250000000u, "0.25"    },
+    { 1000000000u, "1"      }
+};
+
+#if(LWIP_STATS && MEMP_STATS)
+/* Names of the lwIP memory pools, in the order of lwip_stats.memp[]. */
+static const char *const lwip_pool_names[] =
+{
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+#endif /* LWIP_STATS && MEMP_STATS */
+
+/*******************************************************************************
+ * Function Name: metrics_start
+ *******************************************************************************
+ * Summary:
+ *  Creates the metrics task and starts listening for scrapes on METRICS_PORT
+ *  of the server address.
+ *
+ * Parameters:
+ *  const cy_socket_sockaddr_t *server_addr: Address of the TCP server
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t metrics_start(const cy_socket_sockaddr_t *server_addr)
+{
+    cy_rslt_t result;
+    cy_socket_sockaddr_t metrics_addr = *server_addr;
+    cy_socket_opt_callback_t connection_option;
+
+    accept_queue = STATIC_ALLOC_QUEUE_CREATE(accept_queue, METRICS_ACCEPT_QUEUE_LEN, sizeof(cy_socket_t));
+    TRACE_QUEUE_NUMBER(accept_queue, TRACE_QUEUE_METRICS_ACCEPT);
+    if((accept_queue == NULL) ||
+       (STATIC_ALLOC_TASK_CREATE(metrics_task, metrics_task, "Metrics", METRICS_TASK_STACK_SIZE, NULL,
+                                 METRICS_TASK_PRIORITY, NULL) != pdPASS))
+    {
+        printf("Failed to create the metrics task\n");
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    result = cy_socket_create(CY_SOCKET_DOMAIN_AF_INET, CY_SOCKET_TYPE_STREAM,
+                              CY_SOCKET_IPPROTO_TCP, &metrics_handle);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to create the metrics socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    connection_option.callback = metrics_connection_handler;
+    connection_option.arg = NULL;
+
+    result = cy_socket_setsockopt(metrics_handle, CY_SOCKET_SOL_SOCKET,
+                                  CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK,
+                                  &connection_option, sizeof(cy_socket_opt_callback_t));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Set socket option: CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK failed\n");
+        return result;
+    }
+
+    metrics_addr.port = METRICS_PORT;
+    result = cy_socket_bind(metrics_handle, &metrics_addr, sizeof(metrics_addr));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to bind the metrics socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    result = cy_socket_listen(metrics_handle, METRICS_LISTEN_BACKLOG);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to listen on the metrics socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    printf("Serving metrics on Port: %d\n", METRICS_PORT);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_error
+ *******************************************************************************
+ * Summary:
+ *  Counts a failed socket operation under its result code. Lock-free; the
+ *  first caller with a new code claims a free slot for it.
+ *
+ * Parameters:
+ *  metrics_op_t op: Failed operation
+ *  cy_rslt_t result: Result code of the operation
+ *
+ *******************************************************************************/
+void metrics_error(metrics_op_t op, cy_rslt_t result)
+{
+    metrics_error_slot_t *slots = error_slots[op];
+    cy_rslt_t code;
+
+    for(uint32_t i = 0; i < METRICS_MAX_ERROR_CODES; i++)
+    {
+        code = __atomic_load_n(&slots[i].result, __ATOMIC_RELAXED);
+        if((code == CY_RSLT_SUCCESS) &&
+           __atomic_compare_exchange_n(&slots[i].result, &code, result, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            code = result;
+        }
+
+        if(code == result)
+        {
+            (void)__atomic_fetch_add(&slots[i].count, 1u, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    (void)__atomic_fetch_add(&errors_other[op], 1u, __ATOMIC_RELAXED);
+}
+
+/*******************************************************************************
+ * Function Name: metrics_connection_handler
+ *******************************************************************************
+ * Summary:
+ *  Accepts a scrape and hands it to the metrics task. Scrapes beyond
+ *  METRICS_ACCEPT_QUEUE_LEN are closed at once.
+ *
+ * Parameters:
+ *  cy_socket_t socket_handle: Metrics socket
+ *  void *arg: Unused
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+static cy_rslt_t metrics_connection_handler(cy_socket_t socket_handle, void *arg)
+{
+    cy_rslt_t result;
+    cy_socket_t client_handle;
+    cy_socket_sockaddr_t peer_addr;
+    uint32_t peer_addr_len = sizeof(peer_addr);
+
+    result = cy_socket_accept(socket_handle, &peer_addr, &peer_addr_len, &client_handle);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        APP_LOG_ERROR("Failed to accept a metrics scrape. Error code: 0x%08"PRIxPTR, (uint32_t)result);
+        return result;
+    }
+
+    if(xQueueSend(accept_queue, &client_handle, 0) != pdPASS)
+    {
+        cy_socket_disconnect(client_handle, 0);
+        cy_socket_delete(client_handle);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: metrics_task
+ *******************************************************************************
+ * Summary:
+ *  Serves the accepted scrapes one at a time.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused)
+ *
+ *******************************************************************************/
+static void metrics_task(void *arg)
+{
+    cy_socket_t client_handle;
+
+    while(true)
+    {
+        if(xQueueReceive(accept_queue, &client_handle, portMAX_DELAY) == pdPASS)
+        {
+            serve_client(client_handle);
+            cy_socket_disconnect(client_handle, 0);
+            cy_socket_delete(client_handle);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: serve_client
+ *******************************************************************************
+ * Summary:
+ *  Answers an HTTP request: GET /metrics (or /) with the metrics, anything
+ *  else with 404.
+ *
+ * Parameters:
+ *  cy_socket_t handle: Accepted socket of the scraper
+ *
+ *******************************************************************************/
+static void serve_client(cy_socket_t handle)
+{
+    char line[METRICS_REQUEST_LINE_LEN];
+    uint32_t recv_timeout = METRICS_RECV_TIMEOUT_MS;
+    uint32_t send_timeout = METRICS_SEND_TIMEOUT_MS;
+
+    cy_socket_setsockopt(handle, CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_RCVTIMEO,
+                         &recv_timeout, sizeof(recv_timeout));
+    cy_socket_setsockopt(handle, CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_SNDTIMEO,
+                         &send_timeout, sizeof(send_timeout));
+
+    if(!read_request_line(handle, line, sizeof(line)))
+    {
+        return;
+    }
+
+    writer.handle = handle;
+    writer.result = CY_RSLT_SUCCESS;
+    writer.len = 0;
+
+    if((strncmp(line, "GET /metrics ", 13) == 0) || (strncmp(line, "GET / ", 6) == 0))
+    {
+        emit(&writer, "HTTP/1.0 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4\r\n"
+                      "Connection: close\r\n\r\n");
+        render_metrics(&writer);
+    }
+    else
+    {
+        emit(&writer, "HTTP/1.0 404 Not Found\r\n"
+                      "Content-Type: text/plain\r\n"
+                      "Connection: close\r\n\r\n"
+                      "Not found\n");
+    }
+
+    flush(&writer);
+}
+
+/*******************************************************************************
+ * Function Name: read_request_line
+ *******************************************************************************
+ * Summary:
+ *  Reads an HTTP request head up to the blank line ending it, so that no
+ *  unread data makes closing the socket reset the connection, and keeps its
+ *  first line.
+ *
+ * Parameters:
+ *  cy_socket_t handle: Accepted socket of the scraper
+ *  char *line: Set to the request line, truncated to fit
+ *  uint32_t line_size: Size of the line buffer
+ *
+ * Return:
+ *  bool: true if a complete request head was read
+ *
+ *******************************************************************************/
+static bool read_request_line(cy_socket_t handle, char *line, uint32_t line_size)
+{
+    uint32_t line_len = 0;
+    uint32_t bytes_received;
+    bool line_done = false;
+    bool at_line_start = true;
+    char c;
+
+    while(true)
+    {
+        if(cy_socket_recv(handle, writer.buf, sizeof(writer.buf), CY_SOCKET_FLAGS_NONE,
+                          &bytes_received) != CY_RSLT_SUCCESS)
+        {
+            return false;
+        }
+
+        for(uint32_t i = 0; i < bytes_received; i++)
+        {
+            c = writer.buf[i];
+            if((c == '\r') || (c == '\n'))
+            {
+                line_done = true;
+            }
+            else if(!line_done && (line_len < (line_size - 1u)))
+            {
+                line[line_len++] = c;
+            }
+
+            /* A line feed at the start of a line ends the head. */
+            if(c == '\n')
+            {
+                if(at_line_start)
+                {
+                    line[line_len] = '\0';
+                    return true;
+                }
+                at_line_start = true;
+            }
+            else if(c != '\r')
+            {
+                at_line_start = false;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: emit
+ *******************************************************************************
+ * Summary:
+ *  Formats text into the response, sending the buffered chunk first when the
+ *  text does not fit. Lines longer than a chunk are truncated.
+ *
+ *******************************************************************************/
+static void emit(metrics_writer_t *w, const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    if(w->result != CY_RSLT_SUCCESS)
+    {
+        return;
+    }
+
+    va_start(args, fmt);
+    len = vsnprintf(&w->buf[w->len], sizeof(w->buf) - w->len, fmt, args);
+    va_end(args);
+
+    if((len >= 0) && ((uint32_t)len >= (sizeof(w->buf) - w->len)))
+    {
+        flush(w);
+
+        va_start(args, fmt);
+        len = vsnprintf(w->buf, sizeof(w->buf), fmt, args);
+        va_end(args);
+
+        if((uint32_t)len >= sizeof(w->buf))
+        {
+            len = (int)sizeof(w->buf) - 1;
+        }
+    }
+
+    if(len > 0)
+    {
+        w->len += (uint32_t)len;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: emit_header
+ *******************************************************************************
+ * Summary:
+ *  Writes the HELP and TYPE lines of a metric family.
+ *
+ *******************************************************************************/
+static void emit_header(metrics_writer_t *w, const char *name, const char *type, const char *help)
+{
+    emit(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/*******************************************************************************
+ * Function Name: flush
+ *******************************************************************************
+ * Summary:
+ *  Sends the buffered chunk of the response.
+ *
+ *******************************************************************************/
+static void flush(metrics_writer_t *w)
+{
+    uint32_t offset = 0;
+    uint32_t bytes_sent;
+
+    while((w->result == CY_RSLT_SUCCESS) && (offset < w->len))
+    {
+        bytes_sent = 0;
+        w->result = cy_socket_send(w->handle, &w->buf[offset], w->len - offset,
+                                   CY_SOCKET_FLAGS_NONE, &bytes_sent);
+        if((w->result == CY_RSLT_SUCCESS) && (bytes_sent == 0))
+        {
+            w->result = CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+        }
+        offset += bytes_sent;
+    }
+
+    w->len = 0;
+}
+
+/*******************************************************************************
+ * Function Name: u64_to_str
+ *******************************************************************************
+ * Summary:
+ *  Formats a 64-bit counter in decimal; newlib-nano printf() has no %llu.
+ *
+ * Parameters:
+ *  uint64_t value: Value to format
+ *  char *buf: Buffer of at least 21 bytes
+ *
+ * Return:
+ *  const char *: Start of the formatted value in the buffer
+ *
+ *******************************************************************************/
+static const char *u64_to_str(uint64_t value, char *buf)
+{
+    char *p = &buf[20];
+
+    *p = '\0';
+    do
+    {
+        *--p = (char)('0' + (value % 10u));
+        value /= 10u;
+    } while(value > 0);
+
+    return p;
+}
+
+/*******************************************************************************
+ * Function Name: render_metrics
+ *******************************************************************************
+ * Summary:
+ *  Writes all the metrics.
+ *
+ *******************************************************************************/
+static void render_metrics(metrics_writer_t *w)
+{
+    static const struct
+    {
+        metrics_counter_t counter;
+        const char *name;
+        const char *help;
+    } counters[] =
+    {
+        { METRICS_ACCEPTS,         "tcp_server_accepts_total",         "TCP clients accepted." },
+        { METRICS_REJECTS,         "tcp_server_rejects_total",         "TCP clients refused on a full connection table." },
+        { METRICS_DISCONNECTS,     "tcp_server_disconnects_total",     "TCP client connections closed." },
+        { METRICS_RX_BYTES,        "tcp_server_rx_bytes_total",        "Bytes received from the TCP clients." },
+        { METRICS_TX_BYTES,        "tcp_server_tx_bytes_total",        "Bytes sent to the TCP clients." },
+        { METRICS_RX_COPIED_BYTES, "tcp_server_rx_copied_bytes_total", "Received bytes copied by the message parsers." }
+    };
+    char num[21];
+    uint32_t count;
+    uint32_t heap_in_use;
+    uint32_t heap_arena;
+    heap_free_stats_t heap_free;
+
+    for(uint32_t i = 0; i < (sizeof(counters) / sizeof(counters[0])); i++)
+    {
+        emit_header(w, counters[i].name, "counter", counters[i].help);
+        emit(w, "%s %s\n", counters[i].name,
+             u64_to_str(__atomic_load_n(&metrics_counters[counters[i].counter], __ATOMIC_RELAXED), num));
+    }
+
+    emit_header(w, "tcp_server_clients", "gauge", "TCP clients connected.");
+    emit(w, "tcp_server_clients %"PRIu32"\n", tcp_conn_count());
+
+    emit_header(w, "tcp_server_socket_errors_total", "counter", "Failed socket calls by cy_rslt_t code.");
+    for(uint32_t op = 0; op < METRICS_OP_COUNT; op++)
+    {
+        for(uint32_t i = 0; i < METRICS_MAX_ERROR_CODES; i++)
+        {
+            count = __atomic_load_n(&error_slots[op][i].count, __ATOMIC_RELAXED);
+            if(count > 0)
+            {
+                emit(w, "tcp_server_socket_errors_total{op=\"%s\",code=\"0x%08"PRIx32"\"} %"PRIu32"\n",
+                     op_names[op], (uint32_t)error_slots[op][i].result, count);
+            }
+        }
+
+        count = __atomic_load_n(&errors_other[op], __ATOMIC_RELAXED);
+        if(count > 0)
+        {
+            emit(w, "tcp_server_socket_errors_total{op=\"%s\",code=\"other\"} %"PRIu32"\n",
+                 op_names[op], count);
+        }
+    }
+
+    render_latency(w);
+
+    heap_usage_get(&heap_in_use, &heap_arena);
+    emit_header(w, "heap_in_use_bytes", "gauge", "Heap allocated.");
+    emit(w, "heap_in_use_bytes %"PRIu32"\n", heap_in_use);
+    emit_header(w, "heap_arena_bytes", "gauge", "Heap taken from the system; it is never given back.");
+    emit(w, "heap_arena_bytes %"PRIu32"\n", heap_arena);
+    heap_usage_get_free(&heap_free);
+    emit_header(w, "heap_free_bytes", "gauge", "Free memory of the heap serving malloc().");
+    emit(w, "heap_free_bytes %"PRIu32"\n", heap_free.free_bytes);
+    emit_header(w, "heap_free_blocks", "gauge", "Free blocks of the heap serving malloc(); more blocks, more fragmentation.");
+    emit(w, "heap_free_blocks %"PRIu32"\n", heap_free.free_blocks);
+    emit_header(w, "heap_largest_free_bytes", "gauge", "Largest free block of the TLSF heap; 0 with newlib.");
+    emit(w, "heap_largest_free_bytes %"PRIu32"\n", heap_free.largest_free);
+    emit_header(w, "heap_tlsf_fallbacks_total", "counter", "Allocations the TLSF heap passed to newlib.");
+    emit(w, "heap_tlsf_fallbacks_total %"PRIu32"\n", heap_free.fallbacks);
+    emit_header(w, "heap_allocs_after_ready_total", "counter",
+                "Heap allocations since the server started listening; 0 without the heap guard.");
+    emit(w, "heap_allocs_after_ready_total %"PRIu32"\n", heap_guard_get(NULL));
+
+    emit_header(w, "app_log_dropped_total", "counter", "Log records dropped on a full log ring.");
+    emit(w, "app_log_dropped_total %"PRIu32"\n", app_log_dropped());
+
+    render_pools(w);
+    render_lwip(w);
+    render_boot(w);
+
+#if(PERF_PROBE_ENABLED)
+    render_probes(w);
+#endif /* PERF_PROBE_ENABLED */
+}
+
+/*******************************************************************************
+ * Function Name: render_latency
+ *******************************************************************************
+ * Summary:
+ *  Writes the command latency histograms of every stage. The cumulative
+ *  bucket counts come from the log-linear histograms, so a sample within
+ *  6.25% below a bound may be counted in the next bucket.
+ *
+ *******************************************************************************/
+static void render_latency(metrics_writer_t *w)
+{
+    static const char name[] = "tcp_server_command_latency_seconds";
+    const latency_hist_t *hist;
+    uint32_t cumulative;
+    uint32_t count;
+    uint64_t sum;
+    char num[21];
+
+    emit_header(w, name, "histogram", "LED command latency by stage.");
+
+    for(uint32_t stage = 0; stage < CMD_LATENCY_STAGE_COUNT; stage++)
+    {
+        hist = cmd_latency_hist((cmd_latency_stage_t)stage);
+        cumulative = 0;
+
+        for(uint32_t i = 0; i < (sizeof(latency_buckets) / sizeof(latency_buckets[0])); i++)
+        {
+            cumulative = latency_hist_count_at_most(hist, latency_buckets[i].ns);
+            emit(w, "%s_bucket{stage=\"%s\",le=\"%s\"} %"PRIu32"\n",
+                 name, stage_labels[stage], latency_buckets[i].le, cumulative);
+        }
+
+        /* Recorded without a lock: keep the count at least the buckets. */
+        count = hist->count;
+        if(count < cumulative)
+        {
+            count = cumulative;
+        }
+        sum = hist->sum;
+
+        emit(w, "%s_bucket{stage=\"%s\",le=\"+Inf\"} %"PRIu32"\n", name, stage_labels[stage], count);
+        emit(w, "%s_sum{stage=\"%s\"} %s.%09"PRIu32"\n", name, stage_labels[stage],
+             u64_to_str(sum / NS_PER_SECOND, num), (uint32_t)(sum % NS_PER_SECOND));
+        emit(w, "%s_count{stage=\"%s\"} %"PRIu32"\n", name, stage_labels[stage], count);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: render_lwip
+ *******************************************************************************
+ * Summary:
+ *  Writes the usage of the lwIP heap and memory pools, if lwipopts.h enables
+ *  LWIP_STATS with MEM_STATS and MEMP_STATS.
+ *
+ *******************************************************************************/
+static void render_lwip(metrics_writer_t *w)
+{
+#if(LWIP_STATS && MEMP_STATS)
+    static const struct
+    {
+        pool_field_t field;
+        const char *name;
+        const char *type;
+        const char *help;
+    } pool_families[] =
+    {
+        { POOL_USED,  "lwip_memp_used",         "gauge",   "lwIP pool entries in use." },
+        { POOL_MAX,   "lwip_memp_max",          "gauge",   "Most lwIP pool entries ever in use." },
+        { POOL_AVAIL, "lwip_memp_avail",        "gauge",   "lwIP pool entries." },
+        { POOL_ERR,   "lwip_memp_errors_total", "counter", "lwIP pool allocations failed." }
+    };
+    const struct stats_mem *pool;
+    uint32_t value;
+
+    for(uint32_t f = 0; f < (sizeof(pool_families) / sizeof(pool_families[0])); f++)
+    {
+        emit_header(w, pool_families[f].name, pool_families[f].type, pool_families[f].help);
+        for(uint32_t i = 0; i < (uint32_t)MEMP_MAX; i++)
+        {
+            pool = lwip_stats.memp[i];
+            if(pool == NULL)
+            {
+                continue;
+            }
+
+            switch(pool_families[f].field)
+            {
+                case POOL_USED:  value = (uint32_t)pool->used;  break;
+                case POOL_MAX:   value = (uint32_t)pool->max;   break;
+                case POOL_AVAIL: value = (uint32_t)pool->avail; break;
+                default:         value = (uint32_t)pool->err;   break;
+            }
+            emit(w, "%s{pool=\"%s\"} %"PRIu32"\n", pool_families[f].name, lwip_pool_names[i], value);
+        }
+    }
+#endif /* LWIP_STATS && MEMP_STATS */
+
+#if(LWIP_STATS && MEM_STATS)
+    emit_header(w, "lwip_mem_used_bytes", "gauge", "lwIP heap in use.");
+    emit(w, "lwip_mem_used_bytes %"PRIu32"\n", (uint32_t)lwip_stats.mem.used);
+    emit_header(w, "lwip_mem_max_bytes", "gauge", "Most lwIP heap ever in use.");
+    emit(w, "lwip_mem_max_bytes %"PRIu32"\n", (uint32_t)lwip_stats.mem.max);
+    emit_header(w, "lwip_mem_errors_total", "counter", "lwIP heap allocations failed.");
+    emit(w, "lwip_mem_errors_total %"PRIu32"\n", (uint32_t)lwip_stats.mem.err);
+#endif /* LWIP_STATS && MEM_STATS */
+
+    (void)w;
+}
+
+/*******************************************************************************
+ * Function Name: render_pools
+ *******************************************************************************
+ * Summary:
+ *  Writes the statistics of the fixed-block pools of the application.
+ *
+ *******************************************************************************/
+static void render_pools(metrics_writer_t *w)
+{
+    static const struct
+    {
+        pool_field_t field;
+        const char *name;
+        const char *type;
+        const char *help;
+    } pool_families[] =
+    {
+        { POOL_USED,  "mem_pool_used",           "gauge",   "Pool blocks in use." },
+        { POOL_MAX,   "mem_pool_max",            "gauge",   "Most pool blocks ever in use." },
+        { POOL_AVAIL, "mem_pool_avail",          "gauge",   "Pool blocks." },
+        { POOL_ERR,   "mem_pool_failures_total", "counter", "Pool allocations failed." }
+    };
+    mem_pool_stats_t stats;
+    uint32_t value;
+
+    for(uint32_t f = 0; f < (sizeof(pool_families) / sizeof(pool_families[0])); f++)
+    {
+        emit_header(w, pool_families[f].name, pool_families[f].type, pool_families[f].help);
+        for(uint32_t i = 0; mem_pool_get_stats(i, &stats); i++)
+        {
+            switch(pool_families[f].field)
+            {
+                case POOL_USED:  value = stats.in_use;      break;
+                case POOL_MAX:   value = stats.high_water;  break;
+                case POOL_AVAIL: value = stats.block_count; break;
+                default:         value = stats.failures;    break;
+            }
+            emit(w, "%s{pool=\"%s\",block=\"%"PRIu32"\"} %"PRIu32"\n",
+                 pool_families[f].name, stats.name, stats.block_size, value);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: render_boot
+ *******************************************************************************
+ * Summary:
+ *  Writes the startup figures. The times of the previous and the best boot
+ *  are left out while unknown.
+ *
+ *******************************************************************************/
+static void render_boot(metrics_writer_t *w)
+{
+    boot_profile_summary_t boot;
+
+    boot_profile_get(&boot);
+
+    emit_header(w, "boot_count", "gauge", "Boots since the startup history was lost.");
+    emit(w, "boot_count %"PRIu32"\n", boot.boot_count);
+
+    emit_header(w, "boot_time_to_listen_seconds", "gauge", "Time from main() to the first listen, by boot.");
+    emit(w, "boot_time_to_listen_seconds{boot=\"current\"} %"PRIu32".%06"PRIu32"\n",
+         boot.ready_us / 1000000u, boot.ready_us % 1000000u);
+    if(boot.previous_ready_us > 0)
+    {
+        emit(w, "boot_time_to_listen_seconds{boot=\"previous\"} %"PRIu32".%06"PRIu32"\n",
+             boot.previous_ready_us / 1000000u, boot.previous_ready_us % 1000000u);
+    }
+    if(boot.best_ready_us > 0)
+    {
+        emit(w, "boot_time_to_listen_seconds{boot=\"best\"} %"PRIu32".%06"PRIu32"\n",
+             boot.best_ready_us / 1000000u, boot.best_ready_us % 1000000u);
+    }
+}
+
+#if(PERF_PROBE_ENABLED)
+/*******************************************************************************
+ * Function Name: render_probes
+ *******************************************************************************
+ * Summary:
+ *  Writes the statistics of the timing probes.
+ *
+ *******************************************************************************/
+static void render_probes(metrics_writer_t *w)
+{
+    static const struct
+    {
+        const char *name;
+        const char *type;
+        const char *help;
+    } probe_families[] =
+    {
+        { "perf_probe_calls_total",   "counter", "Probed calls." },
+        { "perf_probe_seconds_total", "counter", "Time spent in the probed calls." },
+        { "perf_probe_min_seconds",   "gauge",   "Shortest probed call." },
+        { "perf_probe_max_seconds",   "gauge",   "Longest probed call." }
+    };
+    perf_probe_stat_t stats[PERF_PROBE_COUNT];
+    uint64_t ticks;
+    char num[21];
+
+    for(uint32_t i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        perf_probe_get((perf_probe_id_t)i, &stats[i]);
+    }
+
+    for(uint32_t f = 0; f < (sizeof(probe_families) / sizeof(probe_families[0])); f++)
+    {
+        emit_header(w, probe_families[f].name, probe_families[f].type, probe_families[f].help);
+        for(uint32_t i = 0; i < PERF_PROBE_COUNT; i++)
+        {
+            if(f == 0)
+            {
+                emit(w, "%s{probe=\"%s\"} %"PRIu32"\n", probe_families[f].name,
+                     perf_probe_name((perf_probe_id_t)i), stats[i].count);
+                continue;
+            }
+
+            ticks = (f == 1) ? stats[i].total : ((f == 2) ? stats[i].min : stats[i].max);
+            emit(w, "%s{probe=\"%s\"} %s.%09"PRIu32"\n", probe_families[f].name,
+                 perf_probe_name((perf_probe_id_t)i), u64_to_str(ticks / TIMESTAMP_HZ, num),
+                 (uint32_t)(((ticks % TIMESTAMP_HZ) * NS_PER_SECOND) / TIMESTAMP_HZ));
+        }
+    }
+}
+#endif /* PERF_PROBE_ENABLED */
+#endif /* METRICS_ENABLED */
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+/******************************************************************************
+* File Name:   metrics.h
+*
+* Description: This file contains declaration of the server health counters
+* and of the metrics endpoint, which serves them in the Prometheus text
+* exposition format on a second listening socket.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 0 to leave out the counters and the metrics endpoint. */
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED                           (1)
+#endif
+
+/* Port of the metrics endpoint. */
+#ifndef METRICS_PORT
+#define METRICS_PORT                              (50080)
+#endif
+
+#define METRICS_TASK_STACK_SIZE                   (1024 * 2)
+#define METRICS_TASK_PRIORITY                     (1)
+
+/* Number of distinct cy_rslt_t codes counted per operation; further codes
+ * are counted together.
+ */
+#define METRICS_MAX_ERROR_CODES                   (8u)
+
+#if(METRICS_ENABLED)
+/* Counter updates: one relaxed atomic add, cheap enough for the data path. */
+#define METRICS_ADD(counter, n)                   ((void)__atomic_fetch_add(&metrics_counters[(counter)], \
+                                                   (uint64_t)(n), __ATOMIC_RELAXED))
+#define METRICS_ERROR(op, result)                 metrics_error((op), (result))
+#else
+#define METRICS_ADD(counter, n)                   ((void)0)
+#define METRICS_ERROR(op, result)                 ((void)0)
+#endif /* METRICS_ENABLED */
+
+#define METRICS_INC(counter)                      METRICS_ADD((counter), 1u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Counters. */
+typedef enum
+{
+    METRICS_ACCEPTS = 0,            /* TCP clients accepted. */
+    METRICS_REJECTS,                /* TCP clients refused on a full table. */
+    METRICS_DISCONNECTS,            /* TCP client connections closed. */
+    METRICS_RX_BYTES,               /* Bytes received from the TCP clients. */
+    METRICS_TX_BYTES,               /* Bytes sent to the TCP clients. */
+    METRICS_RX_COPIED_BYTES,        /* Received bytes copied by the message parsers. */
+    METRICS_COUNTER_COUNT
+} metrics_counter_t;
+
+/* Socket operations whose errors are counted by cy_rslt_t code. */
+typedef enum
+{
+    METRICS_OP_ACCEPT = 0,
+    METRICS_OP_RECV,
+    METRICS_OP_SEND,
+    METRICS_OP_COUNT
+} metrics_op_t;
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+extern uint64_t metrics_counters[METRICS_COUNTER_COUNT];
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t metrics_start(const cy_socket_sockaddr_t *server_addr);
+void metrics_error(metrics_op_t op, cy_rslt_t result);
+
+#endif /* METRICS_H_ */
@@ -0,0 +1,188 @@
+/******************************************************************************
+* File Name:   perf_probe.c
+*
+* Description: This file contains the statistics of the timing probes. The
+* probed calls are made from several tasks, so each probe is updated inside a
+* short critical section; the statistics are read the same way, so that a
+* snapshot of a probe is always consistent.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header files */
+#include <string.h>
+#include <inttypes.h>
+
+/* Timing probe header file. */
+#include "perf_probe.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static uint32_t ticks_to_us(uint64_t ticks, uint32_t *frac);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static perf_probe_stat_t probe_stats[PERF_PROBE_COUNT];
+
+static const char *const probe_names[PERF_PROBE_COUNT] =
+{
+    "wcm_connect_ap",
+    "accept",
+    "socket_options",
+    "recv",
+    "send",
+    "connection_handler",
+    "receive_handler"
+};
+
+/*******************************************************************************
+ * Function Name: perf_probe_record
+ *******************************************************************************
+ * Summary:
+ *  Adds a call to the statistics of a probe.
+ *
+ * Parameters:
+ *  perf_probe_id_t id: Probe
+ *  uint32_t ticks: Duration of the call in timestamp ticks
+ *
+ *******************************************************************************/
+void perf_probe_record(perf_probe_id_t id, uint32_t ticks)
+{
+    perf_probe_stat_t *stat = &probe_stats[id];
+
+    taskENTER_CRITICAL();
+
+    if((stat->count == 0) || (ticks < stat->min))
+    {
+        stat->min = ticks;
+    }
+    if(ticks > stat->max)
+    {
+        stat->max = ticks;
+    }
+    stat->count++;
+    stat->total += ticks;
+
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: perf_probe_get
+ *******************************************************************************
+ * Summary:
+ *  Copies the statistics of a probe.
+ *
+ * Parameters:
+ *  perf_probe_id_t id: Probe
+ *  perf_probe_stat_t *stat: Set to the statistics, in timestamp ticks
+ *
+ *******************************************************************************/
+void perf_probe_get(perf_probe_id_t id, perf_probe_stat_t *stat)
+{
+    taskENTER_CRITICAL();
+    *stat = probe_stats[id];
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: perf_probe_name
+ *******************************************************************************
+ * Summary:
+ *  Returns the name of a probe.
+ *
+ *******************************************************************************/
+const char *perf_probe_name(perf_probe_id_t id)
+{
+    return probe_names[id];
+}
+
+/*******************************************************************************
+ * Function Name: perf_probe_reset
+ *******************************************************************************
+ * Summary:
+ *  Clears the statistics of every probe.
+ *
+ *******************************************************************************/
+void perf_probe_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(probe_stats, 0, sizeof(probe_stats));
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+ * Function Name: ticks_to_us
+ *******************************************************************************
+ * Summary:
+ *  Converts timestamp ticks to microseconds.
+ *
+ * Parameters:
+ *  uint64_t ticks: Duration in timestamp ticks
+ *  uint32_t *frac: Set to the thousandths of a microsecond
+ *
+ * Return:
+ *  uint32_t: Whole microseconds
+ *
+ *******************************************************************************/
+static uint32_t ticks_to_us(uint64_t ticks, uint32_t *frac)
+{
+    uint64_t ns = (ticks * 1000000000u) / TIMESTAMP_HZ;
+
+    *frac = (uint32_t)(ns % 1000u);
+
+    return (uint32_t)(ns / 1000u);
+}
+
+/*******************************************************************************
+ * Function Name: perf_probe_print
+ *******************************************************************************
+ * Summary:
+ *  Logs the statistics of every probe that was called, in microseconds.
+ *
+ *******************************************************************************/
+void perf_probe_print(void)
+{
+    perf_probe_stat_t stat;
+    uint32_t min_frac;
+    uint32_t mean_frac;
+    uint32_t max_frac;
+    uint32_t min_us;
+    uint32_t mean_us;
+    uint32_t max_us;
+
+    APP_LOG_INFO("Probe (us)               count          min         mean          max");
+
+    for(uint32_t i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        perf_probe_get((perf_probe_id_t)i, &stat);
+        if(stat.count == 0)
+        {
+            continue;
+        }
+
+        min_us = ticks_to_us(stat.min, &min_frac);
+        mean_us = ticks_to_us(stat.total / stat.count, &mean_frac);
+        max_us = ticks_to_us(stat.max, &max_frac);
+        APP_LOG_INFO("  %-20s %10"PRIuPTR" %8"PRIuPTR".%03"PRIuPTR" %8"PRIuPTR".%03"PRIuPTR" %8"PRIuPTR".%03"PRIuPTR,
+                     APP_LOG_STR(probe_names[i]), stat.count, min_us, min_frac,
+                     mean_us, mean_frac, max_us, max_frac);
+    }
+}
+
+/* [] END OF FILE */
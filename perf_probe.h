@@ -0,0 +1,114 @@
+/******************************************************************************
+* File Name:   perf_probe.h
+*
+* Description: This file contains the timing probes of the hot socket and
+* Wi-Fi calls. A probe times the statement it wraps with the timestamp
+* counter, the Cortex-R4 cycle counter on the CYW43907 and the monotonic
+* clock in the host build, and accumulates the count, minimum, maximum and
+* total time of its calls. With PERF_PROBE_ENABLED 0 a probe is only the
+* statement it wraps.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef PERF_PROBE_H_
+#define PERF_PROBE_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 1, e.g. with 'make DEFINES=PERF_PROBE_ENABLED=1', to time the probed
+ * calls.
+ */
+#ifndef PERF_PROBE_ENABLED
+#define PERF_PROBE_ENABLED                        (0)
+#endif
+
+/* Times the statement given after the probe identifier, for example
+ * PERF_PROBE(PERF_PROBE_RECV, result = cy_socket_recv(...));
+ * Variables declared in the statement are local to the probe.
+ */
+#if(PERF_PROBE_ENABLED)
+#define PERF_PROBE(id, ...)                                                         \
+    do                                                                              \
+    {                                                                               \
+        uint32_t perf_probe_start_ = timestamp_now();                               \
+        __VA_ARGS__;                                                                \
+        perf_probe_record((id), timestamp_now() - perf_probe_start_);               \
+    } while(0)
+#else
+#define PERF_PROBE(id, ...)                                                         \
+    do                                                                              \
+    {                                                                               \
+        __VA_ARGS__;                                                                \
+    } while(0)
+#endif /* PERF_PROBE_ENABLED */
+
+/* Times the rest of the enclosing block, whichever way the block is left. */
+#if(PERF_PROBE_ENABLED)
+#define PERF_PROBE_SCOPE(id)                                                        \
+    perf_probe_scope_t perf_probe_scope_ __attribute__((cleanup(perf_probe_scope_exit))) = \
+        { (id), timestamp_now() }
+#else
+#define PERF_PROBE_SCOPE(id)                      ((void)0)
+#endif /* PERF_PROBE_ENABLED */
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Probed calls. */
+typedef enum
+{
+    PERF_PROBE_WCM_CONNECT_AP = 0,  /* cy_wcm_connect_ap() */
+    PERF_PROBE_ACCEPT,              /* cy_socket_accept() of a TCP client */
+    PERF_PROBE_SOCKET_OPTIONS,      /* tcp_sockopt_accept() of a TCP client */
+    PERF_PROBE_RECV,                /* cy_socket_recv() in the receive handler */
+    PERF_PROBE_SEND,                /* cy_socket_send() in the TCP writer task */
+    PERF_PROBE_CONNECTION_HANDLER,  /* tcp_connection_handler(), whole callback */
+    PERF_PROBE_RECEIVE_HANDLER,     /* tcp_receive_msg_handler(), whole callback */
+    PERF_PROBE_COUNT
+} perf_probe_id_t;
+
+/* Accumulated calls of a probe, in timestamp ticks. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} perf_probe_stat_t;
+
+/* Block timed by PERF_PROBE_SCOPE(). */
+typedef struct
+{
+    perf_probe_id_t id;
+    uint32_t start;
+} perf_probe_scope_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void perf_probe_record(perf_probe_id_t id, uint32_t ticks);
+void perf_probe_get(perf_probe_id_t id, perf_probe_stat_t *stat);
+const char *perf_probe_name(perf_probe_id_t id);
+void perf_probe_reset(void);
+void perf_probe_print(void);
+
+#if(PERF_PROBE_ENABLED)
+static inline void perf_probe_scope_exit(const perf_probe_scope_t *scope)
+{
+    perf_probe_record(scope->id, timestamp_now() - scope->start);
+}
+#endif /* PERF_PROBE_ENABLED */
+
+#endif /* PERF_PROBE_H_ */
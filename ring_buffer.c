@@ -0,0 +1,283 @@
+/******************************************************************************
+* File Name:   ring_buffer.c
+*
+* Description: This file contains a lock-free single-producer, single-consumer
+* byte ring buffer. The producer publishes data by advancing the head with
+* release ordering after the bytes are copied; the consumer frees space by
+* advancing the tail the same way.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Standard C header file */
+#include <string.h>
+
+/* Ring buffer header file. */
+#include "ring_buffer.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define LOAD_ACQUIRE(p)                           __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v)                       __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/*******************************************************************************
+ * Function Name: ring_buffer_init
+ *******************************************************************************
+ * Summary:
+ *  Initializes an empty ring buffer on the given storage.
+ *
+ * Parameters:
+ *  ring_buffer_t *rb: Ring buffer
+ *  uint8_t *storage: Storage of the ring buffer
+ *  uint32_t size: Size of the storage in bytes, a power of two
+ *
+ *******************************************************************************/
+void ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint32_t size)
+{
+    rb->storage = storage;
+    rb->size = size;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_reset
+ *******************************************************************************
+ * Summary:
+ *  Discards the content of the ring buffer. Must not run concurrently with the
+ *  producer or the consumer.
+ *
+ *******************************************************************************/
+void ring_buffer_reset(ring_buffer_t *rb)
+{
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_used
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of bytes stored in the ring buffer.
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_used(const ring_buffer_t *rb)
+{
+    return LOAD_ACQUIRE(&rb->head) - LOAD_ACQUIRE(&rb->tail);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_free
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of bytes that can be written to the ring buffer.
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_free(const ring_buffer_t *rb)
+{
+    return rb->size - ring_buffer_used(rb);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_write
+ *******************************************************************************
+ * Summary:
+ *  Copies a block of data into the ring buffer. The block is either written
+ *  completely or not at all, so fixed size records stay intact.
+ *
+ * Parameters:
+ *  ring_buffer_t *rb: Ring buffer
+ *  const void *data: Data to write
+ *  uint32_t len: Number of bytes to write
+ *
+ * Return:
+ *  bool: true if the data was written, false if there was not enough space
+ *
+ *******************************************************************************/
+bool ring_buffer_write(ring_buffer_t *rb, const void *data, uint32_t len)
+{
+    uint32_t head = rb->head;
+    uint32_t offset = head & (rb->size - 1);
+    uint32_t first;
+
+    if(ring_buffer_free(rb) < len)
+    {
+        return false;
+    }
+
+    first = rb->size - offset;
+    if(first > len)
+    {
+        first = len;
+    }
+
+    memcpy(&rb->storage[offset], data, first);
+    memcpy(rb->storage, (const uint8_t *)data + first, len - first);
+
+    STORE_RELEASE(&rb->head, head + len);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_write_span
+ *******************************************************************************
+ * Summary:
+ *  Returns the largest contiguous free region of the ring buffer, so that the
+ *  producer can fill it in place and then call ring_buffer_commit().
+ *
+ * Parameters:
+ *  ring_buffer_t *rb: Ring buffer
+ *  uint8_t **span: Set to the start of the free region
+ *
+ * Return:
+ *  uint32_t: Length of the free region in bytes
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_write_span(ring_buffer_t *rb, uint8_t **span)
+{
+    uint32_t offset = rb->head & (rb->size - 1);
+    uint32_t free_bytes = ring_buffer_free(rb);
+    uint32_t contiguous = rb->size - offset;
+
+    *span = &rb->storage[offset];
+
+    return (free_bytes < contiguous) ? free_bytes : contiguous;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_commit
+ *******************************************************************************
+ * Summary:
+ *  Publishes bytes written in place after ring_buffer_write_span().
+ *
+ *******************************************************************************/
+void ring_buffer_commit(ring_buffer_t *rb, uint32_t len)
+{
+    STORE_RELEASE(&rb->head, rb->head + len);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_peek
+ *******************************************************************************
+ * Summary:
+ *  Copies data out of the ring buffer without consuming it.
+ *
+ * Parameters:
+ *  const ring_buffer_t *rb: Ring buffer
+ *  uint32_t offset: Offset of the first byte from the read position
+ *  void *data: Destination buffer
+ *  uint32_t len: Maximum number of bytes to copy
+ *
+ * Return:
+ *  uint32_t: Number of bytes copied
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_peek(const ring_buffer_t *rb, uint32_t offset, void *data, uint32_t len)
+{
+    uint32_t used = ring_buffer_used(rb);
+    uint32_t start;
+    uint32_t first;
+
+    if(offset >= used)
+    {
+        return 0;
+    }
+    if(len > used - offset)
+    {
+        len = used - offset;
+    }
+
+    start = (rb->tail + offset) & (rb->size - 1);
+    first = rb->size - start;
+    if(first > len)
+    {
+        first = len;
+    }
+
+    memcpy(data, &rb->storage[start], first);
+    memcpy((uint8_t *)data + first, rb->storage, len - first);
+
+    return len;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_peek_byte
+ *******************************************************************************
+ * Summary:
+ *  Returns one byte of the ring buffer without consuming it. The caller must
+ *  make sure that 'offset' is less than ring_buffer_used().
+ *
+ *******************************************************************************/
+uint8_t ring_buffer_peek_byte(const ring_buffer_t *rb, uint32_t offset)
+{
+    return rb->storage[(rb->tail + offset) & (rb->size - 1)];
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_read_span
+ *******************************************************************************
+ * Summary:
+ *  Returns the largest contiguous region of stored data, so that the consumer
+ *  can use it in place and then call ring_buffer_skip().
+ *
+ * Parameters:
+ *  const ring_buffer_t *rb: Ring buffer
+ *  const uint8_t **span: Set to the start of the stored data
+ *
+ * Return:
+ *  uint32_t: Length of the region in bytes
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_read_span(const ring_buffer_t *rb, const uint8_t **span)
+{
+    uint32_t offset = rb->tail & (rb->size - 1);
+    uint32_t used = ring_buffer_used(rb);
+    uint32_t contiguous = rb->size - offset;
+
+    *span = &rb->storage[offset];
+
+    return (used < contiguous) ? used : contiguous;
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_skip
+ *******************************************************************************
+ * Summary:
+ *  Consumes bytes from the ring buffer.
+ *
+ *******************************************************************************/
+void ring_buffer_skip(ring_buffer_t *rb, uint32_t len)
+{
+    STORE_RELEASE(&rb->tail, rb->tail + len);
+}
+
+/*******************************************************************************
+ * Function Name: ring_buffer_read
+ *******************************************************************************
+ * Summary:
+ *  Copies data out of the ring buffer and consumes it.
+ *
+ * Parameters:
+ *  ring_buffer_t *rb: Ring buffer
+ *  void *data: Destination buffer
+ *  uint32_t len: Maximum number of bytes to read
+ *
+ * Return:
+ *  uint32_t: Number of bytes read
+ *
+ *******************************************************************************/
+uint32_t ring_buffer_read(ring_buffer_t *rb, void *data, uint32_t len)
+{
+    len = ring_buffer_peek(rb, 0, data, len);
+    ring_buffer_skip(rb, len);
+
+    return len;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/******************************************************************************
+* File Name:   ring_buffer.h
+*
+* Description: This file contains declaration of a lock-free single-producer,
+* single-consumer byte ring buffer.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Byte ring buffer. The head is only written by the producer and the tail
+ * only by the consumer, so one producer and one consumer may use the buffer
+ * concurrently without a lock. Both indexes run freely and are reduced
+ * modulo the size, which must be a power of two.
+ */
+typedef struct
+{
+    uint8_t *storage;
+    uint32_t size;
+    uint32_t head;      /* Total bytes written. */
+    uint32_t tail;      /* Total bytes read. */
+} ring_buffer_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint32_t size);
+void ring_buffer_reset(ring_buffer_t *rb);
+uint32_t ring_buffer_used(const ring_buffer_t *rb);
+uint32_t ring_buffer_free(const ring_buffer_t *rb);
+
+/* Producer side. */
+bool ring_buffer_write(ring_buffer_t *rb, const void *data, uint32_t len);
+uint32_t ring_buffer_write_span(ring_buffer_t *rb, uint8_t **span);
+void ring_buffer_commit(ring_buffer_t *rb, uint32_t len);
+
+/* Consumer side. */
+uint32_t ring_buffer_read(ring_buffer_t *rb, void *data, uint32_t len);
+uint32_t ring_buffer_peek(const ring_buffer_t *rb, uint32_t offset, void *data, uint32_t len);
+uint8_t ring_buffer_peek_byte(const ring_buffer_t *rb, uint32_t offset);
+uint32_t ring_buffer_read_span(const ring_buffer_t *rb, const uint8_t **span);
+void ring_buffer_skip(ring_buffer_t *rb, uint32_t len);
+
+#endif /* RING_BUFFER_H_ */
@@ -0,0 +1,100 @@
+/******************************************************************************
+* File Name:   static_alloc.h
+*
+* Description: This file contains the macros creating the FreeRTOS objects of
+* the application. With STATIC_ALLOC_ENABLED, tasks, queues, timers and
+* mutexes are created in memory reserved at build time, from
+* configSUPPORT_STATIC_ALLOCATION; otherwise they come from the heap as
+* before. Each object is declared once at file scope with a _DEFINE macro,
+* which reserves its memory in the static build only, and created with the
+* matching _CREATE macro.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef STATIC_ALLOC_H_
+#define STATIC_ALLOC_H_
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <timers.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 1, e.g. with 'make STATIC_ALLOC=1', to allocate the FreeRTOS objects
+ * of the application statically. The make variable also turns on the heap
+ * guard, see heap_usage.h.
+ */
+#ifndef STATIC_ALLOC_ENABLED
+#define STATIC_ALLOC_ENABLED                      (0)
+#endif
+
+#if(STATIC_ALLOC_ENABLED)
+#define STATIC_ALLOC_TASK_DEFINE(name, stack_depth)                                 \
+    static StackType_t name##_stack[(stack_depth)];                                 \
+    static StaticTask_t name##_tcb
+
+/* Evaluates to pdPASS or pdFAIL, like xTaskCreate(). */
+#define STATIC_ALLOC_TASK_CREATE(name, code, label, stack_depth, arg, priority, handle) \
+    static_alloc_task_create((code), (label), (stack_depth), (arg), (priority), (handle), \
+                             name##_stack, &name##_tcb)
+
+#define STATIC_ALLOC_QUEUE_DEFINE(name, length, item_size)                          \
+    static uint8_t name##_storage[(length) * (item_size)];                          \
+    static StaticQueue_t name##_buffer
+
+#define STATIC_ALLOC_QUEUE_CREATE(name, length, item_size)                          \
+    xQueueCreateStatic((length), (item_size), name##_storage, &name##_buffer)
+
+#define STATIC_ALLOC_MUTEX_DEFINE(name)           static StaticSemaphore_t name##_buffer
+#define STATIC_ALLOC_MUTEX_CREATE(name)           xSemaphoreCreateMutexStatic(&name##_buffer)
+#define STATIC_ALLOC_RECURSIVE_MUTEX_CREATE(name) xSemaphoreCreateRecursiveMutexStatic(&name##_buffer)
+
+#define STATIC_ALLOC_TIMER_DEFINE(name)           static StaticTimer_t name##_buffer
+#define STATIC_ALLOC_TIMER_CREATE(name, label, period, auto_reload, id, callback)  \
+    xTimerCreateStatic((label), (period), (auto_reload), (id), (callback), &name##_buffer)
+#else
+/* Declarations without storage, valid at file scope. */
+#define STATIC_ALLOC_TASK_DEFINE(name, stack_depth)        extern StaticTask_t name##_tcb
+#define STATIC_ALLOC_QUEUE_DEFINE(name, length, item_size) extern StaticQueue_t name##_buffer
+#define STATIC_ALLOC_MUTEX_DEFINE(name)                    extern StaticSemaphore_t name##_buffer
+#define STATIC_ALLOC_TIMER_DEFINE(name)                    extern StaticTimer_t name##_buffer
+
+#define STATIC_ALLOC_TASK_CREATE(name, code, label, stack_depth, arg, priority, handle) \
+    xTaskCreate((code), (label), (stack_depth), (arg), (priority), (handle))
+#define STATIC_ALLOC_QUEUE_CREATE(name, length, item_size)   xQueueCreate((length), (item_size))
+#define STATIC_ALLOC_MUTEX_CREATE(name)                      xSemaphoreCreateMutex()
+#define STATIC_ALLOC_RECURSIVE_MUTEX_CREATE(name)            xSemaphoreCreateRecursiveMutex()
+#define STATIC_ALLOC_TIMER_CREATE(name, label, period, auto_reload, id, callback)  \
+    xTimerCreate((label), (period), (auto_reload), (id), (callback))
+#endif /* STATIC_ALLOC_ENABLED */
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if(STATIC_ALLOC_ENABLED)
+static inline BaseType_t static_alloc_task_create(TaskFunction_t code, const char *label,
+                                                  uint32_t stack_depth, void *arg,
+                                                  UBaseType_t priority, TaskHandle_t *handle,
+                                                  StackType_t *stack, StaticTask_t *tcb)
+{
+    TaskHandle_t task = xTaskCreateStatic(code, label, stack_depth, arg, priority, stack, tcb);
+
+    if(handle != NULL)
+    {
+        *handle = task;
+    }
+
+    return (task != NULL) ? pdPASS : pdFAIL;
+}
+#endif /* STATIC_ALLOC_ENABLED */
+
+#endif /* STATIC_ALLOC_H_ */
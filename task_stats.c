@@ -0,0 +1,259 @@
+/******************************************************************************
+* File Name:   task_stats.c
+*
+* Description: This file contains the task statistics. FreeRTOS accumulates
+* the run time of every task from task_stats_counter(), a 32-bit counter
+* derived from the CPU cycle counter, and calls task_stats_switched_in() on
+* every context switch. A snapshot reports the change of these counters
+* since the previous snapshot, so counter wrap-around does not matter.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* Standard C header files */
+#include <string.h>
+#include <inttypes.h>
+
+/* Task statistics header file. */
+#include "task_stats.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static const char *task_stats_state_str(eTaskState state);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Cycle counter extended to 64 bits. Only updated by the kernel, from the
+ * context switch and with the scheduler suspended, which do not overlap; the
+ * counter must be read at least once per wrap of the cycle counter (26 s at
+ * 160 MHz), which the context switches do.
+ */
+static uint64_t counter_cycles;
+static uint32_t counter_last;
+
+/* Context switches, indexed by task number; entry 0 is not a task. */
+static volatile uint32_t switch_counts[TASK_STATS_MAX_TASK_NUMBER];
+
+/* Counters of the previous snapshot, indexed by task number. */
+static uint32_t prev_run_time[TASK_STATS_MAX_TASK_NUMBER];
+static uint32_t prev_switches[TASK_STATS_MAX_TASK_NUMBER];
+static uint32_t prev_total_run_time;
+static TickType_t prev_tick;
+
+/* Serializes the snapshots. */
+static SemaphoreHandle_t snapshot_mutex;
+STATIC_ALLOC_MUTEX_DEFINE(snapshot_mutex);
+static TaskStatus_t task_status[TASK_STATS_MAX_TASKS];
+
+/*******************************************************************************
+ * Function Name: task_stats_init
+ *******************************************************************************
+ * Summary:
+ *  Prepares the snapshots. The run-time counter itself is started by the
+ *  scheduler.
+ *
+ *******************************************************************************/
+void task_stats_init(void)
+{
+    snapshot_mutex = STATIC_ALLOC_MUTEX_CREATE(snapshot_mutex);
+    TRACE_QUEUE_NUMBER(snapshot_mutex, TRACE_QUEUE_TASK_STATS);
+    prev_tick = xTaskGetTickCount();
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_timer_init
+ *******************************************************************************
+ * Summary:
+ *  Starts the cycle counter. Called by vTaskStartScheduler().
+ *
+ *******************************************************************************/
+void task_stats_timer_init(void)
+{
+    timestamp_init();
+    counter_last = timestamp_now();
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_counter
+ *******************************************************************************
+ * Summary:
+ *  Returns the run-time counter, in units of 2^TASK_STATS_COUNTER_DIVIDER_SHIFT
+ *  CPU cycles.
+ *
+ *******************************************************************************/
+uint32_t task_stats_counter(void)
+{
+    uint32_t now = timestamp_now();
+
+    counter_cycles += (uint32_t)(now - counter_last);
+    counter_last = now;
+
+    return (uint32_t)(counter_cycles >> TASK_STATS_COUNTER_DIVIDER_SHIFT);
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_switched_in
+ *******************************************************************************
+ * Summary:
+ *  Counts a context switch to a task. Called by the kernel.
+ *
+ *******************************************************************************/
+void task_stats_switched_in(uint32_t task_number)
+{
+    if(task_number < TASK_STATS_MAX_TASK_NUMBER)
+    {
+        switch_counts[task_number]++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_snapshot
+ *******************************************************************************
+ * Summary:
+ *  Returns the statistics of the tasks over the interval since the previous
+ *  snapshot, whoever took it.
+ *
+ * Parameters:
+ *  task_stats_entry_t *entries: Set to the statistics of the tasks
+ *  uint32_t max_entries: Maximum number of entries
+ *  uint32_t *interval_ms: Set to the length of the interval
+ *
+ * Return:
+ *  uint32_t: Number of entries set
+ *
+ *******************************************************************************/
+uint32_t task_stats_snapshot(task_stats_entry_t *entries, uint32_t max_entries,
+                             uint32_t *interval_ms)
+{
+    uint32_t total_run_time;
+    uint32_t total_delta;
+    uint32_t run_delta;
+    uint32_t count;
+    uint32_t number;
+    uint32_t switches;
+    TickType_t now;
+
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+
+    count = (uint32_t)uxTaskGetSystemState(task_status, TASK_STATS_MAX_TASKS, &total_run_time);
+    now = xTaskGetTickCount();
+    if(count > max_entries)
+    {
+        count = max_entries;
+    }
+
+    total_delta = total_run_time - prev_total_run_time;
+    prev_total_run_time = total_run_time;
+    *interval_ms = (uint32_t)((now - prev_tick) * portTICK_PERIOD_MS);
+    prev_tick = now;
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        number = (uint32_t)task_status[i].xTaskNumber;
+
+        run_delta = task_status[i].ulRunTimeCounter;
+        switches = 0;
+        if(number < TASK_STATS_MAX_TASK_NUMBER)
+        {
+            run_delta -= prev_run_time[number];
+            prev_run_time[number] = task_status[i].ulRunTimeCounter;
+
+            switches = switch_counts[number];
+            switches -= prev_switches[number];
+            prev_switches[number] += switches;
+        }
+
+        entries[i].name = task_status[i].pcTaskName;
+        entries[i].number = number;
+        entries[i].priority = (uint32_t)task_status[i].uxCurrentPriority;
+        entries[i].state = task_status[i].eCurrentState;
+        entries[i].cpu_permille = (total_delta > 0) ?
+                                  (uint32_t)(((uint64_t)run_delta * 1000u) / total_delta) : 0;
+        entries[i].stack_free = (uint32_t)task_status[i].usStackHighWaterMark * sizeof(StackType_t);
+        entries[i].switches = switches;
+    }
+
+    xSemaphoreGive(snapshot_mutex);
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_print
+ *******************************************************************************
+ * Summary:
+ *  Takes a snapshot and logs it as a table.
+ *
+ *******************************************************************************/
+void task_stats_print(void)
+{
+    static task_stats_entry_t entries[TASK_STATS_MAX_TASKS];
+    uint32_t interval_ms;
+    uint32_t count = task_stats_snapshot(entries, TASK_STATS_MAX_TASKS, &interval_ms);
+
+    APP_LOG_INFO("Task statistics over %"PRIuPTR" ms", interval_ms);
+    APP_LOG_INFO("  Task              num pri st   cpu%%  stack free  switches");
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        APP_LOG_INFO("  %-16s %4"PRIuPTR" %3"PRIuPTR"  %s %3"PRIuPTR".%"PRIuPTR" %11"PRIuPTR" %9"PRIuPTR,
+                     APP_LOG_STR(entries[i].name), entries[i].number, entries[i].priority,
+                     APP_LOG_STR(task_stats_state_str(entries[i].state)), entries[i].cpu_permille / 10u,
+                     entries[i].cpu_permille % 10u, entries[i].stack_free, entries[i].switches);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_state_char
+ *******************************************************************************
+ * Summary:
+ *  Returns a letter for a task state: X - running, R - ready, B - blocked,
+ *  S - suspended, D - deleted.
+ *
+ *******************************************************************************/
+char task_stats_state_char(eTaskState state)
+{
+    return *task_stats_state_str(state);
+}
+
+/*******************************************************************************
+ * Function Name: task_stats_state_str
+ *******************************************************************************
+ * Summary:
+ *  Returns the letter of task_stats_state_char() as a string, for the log.
+ *
+ *******************************************************************************/
+static const char *task_stats_state_str(eTaskState state)
+{
+    static const char *const state_strs[] = { "X", "R", "B", "S", "D" };
+
+    return ((uint32_t)state < (sizeof(state_strs) / sizeof(state_strs[0]))) ? state_strs[state] : "?";
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+/******************************************************************************
+* File Name:   task_stats.h
+*
+* Description: This file contains declaration of the task statistics: share
+* of the CPU, stack high-water mark and context switches of every FreeRTOS
+* task, from the FreeRTOS run-time statistics.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TASK_STATS_H_
+#define TASK_STATS_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Maximum number of tasks reported. */
+#ifndef TASK_STATS_MAX_TASKS
+#define TASK_STATS_MAX_TASKS                      (16u)
+#endif
+
+/* Context switches are counted for the tasks numbered below this; the
+ * switches of later tasks are not counted.
+ */
+#define TASK_STATS_MAX_TASK_NUMBER                (32u)
+
+/* The run-time counter counts CPU cycles divided by this, so that it wraps
+ * after about half an hour.
+ */
+#define TASK_STATS_COUNTER_DIVIDER_SHIFT          (6u)
+
+/* Period of the task statistics report on the debug UART, 0 to disable it. */
+#ifndef TASK_STATS_REPORT_INTERVAL_MS
+#define TASK_STATS_REPORT_INTERVAL_MS             (0u)
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Statistics of one task over the interval since the previous snapshot. */
+typedef struct
+{
+    const char *name;                   /* Valid while the task exists. */
+    uint32_t number;                    /* FreeRTOS task number. */
+    uint32_t priority;
+    eTaskState state;
+    uint32_t cpu_permille;              /* Share of the CPU in the interval. */
+    uint32_t stack_free;                /* Bytes of stack never used. */
+    uint32_t switches;                  /* Times switched in, in the interval. */
+} task_stats_entry_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void task_stats_init(void);
+uint32_t task_stats_snapshot(task_stats_entry_t *entries, uint32_t max_entries,
+                             uint32_t *interval_ms);
+void task_stats_print(void);
+char task_stats_state_char(eTaskState state);
+
+/* FreeRTOS run-time statistics hooks, see FreeRTOSConfig.h. */
+void task_stats_timer_init(void);
+uint32_t task_stats_counter(void);
+void task_stats_switched_in(uint32_t task_number);
+
+#endif /* TASK_STATS_H_ */
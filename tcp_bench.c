@@ -0,0 +1,471 @@
+/******************************************************************************
+* File Name:   tcp_bench.c
+*
+* Description: This file contains the throughput benchmark of the TCP server.
+* One benchmark runs at a time. Received data is read and, in echo mode, sent
+* back by the socket receive callback; in source mode the TCP writer task
+* sends data for as long as the socket takes it. A one-shot software timer
+* ends the benchmark, which reports the throughput and the time spent in the
+* socket calls. The TCP writer then closes the connection, once the receive
+* callback no longer uses the socket.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+/* Standard C header file */
+#include <inttypes.h>
+
+/* Throughput benchmark header file. */
+#include "tcp_bench.h"
+
+/* Protocol v2 header file, for the status codes. */
+#include "tcp_proto.h"
+
+/* TCP writer header file. */
+#include "tcp_writer.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Metrics header file. */
+#include "metrics.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* State of the running benchmark. */
+typedef struct
+{
+    tcp_conn_t *conn;               /* NULL when no benchmark runs. */
+    tcp_bench_mode_t mode;
+    uint32_t block_size;
+    TickType_t start_tick;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t socket_ns;             /* Time spent in cy_socket_recv/send(). */
+} tcp_bench_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void bench_timer_callback(TimerHandle_t timer);
+static bool bench_send_block(tcp_conn_t *conn, const uint8_t *data, uint32_t len);
+static void bench_report(const tcp_bench_t *result);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static tcp_bench_t bench;
+
+/* Connection whose socket the receive callback is using. */
+static tcp_conn_t *receiving_conn;
+
+/* Ends the benchmark after the requested duration. */
+static TimerHandle_t bench_timer;
+STATIC_ALLOC_TIMER_DEFINE(bench_timer);
+
+/* Data received and sent. Shared by the receive callback and the TCP writer;
+ * the content of source mode data does not matter.
+ */
+static uint8_t bench_buffer[TCP_BENCH_BUFFER_SIZE];
+
+static const char *const mode_names[] = { "", "sink", "source", "echo" };
+
+/*******************************************************************************
+ * Function Name: tcp_bench_init
+ *******************************************************************************
+ * Summary:
+ *  Creates the timer of the benchmark.
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_bench_init(void)
+{
+    bench_timer = STATIC_ALLOC_TIMER_CREATE(bench_timer, "Bench timer", 1, pdFALSE, NULL, bench_timer_callback);
+
+    return (bench_timer != NULL) ? CY_RSLT_SUCCESS : CY_RSLT_TYPE_ERROR;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_parse
+ *******************************************************************************
+ * Summary:
+ *  Checks the payload of a BENCH frame.
+ *
+ * Parameters:
+ *  const uint8_t *payload: Payload of the BENCH frame
+ *  uint32_t len: Length of the payload
+ *  tcp_bench_params_t *params: Set to the benchmark parameters
+ *
+ * Return:
+ *  uint8_t: TCP_PROTO_STATUS_OK if the benchmark can be started, the status
+ *  to report to the client otherwise
+ *
+ *******************************************************************************/
+uint8_t tcp_bench_parse(const uint8_t *payload, uint32_t len, tcp_bench_params_t *params)
+{
+    if(len != TCP_BENCH_PARAMS_LEN)
+    {
+        return TCP_PROTO_STATUS_INVALID;
+    }
+
+    params->mode = (tcp_bench_mode_t)payload[0];
+    params->block_size = ((uint32_t)payload[1] << 8) | payload[2];
+    params->duration_ms = ((uint32_t)payload[3] << 24) | ((uint32_t)payload[4] << 16) |
+                          ((uint32_t)payload[5] << 8) | payload[6];
+
+    if((params->mode < TCP_BENCH_MODE_SINK) || (params->mode > TCP_BENCH_MODE_ECHO) ||
+       (params->block_size == 0) || (params->block_size > TCP_BENCH_BUFFER_SIZE) ||
+       (params->duration_ms == 0) || (params->duration_ms > TCP_BENCH_MAX_DURATION_MS))
+    {
+        return TCP_PROTO_STATUS_INVALID;
+    }
+
+    if(__atomic_load_n(&bench.conn, __ATOMIC_ACQUIRE) != NULL)
+    {
+        return TCP_PROTO_STATUS_BUSY;
+    }
+
+    return TCP_PROTO_STATUS_OK;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_start
+ *******************************************************************************
+ * Summary:
+ *  Starts a benchmark on a protocol v2 connection and its timer. The
+ *  connection still carries frames until tcp_bench_activate(), so that the
+ *  answer to the BENCH frame can be queued first. Called from the socket
+ *  receive callback, so it does not wait for the timer command queue.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const tcp_bench_params_t *params: Parameters checked by tcp_bench_parse()
+ *
+ * Return:
+ *  uint8_t: TCP_PROTO_STATUS_OK if the benchmark was started,
+ *  TCP_PROTO_STATUS_BUSY if one is already running or the timer command
+ *  queue is full
+ *
+ *******************************************************************************/
+uint8_t tcp_bench_start(tcp_conn_t *conn, const tcp_bench_params_t *params)
+{
+    tcp_conn_t *expected = NULL;
+
+    if(!__atomic_compare_exchange_n(&bench.conn, &expected, conn, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+        return TCP_PROTO_STATUS_BUSY;
+    }
+
+    bench.mode = params->mode;
+    bench.block_size = params->block_size;
+    bench.bytes_received = 0;
+    bench.bytes_sent = 0;
+    bench.socket_ns = 0;
+    bench.start_tick = xTaskGetTickCount();
+
+    for(uint32_t i = 0; i < params->block_size; i++)
+    {
+        bench_buffer[i] = (uint8_t)i;
+    }
+
+    if(xTimerChangePeriod(bench_timer, pdMS_TO_TICKS(params->duration_ms), 0) != pdPASS)
+    {
+        __atomic_store_n(&bench.conn, NULL, __ATOMIC_SEQ_CST);
+        return TCP_PROTO_STATUS_BUSY;
+    }
+
+    APP_LOG_INFO("Benchmark started: %s, %"PRIuPTR" byte blocks, %"PRIuPTR" ms",
+                 APP_LOG_STR(mode_names[params->mode]), params->block_size, params->duration_ms);
+
+    return TCP_PROTO_STATUS_OK;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_activate
+ *******************************************************************************
+ * Summary:
+ *  Switches the connection of a started benchmark to raw benchmark data,
+ *  once the answer to the BENCH frame is queued. Unprocessed received data
+ *  is discarded.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+void tcp_bench_activate(tcp_conn_t *conn)
+{
+    ring_buffer_skip(&conn->rx_ring, ring_buffer_used(&conn->rx_ring));
+    conn->protocol = TCP_CONN_PROTOCOL_BENCH;
+
+    if(bench.mode == TCP_BENCH_MODE_SOURCE)
+    {
+        tcp_writer_notify();
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_receive
+ *******************************************************************************
+ * Summary:
+ *  Reads all the data pending on the socket of the benchmark connection and,
+ *  in echo mode, sends it back. Called by the socket receive callback, which
+ *  is held while the client does not read the echoed data.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_bench_receive(tcp_conn_t *conn)
+{
+    cy_rslt_t result;
+    uint32_t bytes_received;
+    uint32_t bytes_available = 0;
+    uint32_t optlen = sizeof(bytes_available);
+    uint32_t start;
+
+    /* Announced before the benchmark is checked: see tcp_bench_poll(). */
+    __atomic_store_n(&receiving_conn, conn, __ATOMIC_SEQ_CST);
+
+    do
+    {
+        bytes_received = 0;
+        start = timestamp_now();
+        result = cy_socket_recv(conn->handle, bench_buffer, bench.block_size,
+                                CY_SOCKET_FLAGS_NONE, &bytes_received);
+        bench.socket_ns += timestamp_to_ns(timestamp_now() - start);
+        if(result != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+
+        conn->bytes_received += bytes_received;
+        METRICS_ADD(METRICS_RX_BYTES, bytes_received);
+        if(__atomic_load_n(&bench.conn, __ATOMIC_SEQ_CST) != conn)
+        {
+            break;
+        }
+
+        bench.bytes_received += bytes_received;
+        if((bench.mode == TCP_BENCH_MODE_ECHO) &&
+           !bench_send_block(conn, bench_buffer, bytes_received))
+        {
+            break;
+        }
+
+        result = cy_socket_getsockopt(conn->handle, CY_SOCKET_SOL_SOCKET,
+                                      CY_SOCKET_SO_BYTES_AVAILABLE,
+                                      &bytes_available, &optlen);
+    } while((result == CY_RSLT_SUCCESS) && (bytes_available > 0));
+
+    if(result == CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT)
+    {
+        result = CY_RSLT_SUCCESS;
+    }
+    else if(result != CY_RSLT_SUCCESS)
+    {
+        METRICS_ERROR(METRICS_OP_RECV, result);
+        if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED)
+        {
+            tcp_bench_stop(conn);
+        }
+    }
+
+    __atomic_store_n(&receiving_conn, NULL, __ATOMIC_SEQ_CST);
+
+    /* Let the TCP writer close the connection of a finished benchmark. */
+    if(__atomic_load_n(&bench.conn, __ATOMIC_SEQ_CST) != conn)
+    {
+        tcp_writer_notify();
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_poll
+ *******************************************************************************
+ * Summary:
+ *  Called by the TCP writer task for a connection in benchmark mode once its
+ *  send queue is empty. Sends one block of source mode data while the
+ *  benchmark runs, and closes the connection after it ended, as soon as the
+ *  receive callback has left the socket.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ * Return:
+ *  bool: true if the benchmark has more data to send
+ *
+ *******************************************************************************/
+bool tcp_bench_poll(tcp_conn_t *conn)
+{
+    if(__atomic_load_n(&bench.conn, __ATOMIC_SEQ_CST) == conn)
+    {
+        return (bench.mode == TCP_BENCH_MODE_SOURCE) &&
+               bench_send_block(conn, bench_buffer, bench.block_size);
+    }
+
+    /* The callback notifies the writer when it leaves the socket. */
+    if(__atomic_load_n(&receiving_conn, __ATOMIC_SEQ_CST) != conn)
+    {
+        tcp_conn_close(conn);
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_bench_stop
+ *******************************************************************************
+ * Summary:
+ *  Ends the benchmark running on a connection, if any, and reports it. Called
+ *  when the benchmark time is up, on socket errors and when the client
+ *  disconnects. The TCP writer is woken up to close the connection.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+void tcp_bench_stop(tcp_conn_t *conn)
+{
+    tcp_bench_t result = bench;
+
+    if(!__atomic_compare_exchange_n(&bench.conn, &conn, NULL, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    xTimerStop(bench_timer, 0);
+    bench_report(&result);
+
+    tcp_writer_notify();
+}
+
+/*******************************************************************************
+ * Function Name: bench_timer_callback
+ *******************************************************************************
+ * Summary:
+ *  Ends the benchmark when its time is up. Closing the connection tells the
+ *  client that the benchmark is over.
+ *
+ *******************************************************************************/
+static void bench_timer_callback(TimerHandle_t timer)
+{
+    tcp_conn_t *conn = __atomic_load_n(&bench.conn, __ATOMIC_ACQUIRE);
+
+    (void)timer;
+
+    if(conn != NULL)
+    {
+        tcp_bench_stop(conn);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: bench_send_block
+ *******************************************************************************
+ * Summary:
+ *  Sends a block of benchmark data, retrying after the send timeout while the
+ *  benchmark runs.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const uint8_t *data: Data to send
+ *  uint32_t len: Length of the data
+ *
+ * Return:
+ *  bool: true if the block was sent, false if the benchmark has ended
+ *
+ *******************************************************************************/
+static bool bench_send_block(tcp_conn_t *conn, const uint8_t *data, uint32_t len)
+{
+    cy_rslt_t result;
+    uint32_t bytes_sent;
+    uint32_t start;
+
+    while((len > 0) && (__atomic_load_n(&bench.conn, __ATOMIC_SEQ_CST) == conn))
+    {
+        bytes_sent = 0;
+        start = timestamp_now();
+        result = cy_socket_send(conn->handle, data, len, CY_SOCKET_FLAGS_NONE, &bytes_sent);
+        bench.socket_ns += timestamp_to_ns(timestamp_now() - start);
+
+        conn->bytes_sent += bytes_sent;
+        bench.bytes_sent += bytes_sent;
+        METRICS_ADD(METRICS_TX_BYTES, bytes_sent);
+        data += bytes_sent;
+        len -= bytes_sent;
+
+        if((result != CY_RSLT_SUCCESS) && (result != CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT))
+        {
+            conn->tx_errors++;
+            METRICS_ERROR(METRICS_OP_SEND, result);
+            tcp_bench_stop(conn);
+            return false;
+        }
+    }
+
+    return (len == 0);
+}
+
+/*******************************************************************************
+ * Function Name: bench_report
+ *******************************************************************************
+ * Summary:
+ *  Logs the throughput of a finished benchmark in both directions, and the
+ *  share of the benchmark spent in the socket calls.
+ *
+ *******************************************************************************/
+static void bench_report(const tcp_bench_t *result)
+{
+    uint32_t elapsed_ms = (uint32_t)((xTaskGetTickCount() - result->start_tick) * portTICK_PERIOD_MS);
+    uint32_t socket_ms = (uint32_t)(result->socket_ns / 1000000u);
+    uint32_t rx_kbps;
+    uint32_t tx_kbps;
+
+    if(elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+
+    /* Bytes per millisecond are kilobytes per second. */
+    rx_kbps = (uint32_t)(result->bytes_received / elapsed_ms);
+    tx_kbps = (uint32_t)(result->bytes_sent / elapsed_ms);
+
+    APP_LOG_INFO("Benchmark %s finished after %"PRIuPTR" ms",
+                 APP_LOG_STR(mode_names[result->mode]), elapsed_ms);
+    APP_LOG_INFO("  rx %"PRIuPTR" KB, %"PRIuPTR".%03"PRIuPTR" MB/s",
+                 (uint32_t)(result->bytes_received / 1000u), rx_kbps / 1000u, rx_kbps % 1000u);
+    APP_LOG_INFO("  tx %"PRIuPTR" KB, %"PRIuPTR".%03"PRIuPTR" MB/s",
+                 (uint32_t)(result->bytes_sent / 1000u), tx_kbps / 1000u, tx_kbps % 1000u);
+    APP_LOG_INFO("  CPU time in socket calls %"PRIuPTR" ms (%"PRIuPTR"%%)",
+                 socket_ms, (uint32_t)(((uint64_t)socket_ms * 100u) / elapsed_ms));
+}
+
+/* [] END OF FILE */
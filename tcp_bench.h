@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   tcp_bench.h
+*
+* Description: This file contains declaration of the throughput benchmark of
+* the TCP server. A protocol v2 client starts a benchmark with a BENCH frame;
+* the connection then carries raw data until the benchmark ends and the
+* server closes it.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TCP_BENCH_H_
+#define TCP_BENCH_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/* Connection table header file. */
+#include "tcp_conn.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 0 to build the TCP server without the benchmark. */
+#ifndef TCP_BENCH_ENABLED
+#define TCP_BENCH_ENABLED                         (1)
+#endif
+
+/* Largest block handed to the socket in one call, and size of the data
+ * buffer of the benchmark.
+ */
+#ifndef TCP_BENCH_BUFFER_SIZE
+#define TCP_BENCH_BUFFER_SIZE                     (2048u)
+#endif
+
+#define TCP_BENCH_MAX_DURATION_MS                 (60000u)
+
+/* Length of the payload of a TCP_PROTO_OP_BENCH frame: mode, block size
+ * (16 bits) and duration in milliseconds (32 bits), in network byte order.
+ */
+#define TCP_BENCH_PARAMS_LEN                      (7u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Benchmark variant. */
+typedef enum
+{
+    TCP_BENCH_MODE_SINK = 1,        /* Client sends, the server discards. */
+    TCP_BENCH_MODE_SOURCE,          /* Server sends, the client discards. */
+    TCP_BENCH_MODE_ECHO             /* Server sends back what it receives. */
+} tcp_bench_mode_t;
+
+/* Parameters of a benchmark, from a TCP_PROTO_OP_BENCH frame. */
+typedef struct
+{
+    tcp_bench_mode_t mode;
+    uint32_t block_size;
+    uint32_t duration_ms;
+} tcp_bench_params_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tcp_bench_init(void);
+uint8_t tcp_bench_parse(const uint8_t *payload, uint32_t len, tcp_bench_params_t *params);
+uint8_t tcp_bench_start(tcp_conn_t *conn, const tcp_bench_params_t *params);
+void tcp_bench_activate(tcp_conn_t *conn);
+cy_rslt_t tcp_bench_receive(tcp_conn_t *conn);
+bool tcp_bench_poll(tcp_conn_t *conn);
+void tcp_bench_stop(tcp_conn_t *conn);
+
+#endif /* TCP_BENCH_H_ */
@@ -12,6 +12,9 @@ import socket
 import optparse
 import time
 import sys
+import struct
+import binascii
+import select
 
 BUFFER_SIZE = 1024
 
@@ -21,29 +24,290 @@ DEFAULT_PORT = 50007             # Port of the TCP server
 
 DEFAULT_KEEP_ALIVE = 1           # TCP Keep Alive: 1 - Enable, 0 - Disable
 
-print("================================================================================")
-print("TCP Client")
-print("================================================================================")
-s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-s.setsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE, DEFAULT_KEEP_ALIVE)
-s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPIDLE, 10)
-s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPINTVL, 1)
-s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPCNT, 2)
-s.connect((DEFAULT_IP, DEFAULT_PORT))
-print("Connected to TCP Server (IP Address: ", DEFAULT_IP, "Port: ", DEFAULT_PORT, " )")
-    
-while 1:
-    print("================================================================================")        
-    data = s.recv(BUFFER_SIZE);
-    print("Command from Server:")
-    if data.decode('utf-8') == '0':
-        print("LED OFF")
-        message = 'LED OFF ACK'
-        s.send(message.encode('utf-8'))
-    if data.decode('utf-8') == '1':
-        print("LED ON")
-        message = 'LED ON ACK'
-        s.send(message.encode('utf-8'))
-    print("Acknowledgement sent to server")        
+ACK_DELIMITER = '\n'             # Terminates each acknowledgement message
+
+# Command protocol v2 (see tcp_proto.h)
+PROTO_MAGIC       = 0xA5
+PROTO_VERSION     = 2
+PROTO_FLAG_CRC    = 0x01
+PROTO_HEADER      = struct.Struct('!BBBHH')   # magic, version/flags, opcode, seq, length
+PROTO_CRC_LEN     = 2
+PROTO_OP_HELLO    = 0x01
+PROTO_OP_ACK      = 0x02
+PROTO_OP_STATS    = 0x04
+PROTO_OP_TASK_STATS = 0x05
+PROTO_OP_LOG_LEVEL = 0x06
+PROTO_OP_INFO     = 0x07
+PROTO_OP_LED_SET  = 0x10
+PROTO_OP_BENCH    = 0x20
+PROTO_STATUS_OK   = 0x00
+
+# Log levels (see app_log.h)
+LOG_LEVELS        = ['off', 'error', 'warning', 'info', 'debug']
+
+# Throughput benchmark (see tcp_bench.h)
+BENCH_PARAMS      = struct.Struct('!BHI')     # mode, block size, duration in ms
+BENCH_MODES       = {'sink': 1, 'source': 2, 'echo': 3}
+BENCH_STATUS      = {0: 'OK', 1: 'unsupported', 2: 'busy', 3: 'invalid parameters'}
+
+# Task statistics (see handle_stats_frame() in tcp_server.c)
+TASK_STATS        = struct.Struct('!BBBBBBHIII')  # index, count, snapshot, number, priority,
+                                                  # state, CPU permille, interval ms,
+                                                  # free stack, switches
+STATS_RETRIES     = 3                             # Snapshots replaced by other clients
+TASK_STATES       = 'XRBSD'                     # running, ready, blocked, suspended, deleted
+
+def crc16(data):
+    return binascii.crc_hqx(data, 0xFFFF)
+
+def encode_frame(opcode, seq, payload, use_crc):
+    flags = PROTO_FLAG_CRC if use_crc else 0
+    frame = PROTO_HEADER.pack(PROTO_MAGIC, (PROTO_VERSION << 4) | flags, opcode, seq, len(payload)) + payload
+    if use_crc:
+        frame += struct.pack('!H', crc16(frame))
+    return frame
+
+def decode_frames(buffer):
+    """Returns the complete frames at the start of the buffer and the rest of it."""
+    frames = []
+    while len(buffer) >= PROTO_HEADER.size:
+        if buffer[0] != PROTO_MAGIC:
+            # Resynchronize on the next frame start.
+            buffer = buffer[1:]
+            continue
+        magic, ver_flags, opcode, seq, length = PROTO_HEADER.unpack_from(buffer)
+        end = PROTO_HEADER.size + length
+        has_crc = ver_flags & PROTO_FLAG_CRC
+        frame_len = end + (PROTO_CRC_LEN if has_crc else 0)
+        if len(buffer) < frame_len:
+            break
+        if has_crc and struct.unpack_from('!H', buffer, end)[0] != crc16(buffer[:end]):
+            print("Frame with a wrong CRC dropped")
+        else:
+            frames.append((opcode, seq, buffer[PROTO_HEADER.size:end]))
+        buffer = buffer[frame_len:]
+    return frames, buffer
+
+def run_bench(s, mode, block_size, duration, use_crc):
+    """Runs a throughput benchmark; the server closes the connection at the end."""
+    s.send(encode_frame(PROTO_OP_BENCH, 1, BENCH_PARAMS.pack(BENCH_MODES[mode], block_size,
+                                                              int(duration * 1000)), use_crc))
+    rx_buffer = b''
+    while 1:
+        data = s.recv(BUFFER_SIZE)
+        if not data:
+            print("Connection closed by the TCP server")
+            return
+        frames, rx_buffer = decode_frames(rx_buffer + data)
+        if frames:
+            break
+    opcode, seq, payload = frames[0]
+    status = payload[0] if payload else 0
+    if opcode != PROTO_OP_ACK or status != PROTO_STATUS_OK:
+        print("Benchmark refused by the TCP server:", BENCH_STATUS.get(status, status))
+        return
+    print("Benchmark started:", mode, block_size, "byte blocks,", duration, "s")
+
+    # Source mode data may follow the acknowledgement in the same segment.
+    rx_bytes = len(rx_buffer)
+    tx_bytes = 0
+    block = bytes(i & 0xFF for i in range(block_size))
+    start = time.monotonic()
+    cpu_start = time.process_time()
+    s.setblocking(False)
+    try:
+        while 1:
+            readable, writable, _ = select.select([s], [s] if mode != 'source' else [], [], 1.0)
+            if readable:
+                data = s.recv(65536)
+                if not data:
+                    break
+                rx_bytes += len(data)
+            if writable:
+                try:
+                    tx_bytes += s.send(block)
+                except BlockingIOError:
+                    pass
+    except (ConnectionResetError, BrokenPipeError):
+        pass
+    elapsed = time.monotonic() - start
+    cpu = time.process_time() - cpu_start
+    print("================================================================================")
+    print("Benchmark finished after %.2f s" % elapsed)
+    print("  rx %d bytes, %.3f MB/s" % (rx_bytes, rx_bytes / elapsed / 1e6))
+    print("  tx %d bytes, %.3f MB/s" % (tx_bytes, tx_bytes / elapsed / 1e6))
+    print("  client CPU time %.2f s (%d%%)" % (cpu, 100 * cpu / elapsed))
+    print("The server reports its own figures on its debug UART")
+
+def run_stats(s, use_crc):
+    """Prints the task statistics of the server since the previous request."""
+    rx_buffer = b''
+    index = 0
+    count = 1
+    retries = STATS_RETRIES
+    rows = []
+    while index < count:
+        s.send(encode_frame(PROTO_OP_STATS, index, bytes([index]), use_crc))
+        frames = []
+        while not frames:
+            data = s.recv(BUFFER_SIZE)
+            if not data:
+                print("Connection closed by the TCP server")
+                return
+            frames, rx_buffer = decode_frames(rx_buffer + data)
+        opcode, seq, payload = frames[0]
+        if opcode == PROTO_OP_ACK and index > 0 and retries > 0:
+            # Another client took a snapshot in between; start over.
+            retries -= 1
+            index = 0
+            count = 1
+            rows = []
+            continue
+        if opcode != PROTO_OP_TASK_STATS or len(payload) < TASK_STATS.size:
+            print("Task statistics refused by the TCP server")
+            return
+        fields = TASK_STATS.unpack_from(payload)
+        count = fields[1]
+        snapshot, interval_ms = fields[2], fields[7]
+        rows.append((payload[TASK_STATS.size:].decode('utf-8', 'replace'),) + fields[3:7] + fields[8:])
+        index += 1
+    print("  Snapshot %d over the last %d ms" % (snapshot, interval_ms))
+    print("  Task              num pri st   cpu%  stack free  switches")
+    for name, number, priority, state, permille, stack_free, switches in rows:
+        state = TASK_STATES[state] if state < len(TASK_STATES) else '?'
+        print("  %-16s %4d %3d  %s %5.1f %11d %9d" % (name, number, priority, state,
+                                                   permille / 10, stack_free, switches))
+
+def run_log_level(s, level, use_crc):
+    """Sets the log level of the server, or reads it if level is None."""
+    payload = bytes([LOG_LEVELS.index(level)]) if level else b''
+    s.send(encode_frame(PROTO_OP_LOG_LEVEL, 1, payload, use_crc))
+    rx_buffer = b''
+    frames = []
+    while not frames:
+        data = s.recv(BUFFER_SIZE)
+        if not data:
+            print("Connection closed by the TCP server")
+            return
+        frames, rx_buffer = decode_frames(rx_buffer + data)
+    opcode, seq, payload = frames[0]
+    if opcode != PROTO_OP_ACK or len(payload) < 2 or payload[0] != PROTO_STATUS_OK:
+        print("Log level refused by the TCP server")
+        return
+    print("Log level of the TCP server:", LOG_LEVELS[payload[1]] if payload[1] < len(LOG_LEVELS) else payload[1])
+
+def run_info(s, use_crc):
+    """Prints the command table of the server."""
+    s.send(encode_frame(PROTO_OP_INFO, 1, b'', use_crc))
+    rx_buffer = b''
+    frames = []
+    while not frames:
+        data = s.recv(BUFFER_SIZE)
+        if not data:
+            print("Connection closed by the TCP server")
+            return
+        frames, rx_buffer = decode_frames(rx_buffer + data)
+    opcode, seq, payload = frames[0]
+    if opcode != PROTO_OP_INFO:
+        print("Information refused by the TCP server")
+        return
+    print(payload.decode('utf-8', 'replace'), end='')
+
+parser = optparse.OptionParser()
+parser.add_option('-a', '--address', dest='ip', default=DEFAULT_IP,
+                  help='IP address of the TCP server [default: %default]')
+parser.add_option('-p', '--port', dest='port', type='int', default=DEFAULT_PORT,
+                  help='port of the TCP server [default: %default]')
+parser.add_option('--protocol', dest='protocol', type='choice', choices=['1', '2'], default='1',
+                  help='command protocol: 1 - one byte commands, 2 - binary frames [default: %default]')
+parser.add_option('--crc', dest='crc', action='store_true', default=False,
+                  help='protect protocol 2 frames with a CRC')
+parser.add_option('--bench', dest='bench', type='choice', choices=list(BENCH_MODES),
+                  help='run a throughput benchmark: sink, source or echo (uses protocol 2)')
+parser.add_option('--size', dest='size', type='int', default=1024,
+                  help='benchmark block size in bytes, up to 2048 [default: %default]')
+parser.add_option('--duration', dest='duration', type='float', default=10,
+                  help='benchmark duration in seconds, up to 60 [default: %default]')
+parser.add_option('--stats', dest='stats', action='store_true', default=False,
+                  help='print the task statistics of the server and exit (uses protocol 2)')
+parser.add_option('--info', dest='info', action='store_true', default=False,
+                  help='print the command table of the server and exit (uses protocol 2)')
+parser.add_option('--log-level', dest='log_level', type='choice', choices=LOG_LEVELS + ['get'],
+                  help='set the log level of the server (off, error, warning, info, debug), '
+                       'or print it with "get", and exit (uses protocol 2)')
+if __name__ == '__main__':
+    (options, args) = parser.parse_args()
+
+    print("================================================================================")
+    print("TCP Client")
+    print("================================================================================")
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE, DEFAULT_KEEP_ALIVE)
+    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPIDLE, 10)
+    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPINTVL, 1)
+    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_KEEPCNT, 2)
+    s.connect((options.ip, options.port))
+    print("Connected to TCP Server (IP Address: ", options.ip, "Port: ", options.port, " )")
+
+    if options.bench:
+        run_bench(s, options.bench, options.size, options.duration, options.crc)
+        sys.exit(0)
+
+    if options.info:
+        run_info(s, options.crc)
+        sys.exit(0)
+
+    if options.log_level:
+        run_log_level(s, None if options.log_level == 'get' else options.log_level, options.crc)
+        sys.exit(0)
+
+    if options.stats:
+        run_stats(s, options.crc)
+        sys.exit(0)
+
+    if options.protocol == '2':
+        # Select protocol v2; the server acknowledges the HELLO.
+        s.send(encode_frame(PROTO_OP_HELLO, 0, b'', options.crc))
+        rx_buffer = b''
+        while 1:
+            data = s.recv(BUFFER_SIZE)
+            if not data:
+                print("Connection closed by the TCP server")
+                break
+            frames, rx_buffer = decode_frames(rx_buffer + data)
+            # Commands are acknowledged one by one, in the order they arrive; any
+            # number of them may be outstanding.
+            acks = b''
+            for opcode, seq, payload in frames:
+                if opcode == PROTO_OP_ACK and seq == 0:
+                    print("Protocol v2 accepted by the TCP server")
+                elif opcode == PROTO_OP_LED_SET and len(payload) == 1:
+                    print("================================================================================")
+                    print("Command", seq, "from Server:", "LED ON" if payload[0] else "LED OFF")
+                    acks += encode_frame(PROTO_OP_ACK, seq, bytes([PROTO_STATUS_OK, payload[0]]), options.crc)
+            if acks:
+                s.send(acks)
+                print("Acknowledgement sent to server")
+        sys.exit(0)
+
+    while 1:
+        print("================================================================================")        
+        data = s.recv(BUFFER_SIZE);
+        if not data:
+            print("Connection closed by the TCP server")
+            break
+        # Several commands may arrive in one segment; acknowledge each of them.
+        # Acknowledgements are terminated by ACK_DELIMITER.
+        for command in data.decode('utf-8'):
+            print("Command from Server:")
+            if command == '0':
+                print("LED OFF")
+                message = 'LED OFF ACK' + ACK_DELIMITER
+                s.send(message.encode('utf-8'))
+            if command == '1':
+                print("LED ON")
+                message = 'LED ON ACK' + ACK_DELIMITER
+                s.send(message.encode('utf-8'))
+            print("Acknowledgement sent to server")        
 
 # [] END OF FILE
@@ -0,0 +1,927 @@
+/******************************************************************************
+* File Name:   tcp_conn.c
+*
+* Description: This file contains the connection table used by the TCP server
+* to track the connected TCP clients. Each accepted client owns one entry of a
+* fixed size table; the entry is passed as the argument of the socket
+* callbacks so that the handlers find it without searching the table. The
+* table is the memory of a fixed-block pool (see mem_pool.h), so that an entry
+* is taken and released in constant time whatever the table size.
+*
+* Each entry also holds the send queue of the client. Messages are queued
+* without blocking and sent by the TCP writer task (see tcp_writer.c), which
+* is also the only task that closes client sockets. Buffers that outlive
+* their sending, such as constant tables, are queued by reference instead of
+* being copied into the send queue; each is sent in place at the send queue
+* position it was queued at.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_utils.h"
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+/* Standard C header files */
+#include <string.h>
+#include <inttypes.h>
+
+/* Connection table header file. */
+#include "tcp_conn.h"
+
+/* TCP writer task header file. */
+#include "tcp_writer.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Metrics header file. */
+#include "metrics.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/* Fixed-block pool header file. */
+#include "mem_pool.h"
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Connection table. */
+static tcp_conn_t conn_table[TCP_CONN_MAX_CLIENTS];
+
+/* Pool of the connection table entries. The pool never writes to a free
+ * entry, which the TCP writer task may be scanning.
+ */
+static mem_pool_t conn_pool;
+static uint16_t conn_free[TCP_CONN_MAX_CLIENTS];
+
+/* Number of entries in the connected state. */
+static uint32_t conn_count;
+
+/* Recursive mutex protecting allocation, release and iteration of the table.
+ * It is recursive so that an entry can be released from tcp_conn_for_each().
+ */
+static SemaphoreHandle_t conn_table_mutex;
+STATIC_ALLOC_MUTEX_DEFINE(conn_table_mutex);
+
+/* Backpressure callback of the send queues. */
+static tcp_conn_watermark_cb_t watermark_callback;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static bool update_tx_depth(tcp_conn_t *conn);
+static bool enqueue_static(tcp_conn_t *conn, const void *head, uint32_t head_len,
+                           const void *data, uint32_t len, const void *tail, uint32_t tail_len,
+                           tcp_conn_sent_cb_t callback, void *arg);
+static const tcp_conn_tx_ref_t *front_tx_ref(const tcp_conn_t *conn);
+static void consume_tx_ref(tcp_conn_t *conn, const tcp_conn_tx_ref_t *ref, uint32_t len);
+static void release_tx_refs(tcp_conn_t *conn);
+
+/*******************************************************************************
+ * Function Name: tcp_conn_table_init
+ *******************************************************************************
+ * Summary:
+ *  Marks all the connection table entries as free. Must be called before the
+ *  TCP server socket starts listening.
+ *
+ *******************************************************************************/
+void tcp_conn_table_init(void)
+{
+    memset(conn_table, 0, sizeof(conn_table));
+    mem_pool_init(&conn_pool, "conn", conn_table, conn_free, sizeof(tcp_conn_t), TCP_CONN_MAX_CLIENTS);
+    conn_count = 0;
+
+    if(conn_table_mutex == NULL)
+    {
+        conn_table_mutex = STATIC_ALLOC_RECURSIVE_MUTEX_CREATE(conn_table_mutex);
+        configASSERT(conn_table_mutex != NULL);
+        TRACE_QUEUE_NUMBER(conn_table_mutex, TRACE_QUEUE_CONN_TABLE);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_alloc
+ *******************************************************************************
+ * Summary:
+ *  Takes a free entry of the connection table for an accepted TCP client.
+ *
+ * Parameters:
+ *  cy_socket_t handle: Socket of the accepted TCP client
+ *  const cy_socket_sockaddr_t *peer_addr: Address of the TCP client
+ *
+ * Return:
+ *  tcp_conn_t *: Connection entry, or NULL if the table is full
+ *
+ *******************************************************************************/
+tcp_conn_t *tcp_conn_alloc(cy_socket_t handle, const cy_socket_sockaddr_t *peer_addr)
+{
+    tcp_conn_t *conn;
+
+    xSemaphoreTakeRecursive(conn_table_mutex, portMAX_DELAY);
+
+    conn = (tcp_conn_t *)mem_pool_alloc(&conn_pool);
+    if(conn != NULL)
+    {
+        memset(conn, 0, sizeof(*conn));
+        conn->handle = handle;
+        conn->peer_addr = *peer_addr;
+        ring_buffer_init(&conn->rx_ring, conn->rx_storage, sizeof(conn->rx_storage));
+        ring_buffer_init(&conn->tx_ring, conn->tx_storage, sizeof(conn->tx_storage));
+
+        /* The TCP writer task scans the table without the lock, so the
+         * entry is published only once it is fully initialized.
+         */
+        __atomic_store_n(&conn->state, TCP_CONN_STATE_CONNECTED, __ATOMIC_RELEASE);
+        conn_count++;
+    }
+
+    xSemaphoreGiveRecursive(conn_table_mutex);
+
+    return conn;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_find
+ *******************************************************************************
+ * Summary:
+ *  Returns the connection entry of a client socket. The socket callbacks of an
+ *  accepted client are registered with its entry as the argument, so the entry
+ *  is normally found in constant time. The table is only searched for
+ *  callbacks that run before the per-client callbacks are registered.
+ *
+ * Parameters:
+ *  cy_socket_t handle: Socket of the TCP client
+ *  void *arg: Argument received by the socket callback
+ *
+ * Return:
+ *  tcp_conn_t *: Connection entry, or NULL if the socket is not in the table
+ *
+ *******************************************************************************/
+tcp_conn_t *tcp_conn_find(cy_socket_t handle, void *arg)
+{
+    tcp_conn_t *conn = (tcp_conn_t *)arg;
+
+    if((conn != NULL) && (conn->state != TCP_CONN_STATE_FREE) && (conn->handle == handle))
+    {
+        return conn;
+    }
+
+    for(uint32_t i = 0; i < TCP_CONN_MAX_CLIENTS; i++)
+    {
+        if((conn_table[i].state != TCP_CONN_STATE_FREE) && (conn_table[i].handle == handle))
+        {
+            return &conn_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_close
+ *******************************************************************************
+ * Summary:
+ *  Requests the closing of a client connection. The entry stops taking part in
+ *  the fan-out right away; the TCP writer task then disconnects and deletes
+ *  the socket and releases the entry, so that a socket is never deleted while
+ *  a send on it is in progress.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry to close
+ *
+ *******************************************************************************/
+void tcp_conn_close(tcp_conn_t *conn)
+{
+    bool closing = false;
+
+    xSemaphoreTakeRecursive(conn_table_mutex, portMAX_DELAY);
+
+    if(conn->state == TCP_CONN_STATE_CONNECTED)
+    {
+        __atomic_store_n(&conn->state, TCP_CONN_STATE_CLOSING, __ATOMIC_RELEASE);
+        conn_count--;
+        closing = true;
+    }
+
+    xSemaphoreGiveRecursive(conn_table_mutex);
+
+    if(closing)
+    {
+        tcp_writer_notify();
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_free
+ *******************************************************************************
+ * Summary:
+ *  Returns a connection entry to the table, completing the buffers still
+ *  queued by reference as unsent. The socket must already be deleted by the
+ *  caller, the TCP writer task.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry to release
+ *
+ *******************************************************************************/
+void tcp_conn_free(tcp_conn_t *conn)
+{
+    release_tx_refs(conn);
+
+    xSemaphoreTakeRecursive(conn_table_mutex, portMAX_DELAY);
+
+    if(conn->state == TCP_CONN_STATE_CONNECTED)
+    {
+        conn_count--;
+    }
+    conn->state = TCP_CONN_STATE_FREE;
+    conn->handle = NULL;
+    mem_pool_free(&conn_pool, conn);
+
+    xSemaphoreGiveRecursive(conn_table_mutex);
+
+    METRICS_INC(METRICS_DISCONNECTS);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_at
+ *******************************************************************************
+ * Summary:
+ *  Returns the connection table entry at an index, whatever its state. Used
+ *  by the TCP writer task to scan the table without taking the lock.
+ *
+ *******************************************************************************/
+tcp_conn_t *tcp_conn_at(uint32_t index)
+{
+    return (index < TCP_CONN_MAX_CLIENTS) ? &conn_table[index] : NULL;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_for_each
+ *******************************************************************************
+ * Summary:
+ *  Calls a function for every connected TCP client. The table is locked while
+ *  the function runs, so it must not allocate or release entries other than
+ *  the one it is called for.
+ *
+ * Parameters:
+ *  tcp_conn_iter_t iter: Function to call
+ *  void *arg: Argument passed on to the function
+ *
+ * Return:
+ *  uint32_t: Number of clients the function was called for
+ *
+ *******************************************************************************/
+uint32_t tcp_conn_for_each(tcp_conn_iter_t iter, void *arg)
+{
+    uint32_t visited = 0;
+
+    xSemaphoreTakeRecursive(conn_table_mutex, portMAX_DELAY);
+
+    for(uint32_t i = 0; i < TCP_CONN_MAX_CLIENTS; i++)
+    {
+        if(conn_table[i].state == TCP_CONN_STATE_CONNECTED)
+        {
+            iter(&conn_table[i], arg);
+            visited++;
+        }
+    }
+
+    xSemaphoreGiveRecursive(conn_table_mutex);
+
+    return visited;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_count
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of connected TCP clients.
+ *
+ *******************************************************************************/
+uint32_t tcp_conn_count(void)
+{
+    return conn_count;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_print_stats
+ *******************************************************************************
+ * Summary:
+ *  Logs the counters and the send queue statistics of a client connection.
+ *
+ *******************************************************************************/
+void tcp_conn_print_stats(const tcp_conn_t *conn)
+{
+    APP_LOG_INFO("Client "APP_LOG_IPV4_FMT": rx %"PRIuPTR" bytes, tx %"PRIuPTR" bytes",
+                 APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4),
+                 conn->bytes_received, conn->bytes_sent);
+    APP_LOG_INFO("  %"PRIuPTR" commands, %"PRIuPTR" acks, %"PRIuPTR" rx frame errors",
+                 conn->cmds_sent, conn->acks_received, conn->rx_frame_errors);
+    APP_LOG_INFO("  Send queue: depth %"PRIuPTR"/%"PRIuPTR", peak %"PRIuPTR", "
+                 "dropped %"PRIuPTR", send errors %"PRIuPTR,
+                 tcp_conn_tx_depth(conn), (uint32_t)TCP_CONN_TX_BUFFER_SIZE,
+                 conn->tx_peak_depth, conn->tx_dropped, conn->tx_errors);
+    if(conn->protocol == TCP_CONN_PROTOCOL_V2)
+    {
+        APP_LOG_INFO("  Protocol v2: %"PRIuPTR" commands in flight, %"PRIuPTR" unmatched acks, "
+                     "%"PRIuPTR" refused on a full window",
+                     conn->inflight, conn->acks_unmatched, conn->window_full);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_set_watermark_callback
+ *******************************************************************************
+ * Summary:
+ *  Registers the backpressure callback of the send queues.
+ *
+ *******************************************************************************/
+void tcp_conn_set_watermark_callback(tcp_conn_watermark_cb_t callback)
+{
+    watermark_callback = callback;
+}
+
+/*******************************************************************************
+ * Function Name: enqueue
+ *******************************************************************************
+ * Summary:
+ *  Queues a message for a TCP client and wakes up the TCP writer task. If
+ *  'pending' is not NULL, the send queue position after the message is
+ *  stored in it before the writer can send the message.
+ *
+ *******************************************************************************/
+static bool enqueue(tcp_conn_t *conn, const void *data, uint32_t len,
+                    tcp_conn_pending_t *pending)
+{
+    bool queued;
+    bool crossed = false;
+
+    taskENTER_CRITICAL();
+
+    queued = ring_buffer_write(&conn->tx_ring, data, len);
+    if(queued)
+    {
+        if(pending != NULL)
+        {
+            pending->tx_end = conn->tx_ring.head;
+        }
+
+        crossed = update_tx_depth(conn);
+    }
+    else
+    {
+        conn->tx_dropped++;
+    }
+
+    taskEXIT_CRITICAL();
+
+    if(crossed && (watermark_callback != NULL))
+    {
+        watermark_callback(conn, true);
+    }
+
+    if(queued)
+    {
+        tcp_writer_notify();
+    }
+
+    return queued;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_enqueue
+ *******************************************************************************
+ * Summary:
+ *  Queues a message for a TCP client and wakes up the TCP writer task. Never
+ *  blocks: if the send queue has no room for the whole message, the message
+ *  is dropped and counted. Commands are queued by the TCP server task and
+ *  protocol replies by the receive handler, so producers are serialized by a
+ *  short critical section; the TCP writer task reads the queue without it.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const void *data: Message to send
+ *  uint32_t len: Length of the message
+ *
+ * Return:
+ *  bool: true if the message was queued, false if it was dropped
+ *
+ *******************************************************************************/
+bool tcp_conn_enqueue(tcp_conn_t *conn, const void *data, uint32_t len)
+{
+    return enqueue(conn, data, len, NULL);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_enqueue_pending
+ *******************************************************************************
+ * Summary:
+ *  Queues a command recorded with tcp_conn_pending_add(), so that the TCP
+ *  writer task time stamps the command once it is sent.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const void *data: Command to send
+ *  uint32_t len: Length of the command
+ *  uint16_t seq: Sequence number of the command
+ *
+ * Return:
+ *  bool: true if the command was queued, false if it was dropped
+ *
+ *******************************************************************************/
+bool tcp_conn_enqueue_pending(tcp_conn_t *conn, const void *data, uint32_t len, uint16_t seq)
+{
+    return enqueue(conn, data, len, &conn->pending[seq & (TCP_CONN_MAX_INFLIGHT - 1)]);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_enqueue_static
+ *******************************************************************************
+ * Summary:
+ *  Queues a buffer by reference: the TCP writer task sends it in place, after
+ *  the messages already queued and before those queued later, and then calls
+ *  the completion callback. Saves the copy into the send queue, whose size
+ *  does not limit the buffer. Never blocks; fails if TCP_CONN_MAX_TX_REFS
+ *  buffers are already queued on the connection, or if it is closing.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const void *data: Buffer to send, left untouched until its completion
+ *  uint32_t len: Length of the buffer, not 0
+ *  tcp_conn_sent_cb_t callback: Completion callback, may be NULL for a
+ *  constant buffer
+ *  void *arg: Argument passed on to the callback
+ *
+ * Return:
+ *  bool: true if the buffer was queued, false if it was dropped; the
+ *        callback is not called for a dropped buffer
+ *
+ *******************************************************************************/
+bool tcp_conn_enqueue_static(tcp_conn_t *conn, const void *data, uint32_t len,
+                             tcp_conn_sent_cb_t callback, void *arg)
+{
+    return enqueue_static(conn, NULL, 0, data, len, NULL, 0, callback, arg);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_enqueue_static_framed
+ *******************************************************************************
+ * Summary:
+ *  Queues a buffer by reference, as tcp_conn_enqueue_static(), between a
+ *  head and a tail copied into the send queue, e.g. the header and the CRC
+ *  of a frame whose payload is the buffer. The three parts are queued
+ *  together or not at all, so no other message comes between them.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const void *head: Bytes sent before the buffer, may be NULL if 'head_len'
+ *  is 0
+ *  uint32_t head_len: Length of the head
+ *  const void *data: Buffer to send, left untouched until its completion
+ *  uint32_t len: Length of the buffer, not 0
+ *  const void *tail: Bytes sent after the buffer, may be NULL if 'tail_len'
+ *  is 0
+ *  uint32_t tail_len: Length of the tail
+ *  tcp_conn_sent_cb_t callback: Completion callback, may be NULL for a
+ *  constant buffer
+ *  void *arg: Argument passed on to the callback
+ *
+ * Return:
+ *  bool: true if the message was queued, false if it was dropped because
+ *        the send queue has no room for the head and the tail, or for the
+ *        reasons of tcp_conn_enqueue_static()
+ *
+ *******************************************************************************/
+bool tcp_conn_enqueue_static_framed(tcp_conn_t *conn, const void *head, uint32_t head_len,
+                                    const void *data, uint32_t len, const void *tail, uint32_t tail_len,
+                                    tcp_conn_sent_cb_t callback, void *arg)
+{
+    return enqueue_static(conn, head, head_len, data, len, tail, tail_len, callback, arg);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_tx_peek
+ *******************************************************************************
+ * Summary:
+ *  Returns the next contiguous block of queued data: part of the send queue,
+ *  or the rest of a buffer queued by reference. Called by the TCP writer task
+ *  only.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const uint8_t **span: Set to the start of the block
+ *
+ * Return:
+ *  uint32_t: Length of the block, 0 if the send queue is empty
+ *
+ *******************************************************************************/
+uint32_t tcp_conn_tx_peek(tcp_conn_t *conn, const uint8_t **span)
+{
+    const tcp_conn_tx_ref_t *ref;
+    const uint8_t *ring_span;
+    uint32_t len;
+
+    /* The send queue is read first: the bytes queued after a buffer are
+     * published after the buffer, so the buffer is known to bound them.
+     */
+    len = ring_buffer_read_span(&conn->tx_ring, &ring_span);
+    ref = front_tx_ref(conn);
+
+    /* The oldest buffer queued by reference is due once the send queue was
+     * sent up to its position, and bounds the block until then.
+     */
+    if((ref != NULL) && (conn->tx_ring.tail == ref->tx_pos))
+    {
+        *span = &ref->data[conn->tx_ref_offset];
+        return ref->len - conn->tx_ref_offset;
+    }
+
+    if((ref != NULL) && (len > (ref->tx_pos - conn->tx_ring.tail)))
+    {
+        len = ref->tx_pos - conn->tx_ring.tail;
+    }
+
+    *span = ring_span;
+    return len;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_tx_consume
+ *******************************************************************************
+ * Summary:
+ *  Removes sent data from the send queue and time stamps the commands sent
+ *  completely, or advances in the buffer queued by reference being sent.
+ *  Called by the TCP writer task only.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  uint32_t len: Number of bytes sent
+ *
+ *******************************************************************************/
+void tcp_conn_tx_consume(tcp_conn_t *conn, uint32_t len)
+{
+    const tcp_conn_tx_ref_t *ref = front_tx_ref(conn);
+    tcp_conn_pending_t *pending;
+    uint32_t tail;
+    uint32_t now;
+    bool crossed = false;
+
+    /* The block came from the buffer queued by reference, as in
+     * tcp_conn_tx_peek(); buffers queued since then are further on.
+     */
+    if((ref != NULL) && (conn->tx_ring.tail == ref->tx_pos))
+    {
+        consume_tx_ref(conn, ref, len);
+        return;
+    }
+
+    ring_buffer_skip(&conn->tx_ring, len);
+    conn->bytes_sent += len;
+    METRICS_ADD(METRICS_TX_BYTES, len);
+
+    /* Time stamp the commands that have now been handed to the socket. */
+    if(conn->inflight > 0)
+    {
+        tail = conn->tx_ring.tail;
+        now = timestamp_now();
+        for(uint32_t i = 0; i < TCP_CONN_MAX_INFLIGHT; i++)
+        {
+            pending = &conn->pending[i];
+            if(__atomic_load_n(&pending->in_use, __ATOMIC_ACQUIRE) && (!pending->sent) &&
+               ((int32_t)(tail - pending->tx_end) >= 0))
+            {
+                pending->t_sent = now;
+                __atomic_store_n(&pending->sent, true, __ATOMIC_RELEASE);
+            }
+        }
+    }
+
+    if(conn->tx_throttled)
+    {
+        taskENTER_CRITICAL();
+        if(conn->tx_throttled && (ring_buffer_used(&conn->tx_ring) <= TCP_CONN_TX_LOW_WATERMARK))
+        {
+            conn->tx_throttled = false;
+            crossed = true;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if(crossed && (watermark_callback != NULL))
+    {
+        watermark_callback(conn, false);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_tx_depth
+ *******************************************************************************
+ * Summary:
+ *  Returns the number of bytes waiting in the send queue of a client.
+ *
+ *******************************************************************************/
+uint32_t tcp_conn_tx_depth(const tcp_conn_t *conn)
+{
+    return ring_buffer_used(&conn->tx_ring);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_pending_add
+ *******************************************************************************
+ * Summary:
+ *  Assigns the next sequence number to a command and records the command
+ *  until it is acknowledged. The sequence number is used up even if the
+ *  command cannot be recorded, so that implicitly numbered protocol v1 acks
+ *  stay matched to their commands. Fails without blocking if the slot of the
+ *  sequence number is still taken, that is if TCP_CONN_MAX_INFLIGHT commands
+ *  are awaiting their acknowledgement.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const tcp_conn_pending_t *cmd: Opcode, value and timestamps of the command
+ *  uint16_t *seq: Set to the sequence number of the command
+ *
+ * Return:
+ *  bool: true if the command was recorded, false if the window is full
+ *
+ *******************************************************************************/
+bool tcp_conn_pending_add(tcp_conn_t *conn, const tcp_conn_pending_t *cmd, uint16_t *seq)
+{
+    tcp_conn_pending_t *pending = &conn->pending[conn->tx_seq & (TCP_CONN_MAX_INFLIGHT - 1)];
+
+    *seq = conn->tx_seq++;
+
+    if(__atomic_load_n(&pending->in_use, __ATOMIC_ACQUIRE))
+    {
+        conn->window_full++;
+        return false;
+    }
+
+    *pending = *cmd;
+    pending->seq = *seq;
+    pending->sent = false;
+    /* Not sent before tcp_conn_enqueue_pending() sets the real position. */
+    pending->tx_end = conn->tx_ring.head + TCP_CONN_TX_BUFFER_SIZE;
+    __atomic_store_n(&pending->in_use, true, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&conn->inflight, 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_pending_complete
+ *******************************************************************************
+ * Summary:
+ *  Releases the pending command with a given sequence number, on its
+ *  acknowledgement or when it could not be sent.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  uint16_t seq: Sequence number of the command
+ *  tcp_conn_pending_t *pending: Set to a copy of the released command
+ *
+ * Return:
+ *  bool: true if the command was pending, false if no command has this
+ *        sequence number
+ *
+ *******************************************************************************/
+bool tcp_conn_pending_complete(tcp_conn_t *conn, uint16_t seq, tcp_conn_pending_t *pending)
+{
+    tcp_conn_pending_t *slot = &conn->pending[seq & (TCP_CONN_MAX_INFLIGHT - 1)];
+
+    if((!__atomic_load_n(&slot->in_use, __ATOMIC_ACQUIRE)) || (slot->seq != seq))
+    {
+        return false;
+    }
+
+    *pending = *slot;
+    __atomic_store_n(&slot->in_use, false, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&conn->inflight, 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_conn_pending_cancel
+ *******************************************************************************
+ * Summary:
+ *  Withdraws the last command given a sequence number by
+ *  tcp_conn_pending_add(), when the command could not be queued. The
+ *  sequence number is given back, so that protocol v1 acks stay matched.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  uint16_t seq: Sequence number of the command
+ *
+ *******************************************************************************/
+void tcp_conn_pending_cancel(tcp_conn_t *conn, uint16_t seq)
+{
+    tcp_conn_pending_t pending;
+
+    tcp_conn_pending_complete(conn, seq, &pending);
+
+    if((uint16_t)(conn->tx_seq - 1u) == seq)
+    {
+        conn->tx_seq = seq;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: update_tx_depth
+ *******************************************************************************
+ * Summary:
+ *  Updates the peak depth of the send queue after bytes were queued, and
+ *  throttles the client when the queue reaches the high watermark. Called
+ *  in the producers' critical section.
+ *
+ * Return:
+ *  bool: true if the client was throttled now; the caller reports it
+ *
+ *******************************************************************************/
+static bool update_tx_depth(tcp_conn_t *conn)
+{
+    uint32_t depth = ring_buffer_used(&conn->tx_ring);
+
+    if(depth > conn->tx_peak_depth)
+    {
+        conn->tx_peak_depth = depth;
+    }
+
+    if((!conn->tx_throttled) && (depth >= TCP_CONN_TX_HIGH_WATERMARK))
+    {
+        conn->tx_throttled = true;
+        return true;
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: enqueue_static
+ *******************************************************************************
+ * Summary:
+ *  Queues a buffer by reference, with the optional head and tail copied
+ *  into the send queue around it, and wakes up the TCP writer task. See
+ *  tcp_conn_enqueue_static_framed().
+ *
+ *******************************************************************************/
+static bool enqueue_static(tcp_conn_t *conn, const void *head, uint32_t head_len,
+                           const void *data, uint32_t len, const void *tail, uint32_t tail_len,
+                           tcp_conn_sent_cb_t callback, void *arg)
+{
+    tcp_conn_tx_ref_t *ref;
+    bool queued = false;
+    bool crossed = false;
+
+    CY_ASSERT(len > 0);
+
+    taskENTER_CRITICAL();
+
+    if((conn->state == TCP_CONN_STATE_CONNECTED) &&
+       ((conn->tx_ref_head - __atomic_load_n(&conn->tx_ref_tail, __ATOMIC_ACQUIRE)) < TCP_CONN_MAX_TX_REFS) &&
+       (ring_buffer_free(&conn->tx_ring) >= (head_len + tail_len)))
+    {
+        if(head_len > 0)
+        {
+            (void)ring_buffer_write(&conn->tx_ring, head, head_len);
+        }
+
+        ref = &conn->tx_refs[conn->tx_ref_head & (TCP_CONN_MAX_TX_REFS - 1u)];
+        ref->data = (const uint8_t *)data;
+        ref->len = len;
+        ref->tx_pos = conn->tx_ring.head;
+        ref->callback = callback;
+        ref->arg = arg;
+
+        /* Published before the tail is queued, so that the TCP writer never
+         * takes the tail for bytes due before the buffer.
+         */
+        __atomic_store_n(&conn->tx_ref_head, conn->tx_ref_head + 1u, __ATOMIC_RELEASE);
+
+        if(tail_len > 0)
+        {
+            (void)ring_buffer_write(&conn->tx_ring, tail, tail_len);
+        }
+
+        crossed = update_tx_depth(conn);
+        queued = true;
+    }
+    else
+    {
+        conn->tx_dropped++;
+    }
+
+    taskEXIT_CRITICAL();
+
+    if(crossed && (watermark_callback != NULL))
+    {
+        watermark_callback(conn, true);
+    }
+
+    if(queued)
+    {
+        tcp_writer_notify();
+    }
+
+    return queued;
+}
+
+/*******************************************************************************
+ * Function Name: front_tx_ref
+ *******************************************************************************
+ * Summary:
+ *  Returns the oldest buffer queued by reference, NULL if there is none.
+ *
+ *******************************************************************************/
+static const tcp_conn_tx_ref_t *front_tx_ref(const tcp_conn_t *conn)
+{
+    if(conn->tx_ref_tail == __atomic_load_n(&conn->tx_ref_head, __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    return &conn->tx_refs[conn->tx_ref_tail & (TCP_CONN_MAX_TX_REFS - 1u)];
+}
+
+/*******************************************************************************
+ * Function Name: consume_tx_ref
+ *******************************************************************************
+ * Summary:
+ *  Advances in the oldest buffer queued by reference, and releases it and
+ *  calls its completion callback once it is sent completely.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection entry of the TCP client
+ *  const tcp_conn_tx_ref_t *ref: Oldest buffer queued by reference
+ *  uint32_t len: Number of bytes sent
+ *
+ *******************************************************************************/
+static void consume_tx_ref(tcp_conn_t *conn, const tcp_conn_tx_ref_t *ref, uint32_t len)
+{
+    tcp_conn_tx_ref_t done;
+
+    conn->bytes_sent += len;
+    METRICS_ADD(METRICS_TX_BYTES, len);
+
+    conn->tx_ref_offset += len;
+    if(conn->tx_ref_offset < ref->len)
+    {
+        return;
+    }
+
+    /* The slot is reused once released. */
+    done = *ref;
+    conn->tx_ref_offset = 0;
+    __atomic_store_n(&conn->tx_ref_tail, conn->tx_ref_tail + 1u, __ATOMIC_RELEASE);
+
+    if(done.callback != NULL)
+    {
+        done.callback(done.data, true, done.arg);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: release_tx_refs
+ *******************************************************************************
+ * Summary:
+ *  Releases the buffers still queued by reference on a closing connection,
+ *  calling their completion callbacks as unsent. No buffer is queued on a
+ *  closing connection.
+ *
+ *******************************************************************************/
+static void release_tx_refs(tcp_conn_t *conn)
+{
+    const tcp_conn_tx_ref_t *ref;
+    tcp_conn_tx_ref_t done;
+
+    while((ref = front_tx_ref(conn)) != NULL)
+    {
+        done = *ref;
+        conn->tx_ref_offset = 0;
+        __atomic_store_n(&conn->tx_ref_tail, conn->tx_ref_tail + 1u, __ATOMIC_RELEASE);
+
+        if(done.callback != NULL)
+        {
+            done.callback(done.data, false, done.arg);
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,207 @@
+/******************************************************************************
+* File Name:   tcp_conn.h
+*
+* Description: This file contains declaration of the connection table used by
+* the TCP server to track the connected TCP clients.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TCP_CONN_H_
+#define TCP_CONN_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/* Ring buffer header file. */
+#include "ring_buffer.h"
+
+/* Memory budget header file, for the sizes of the connection table. */
+#include "app_memory_budget.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* TCP_CONN_MAX_CLIENTS, the maximum number of TCP clients served at the same
+ * time, and the sizes below default to those of the memory budget, see
+ * app_memory_budget.h.
+ *
+ * TCP_CONN_RX_BUFFER_SIZE: Size of the receive ring buffer of each client.
+ * Must be a power of two.
+ *
+ * TCP_CONN_TX_BUFFER_SIZE: Size of the send queue of each client. Must be a
+ * power of two.
+ *
+ * TCP_CONN_MAX_INFLIGHT: Maximum number of commands awaiting their
+ * acknowledgement on one connection. Must be a power of two.
+ *
+ * TCP_CONN_MAX_TX_REFS: Maximum number of buffers queued by reference on one
+ * connection, see tcp_conn_enqueue_static(). Must be a power of two.
+ */
+
+/* Send queue depths at which the backpressure callback reports that a client
+ * is falling behind, and that it has caught up again.
+ */
+#define TCP_CONN_TX_HIGH_WATERMARK                ((TCP_CONN_TX_BUFFER_SIZE * 3u) / 4u)
+#define TCP_CONN_TX_LOW_WATERMARK                 (TCP_CONN_TX_BUFFER_SIZE / 4u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* State of a connection table entry. */
+typedef enum
+{
+    TCP_CONN_STATE_FREE = 0,        /* Entry is not in use. */
+    TCP_CONN_STATE_CONNECTED,       /* Entry holds an accepted TCP client. */
+    TCP_CONN_STATE_CLOSING          /* Socket waits to be closed by the writer. */
+} tcp_conn_state_t;
+
+/* Command protocol spoken by a TCP client. */
+typedef enum
+{
+    TCP_CONN_PROTOCOL_V1 = 0,       /* One byte commands, text acks. */
+    TCP_CONN_PROTOCOL_V2,           /* Binary frames, see tcp_proto.h. */
+    TCP_CONN_PROTOCOL_BENCH         /* Raw benchmark data, see tcp_bench.h. */
+} tcp_conn_protocol_t;
+
+/* LED command protocol state of a protocol v1 client. */
+typedef enum
+{
+    TCP_CONN_PROTO_IDLE = 0,        /* No command outstanding. */
+    TCP_CONN_PROTO_WAIT_ACK         /* Command sent, waiting for the ack. */
+} tcp_conn_proto_state_t;
+
+/* Command awaiting its acknowledgement. The timestamps (see timestamp.h)
+ * time the stages of the command for the latency histograms.
+ */
+typedef struct
+{
+    uint16_t seq;
+    uint8_t opcode;
+    uint8_t value;
+    bool in_use;
+    bool sent;                          /* t_sent is valid. */
+    uint32_t t_isr;                     /* User button interrupt. */
+    uint32_t t_task;                    /* TCP server task wakeup. */
+    uint32_t t_sent;                    /* cy_socket_send() return. */
+    uint32_t tx_end;                    /* Send queue position after the command. */
+} tcp_conn_pending_t;
+
+/* Completion callback of a buffer queued with tcp_conn_enqueue_static().
+ * Called by the TCP writer task once the whole buffer was handed to the
+ * socket, with 'sent' true, or when the connection is released before, with
+ * 'sent' false. The buffer may be reused from then on. Must not block.
+ */
+typedef void (*tcp_conn_sent_cb_t)(const void *data, bool sent, void *arg);
+
+/* Buffer queued by reference. */
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t tx_pos;                    /* Send queue position the buffer is sent at. */
+    tcp_conn_sent_cb_t callback;
+    void *arg;
+} tcp_conn_tx_ref_t;
+
+/* Per-client connection state. */
+typedef struct
+{
+    cy_socket_t handle;                 /* Socket of the accepted client. */
+    cy_socket_sockaddr_t peer_addr;     /* Address of the TCP client. */
+    tcp_conn_state_t state;
+    tcp_conn_protocol_t protocol;
+    bool crc_enabled;                   /* Client asked for CRCs in its frames. */
+    tcp_conn_proto_state_t proto_state;
+    uint32_t last_cmd;                  /* Last LED command sent. */
+    uint32_t bytes_received;
+    uint32_t bytes_sent;
+    uint32_t cmds_sent;
+    uint32_t acks_received;
+    uint32_t rx_frame_errors;           /* Unframed data discarded. */
+    uint32_t rx_timestamp;              /* Time the last data was received. */
+    uint32_t acks_unmatched;            /* Acks without a pending command. */
+    uint32_t window_full;               /* Commands refused on a full window. */
+    uint8_t stats_snapshot;             /* Task statistics snapshot taken, 0 if none. */
+    ring_buffer_t rx_ring;              /* Received bytes not yet framed. */
+    uint8_t rx_storage[TCP_CONN_RX_BUFFER_SIZE];
+
+    /* Send queue. Producers are serialized by tcp_conn_enqueue(); the
+     * consumer is the TCP writer task.
+     */
+    ring_buffer_t tx_ring;
+    uint8_t tx_storage[TCP_CONN_TX_BUFFER_SIZE];
+    uint32_t tx_peak_depth;             /* Deepest the send queue has been. */
+    uint32_t tx_dropped;                /* Messages refused on a full queue. */
+    uint32_t tx_errors;                 /* Failed cy_socket_send() calls. */
+    bool tx_throttled;                  /* Above the high watermark. */
+
+    /* Buffers sent in place, between the bytes of the send queue. Queued
+     * like the send queue; released by the TCP writer task.
+     */
+    tcp_conn_tx_ref_t tx_refs[TCP_CONN_MAX_TX_REFS];
+    uint32_t tx_ref_head;
+    uint32_t tx_ref_tail;
+    uint32_t tx_ref_offset;             /* Bytes of the oldest buffer sent. */
+
+    /* Commands awaiting their acknowledgement, indexed by the sequence number
+     * modulo TCP_CONN_MAX_INFLIGHT. Slots are taken by the task sending the
+     * commands and released by the receive handler. Protocol v1 commands are
+     * numbered implicitly, the acks arriving in command order.
+     */
+    uint16_t tx_seq;                    /* Sequence number of the next command. */
+    uint16_t rx_seq;                    /* Sequence number of the next v1 ack. */
+    uint32_t inflight;
+    tcp_conn_pending_t pending[TCP_CONN_MAX_INFLIGHT];
+} tcp_conn_t;
+
+/* Function called for every connected client by tcp_conn_for_each(). */
+typedef void (*tcp_conn_iter_t)(tcp_conn_t *conn, void *arg);
+
+/* Backpressure callback. Called with 'throttled' true when the send queue of
+ * a client reaches TCP_CONN_TX_HIGH_WATERMARK, and with false when it drains
+ * to TCP_CONN_TX_LOW_WATERMARK. Runs in the context of the producer or of
+ * the TCP writer task and must not block.
+ */
+typedef void (*tcp_conn_watermark_cb_t)(tcp_conn_t *conn, bool throttled);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void tcp_conn_table_init(void);
+tcp_conn_t *tcp_conn_alloc(cy_socket_t handle, const cy_socket_sockaddr_t *peer_addr);
+tcp_conn_t *tcp_conn_find(cy_socket_t handle, void *arg);
+void tcp_conn_close(tcp_conn_t *conn);
+void tcp_conn_free(tcp_conn_t *conn);
+tcp_conn_t *tcp_conn_at(uint32_t index);
+uint32_t tcp_conn_for_each(tcp_conn_iter_t iter, void *arg);
+uint32_t tcp_conn_count(void);
+void tcp_conn_print_stats(const tcp_conn_t *conn);
+
+/* Send queue. */
+void tcp_conn_set_watermark_callback(tcp_conn_watermark_cb_t callback);
+bool tcp_conn_enqueue(tcp_conn_t *conn, const void *data, uint32_t len);
+bool tcp_conn_enqueue_pending(tcp_conn_t *conn, const void *data, uint32_t len, uint16_t seq);
+bool tcp_conn_enqueue_static(tcp_conn_t *conn, const void *data, uint32_t len,
+                             tcp_conn_sent_cb_t callback, void *arg);
+bool tcp_conn_enqueue_static_framed(tcp_conn_t *conn, const void *head, uint32_t head_len,
+                                    const void *data, uint32_t len, const void *tail, uint32_t tail_len,
+                                    tcp_conn_sent_cb_t callback, void *arg);
+uint32_t tcp_conn_tx_peek(tcp_conn_t *conn, const uint8_t **span);
+void tcp_conn_tx_consume(tcp_conn_t *conn, uint32_t len);
+uint32_t tcp_conn_tx_depth(const tcp_conn_t *conn);
+
+/* Commands awaiting their acknowledgement. */
+bool tcp_conn_pending_add(tcp_conn_t *conn, const tcp_conn_pending_t *cmd, uint16_t *seq);
+bool tcp_conn_pending_complete(tcp_conn_t *conn, uint16_t seq, tcp_conn_pending_t *pending);
+void tcp_conn_pending_cancel(tcp_conn_t *conn, uint16_t seq);
+
+#endif /* TCP_CONN_H_ */
@@ -0,0 +1,221 @@
+#******************************************************************************
+# File Name:   tcp_loadgen.py
+#
+# Description: Load generator for the TCP server. Opens many concurrent
+# protocol v2 connections, sends PING commands on each at a fixed rate and
+# reports the connect and acknowledgement latencies as CSV or JSON.
+#
+#******************************************************************************
+# $ Copyright 2021-2023 Cypress Semiconductor $
+#******************************************************************************
+
+#!/usr/bin/env python3
+import asyncio
+import optparse
+import json
+import math
+import socket
+import sys
+import time
+
+from tcp_client import (DEFAULT_IP, DEFAULT_PORT, PROTO_OP_HELLO, PROTO_OP_ACK,
+                        PROTO_OP_LED_SET, PROTO_STATUS_OK, encode_frame, decode_frames)
+
+PROTO_OP_PING = 0x03
+BUFFER_SIZE   = 4096
+
+class Stats:
+    def __init__(self):
+        self.attempted = 0
+        self.established = 0
+        self.failed = 0          # connect() failed or timed out
+        self.rejected = 0        # closed by the server before the HELLO ack
+        self.dropped = 0         # closed by the server during the test
+        self.sent = 0
+        self.acked = 0
+        self.refused = 0         # acknowledged with an error status
+        self.lost = 0            # not acknowledged by the end of the test
+        self.led_commands = 0
+        self.connect_latency = []
+        self.ack_latency = []
+
+def percentile(samples, fraction):
+    """Nearest-rank percentile of a sorted list."""
+    if not samples:
+        return 0.0
+    # Rounded first, so that e.g. 0.07 * 100 is not taken as just above 7.
+    index = min(len(samples) - 1, max(0, math.ceil(round(fraction * len(samples), 9)) - 1))
+    return samples[index]
+
+async def connection(options, stats, start_at, stop_at):
+    await asyncio.sleep(max(0.0, start_at - time.monotonic()))
+    stats.attempted += 1
+    t0 = time.monotonic()
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(options.ip, options.port), options.connect_timeout)
+    except (OSError, asyncio.TimeoutError):
+        stats.failed += 1
+        return
+
+    # Commands are sent as they are due, not coalesced by the client stack.
+    writer.get_extra_info('socket').setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    rx_buffer = b''
+    outstanding = {}
+    seq = 0
+    hello_acked = False
+    established = False
+
+    async def receive():
+        nonlocal rx_buffer, hello_acked
+        data = await reader.read(BUFFER_SIZE)
+        if not data:
+            raise ConnectionResetError
+        frames, rx_buffer = decode_frames(rx_buffer + data)
+        acks = b''
+        for opcode, frame_seq, payload in frames:
+            if opcode == PROTO_OP_ACK and frame_seq == 0:
+                hello_acked = True
+            elif opcode == PROTO_OP_ACK and frame_seq in outstanding:
+                stats.ack_latency.append(time.monotonic() - outstanding.pop(frame_seq))
+                if payload and payload[0] != PROTO_STATUS_OK:
+                    stats.refused += 1
+                else:
+                    stats.acked += 1
+            elif opcode == PROTO_OP_LED_SET and len(payload) == 1:
+                # Behave like tcp_client.py if the user button is pressed.
+                stats.led_commands += 1
+                acks += encode_frame(PROTO_OP_ACK, frame_seq, bytes([PROTO_STATUS_OK, payload[0]]), options.crc)
+        if acks:
+            writer.write(acks)
+        return frames
+
+    try:
+        # The connection counts once the server acknowledged the HELLO.
+        writer.write(encode_frame(PROTO_OP_HELLO, 0, b'', options.crc))
+        while not hello_acked:
+            await asyncio.wait_for(receive(), options.connect_timeout)
+        stats.connect_latency.append(time.monotonic() - t0)
+        stats.established += 1
+        established = True
+
+        reading = asyncio.ensure_future(receive())
+        next_send = time.monotonic()
+        while time.monotonic() < stop_at:
+            if len(outstanding) < options.window:
+                seq = (seq + 1) & 0xFFFF or 1
+                outstanding[seq] = time.monotonic()
+                writer.write(encode_frame(PROTO_OP_PING, seq, b'', options.crc))
+                stats.sent += 1
+            next_send += 1.0 / options.rate
+            timeout = max(0.0, min(next_send, stop_at) - time.monotonic())
+            while True:
+                done, _ = await asyncio.wait([reading], timeout=timeout)
+                if not done:
+                    break
+                reading.result()
+                reading = asyncio.ensure_future(receive())
+                timeout = max(0.0, min(next_send, stop_at) - time.monotonic())
+
+        # Give the last commands time to be acknowledged.
+        grace_end = time.monotonic() + options.connect_timeout
+        while outstanding and time.monotonic() < grace_end:
+            done, _ = await asyncio.wait([reading], timeout=grace_end - time.monotonic())
+            if not done:
+                break
+            reading.result()
+            reading = asyncio.ensure_future(receive())
+        reading.cancel()
+    except (OSError, asyncio.TimeoutError, ConnectionResetError):
+        if established:
+            stats.dropped += 1
+        else:
+            stats.rejected += 1
+    finally:
+        stats.lost += len(outstanding)
+        writer.close()
+
+async def run(options):
+    stats = Stats()
+    start = time.monotonic()
+    # Connections are opened at options.connect_rate per second.
+    tasks = [connection(options, stats, start + i / options.connect_rate,
+                        start + i / options.connect_rate + options.duration)
+             for i in range(options.connections)]
+    await asyncio.gather(*tasks)
+    elapsed = time.monotonic() - start
+    return stats, elapsed
+
+def summarize(options, stats, elapsed):
+    connect = sorted(stats.connect_latency)
+    ack = sorted(stats.ack_latency)
+    ms = lambda v: round(v * 1000.0, 3)
+    return {
+        'connections': options.connections,
+        'rate_per_connection': options.rate,
+        'window': options.window,
+        'duration_s': options.duration,
+        'elapsed_s': round(elapsed, 3),
+        'attempted': stats.attempted,
+        'established': stats.established,
+        'failed': stats.failed,
+        'rejected': stats.rejected,
+        'dropped': stats.dropped,
+        'commands_sent': stats.sent,
+        'acks_received': stats.acked,
+        'acks_refused': stats.refused,
+        'commands_lost': stats.lost,
+        'led_commands': stats.led_commands,
+        'ack_throughput_per_s': round(stats.acked / elapsed, 1) if elapsed > 0 else 0.0,
+        'connect_ms_p50': ms(percentile(connect, 0.50)),
+        'connect_ms_p90': ms(percentile(connect, 0.90)),
+        'connect_ms_p99': ms(percentile(connect, 0.99)),
+        'connect_ms_max': ms(connect[-1] if connect else 0.0),
+        'ack_ms_p50': ms(percentile(ack, 0.50)),
+        'ack_ms_p99': ms(percentile(ack, 0.99)),
+        'ack_ms_p999': ms(percentile(ack, 0.999)),
+        'ack_ms_max': ms(ack[-1] if ack else 0.0),
+    }
+
+parser = optparse.OptionParser()
+parser.add_option('-a', '--address', dest='ip', default=DEFAULT_IP,
+                  help='IP address of the TCP server [default: %default]')
+parser.add_option('-p', '--port', dest='port', type='int', default=DEFAULT_PORT,
+                  help='port of the TCP server [default: %default]')
+parser.add_option('-c', '--connections', dest='connections', type='int', default=4,
+                  help='number of concurrent connections [default: %default]')
+parser.add_option('--connect-rate', dest='connect_rate', type='float', default=50,
+                  help='connections opened per second [default: %default]')
+parser.add_option('--connect-timeout', dest='connect_timeout', type='float', default=5,
+                  help='connect and acknowledgement timeout in seconds [default: %default]')
+parser.add_option('-r', '--rate', dest='rate', type='float', default=10,
+                  help='commands per second on each connection [default: %default]')
+parser.add_option('-w', '--window', dest='window', type='int', default=8,
+                  help='unacknowledged commands allowed per connection [default: %default]')
+parser.add_option('-d', '--duration', dest='duration', type='float', default=10,
+                  help='test duration of each connection in seconds [default: %default]')
+parser.add_option('--crc', dest='crc', action='store_true', default=False,
+                  help='protect the frames with a CRC')
+parser.add_option('-f', '--format', dest='format', type='choice', choices=['json', 'csv'], default='json',
+                  help='report format: json or csv [default: %default]')
+parser.add_option('-o', '--output', dest='output',
+                  help='append the report to this file instead of printing it')
+
+if __name__ == '__main__':
+    (options, args) = parser.parse_args()
+    stats, elapsed = asyncio.run(run(options))
+    summary = summarize(options, stats, elapsed)
+
+    if options.format == 'json':
+        report = json.dumps(summary, indent=2) + '\n'
+    else:
+        report = ','.join(summary.keys()) + '\n' + ','.join(str(v) for v in summary.values()) + '\n'
+
+    if options.output:
+        with open(options.output, 'a') as f:
+            f.write(report)
+    else:
+        sys.stdout.write(report)
+
+# [] END OF FILE
@@ -0,0 +1,247 @@
+/******************************************************************************
+* File Name:   tcp_proto.c
+*
+* Description: This file contains the encoder and the decoder of the binary
+* command protocol (version 2). Frames carry a sequence number so that many
+* commands can be outstanding on a connection and every acknowledgement can
+* be matched to its command.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Standard C header file */
+#include <string.h>
+
+/* Protocol header file. */
+#include "tcp_proto.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define CRC16_INIT                                (0xFFFFu)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* CRC-16/CCITT (polynomial 0x1021) of every 4-bit value, so that the CRC is
+ * computed a nibble at a time with a 32 byte table.
+ */
+static const uint16_t crc16_nibble_table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*******************************************************************************
+ * Function Name: tcp_proto_crc16
+ *******************************************************************************
+ * Summary:
+ *  Computes the CRC-16/CCITT-FALSE of a block of data.
+ *
+ * Parameters:
+ *  const uint8_t *data: Data
+ *  uint32_t len: Length of the data
+ *
+ * Return:
+ *  uint16_t: CRC of the data
+ *
+ *******************************************************************************/
+uint16_t tcp_proto_crc16(const uint8_t *data, uint32_t len)
+{
+    return tcp_proto_crc16_update(CRC16_INIT, data, len);
+}
+
+/*******************************************************************************
+ * Function Name: tcp_proto_crc16_update
+ *******************************************************************************
+ * Summary:
+ *  Continues a CRC-16/CCITT-FALSE over the next block of data, for data that
+ *  is not contiguous.
+ *
+ * Parameters:
+ *  uint16_t crc: CRC of the data before the block
+ *  const uint8_t *data: Data
+ *  uint32_t len: Length of the data
+ *
+ * Return:
+ *  uint16_t: CRC of the data up to the end of the block
+ *
+ *******************************************************************************/
+uint16_t tcp_proto_crc16_update(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+    while(len-- > 0)
+    {
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (*data >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (*data & 0x0Fu)]);
+        data++;
+    }
+
+    return crc;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_proto_encode
+ *******************************************************************************
+ * Summary:
+ *  Builds a protocol frame.
+ *
+ * Parameters:
+ *  uint8_t *buf: Destination, at least TCP_PROTO_MAX_FRAME_LEN bytes
+ *  uint8_t opcode: Opcode of the frame
+ *  uint16_t seq: Sequence number of the frame
+ *  const void *payload: Payload, may be NULL if 'len' is 0
+ *  uint16_t len: Length of the payload, at most TCP_PROTO_MAX_PAYLOAD_LEN
+ *  bool crc: true to append a CRC to the frame
+ *
+ * Return:
+ *  uint32_t: Length of the frame, 0 if the payload is too long
+ *
+ *******************************************************************************/
+uint32_t tcp_proto_encode(uint8_t *buf, uint8_t opcode, uint16_t seq,
+                          const void *payload, uint16_t len, bool crc)
+{
+    uint32_t frame_len = TCP_PROTO_HEADER_LEN + len;
+    uint16_t frame_crc;
+
+    if(len > TCP_PROTO_MAX_PAYLOAD_LEN)
+    {
+        return 0;
+    }
+
+    tcp_proto_encode_header(buf, opcode, seq, len, crc);
+    if(len > 0)
+    {
+        memcpy(&buf[TCP_PROTO_HEADER_LEN], payload, len);
+    }
+
+    if(crc)
+    {
+        frame_crc = tcp_proto_crc16(buf, frame_len);
+        buf[frame_len++] = (uint8_t)(frame_crc >> 8);
+        buf[frame_len++] = (uint8_t)frame_crc;
+    }
+
+    return frame_len;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_proto_encode_header
+ *******************************************************************************
+ * Summary:
+ *  Builds the header of a frame whose payload is sent from elsewhere. The
+ *  payload length is not limited to TCP_PROTO_MAX_PAYLOAD_LEN.
+ *
+ * Parameters:
+ *  uint8_t *buf: Destination, TCP_PROTO_HEADER_LEN bytes
+ *  uint8_t opcode: Opcode of the frame
+ *  uint16_t seq: Sequence number of the frame
+ *  uint16_t len: Length of the payload
+ *  bool crc: true if a CRC follows the payload
+ *
+ *******************************************************************************/
+void tcp_proto_encode_header(uint8_t *buf, uint8_t opcode, uint16_t seq, uint16_t len, bool crc)
+{
+    buf[0] = TCP_PROTO_MAGIC;
+    buf[1] = (uint8_t)((TCP_PROTO_VERSION << 4) | (crc ? TCP_PROTO_FLAG_CRC : 0u));
+    buf[2] = opcode;
+    buf[3] = (uint8_t)(seq >> 8);
+    buf[4] = (uint8_t)seq;
+    buf[5] = (uint8_t)(len >> 8);
+    buf[6] = (uint8_t)len;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_proto_decode
+ *******************************************************************************
+ * Summary:
+ *  Decodes the frame at the read position of a receive ring buffer, without
+ *  consuming it: on TCP_PROTO_FRAME_OK and TCP_PROTO_FRAME_BAD_CRC the caller
+ *  skips 'frame_len' bytes, on TCP_PROTO_FRAME_INVALID one byte. The frame is
+ *  read in place; only a frame wrapping around the end of the ring buffer is
+ *  copied to 'buf'. The payload stays valid until more data is written to the
+ *  ring buffer, even once the frame is skipped.
+ *
+ * Parameters:
+ *  const ring_buffer_t *rb: Receive ring buffer
+ *  uint8_t *buf: Frame buffer, at least TCP_PROTO_MAX_FRAME_LEN bytes
+ *  tcp_proto_frame_t *frame: Decoded frame
+ *  uint32_t *frame_len: Length of the frame on the wire
+ *
+ * Return:
+ *  tcp_proto_result_t: Result of the decoding
+ *
+ *******************************************************************************/
+tcp_proto_result_t tcp_proto_decode(const ring_buffer_t *rb, uint8_t *buf,
+                                    tcp_proto_frame_t *frame, uint32_t *frame_len)
+{
+    uint32_t used = ring_buffer_used(rb);
+    const uint8_t *data;
+    uint32_t contiguous;
+    uint32_t len;
+    uint16_t frame_crc;
+
+    frame->copied = 0;
+
+    if(used < TCP_PROTO_HEADER_LEN)
+    {
+        /* Reject a wrong start early instead of waiting for a full header. */
+        if((used > 0) && (ring_buffer_peek_byte(rb, 0) != TCP_PROTO_MAGIC))
+        {
+            return TCP_PROTO_FRAME_INVALID;
+        }
+        return TCP_PROTO_FRAME_INCOMPLETE;
+    }
+
+    contiguous = ring_buffer_read_span(rb, &data);
+    if(contiguous < TCP_PROTO_HEADER_LEN)
+    {
+        frame->copied = (uint16_t)ring_buffer_peek(rb, 0, buf, TCP_PROTO_HEADER_LEN);
+        data = buf;
+    }
+
+    if((data[0] != TCP_PROTO_MAGIC) || ((data[1] >> 4) != TCP_PROTO_VERSION))
+    {
+        return TCP_PROTO_FRAME_INVALID;
+    }
+
+    frame->flags = data[1] & 0x0Fu;
+    frame->opcode = data[2];
+    frame->seq = (uint16_t)((data[3] << 8) | data[4]);
+    frame->len = (uint16_t)((data[5] << 8) | data[6]);
+
+    if(frame->len > TCP_PROTO_MAX_PAYLOAD_LEN)
+    {
+        return TCP_PROTO_FRAME_INVALID;
+    }
+
+    len = TCP_PROTO_HEADER_LEN + frame->len;
+    *frame_len = len + ((frame->flags & TCP_PROTO_FLAG_CRC) ? TCP_PROTO_CRC_LEN : 0u);
+    if(used < *frame_len)
+    {
+        return TCP_PROTO_FRAME_INCOMPLETE;
+    }
+
+    if(contiguous < *frame_len)
+    {
+        frame->copied = (uint16_t)ring_buffer_peek(rb, 0, buf, *frame_len);
+        data = buf;
+    }
+    frame->payload = &data[TCP_PROTO_HEADER_LEN];
+
+    if(frame->flags & TCP_PROTO_FLAG_CRC)
+    {
+        frame_crc = (uint16_t)((data[len] << 8) | data[len + 1]);
+        if(tcp_proto_crc16(data, len) != frame_crc)
+        {
+            return TCP_PROTO_FRAME_BAD_CRC;
+        }
+    }
+
+    return TCP_PROTO_FRAME_OK;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,109 @@
+/******************************************************************************
+* File Name:   tcp_proto.h
+*
+* Description: This file contains declaration of the binary command protocol
+* (version 2) spoken between the TCP server and the TCP clients.
+*
+* Frame layout, multi-byte fields in network byte order:
+*
+*   offset  size  field
+*   0       1     TCP_PROTO_MAGIC
+*   1       1     version (high nibble) | flags (low nibble)
+*   2       1     opcode
+*   3       2     sequence number
+*   5       2     payload length
+*   7       n     payload
+*   7 + n   2     CRC-16/CCITT of bytes 0 to 6 + n, if TCP_PROTO_FLAG_CRC is set
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TCP_PROTO_H_
+#define TCP_PROTO_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Ring buffer header file. */
+#include "ring_buffer.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TCP_PROTO_MAGIC                           (0xA5u)
+#define TCP_PROTO_VERSION                         (2u)
+
+/* Flags of the version/flags byte. */
+#define TCP_PROTO_FLAG_CRC                        (0x01u)
+
+#define TCP_PROTO_HEADER_LEN                      (7u)
+#define TCP_PROTO_CRC_LEN                         (2u)
+
+/* Longest payload of the frames received, and of those built with
+ * tcp_proto_encode(). The INFO answer, sent from a constant buffer, is longer.
+ */
+#define TCP_PROTO_MAX_PAYLOAD_LEN                 (32u)
+#define TCP_PROTO_MAX_FRAME_LEN                   (TCP_PROTO_HEADER_LEN + \
+                                                   TCP_PROTO_MAX_PAYLOAD_LEN + \
+                                                   TCP_PROTO_CRC_LEN)
+
+/* Opcodes. */
+#define TCP_PROTO_OP_HELLO                        (0x01u)   /* Client selects protocol v2. */
+#define TCP_PROTO_OP_ACK                          (0x02u)   /* Answer to the frame with the same sequence number. */
+#define TCP_PROTO_OP_PING                         (0x03u)   /* Client command answered with an ACK, for load tests. */
+#define TCP_PROTO_OP_STATS                        (0x04u)   /* Payload: task index, answered with TASK_STATS. */
+#define TCP_PROTO_OP_TASK_STATS                   (0x05u)   /* Statistics of one task, see tcp_server.c. */
+#define TCP_PROTO_OP_LOG_LEVEL                    (0x06u)   /* Payload: log level, or none to read it; answered with ACK [status, level]. */
+#define TCP_PROTO_OP_INFO                         (0x07u)   /* Answered with INFO: the command table, see tcp_server.c. */
+#define TCP_PROTO_OP_LED_SET                      (0x10u)   /* Payload: LED state, 1 - ON, 0 - OFF. */
+#define TCP_PROTO_OP_BENCH                        (0x20u)   /* Payload: benchmark parameters, see tcp_bench.h. */
+
+/* Status, first payload byte of TCP_PROTO_OP_ACK. */
+#define TCP_PROTO_STATUS_OK                       (0x00u)
+#define TCP_PROTO_STATUS_UNSUPPORTED              (0x01u)
+#define TCP_PROTO_STATUS_BUSY                     (0x02u)
+#define TCP_PROTO_STATUS_INVALID                  (0x03u)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Result of decoding a frame from a receive ring buffer. */
+typedef enum
+{
+    TCP_PROTO_FRAME_OK = 0,         /* A complete, valid frame was decoded. */
+    TCP_PROTO_FRAME_INCOMPLETE,     /* More data is needed. */
+    TCP_PROTO_FRAME_INVALID,        /* Not a frame start; skip one byte to resync. */
+    TCP_PROTO_FRAME_BAD_CRC         /* Frame complete but corrupted; skip it. */
+} tcp_proto_result_t;
+
+/* Decoded frame. The payload points into the receive ring buffer, or into
+ * the buffer given to the decoder if the frame wraps around the end of the
+ * ring buffer.
+ */
+typedef struct
+{
+    uint8_t flags;
+    uint8_t opcode;
+    uint16_t seq;
+    uint16_t len;
+    const uint8_t *payload;
+    uint16_t copied;                /* Bytes copied to the decoder buffer. */
+} tcp_proto_frame_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+uint16_t tcp_proto_crc16(const uint8_t *data, uint32_t len);
+uint16_t tcp_proto_crc16_update(uint16_t crc, const uint8_t *data, uint32_t len);
+uint32_t tcp_proto_encode(uint8_t *buf, uint8_t opcode, uint16_t seq,
+                          const void *payload, uint16_t len, bool crc);
+void tcp_proto_encode_header(uint8_t *buf, uint8_t opcode, uint16_t seq, uint16_t len, bool crc);
+tcp_proto_result_t tcp_proto_decode(const ring_buffer_t *rb, uint8_t *buf,
+                                    tcp_proto_frame_t *frame, uint32_t *frame_len);
+
+#endif /* TCP_PROTO_H_ */
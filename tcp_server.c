@@ -19,6 +19,7 @@
 /* FreeRTOS header file */
 #include <FreeRTOS.h>
 #include <task.h>
+#include <timers.h>
 
 /* Cypress secure socket header file */
 #include "cy_secure_sockets.h"
@@ -33,6 +34,55 @@
 /* TCP server task header file. */
 #include "tcp_server.h"
 
+/* TCP client connection table header file. */
+#include "tcp_conn.h"
+
+/* TCP writer task header file. */
+#include "tcp_writer.h"
+
+/* Command protocol v2 header file. */
+#include "tcp_proto.h"
+
+/* Command latency measurement header files. */
+#include "cmd_latency.h"
+#include "timestamp.h"
+
+/* Interrupt event ring header file. */
+#include "isr_event.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Throughput benchmark header file. */
+#include "tcp_bench.h"
+
+/* Task statistics header file. */
+#include "task_stats.h"
+
+/* Heap usage header file. */
+#include "heap_usage.h"
+
+/* Metrics header file. */
+#include "metrics.h"
+
+/* Timing probe header file. */
+#include "perf_probe.h"
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/* Connection options profile header file. */
+#include "tcp_sockopt.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/* Startup profiler header file. */
+#include "boot_profile.h"
+
+/* Memory budget header file. */
+#include "app_memory_budget.h"
+
 /* IP address related header files (part of the lwIP TCP/IP stack). */
 #include "ip_addr.h"
 
@@ -92,9 +142,24 @@
 
 /* TCP server related macros. */
 #define TCP_SERVER_PORT                           (50007)
+#ifndef TCP_SERVER_MAX_PENDING_CONNECTIONS
 #define TCP_SERVER_MAX_PENDING_CONNECTIONS        (3u)
+#endif
 #define TCP_SERVER_RECV_TIMEOUT_MS                (500u)
-#define MAX_TCP_RECV_BUFFER_SIZE                  (20u)
+
+/* Send timeout of the client sockets. Unsent data stays queued and is
+ * retried.
+ */
+#define TCP_SERVER_SEND_TIMEOUT_MS                (100u)
+
+/* Acknowledgement messages from the TCP client are terminated by this
+ * delimiter. The acknowledgement strings themselves are also accepted as
+ * complete messages, for clients that do not send the delimiter.
+ */
+#define TCP_ACK_MSG_DELIMITER                     '\n'
+#define TCP_ACK_MSG_MAX_LEN                       (20u)
+#define LED_ON_ACK_MSG                            "LED ON ACK"
+#define LED_OFF_ACK_MSG                           "LED OFF ACK"
 
 /* TCP keep alive related macros. */
 #define TCP_KEEP_ALIVE_IDLE_TIME_MS               (10000u)
@@ -108,10 +173,22 @@
 #define LED_ON_CMD                                '1'
 #define LED_OFF_CMD                               '0'
 
+/* Maximum number of interrupt events handled per batch. */
+#define TCP_SERVER_EVENT_BATCH_LEN                (4u)
+
 /* Interrupt priority of the user button. */
 #define USER_BTN_INTR_PRIORITY                    (5)
 
-/* Debounce delay for user button. */
+/* Fixed part of the TASK_STATS payload: index, count, snapshot number,
+ * task number, priority, state (one byte each), CPU share in permille (two
+ * bytes), snapshot interval in milliseconds, free stack in bytes and context
+ * switches (four bytes each). The task name follows.
+ */
+#define TCP_SERVER_TASK_STATS_LEN                 (20u)
+
+/* Debounce delay for user button. The falling edge detection stays disabled
+ * for this long after a press, and until the button is released.
+ */
 #define DEBOUNCE_DELAY_MS                         (50)
 
 /*******************************************************************************
@@ -121,7 +198,26 @@ static cy_rslt_t create_tcp_server_socket(void);
 static cy_rslt_t tcp_connection_handler(cy_socket_t socket_handle, void *arg);
 static cy_rslt_t tcp_receive_msg_handler(cy_socket_t socket_handle, void *arg);
 static cy_rslt_t tcp_disconnection_handler(cy_socket_t socket_handle, void *arg);
+static void process_rx_messages(tcp_conn_t *conn);
+static void process_rx_text_messages(tcp_conn_t *conn);
+static void process_rx_frames(tcp_conn_t *conn);
+static void handle_ack_message(tcp_conn_t *conn, const char *message);
+static void handle_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame);
+static bool send_frame(tcp_conn_t *conn, uint8_t opcode, uint16_t seq,
+                       const void *payload, uint16_t len, bool pending);
+static bool send_static_frame(tcp_conn_t *conn, uint8_t opcode, uint16_t seq,
+                              const void *payload, uint16_t len);
+static void record_cmd_latency(const tcp_conn_t *conn, const tcp_conn_pending_t *pending);
+#if(TCP_BENCH_ENABLED)
+static void handle_bench_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame);
+#endif /* TCP_BENCH_ENABLED */
+static void handle_stats_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame);
+static cy_rslt_t register_client_callbacks(tcp_conn_t *conn);
+static void send_led_cmd_to_client(tcp_conn_t *conn, void *arg);
+static void send_queue_watermark_handler(tcp_conn_t *conn, bool throttled);
+static void handle_button_press(const isr_event_t *event, uint32_t wakeup_time);
 static void isr_button_press( void *callback_arg, cyhal_gpio_event_t event);
+static void debounce_timer_callback(TimerHandle_t timer);
 
 #if(USE_AP_INTERFACE)
     static cy_rslt_t softap_start(void);
@@ -133,11 +229,8 @@ static void isr_button_press( void *callback_arg, cyhal_gpio_event_t event);
 * Global Variables
 ********************************************************************************/
 /* Secure socket variables. */
-cy_socket_sockaddr_t tcp_server_addr, peer_addr;
-cy_socket_t server_handle, client_handle;
-
-/* Size of the peer socket address. */
-uint32_t peer_addr_len;
+cy_socket_sockaddr_t tcp_server_addr;
+cy_socket_t server_handle;
 
 /* Flags to track the LED state. */
 bool led_state = CYBSP_LED_STATE_OFF;
@@ -145,8 +238,50 @@ bool led_state = CYBSP_LED_STATE_OFF;
 /* TCP server task handle. */
 extern TaskHandle_t server_task_handle;
 
-/* Flag variable to check if TCP client is connected. */
-bool client_connected;
+/* One-shot timer ending the debounce period of the user button. */
+static TimerHandle_t debounce_timer;
+STATIC_ALLOC_TIMER_DEFINE(debounce_timer);
+
+/* Socket options of the TCP clients. The send timeout keeps a stalled client
+ * from holding up the TCP writer task; commands are single small frames,
+ * which Nagle's algorithm would hold back behind a delayed acknowledgement.
+ */
+static const tcp_sockopt_t client_sockopts[] =
+{
+    { CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_SNDTIMEO, TCP_SERVER_SEND_TIMEOUT_MS, false, "CY_SOCKET_SO_SNDTIMEO" },
+    { CY_SOCKET_SOL_TCP, CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL, TCP_KEEP_ALIVE_INTERVAL_MS, false,
+      "CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL" },
+    { CY_SOCKET_SOL_TCP, CY_SOCKET_SO_TCP_KEEPALIVE_COUNT, TCP_KEEP_ALIVE_RETRY_COUNT, false,
+      "CY_SOCKET_SO_TCP_KEEPALIVE_COUNT" },
+    { CY_SOCKET_SOL_TCP, CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME, TCP_KEEP_ALIVE_IDLE_TIME_MS, false,
+      "CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME" },
+    { CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE, 1u, true, "CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE" },
+    { CY_SOCKET_SOL_TCP, CY_SOCKET_SO_TCP_NODELAY, 1u, true, "CY_SOCKET_SO_TCP_NODELAY" }
+};
+
+static tcp_sockopt_profile_t client_sockopt_profile =
+{
+    .options = client_sockopts,
+    .count = sizeof(client_sockopts) / sizeof(client_sockopts[0])
+};
+
+/* Answer to INFO frames: the commands of protocol v2. It is larger than the
+ * send queue of a client and is sent from here, see send_static_frame().
+ */
+static const char server_info[] =
+    "TCP server, command protocol v2\n"
+    "0x01 HELLO      select protocol v2; replies carry a CRC if the HELLO does\n"
+    "0x02 ACK        [status, ...] answer to the frame with the same sequence number\n"
+    "0x03 PING       answered with ACK [OK]\n"
+    "0x04 STATS      [task index] answered with TASK_STATS, index 0 takes a snapshot\n"
+    "0x05 TASK_STATS statistics of one task\n"
+    "0x06 LOG_LEVEL  [level] sets the log level, or reads it without a payload\n"
+    "0x07 INFO       answered with this table\n"
+    "0x10 LED_SET    [state] sent by the server, acknowledged by the client\n"
+#if(TCP_BENCH_ENABLED)
+    "0x20 BENCH      [mode, block size, duration] runs a throughput benchmark\n"
+#endif /* TCP_BENCH_ENABLED */
+    ;
 
 /*******************************************************************************
  * Function Name: tcp_server_task
@@ -173,11 +308,33 @@ void tcp_server_task(void *arg)
 
     cy_wcm_config_t wifi_config = { .interface = WIFI_INTERFACE_TYPE };
 
-    /* Variable to store number of bytes sent over TCP socket. */
-    uint32_t bytes_sent = 0;
+    /* Events received from the user button ISR. */
+    isr_event_t events[TCP_SERVER_EVENT_BATCH_LEN];
+    uint32_t event_count;
+    uint32_t wakeup_time;
+    uint32_t events_lost = 0;
+#if(TASK_STATS_REPORT_INTERVAL_MS > 0)
+    TickType_t next_report;
+    TickType_t now;
+#endif /* TASK_STATS_REPORT_INTERVAL_MS > 0 */
 
-    /* Variable to receive LED ON/OFF command from the user button ISR. */
-    uint32_t led_state_cmd = LED_OFF_CMD;
+    boot_profile_mark(BOOT_STAGE_SCHEDULER);
+
+    /* Start the timestamp counter and the event ring before the first
+     * button interrupt.
+     */
+    cmd_latency_init();
+    isr_event_init(server_task_handle);
+    task_stats_init();
+
+    /* Create the debounce timer of the user button. */
+    debounce_timer = STATIC_ALLOC_TIMER_CREATE(debounce_timer, "Debounce", pdMS_TO_TICKS(DEBOUNCE_DELAY_MS), pdFALSE,
+                                               NULL, debounce_timer_callback);
+    if (debounce_timer == NULL)
+    {
+        printf("Failed to create the debounce timer!\n");
+        CY_ASSERT(0);
+    }
 
     /* Initialize the user button (CYBSP_SW1) and register interrupt on falling edge. */
     cyhal_gpio_init(CYBSP_SW1, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_PULLUP, CYBSP_BTN_OFF);
@@ -192,7 +349,9 @@ void tcp_server_task(void *arg)
         printf("Wi-Fi Connection Manager initialization failed! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
         CY_ASSERT(0);
     }
+    boot_profile_mark(BOOT_STAGE_WCM_INIT);
     printf("Wi-Fi Connection Manager initialized.\r\n");
+    print_heap_usage("After cy_wcm_init");
 
     #if(USE_AP_INTERFACE)
 
@@ -212,6 +371,8 @@ void tcp_server_task(void *arg)
             CY_ASSERT(0);
         }
     #endif /* USE_AP_INTERFACE */
+    boot_profile_mark(BOOT_STAGE_WIFI);
+    print_heap_usage("After Wi-Fi connect");
 
     /* Initialize secure socket library. */
     result = cy_socket_init();
@@ -220,7 +381,31 @@ void tcp_server_task(void *arg)
         printf("Secure Socket initialization failed! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
         CY_ASSERT(0);
     }
+    boot_profile_mark(BOOT_STAGE_SOCKET_INIT);
     printf("Secure Socket initialized\n");
+    print_heap_usage("After cy_socket_init");
+    app_memory_budget_print();
+
+    /* Clear the table of connected TCP clients. */
+    tcp_conn_table_init();
+    tcp_conn_set_watermark_callback(send_queue_watermark_handler);
+
+    /* Start the task sending the queued messages to the TCP clients. */
+    result = tcp_writer_start();
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to start the TCP writer! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        CY_ASSERT(0);
+    }
+
+#if(TCP_BENCH_ENABLED)
+    result = tcp_bench_init();
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to initialize the benchmark! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        CY_ASSERT(0);
+    }
+#endif /* TCP_BENCH_ENABLED */
 
     /* Create TCP server socket. */
     result = create_tcp_server_socket();
@@ -229,6 +414,7 @@ void tcp_server_task(void *arg)
         printf("Failed to create socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
         CY_ASSERT(0);
     }
+    boot_profile_mark(BOOT_STAGE_SOCKET_CREATE);
 
     /* Start listening on the TCP server socket. */
     result = cy_socket_listen(server_handle, TCP_SERVER_MAX_PENDING_CONNECTIONS);
@@ -244,60 +430,127 @@ void tcp_server_task(void *arg)
         printf("Listening for incoming TCP client connection on Port: %d\n",
                 tcp_server_addr.port);
     }
+    boot_profile_ready();
 
-    while(true)
+#if(METRICS_ENABLED)
+    /* Serve the metrics on a second port of the same address. */
+    result = metrics_start(&tcp_server_addr);
+    if (result != CY_RSLT_SUCCESS)
     {
-        /* Wait till user button is pressed to send LED ON/OFF command to TCP client. */
-        xTaskNotifyWait(0, 0, &led_state_cmd, portMAX_DELAY);
+        printf("Failed to start the metrics endpoint! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        CY_ASSERT(0);
+    }
+#endif /* METRICS_ENABLED */
 
-        /* Disable the GPIO signal falling edge detection until the command is
-         * sent to the TCP client.
-         */
-        cyhal_gpio_enable_event(CYBSP_SW1, CYHAL_GPIO_IRQ_FALL, USER_BTN_INTR_PRIORITY, false);
+#if(TRACE_ENABLED)
+    /* Stream the trace on a third port of the same address. */
+    result = trace_start(&tcp_server_addr);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to start the trace recorder! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        CY_ASSERT(0);
+    }
+#endif /* TRACE_ENABLED */
 
-        /* Wait till the debounce period of the user button. */
-        vTaskDelay(DEBOUNCE_DELAY_MS/portTICK_PERIOD_MS);
+    /* Startup is over: count the heap allocations from here on. */
+    heap_guard_arm();
 
-        if(!cyhal_gpio_read(CYBSP_SW1))
+#if(TASK_STATS_REPORT_INTERVAL_MS > 0)
+    next_report = xTaskGetTickCount() + pdMS_TO_TICKS(TASK_STATS_REPORT_INTERVAL_MS);
+#endif /* TASK_STATS_REPORT_INTERVAL_MS > 0 */
+
+    while(true)
+    {
+#if(TASK_STATS_REPORT_INTERVAL_MS > 0)
+        /* Wait till user button is pressed or the task statistics are due. */
+        now = xTaskGetTickCount();
+        if((int32_t)(next_report - now) <= 0)
         {
-            /* Send LED ON/OFF command to TCP client if there is an active
-             * TCP client connection.
-             */
-            if(client_connected)
+            task_stats_print();
+            next_report += pdMS_TO_TICKS(TASK_STATS_REPORT_INTERVAL_MS);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, next_report - now);
+#else
+        /* Wait till user button is pressed to send LED ON/OFF command to TCP client. */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif /* TASK_STATS_REPORT_INTERVAL_MS > 0 */
+        wakeup_time = timestamp_now();
+
+        /* One wakeup drains all the events posted until the ring is empty. */
+        while((event_count = isr_event_read(events, TCP_SERVER_EVENT_BATCH_LEN)) > 0)
+        {
+            for(uint32_t i = 0; i < event_count; i++)
             {
-                /* Send the command to TCP client. */
-                result = cy_socket_send(client_handle, &led_state_cmd, TCP_LED_CMD_LEN,
-                               CY_SOCKET_FLAGS_NONE, &bytes_sent);
-                if(result == CY_RSLT_SUCCESS )
+                if(events[i].type == ISR_EVENT_BUTTON_PRESS)
                 {
-                    if(led_state_cmd == LED_ON_CMD)
-                    {
-                        printf("LED ON command sent to TCP client\n");
-                    }
-                    else
-                    {
-                        printf("LED OFF command sent to TCP client\n");
-                    }
-                }
-                else
-                {
-                    printf("Failed to send command to client. Error code: 0x%08"PRIx32"\n", (uint32_t)result);
-                    if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED)
-                    {
-                        /* Disconnect the socket. */
-                        cy_socket_disconnect(client_handle, 0);
-                        /* Delete the socket. */
-                        cy_socket_delete(client_handle);
-                    }
+                    handle_button_press(&events[i], wakeup_time);
                 }
             }
         }
 
-        /* Enable the GPIO signal falling edge detection. */
-        cyhal_gpio_enable_event(CYBSP_SW1, CYHAL_GPIO_IRQ_FALL, USER_BTN_INTR_PRIORITY, true);
+        if(isr_event_overflow_count() != events_lost)
+        {
+            events_lost = isr_event_overflow_count();
+            APP_LOG_WARNING("User button events lost on a full event ring: %"PRIuPTR, events_lost);
+        }
     }
  }
 
+/*******************************************************************************
+ * Function Name: handle_button_press
+ *******************************************************************************
+ * Summary:
+ *  Sends the LED ON/OFF command of a user button press to every connected TCP
+ *  client, unless the press is a bounce of the previous one.
+ *
+ * Parameters:
+ *  const isr_event_t *event: Button press event, carrying the LED ON/OFF
+ *  command chosen by the ISR
+ *  uint32_t wakeup_time: Time the TCP server task woke up for the event
+ *
+ *******************************************************************************/
+static void handle_button_press(const isr_event_t *event, uint32_t wakeup_time)
+{
+    TRACE_SPAN_SCOPE(TRACE_SPAN_BUTTON_PRESS);
+
+    /* LED command sent to the TCP clients, with its timestamps. */
+    tcp_conn_pending_t led_cmd =
+    {
+        .opcode = TCP_PROTO_OP_LED_SET,
+        .value  = (event->data == LED_ON_CMD) ? 1u : 0u,
+        .t_isr  = event->timestamp,
+        .t_task = wakeup_time
+    };
+
+    /* Edges posted before the detection was disabled are bounces of the
+     * press being debounced.
+     */
+    if(xTimerIsTimerActive(debounce_timer) != pdFALSE)
+    {
+        return;
+    }
+
+    /* Disable the GPIO signal falling edge detection for the debounce
+     * period. The debounce timer enables it again, so this task does not
+     * wait for the button.
+     */
+    cyhal_gpio_enable_event(CYBSP_SW1, CYHAL_GPIO_IRQ_FALL, USER_BTN_INTR_PRIORITY, false);
+    xTimerStart(debounce_timer, 0);
+
+    /* The command goes out on the first edge, unless the button is already
+     * released again, i.e. the edge was a glitch.
+     */
+    if(!cyhal_gpio_read(CYBSP_SW1))
+    {
+        /* Only the presses sent out count in the ISR to task stage. */
+        cmd_latency_record(CMD_LATENCY_ISR_TO_TASK, led_cmd.t_isr, led_cmd.t_task);
+
+        /* Queue the LED ON/OFF command for every connected TCP client. */
+        tcp_conn_for_each(send_led_cmd_to_client, &led_cmd);
+    }
+}
+
 #if(!USE_AP_INTERFACE)
 /*******************************************************************************
  * Function Name: connect_to_wifi_ap()
@@ -349,7 +602,8 @@ static cy_rslt_t connect_to_wifi_ap(void)
     /* Join the Wi-Fi AP. */
     for(conn_retries = 0; conn_retries < MAX_WIFI_CONN_RETRIES; conn_retries++ )
     {
-        result = cy_wcm_connect_ap(&wifi_conn_param, &ip_address);
+        PERF_PROBE(PERF_PROBE_WCM_CONNECT_AP,
+                   result = cy_wcm_connect_ap(&wifi_conn_param, &ip_address));
 
         if(result == CY_RSLT_SUCCESS)
         {
@@ -467,6 +721,15 @@ static cy_rslt_t create_tcp_server_socket(void)
         return result;
     }
 
+    /* Set the options of the TCP clients on the server socket, for the stacks
+     * whose accepted sockets inherit them.
+     */
+    result = tcp_sockopt_listen(&client_sockopt_profile, server_handle);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
     /* Register the callback function to handle connection request from a TCP client. */
     tcp_connection_option.callback = tcp_connection_handler;
     tcp_connection_option.arg = NULL;
@@ -520,7 +783,9 @@ static cy_rslt_t create_tcp_server_socket(void)
  * Function Name: tcp_connection_handler
  *******************************************************************************
  * Summary:
- *  Callback function to handle incoming TCP client connection.
+ *  Callback function to handle incoming TCP client connection. The accepted
+ *  client is added to the connection table; the connection is closed if the
+ *  table is full.
  *
  * Parameters:
  * cy_socket_t socket_handle: Connection handle for the TCP server socket
@@ -532,75 +797,73 @@ static cy_rslt_t create_tcp_server_socket(void)
  *******************************************************************************/
 static cy_rslt_t tcp_connection_handler(cy_socket_t socket_handle, void *arg)
 {
+    TRACE_SPAN_SCOPE(TRACE_SPAN_ACCEPT_CB);
+    PERF_PROBE_SCOPE(PERF_PROBE_CONNECTION_HANDLER);
+
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    /* TCP keep alive parameters. */
-    int keep_alive = 1;
-    uint32_t keep_alive_interval = TCP_KEEP_ALIVE_INTERVAL_MS;
-    uint32_t keep_alive_count    = TCP_KEEP_ALIVE_RETRY_COUNT;
-    uint32_t keep_alive_idle_time = TCP_KEEP_ALIVE_IDLE_TIME_MS;
+    /* Socket and address of the accepted TCP client. */
+    cy_socket_t client_handle;
+    cy_socket_sockaddr_t peer_addr;
+    uint32_t peer_addr_len = sizeof(peer_addr);
+
+    /* Connection table entry of the accepted TCP client. */
+    tcp_conn_t *conn;
 
     /* Accept new incoming connection from a TCP client.*/
-    result = cy_socket_accept(socket_handle, &peer_addr, &peer_addr_len,
-                              &client_handle);
-    if(result == CY_RSLT_SUCCESS)
+    PERF_PROBE(PERF_PROBE_ACCEPT,
+               result = cy_socket_accept(socket_handle, &peer_addr, &peer_addr_len,
+                                         &client_handle));
+    if(result != CY_RSLT_SUCCESS)
     {
-        printf("Incoming TCP connection accepted\n");
-        printf("IP Address : %s\n\n",
-                ip4addr_ntoa((const ip4_addr_t *)&peer_addr.ip_address.ip.v4));
-        printf("Press the user button to send LED ON/OFF command to the TCP client\n");
-
-        /* Set the TCP keep alive interval. */
-        result = cy_socket_setsockopt(client_handle, CY_SOCKET_SOL_TCP,
-                                      CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL,
-                                      &keep_alive_interval, sizeof(keep_alive_interval));
-        if(result != CY_RSLT_SUCCESS)
-        {
-            printf("Set socket option: CY_SOCKET_SO_TCP_KEEPALIVE_INTERVAL failed\n");
-            return result;
-        }
+        APP_LOG_ERROR("Failed to accept incoming client connection. Error code: 0x%08"PRIxPTR,
+                      (uint32_t)result);
+        METRICS_ERROR(METRICS_OP_ACCEPT, result);
+        return result;
+    }
 
-        /* Set the retry count for TCP keep alive packet. */
-        result = cy_socket_setsockopt(client_handle, CY_SOCKET_SOL_TCP,
-                                      CY_SOCKET_SO_TCP_KEEPALIVE_COUNT,
-                                      &keep_alive_count, sizeof(keep_alive_count));
-        if(result != CY_RSLT_SUCCESS)
-        {
-            printf("Set socket option: CY_SOCKET_SO_TCP_KEEPALIVE_COUNT failed\n");
-            return result;
-        }
+    /* Add the TCP client to the connection table. */
+    conn = tcp_conn_alloc(client_handle, &peer_addr);
+    if(conn == NULL)
+    {
+        APP_LOG_WARNING("Rejected TCP connection from "APP_LOG_IPV4_FMT": %"PRIuPTR" clients already connected",
+                        APP_LOG_IPV4(peer_addr.ip_address.ip.v4), (unsigned int)TCP_CONN_MAX_CLIENTS);
+        METRICS_INC(METRICS_REJECTS);
+        cy_socket_disconnect(client_handle, 0);
+        cy_socket_delete(client_handle);
+        return CY_RSLT_SUCCESS;
+    }
 
-        /* Set the network idle time before sending the TCP keep alive packet. */
-        result = cy_socket_setsockopt(client_handle, CY_SOCKET_SOL_TCP,
-                                      CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME,
-                                      &keep_alive_idle_time, sizeof(keep_alive_idle_time));
-        if(result != CY_RSLT_SUCCESS)
-        {
-            printf("Set socket option: CY_SOCKET_SO_TCP_KEEPALIVE_IDLE_TIME failed\n");
-            return result;
-        }
+    METRICS_INC(METRICS_ACCEPTS);
 
-        /* Enable TCP keep alive. */
-        result = cy_socket_setsockopt(client_handle, CY_SOCKET_SOL_SOCKET,
-                                          CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE,
-                                              &keep_alive, sizeof(keep_alive));
-        if(result != CY_RSLT_SUCCESS)
-        {
-            printf("Set socket option: CY_SOCKET_SO_TCP_KEEPALIVE_ENABLE failed\n");
-            return result;
-        }
+    APP_LOG_INFO("Incoming TCP connection accepted from "APP_LOG_IPV4_FMT", connected TCP clients: %"PRIuPTR,
+                 APP_LOG_IPV4(peer_addr.ip_address.ip.v4), tcp_conn_count());
 
-        /* Set the client connection flag as true. */
-        client_connected = true;
+    /* Set the options of the connection options profile that the socket did
+     * not inherit from the server socket.
+     */
+    PERF_PROBE(PERF_PROBE_SOCKET_OPTIONS,
+               result = tcp_sockopt_accept(&client_sockopt_profile, client_handle));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        tcp_conn_close(conn);
+        return result;
     }
-    else
+
+    /* Let the receive and disconnection handlers of this client find the
+     * connection table entry directly.
+     */
+    result = register_client_callbacks(conn);
+    if(result != CY_RSLT_SUCCESS)
     {
-        printf("Failed to accept incoming client connection. Error code: 0x%08"PRIx32"\n", (uint32_t)result);
-        printf("===============================================================\n");
-        printf("Listening for incoming TCP client connection on Port: %d\n",
-                tcp_server_addr.port);
+        tcp_conn_close(conn);
     }
 
+    /* Compared with the previous accept, shows the heap growing under
+     * connection churn.
+     */
+    heap_profile_phase("TCP client accepted");
+
     return result;
 }
 
@@ -608,11 +871,14 @@ static cy_rslt_t tcp_connection_handler(cy_socket_t socket_handle, void *arg)
  * Function Name: tcp_receive_msg_handler
  *******************************************************************************
  * Summary:
- *  Callback function to handle incoming TCP client messages.
+ *  Callback function to handle incoming TCP client messages. All the bytes
+ *  pending on the socket are read into the receive ring buffer of the client
+ *  and every complete acknowledgement message is processed, so messages split
+ *  over several TCP segments or sent back-to-back are handled correctly.
  *
  * Parameters:
  * cy_socket_t socket_handle: Connection handle for the TCP client socket
- *  void *args : Parameter passed on to the function (unused)
+ *  void *args : Connection table entry of the TCP client
  *
  * Return:
  *  cy_result result: Result of the operation
@@ -620,85 +886,835 @@ static cy_rslt_t tcp_connection_handler(cy_socket_t socket_handle, void *arg)
  *******************************************************************************/
 static cy_rslt_t tcp_receive_msg_handler(cy_socket_t socket_handle, void *arg)
 {
-    char message_buffer[MAX_TCP_RECV_BUFFER_SIZE] = {0};
+    TRACE_SPAN_SCOPE(TRACE_SPAN_RECV_CB);
+    PERF_PROBE_SCOPE(PERF_PROBE_RECEIVE_HANDLER);
+
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    tcp_conn_t *conn = tcp_conn_find(socket_handle, arg);
+
+    /* Free region of the receive ring buffer. */
+    uint8_t *span;
+    uint32_t span_len;
 
-    /* Variable to store number of bytes received from TCP client. */
+    /* Variables to store number of bytes received and still pending. */
     uint32_t bytes_received = 0;
-    result = cy_socket_recv(socket_handle, message_buffer, MAX_TCP_RECV_BUFFER_SIZE,
-                            CY_SOCKET_FLAGS_NONE, &bytes_received);
+    uint32_t bytes_available = 0;
+    uint32_t optlen = sizeof(bytes_available);
 
-    if(result == CY_RSLT_SUCCESS)
+    /* Data of a connection being closed is left to the socket teardown. */
+    if((conn == NULL) || (conn->state != TCP_CONN_STATE_CONNECTED))
     {
-        /* Terminate the received string with '\0'. */
-        message_buffer[bytes_received] = '\0';
-        printf("\r\nAcknowledgement from TCP Client: %s\n", message_buffer);
+        return CY_RSLT_SUCCESS;
+    }
 
-        /* Set the LED state based on the acknowledgement received from the TCP client. */
-        if(strcmp(message_buffer, "LED ON ACK") == 0)
+#if(TCP_BENCH_ENABLED)
+    if(conn->protocol == TCP_CONN_PROTOCOL_BENCH)
+    {
+        return tcp_bench_receive(conn);
+    }
+#endif /* TCP_BENCH_ENABLED */
+
+    /* Drain the socket, framing messages each time the ring buffer is filled. */
+    do
+    {
+        span_len = ring_buffer_write_span(&conn->rx_ring, &span);
+        PERF_PROBE(PERF_PROBE_RECV,
+                   result = cy_socket_recv(socket_handle, span, span_len,
+                                           CY_SOCKET_FLAGS_NONE, &bytes_received));
+        if(result != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+
+        ring_buffer_commit(&conn->rx_ring, bytes_received);
+        conn->bytes_received += bytes_received;
+        METRICS_ADD(METRICS_RX_BYTES, bytes_received);
+        conn->rx_timestamp = timestamp_now();
+
+        process_rx_messages(conn);
+
+        result = cy_socket_getsockopt(socket_handle, CY_SOCKET_SOL_SOCKET,
+                                      CY_SOCKET_SO_BYTES_AVAILABLE,
+                                      &bytes_available, &optlen);
+    } while((result == CY_RSLT_SUCCESS) && (bytes_available > 0));
+
+    /* The socket has no more data to read. */
+    if(result == CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT)
+    {
+        result = CY_RSLT_SUCCESS;
+    }
+
+    if(result != CY_RSLT_SUCCESS)
+    {
+        APP_LOG_ERROR("Failed to receive acknowledgement from the TCP client. Error: 0x%08"PRIxPTR,
+                      (uint32_t)result);
+        METRICS_ERROR(METRICS_OP_RECV, result);
+        if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED)
         {
-            led_state = CYBSP_LED_STATE_ON;
+            /* Let the TCP writer disconnect and delete the socket. */
+            tcp_conn_close(conn);
+        }
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: process_rx_messages
+ *******************************************************************************
+ * Summary:
+ *  Processes the data in the receive ring buffer of a TCP client according to
+ *  the protocol of the client. Clients start in protocol v1; a client selects
+ *  protocol v2 by sending a frame, whose first byte cannot start a v1 message.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+static void process_rx_messages(tcp_conn_t *conn)
+{
+    if((conn->protocol == TCP_CONN_PROTOCOL_V1) &&
+       (ring_buffer_used(&conn->rx_ring) > 0) &&
+       (ring_buffer_peek_byte(&conn->rx_ring, 0) == TCP_PROTO_MAGIC))
+    {
+        conn->protocol = TCP_CONN_PROTOCOL_V2;
+    }
+
+    if(conn->protocol == TCP_CONN_PROTOCOL_V2)
+    {
+        process_rx_frames(conn);
+    }
+    else
+    {
+        process_rx_text_messages(conn);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: process_rx_text_messages
+ *******************************************************************************
+ * Summary:
+ *  Extracts the complete protocol v1 acknowledgement messages from the
+ *  receive ring buffer of a TCP client. A message ends at TCP_ACK_MSG_DELIMITER; a known
+ *  acknowledgement string at the start of the buffer is also taken as a
+ *  complete message. Incomplete messages stay in the ring buffer until more
+ *  data arrives. Data that cannot be a message is discarded.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+static void process_rx_text_messages(tcp_conn_t *conn)
+{
+    char message[TCP_ACK_MSG_MAX_LEN + 1];
+    uint32_t used;
+    uint32_t len;
+    uint32_t copied = 0;
+
+    while((used = ring_buffer_used(&conn->rx_ring)) > 0)
+    {
+        /* Look for the delimiter within the longest allowed message. */
+        for(len = 0; (len < used) && (len <= TCP_ACK_MSG_MAX_LEN); len++)
+        {
+            if(ring_buffer_peek_byte(&conn->rx_ring, len) == TCP_ACK_MSG_DELIMITER)
+            {
+                break;
+            }
+        }
+
+        if((len < used) && (len <= TCP_ACK_MSG_MAX_LEN))
+        {
+            /* Delimited message; a trailing '\r' is dropped. */
+            ring_buffer_read(&conn->rx_ring, message, len);
+            copied += len;
+            ring_buffer_skip(&conn->rx_ring, 1);
+            if((len > 0) && (message[len - 1] == '\r'))
+            {
+                len--;
+            }
         }
         else
         {
-            led_state = CYBSP_LED_STATE_OFF;
+            len = ring_buffer_peek(&conn->rx_ring, 0, message, TCP_ACK_MSG_MAX_LEN);
+            copied += len;
+
+            if((len >= sizeof(LED_ON_ACK_MSG) - 1) &&
+               (memcmp(message, LED_ON_ACK_MSG, sizeof(LED_ON_ACK_MSG) - 1) == 0))
+            {
+                len = sizeof(LED_ON_ACK_MSG) - 1;
+            }
+            else if((len >= sizeof(LED_OFF_ACK_MSG) - 1) &&
+                    (memcmp(message, LED_OFF_ACK_MSG, sizeof(LED_OFF_ACK_MSG) - 1) == 0))
+            {
+                len = sizeof(LED_OFF_ACK_MSG) - 1;
+            }
+            else if(used > TCP_ACK_MSG_MAX_LEN)
+            {
+                /* No delimiter where one is due: drop the data and resync. */
+                ring_buffer_skip(&conn->rx_ring, used);
+                conn->rx_frame_errors++;
+                continue;
+            }
+            else
+            {
+                /* Wait for the rest of the message. */
+                break;
+            }
+
+            ring_buffer_skip(&conn->rx_ring, len);
+        }
+
+        /* Empty lines are ignored. */
+        if(len > 0)
+        {
+            message[len] = '\0';
+            handle_ack_message(conn, message);
         }
     }
+
+    if(copied > 0)
+    {
+        METRICS_ADD(METRICS_RX_COPIED_BYTES, copied);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: handle_ack_message
+ *******************************************************************************
+ * Summary:
+ *  Updates the LED state from an acknowledgement message of a TCP client.
+ *  Protocol v1 acknowledgements arrive in command order, so the message
+ *  completes the oldest outstanding command.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const char *message: Acknowledgement message, without the delimiter
+ *
+ *******************************************************************************/
+static void handle_ack_message(tcp_conn_t *conn, const char *message)
+{
+    tcp_conn_pending_t pending;
+
+    conn->acks_received++;
+    conn->proto_state = TCP_CONN_PROTO_IDLE;
+
+    if(tcp_conn_pending_complete(conn, conn->rx_seq++, &pending))
+    {
+        record_cmd_latency(conn, &pending);
+    }
+
+    /* Set the LED state based on the acknowledgement received from the TCP client. */
+    if(strcmp(message, LED_ON_ACK_MSG) == 0)
+    {
+        led_state = CYBSP_LED_STATE_ON;
+    }
     else
     {
-        printf("Failed to receive acknowledgement from the TCP client. Error: 0x%08"PRIx32"\n",
-              (uint32_t)result);
-        if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED)
+        led_state = CYBSP_LED_STATE_OFF;
+    }
+
+    /* The message lives on the stack: log the matching constant instead. */
+    APP_LOG_INFO("Acknowledgement from TCP client "APP_LOG_IPV4_FMT": %s",
+                 APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4),
+                 APP_LOG_STR((led_state == CYBSP_LED_STATE_ON) ? LED_ON_ACK_MSG : LED_OFF_ACK_MSG));
+}
+
+/*******************************************************************************
+ * Function Name: record_cmd_latency
+ *******************************************************************************
+ * Summary:
+ *  Records the latencies of an acknowledged command. The send stages are only
+ *  recorded if the TCP writer task time stamped the command before the
+ *  acknowledgement was processed.
+ *
+ * Parameters:
+ *  const tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const tcp_conn_pending_t *pending: Acknowledged command
+ *
+ *******************************************************************************/
+static void record_cmd_latency(const tcp_conn_t *conn, const tcp_conn_pending_t *pending)
+{
+    cmd_latency_record(CMD_LATENCY_ISR_TO_ACK, pending->t_isr, conn->rx_timestamp);
+
+    if(pending->sent)
+    {
+        cmd_latency_record(CMD_LATENCY_TASK_TO_SENT, pending->t_task, pending->t_sent);
+        cmd_latency_record(CMD_LATENCY_SENT_TO_ACK, pending->t_sent, conn->rx_timestamp);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: process_rx_frames
+ *******************************************************************************
+ * Summary:
+ *  Decodes and handles the complete protocol v2 frames in the receive ring
+ *  buffer of a TCP client. Bytes that cannot start a frame are skipped one at
+ *  a time until the next frame start, and frames with a wrong CRC are
+ *  dropped; both count as frame errors.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+static void process_rx_frames(tcp_conn_t *conn)
+{
+    uint8_t frame_buf[TCP_PROTO_MAX_FRAME_LEN];
+    tcp_proto_frame_t frame;
+    uint32_t frame_len;
+    tcp_proto_result_t result;
+
+    while(true)
+    {
+        result = tcp_proto_decode(&conn->rx_ring, frame_buf, &frame, &frame_len);
+        if(frame.copied > 0)
         {
-            /* Disconnect the socket. */
-            cy_socket_disconnect(socket_handle, 0);
-            /* Delete the socket. */
-            cy_socket_delete(socket_handle);
+            METRICS_ADD(METRICS_RX_COPIED_BYTES, frame.copied);
+        }
+
+        switch(result)
+        {
+            case TCP_PROTO_FRAME_OK:
+                /* The payload stays in place until the next receive, so the
+                 * frame is consumed first.
+                 */
+                ring_buffer_skip(&conn->rx_ring, frame_len);
+                handle_frame(conn, &frame);
+
+                /* The frame started a benchmark: no more frames follow. */
+                if(conn->protocol != TCP_CONN_PROTOCOL_V2)
+                {
+                    return;
+                }
+                break;
+
+            case TCP_PROTO_FRAME_BAD_CRC:
+                ring_buffer_skip(&conn->rx_ring, frame_len);
+                conn->rx_frame_errors++;
+                break;
+
+            case TCP_PROTO_FRAME_INVALID:
+                ring_buffer_skip(&conn->rx_ring, 1);
+                conn->rx_frame_errors++;
+                break;
+
+            default:
+                /* Wait for the rest of the frame. */
+                return;
         }
     }
+}
 
-    printf("===============================================================\n");
-    printf("Press the user button to send LED ON/OFF command to the TCP client\n");
+/*******************************************************************************
+ * Function Name: handle_frame
+ *******************************************************************************
+ * Summary:
+ *  Handles a protocol v2 frame received from a TCP client. Acknowledgements
+ *  are matched to the pending command with the same sequence number, so any
+ *  number of commands up to TCP_CONN_MAX_INFLIGHT may be outstanding and the
+ *  client may acknowledge them in any order.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const tcp_proto_frame_t *frame: Decoded frame
+ *
+ *******************************************************************************/
+static void handle_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame)
+{
+    uint8_t reply[2];
+    tcp_conn_pending_t pending;
 
-    return result;
+    switch(frame->opcode)
+    {
+        case TCP_PROTO_OP_HELLO:
+            /* Replies use CRCs if the client's HELLO did. */
+            conn->crc_enabled = ((frame->flags & TCP_PROTO_FLAG_CRC) != 0);
+            reply[0] = TCP_PROTO_STATUS_OK;
+            reply[1] = TCP_PROTO_VERSION;
+            send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, sizeof(reply), false);
+
+            APP_LOG_INFO("TCP client "APP_LOG_IPV4_FMT" selected protocol v2%s",
+                         APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4), APP_LOG_STR(conn->crc_enabled ? " with CRC" : ""));
+            break;
+
+        case TCP_PROTO_OP_ACK:
+            if(!tcp_conn_pending_complete(conn, frame->seq, &pending))
+            {
+                conn->acks_unmatched++;
+                break;
+            }
+
+            conn->acks_received++;
+            record_cmd_latency(conn, &pending);
+
+            if((frame->len > 0) && (frame->payload[0] != TCP_PROTO_STATUS_OK))
+            {
+                APP_LOG_WARNING("TCP client "APP_LOG_IPV4_FMT" refused command %"PRIuPTR": status %"PRIuPTR,
+                                APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4), (unsigned int)frame->seq,
+                                (unsigned int)frame->payload[0]);
+            }
+            else if(pending.opcode == TCP_PROTO_OP_LED_SET)
+            {
+                APP_LOG_INFO("Acknowledgement from TCP client "APP_LOG_IPV4_FMT": LED %s (command %"PRIuPTR")",
+                             APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4), APP_LOG_STR(pending.value ? "ON" : "OFF"),
+                             (unsigned int)frame->seq);
+
+                /* Set the LED state based on the acknowledged command. */
+                led_state = pending.value ? CYBSP_LED_STATE_ON : CYBSP_LED_STATE_OFF;
+            }
+            break;
+
+        case TCP_PROTO_OP_PING:
+            reply[0] = TCP_PROTO_STATUS_OK;
+            send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, 1, false);
+            break;
+
+        case TCP_PROTO_OP_STATS:
+            handle_stats_frame(conn, frame);
+            break;
+
+        case TCP_PROTO_OP_INFO:
+            if(!send_static_frame(conn, TCP_PROTO_OP_INFO, frame->seq, server_info, sizeof(server_info) - 1u))
+            {
+                reply[0] = TCP_PROTO_STATUS_BUSY;
+                send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, 1, false);
+            }
+            break;
+
+        case TCP_PROTO_OP_LOG_LEVEL:
+            /* An empty payload only reads the level. */
+            if((frame->len > 0) && (frame->payload[0] > APP_LOG_LEVEL_DEBUG))
+            {
+                reply[0] = TCP_PROTO_STATUS_INVALID;
+                send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, 1, false);
+                break;
+            }
+
+            if(frame->len > 0)
+            {
+                app_log_set_level(frame->payload[0]);
+            }
+            reply[0] = TCP_PROTO_STATUS_OK;
+            reply[1] = (uint8_t)app_log_level;
+            send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, sizeof(reply), false);
+            break;
+
+#if(TCP_BENCH_ENABLED)
+        case TCP_PROTO_OP_BENCH:
+            handle_bench_frame(conn, frame);
+            break;
+#endif /* TCP_BENCH_ENABLED */
+
+        default:
+            reply[0] = TCP_PROTO_STATUS_UNSUPPORTED;
+            send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, 1, false);
+            break;
+    }
+}
+
+ #if(TCP_BENCH_ENABLED)
+/*******************************************************************************
+ * Function Name: handle_bench_frame
+ *******************************************************************************
+ * Summary:
+ *  Starts the benchmark requested by a BENCH frame and answers it. The
+ *  answer is queued before the connection switches to raw benchmark data,
+ *  so the client receives it first.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const tcp_proto_frame_t *frame: Decoded BENCH frame
+ *
+ *******************************************************************************/
+static void handle_bench_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame)
+{
+    tcp_bench_params_t params;
+    uint8_t status;
+
+    status = tcp_bench_parse(frame->payload, frame->len, &params);
+    if(status == TCP_PROTO_STATUS_OK)
+    {
+        status = tcp_bench_start(conn, &params);
+    }
+
+    if(!send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, &status, sizeof(status), false))
+    {
+        /* The client does not learn that the benchmark started. */
+        if(status == TCP_PROTO_STATUS_OK)
+        {
+            tcp_bench_stop(conn);
+        }
+        return;
+    }
+
+    if(status == TCP_PROTO_STATUS_OK)
+    {
+        tcp_bench_activate(conn);
+    }
+}
+#endif /* TCP_BENCH_ENABLED */
+
+/*******************************************************************************
+ * Function Name: handle_stats_frame
+ *******************************************************************************
+ * Summary:
+ *  Answers a STATS frame with the statistics of the task at the requested
+ *  index in a TASK_STATS frame. Index 0 takes a new snapshot, covering the
+ *  time since the previous one; the client then asks for the other tasks of
+ *  the snapshot one at a time, so the answers never fill the send queue.
+ *  Every answer carries the number of the snapshot and its interval. An
+ *  index past the last task, or an index other than 0 once the snapshot the
+ *  client took has been replaced by that of another client, is answered with
+ *  ACK [INVALID].
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  const tcp_proto_frame_t *frame: Decoded STATS frame
+ *
+ *******************************************************************************/
+static void handle_stats_frame(tcp_conn_t *conn, const tcp_proto_frame_t *frame)
+{
+    /* Snapshot answered from, numbered from 1; only used by the socket
+     * callback thread.
+     */
+    static task_stats_entry_t entries[TASK_STATS_MAX_TASKS];
+    static uint32_t entry_count;
+    static uint32_t interval_ms;
+    static uint8_t snapshot;
+
+    uint8_t reply[TCP_PROTO_MAX_PAYLOAD_LEN];
+    const task_stats_entry_t *entry;
+    uint32_t index = (frame->len > 0) ? frame->payload[0] : 0;
+    uint32_t name_len;
+
+    if(index == 0)
+    {
+        entry_count = task_stats_snapshot(entries, TASK_STATS_MAX_TASKS, &interval_ms);
+        snapshot = (snapshot == UINT8_MAX) ? 1u : (uint8_t)(snapshot + 1u);
+        conn->stats_snapshot = snapshot;
+    }
+
+    if((conn->stats_snapshot != snapshot) || (index >= entry_count))
+    {
+        reply[0] = TCP_PROTO_STATUS_INVALID;
+        send_frame(conn, TCP_PROTO_OP_ACK, frame->seq, reply, 1, false);
+        return;
+    }
+
+    entry = &entries[index];
+    reply[0] = (uint8_t)index;
+    reply[1] = (uint8_t)entry_count;
+    reply[2] = snapshot;
+    reply[3] = (uint8_t)entry->number;
+    reply[4] = (uint8_t)entry->priority;
+    reply[5] = (uint8_t)entry->state;
+    reply[6] = (uint8_t)(entry->cpu_permille >> 8);
+    reply[7] = (uint8_t)entry->cpu_permille;
+    reply[8] = (uint8_t)(interval_ms >> 24);
+    reply[9] = (uint8_t)(interval_ms >> 16);
+    reply[10] = (uint8_t)(interval_ms >> 8);
+    reply[11] = (uint8_t)interval_ms;
+    reply[12] = (uint8_t)(entry->stack_free >> 24);
+    reply[13] = (uint8_t)(entry->stack_free >> 16);
+    reply[14] = (uint8_t)(entry->stack_free >> 8);
+    reply[15] = (uint8_t)entry->stack_free;
+    reply[16] = (uint8_t)(entry->switches >> 24);
+    reply[17] = (uint8_t)(entry->switches >> 16);
+    reply[18] = (uint8_t)(entry->switches >> 8);
+    reply[19] = (uint8_t)entry->switches;
+
+    name_len = strnlen(entry->name, sizeof(reply) - TCP_SERVER_TASK_STATS_LEN);
+    memcpy(&reply[TCP_SERVER_TASK_STATS_LEN], entry->name, name_len);
+
+    send_frame(conn, TCP_PROTO_OP_TASK_STATS, frame->seq, reply,
+               (uint16_t)(TCP_SERVER_TASK_STATS_LEN + name_len), false);
 }
 
  /*******************************************************************************
  * Function Name: tcp_disconnection_handler
  *******************************************************************************
  * Summary:
- *  Callback function to handle TCP client disconnection event.
+ *  Callback function to handle TCP client disconnection event. The socket is
+ *  disconnected and deleted by the TCP writer task, which may still be
+ *  sending on it.
  *
  * Parameters:
  * cy_socket_t socket_handle: Connection handle for the TCP client socket
- *  void *args : Parameter passed on to the function (unused)
+ *  void *args : Connection table entry of the TCP client
  *
  * Return:
  *  cy_result result: Result of the operation
  *
  *******************************************************************************/
 static cy_rslt_t tcp_disconnection_handler(cy_socket_t socket_handle, void *arg)
+{
+    TRACE_SPAN_SCOPE(TRACE_SPAN_DISCONNECT_CB);
+
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    tcp_conn_t *conn = tcp_conn_find(socket_handle, arg);
+
+    if(conn != NULL)
+    {
+        if(conn->state == TCP_CONN_STATE_CONNECTED)
+        {
+            tcp_conn_print_stats(conn);
+            cmd_latency_print();
+        }
+
+#if(TCP_BENCH_ENABLED)
+        tcp_bench_stop(conn);
+#endif /* TCP_BENCH_ENABLED */
+
+        /* Let the TCP writer disconnect and delete the socket. */
+        tcp_conn_close(conn);
+    }
+    else
+    {
+        /* The socket never made it into the connection table. */
+        result = cy_socket_disconnect(socket_handle, 0);
+        cy_socket_delete(socket_handle);
+    }
+
+    APP_LOG_INFO("TCP client disconnected! Connected TCP clients: %"PRIuPTR, tcp_conn_count());
+
+    /* Set the LED state to OFF when the last TCP client disconnects. */
+    if(tcp_conn_count() == 0)
+    {
+        led_state = CYBSP_LED_STATE_OFF;
+
+        /* With no client left, what the connections served since start up
+         * still hold is what connection churn leaks.
+         */
+        heap_profile_phase("All TCP clients disconnected");
+        heap_profile_diff("After cy_socket_init", "All TCP clients disconnected");
+        heap_profile_print();
+#if(PERF_PROBE_ENABLED)
+        perf_probe_print();
+#endif /* PERF_PROBE_ENABLED */
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: register_client_callbacks
+ *******************************************************************************
+ * Summary:
+ *  Registers the receive and disconnection callbacks on an accepted client
+ *  socket with its connection table entry as the callback argument.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+static cy_rslt_t register_client_callbacks(tcp_conn_t *conn)
 {
     cy_rslt_t result;
+    cy_socket_opt_callback_t tcp_receive_option;
+    cy_socket_opt_callback_t tcp_disconnection_option;
 
-    /* Disconnect the TCP client. */
-    result = cy_socket_disconnect(socket_handle, 0);
-    /* Delete the socket. */
-    cy_socket_delete(socket_handle);
+    tcp_receive_option.callback = tcp_receive_msg_handler;
+    tcp_receive_option.arg = conn;
 
-    /* Set the client connection flag as false. */
-    client_connected = false;
-    printf("TCP Client disconnected! Please reconnect the TCP Client\n");
-    printf("===============================================================\n");
-    printf("Listening for incoming TCP client connection on Port:%d\n",
-            tcp_server_addr.port);
+    result = cy_socket_setsockopt(conn->handle, CY_SOCKET_SOL_SOCKET,
+                                  CY_SOCKET_SO_RECEIVE_CALLBACK,
+                                  &tcp_receive_option, sizeof(cy_socket_opt_callback_t));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        APP_LOG_ERROR("Set socket option: CY_SOCKET_SO_RECEIVE_CALLBACK failed");
+        return result;
+    }
 
-    /* Set the LED state to OFF when the TCP client disconnects. */
-    led_state = CYBSP_LED_STATE_OFF;
+    tcp_disconnection_option.callback = tcp_disconnection_handler;
+    tcp_disconnection_option.arg = conn;
+
+    result = cy_socket_setsockopt(conn->handle, CY_SOCKET_SOL_SOCKET,
+                                  CY_SOCKET_SO_DISCONNECT_CALLBACK,
+                                  &tcp_disconnection_option, sizeof(cy_socket_opt_callback_t));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        APP_LOG_ERROR("Set socket option: CY_SOCKET_SO_DISCONNECT_CALLBACK failed");
+    }
 
     return result;
 }
 
+/*******************************************************************************
+ * Function Name: send_frame
+ *******************************************************************************
+ * Summary:
+ *  Queues a protocol v2 frame for a TCP client, with a CRC if the client
+ *  asked for it.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  uint8_t opcode: Opcode of the frame
+ *  uint16_t seq: Sequence number of the frame
+ *  const void *payload: Payload of the frame
+ *  uint16_t len: Length of the payload
+ *  bool pending: true for a command recorded with tcp_conn_pending_add()
+ *
+ * Return:
+ *  bool: true if the frame was queued, false if it was dropped
+ *
+ *******************************************************************************/
+static bool send_frame(tcp_conn_t *conn, uint8_t opcode, uint16_t seq,
+                       const void *payload, uint16_t len, bool pending)
+{
+    uint8_t frame_buf[TCP_PROTO_MAX_FRAME_LEN];
+    uint32_t frame_len;
+
+    frame_len = tcp_proto_encode(frame_buf, opcode, seq, payload, len, conn->crc_enabled);
+    if(frame_len == 0)
+    {
+        return false;
+    }
+
+    if(pending)
+    {
+        return tcp_conn_enqueue_pending(conn, frame_buf, frame_len, seq);
+    }
+
+    return tcp_conn_enqueue(conn, frame_buf, frame_len);
+}
+
+/*******************************************************************************
+ * Function Name: send_static_frame
+ *******************************************************************************
+ * Summary:
+ *  Queues a protocol v2 frame whose payload is a constant buffer. Only the
+ *  header and the CRC are copied into the send queue; the TCP writer sends
+ *  the payload in place, so its length is not limited by the send queue.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  uint8_t opcode: Opcode of the frame
+ *  uint16_t seq: Sequence number of the frame
+ *  const void *payload: Payload of the frame, constant
+ *  uint16_t len: Length of the payload
+ *
+ * Return:
+ *  bool: true if the frame was queued, false if it was dropped
+ *
+ *******************************************************************************/
+static bool send_static_frame(tcp_conn_t *conn, uint8_t opcode, uint16_t seq,
+                              const void *payload, uint16_t len)
+{
+    uint8_t header[TCP_PROTO_HEADER_LEN];
+    uint8_t crc[TCP_PROTO_CRC_LEN];
+    uint16_t frame_crc;
+
+    tcp_proto_encode_header(header, opcode, seq, len, conn->crc_enabled);
+    if(!conn->crc_enabled)
+    {
+        return tcp_conn_enqueue_static_framed(conn, header, sizeof(header), payload, len, NULL, 0, NULL, NULL);
+    }
+
+    frame_crc = tcp_proto_crc16_update(tcp_proto_crc16(header, sizeof(header)), payload, len);
+    crc[0] = (uint8_t)(frame_crc >> 8);
+    crc[1] = (uint8_t)frame_crc;
+
+    return tcp_conn_enqueue_static_framed(conn, header, sizeof(header), payload, len, crc, sizeof(crc), NULL, NULL);
+}
+
+/*******************************************************************************
+ * Function Name: send_led_cmd_to_client
+ *******************************************************************************
+ * Summary:
+ *  Queues the LED ON/OFF command for one TCP client, as one byte for protocol
+ *  v1 clients and as a LED_SET frame for protocol v2 clients; the TCP writer
+ *  task sends it. The command is recorded until its acknowledgement arrives,
+ *  to time it and, in protocol v2, to match the acknowledgement. Protocol v2
+ *  commands are dropped when TCP_CONN_MAX_INFLIGHT commands are outstanding;
+ *  protocol v1 commands are then sent without being timed. Clients whose
+ *  send queue is above the high watermark are skipped until they catch up.
+ *  Called for every connected client by tcp_conn_for_each().
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  void *arg: LED_SET command with its timestamps (tcp_conn_pending_t)
+ *
+ *******************************************************************************/
+static void send_led_cmd_to_client(tcp_conn_t *conn, void *arg)
+{
+    const tcp_conn_pending_t *led_cmd = (const tcp_conn_pending_t *)arg;
+    uint8_t led_state_cmd = led_cmd->value ? LED_ON_CMD : LED_OFF_CMD;
+    uint16_t seq;
+    bool recorded;
+    bool queued;
+
+    /* A benchmark connection carries no commands. */
+    if(conn->protocol == TCP_CONN_PROTOCOL_BENCH)
+    {
+        return;
+    }
+
+    if(conn->tx_throttled)
+    {
+        conn->tx_dropped++;
+        return;
+    }
+
+    recorded = tcp_conn_pending_add(conn, led_cmd, &seq);
+
+    if(conn->protocol == TCP_CONN_PROTOCOL_V2)
+    {
+        if(!recorded)
+        {
+            tcp_conn_pending_cancel(conn, seq);
+            APP_LOG_WARNING("TCP client "APP_LOG_IPV4_FMT" has %"PRIuPTR" unacknowledged commands, command dropped",
+                            APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4), (unsigned int)TCP_CONN_MAX_INFLIGHT);
+            return;
+        }
+
+        queued = send_frame(conn, TCP_PROTO_OP_LED_SET, seq, &led_cmd->value,
+                            sizeof(led_cmd->value), true);
+    }
+    else if(recorded)
+    {
+        queued = tcp_conn_enqueue_pending(conn, &led_state_cmd, TCP_LED_CMD_LEN, seq);
+    }
+    else
+    {
+        queued = tcp_conn_enqueue(conn, &led_state_cmd, TCP_LED_CMD_LEN);
+    }
+
+    if(queued)
+    {
+        conn->cmds_sent++;
+        conn->last_cmd = led_state_cmd;
+        conn->proto_state = TCP_CONN_PROTO_WAIT_ACK;
+
+        APP_LOG_DEBUG("LED %s command queued for TCP client "APP_LOG_IPV4_FMT,
+                      APP_LOG_STR(led_cmd->value ? "ON" : "OFF"), APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4));
+    }
+    else
+    {
+        tcp_conn_pending_cancel(conn, seq);
+        APP_LOG_WARNING("Send queue of TCP client "APP_LOG_IPV4_FMT" is full, command dropped", APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4));
+    }
+}
+
+/*******************************************************************************
+ * Function Name: send_queue_watermark_handler
+ *******************************************************************************
+ * Summary:
+ *  Reports TCP clients that stop reading their commands, and their recovery.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *  bool throttled: true above the high watermark, false back at the low one
+ *
+ *******************************************************************************/
+static void send_queue_watermark_handler(tcp_conn_t *conn, bool throttled)
+{
+    APP_LOG_WARNING("TCP client "APP_LOG_IPV4_FMT" %s: %"PRIuPTR" bytes queued",
+                    APP_LOG_IPV4(conn->peer_addr.ip_address.ip.v4), APP_LOG_STR(throttled ? "is not keeping up" : "caught up"),
+                    tcp_conn_tx_depth(conn));
+}
+
 /*******************************************************************************
  * Function Name: isr_button_press
  *******************************************************************************
@@ -719,6 +1735,11 @@ static void isr_button_press( void *callback_arg, cyhal_gpio_event_t event)
 { 
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+    /* Start of the command latency measurement. */
+    uint32_t timestamp = timestamp_now();
+
+    TRACE_ISR_ENTER(TRACE_ISR_BUTTON);
+
     /* Variable to hold the LED ON/OFF command to be sent to the TCP client. */
     uint32_t led_state_cmd;
 
@@ -732,12 +1753,40 @@ static void isr_button_press( void *callback_arg, cyhal_gpio_event_t event)
         led_state_cmd = LED_ON_CMD;
     }
 
-    /* Set the flag to send command to TCP client. */
-    xTaskNotifyFromISR(server_task_handle, led_state_cmd,
-                      eSetValueWithoutOverwrite, &xHigherPriorityTaskWoken);
+    /* Post the command to the TCP server task. */
+    isr_event_post_from_isr(ISR_EVENT_BUTTON_PRESS, (uint16_t)led_state_cmd, timestamp,
+                            &xHigherPriorityTaskWoken);
+
+    TRACE_ISR_EXIT(TRACE_ISR_BUTTON);
 
     /* Force a context switch if xHigherPriorityTaskWoken is now set to pdTRUE. */
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+/*******************************************************************************
+ * Function Name: debounce_timer_callback
+ *******************************************************************************
+ *
+ * Summary:
+ *  Ends the debounce period of the user button by enabling the falling edge
+ *  detection again. While the button is still pressed the period is
+ *  extended, so that the bounces of the release are not taken as a press.
+ *  Runs in the FreeRTOS timer service task.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Debounce timer
+ *
+ *******************************************************************************/
+static void debounce_timer_callback(TimerHandle_t timer)
+{
+    if(!cyhal_gpio_read(CYBSP_SW1))
+    {
+        xTimerStart(timer, 0);
+        return;
+    }
+
+    /* Enable the GPIO signal falling edge detection. */
+    cyhal_gpio_enable_event(CYBSP_SW1, CYHAL_GPIO_IRQ_FALL, USER_BTN_INTR_PRIORITY, true);
+}
+
 /* [] END OF FILE */
@@ -0,0 +1,163 @@
+/******************************************************************************
+* File Name:   tcp_sockopt.c
+*
+* Description: This file contains the connection options profiles. Which
+* options an accepted socket inherits from the listening socket depends on
+* the TCP/IP stack: lwIP only passes on the keepalive flag, while the host
+* build inherits all the TCP options. Rather than hard-coding either, the
+* options of the first accepted socket are read back; those that already
+* have the profile's value are not set again on the later accepted sockets.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_utils.h"
+#include "cy_retarget_io.h"
+
+/* Standard C header file */
+#include <inttypes.h>
+
+/* Connection options profile header file. */
+#include "tcp_sockopt.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void find_inherited_options(tcp_sockopt_profile_t *profile, cy_socket_t socket);
+
+/*******************************************************************************
+ * Function Name: tcp_sockopt_listen
+ *******************************************************************************
+ * Summary:
+ *  Sets the options of a profile on a listening socket, before it listens.
+ *  Every option is set on the accepted sockets until the first accept shows
+ *  which are inherited.
+ *
+ * Parameters:
+ *  tcp_sockopt_profile_t *profile: Connection options profile
+ *  cy_socket_t listener: Listening socket
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_sockopt_listen(tcp_sockopt_profile_t *profile, cy_socket_t listener)
+{
+    cy_rslt_t result;
+
+    CY_ASSERT(profile->count <= 32u);
+
+    for(uint32_t i = 0; i < profile->count; i++)
+    {
+        result = cy_socket_setsockopt(listener, profile->options[i].level, profile->options[i].optname,
+                                      &profile->options[i].value, sizeof(profile->options[i].value));
+        if(result != CY_RSLT_SUCCESS)
+        {
+            printf("Set socket option: %s failed\n", profile->options[i].name);
+            return result;
+        }
+    }
+
+    profile->per_accept = (profile->count < 32u) ? ((1u << profile->count) - 1u) : UINT32_MAX;
+    profile->checked = false;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_sockopt_accept
+ *******************************************************************************
+ * Summary:
+ *  Sets the options of a profile that an accepted socket did not inherit.
+ *  Must be called from the socket callbacks, which run one at a time.
+ *
+ * Parameters:
+ *  tcp_sockopt_profile_t *profile: Connection options profile of the
+ *  listening socket
+ *  cy_socket_t socket: Accepted socket
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_sockopt_accept(tcp_sockopt_profile_t *profile, cy_socket_t socket)
+{
+    cy_rslt_t result;
+
+    if(!profile->checked)
+    {
+        find_inherited_options(profile, socket);
+    }
+
+    for(uint32_t i = 0; i < profile->count; i++)
+    {
+        if((profile->per_accept & (1u << i)) == 0)
+        {
+            continue;
+        }
+
+        result = cy_socket_setsockopt(socket, profile->options[i].level, profile->options[i].optname,
+                                      &profile->options[i].value, sizeof(profile->options[i].value));
+        if(result != CY_RSLT_SUCCESS)
+        {
+            APP_LOG_ERROR("Set socket option: %s failed. Error code: 0x%08"PRIxPTR,
+                          APP_LOG_STR(profile->options[i].name), (uint32_t)result);
+            return result;
+        }
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: find_inherited_options
+ *******************************************************************************
+ * Summary:
+ *  Reads the options of the first accepted socket and leaves out of the
+ *  per-accept batch those that already have the profile's value. Options the
+ *  stack cannot read back stay in the batch.
+ *
+ * Parameters:
+ *  tcp_sockopt_profile_t *profile: Connection options profile
+ *  cy_socket_t socket: First accepted socket
+ *
+ *******************************************************************************/
+static void find_inherited_options(tcp_sockopt_profile_t *profile, cy_socket_t socket)
+{
+    const tcp_sockopt_t *option;
+    uint32_t value;
+    uint32_t optlen;
+    uint32_t inherited = 0;
+
+    for(uint32_t i = 0; i < profile->count; i++)
+    {
+        option = &profile->options[i];
+        value = 0;
+        optlen = sizeof(value);
+        if(cy_socket_getsockopt(socket, option->level, option->optname, &value, &optlen) != CY_RSLT_SUCCESS)
+        {
+            continue;
+        }
+
+        if(option->boolean ? ((value != 0) == (option->value != 0)) : (value == option->value))
+        {
+            profile->per_accept &= ~(1u << i);
+            inherited++;
+        }
+    }
+
+    profile->checked = true;
+
+    APP_LOG_INFO("Accepted sockets already have %"PRIuPTR" of %"PRIuPTR" socket options",
+                 inherited, profile->count);
+}
+
+/* [] END OF FILE */
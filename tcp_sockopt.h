@@ -0,0 +1,57 @@
+/******************************************************************************
+* File Name:   tcp_sockopt.h
+*
+* Description: This file contains declaration of the connection options
+* profiles. A profile lists the socket options of the connections accepted
+* by a listening socket. It is set once on the listening socket; the options
+* the accepted sockets inherit from it are found on the first accept, and
+* only the others are set on each accepted socket, in one batch.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TCP_SOCKOPT_H_
+#define TCP_SOCKOPT_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Socket option. The options of a profile all take a 32-bit value, an int
+ * for the boolean ones.
+ */
+typedef struct
+{
+    int level;
+    int optname;
+    uint32_t value;
+    bool boolean;                   /* Any non-zero value read back means enabled. */
+    const char *name;               /* For the error messages. */
+} tcp_sockopt_t;
+
+/* Connection options profile of a listening socket. */
+typedef struct
+{
+    const tcp_sockopt_t *options;
+    uint32_t count;                 /* At most 32 options. */
+    uint32_t per_accept;            /* Mask of the options set on each accepted socket. */
+    bool checked;                   /* Whether the inherited options were looked for. */
+} tcp_sockopt_profile_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tcp_sockopt_listen(tcp_sockopt_profile_t *profile, cy_socket_t listener);
+cy_rslt_t tcp_sockopt_accept(tcp_sockopt_profile_t *profile, cy_socket_t socket);
+
+#endif /* TCP_SOCKOPT_H_ */
@@ -0,0 +1,234 @@
+/******************************************************************************
+* File Name:   tcp_writer.c
+*
+* Description: This file contains the TCP writer task. The task drains the
+* send queues of the connected TCP clients, so that the task queueing a
+* command never blocks on a slow client, and it is the only task that deletes
+* client sockets: connections closed by the other tasks are only marked as
+* closing in the connection table and torn down here.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* Standard C header file */
+#include <inttypes.h>
+
+/* TCP writer task header file. */
+#include "tcp_writer.h"
+
+/* Connection table header file. */
+#include "tcp_conn.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Throughput benchmark header file. */
+#include "tcp_bench.h"
+
+/* Metrics header file. */
+#include "metrics.h"
+
+/* Timing probe header file. */
+#include "perf_probe.h"
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void tcp_writer_task(void *arg);
+static bool drain_send_queue(tcp_conn_t *conn);
+static void destroy_connection(tcp_conn_t *conn);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* TCP writer task handle. */
+static TaskHandle_t writer_task_handle;
+STATIC_ALLOC_TASK_DEFINE(writer_task, TCP_WRITER_TASK_STACK_SIZE);
+
+/*******************************************************************************
+ * Function Name: tcp_writer_start
+ *******************************************************************************
+ * Summary:
+ *  Creates the TCP writer task. Must be called before the TCP server socket
+ *  starts listening.
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t tcp_writer_start(void)
+{
+    if(STATIC_ALLOC_TASK_CREATE(writer_task, tcp_writer_task, "TCP writer", TCP_WRITER_TASK_STACK_SIZE, NULL,
+                                TCP_WRITER_TASK_PRIORITY, &writer_task_handle) != pdPASS)
+    {
+        printf("Failed to create the TCP writer task\n");
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: tcp_writer_notify
+ *******************************************************************************
+ * Summary:
+ *  Wakes up the TCP writer task after a message was queued or a connection
+ *  was marked as closing. Notifications are counted, so none is lost while
+ *  the writer is busy.
+ *
+ *******************************************************************************/
+void tcp_writer_notify(void)
+{
+    if(writer_task_handle != NULL)
+    {
+        xTaskNotifyGive(writer_task_handle);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tcp_writer_task
+ *******************************************************************************
+ * Summary:
+ *  Waits for work and then visits every entry of the connection table:
+ *  closing connections are torn down and the send queues of the connected
+ *  clients are drained. While a send queue could not be emptied, the table is
+ *  visited again every TCP_WRITER_RETRY_INTERVAL_MS. A source mode benchmark
+ *  keeps the writer sending until it ends.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused)
+ *
+ *******************************************************************************/
+static void tcp_writer_task(void *arg)
+{
+    bool pending = false;
+    bool streaming = false;
+    TickType_t timeout;
+
+    while(true)
+    {
+        timeout = streaming ? 0 :
+                  pending ? pdMS_TO_TICKS(TCP_WRITER_RETRY_INTERVAL_MS) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, timeout);
+        pending = false;
+        streaming = false;
+
+        for(uint32_t i = 0; i < TCP_CONN_MAX_CLIENTS; i++)
+        {
+            tcp_conn_t *conn = tcp_conn_at(i);
+
+            switch(__atomic_load_n(&conn->state, __ATOMIC_ACQUIRE))
+            {
+                case TCP_CONN_STATE_CLOSING:
+                    destroy_connection(conn);
+                    break;
+
+                case TCP_CONN_STATE_CONNECTED:
+                    if(!drain_send_queue(conn))
+                    {
+                        pending = true;
+                    }
+#if(TCP_BENCH_ENABLED)
+                    else if((conn->protocol == TCP_CONN_PROTOCOL_BENCH) && tcp_bench_poll(conn))
+                    {
+                        streaming = true;
+                    }
+#endif /* TCP_BENCH_ENABLED */
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: drain_send_queue
+ *******************************************************************************
+ * Summary:
+ *  Sends the queued data of a TCP client, one contiguous block of the send
+ *  queue at a time. The data is removed from the queue as the socket accepts
+ *  it. A client that has closed its side is marked as closing.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ * Return:
+ *  bool: true if the send queue is empty, false if data is left to send
+ *
+ *******************************************************************************/
+static bool drain_send_queue(tcp_conn_t *conn)
+{
+    cy_rslt_t result;
+    const uint8_t *span;
+    uint32_t span_len;
+    uint32_t bytes_sent;
+
+    while((span_len = tcp_conn_tx_peek(conn, &span)) > 0)
+    {
+        bytes_sent = 0;
+        TRACE_SPAN_BEGIN(TRACE_SPAN_SEND);
+        PERF_PROBE(PERF_PROBE_SEND,
+                   result = cy_socket_send(conn->handle, span, span_len,
+                                           CY_SOCKET_FLAGS_NONE, &bytes_sent));
+        TRACE_SPAN_END(TRACE_SPAN_SEND);
+        tcp_conn_tx_consume(conn, bytes_sent);
+
+        if(result != CY_RSLT_SUCCESS)
+        {
+            conn->tx_errors++;
+            APP_LOG_ERROR("Failed to send to TCP client. Error code: 0x%08"PRIxPTR, (uint32_t)result);
+            METRICS_ERROR(METRICS_OP_SEND, result);
+            if(result == CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED)
+            {
+                /* Torn down on the next pass of the writer. */
+                tcp_conn_close(conn);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: destroy_connection
+ *******************************************************************************
+ * Summary:
+ *  Disconnects and deletes the socket of a closing connection and releases
+ *  its connection table entry.
+ *
+ * Parameters:
+ *  tcp_conn_t *conn: Connection table entry of the TCP client
+ *
+ *******************************************************************************/
+static void destroy_connection(tcp_conn_t *conn)
+{
+    /* Disconnect the socket. */
+    cy_socket_disconnect(conn->handle, 0);
+    /* Delete the socket. */
+    cy_socket_delete(conn->handle);
+
+    tcp_conn_free(conn);
+}
+
+/* [] END OF FILE */
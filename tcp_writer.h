@@ -0,0 +1,38 @@
+/******************************************************************************
+* File Name:   tcp_writer.h
+*
+* Description: This file contains declaration of the TCP writer task, which
+* sends the queued messages of the connected TCP clients.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TCP_WRITER_H_
+#define TCP_WRITER_H_
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* The writer runs above the TCP server task so that queued commands are sent
+ * as soon as the fan-out is done.
+ */
+#define TCP_WRITER_TASK_STACK_SIZE                (1024 * 2)
+#define TCP_WRITER_TASK_PRIORITY                  (2)
+
+/* Period at which the writer retries sends that failed or did not complete. */
+#define TCP_WRITER_RETRY_INTERVAL_MS              (10u)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t tcp_writer_start(void);
+void tcp_writer_notify(void);
+
+#endif /* TCP_WRITER_H_ */
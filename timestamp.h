@@ -0,0 +1,117 @@
+/******************************************************************************
+* File Name:   timestamp.h
+*
+* Description: This file contains high resolution timestamps used to measure
+* latencies. On the CYW43907 the timestamps are read from the cycle counter
+* of the Cortex-R4 performance monitor unit, so taking one costs a single
+* coprocessor register read and is safe in interrupt context.
+*
+* Timestamps are 32-bit and wrap around; only differences between timestamps
+* taken less than one wrap period apart (about 26 s at 160 MHz) are valid.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7R__)
+
+/* FreeRTOS header file, for configCPU_CLOCK_HZ. */
+#include <FreeRTOS.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Timestamps count CPU cycles. */
+#define TIMESTAMP_HZ                              ((uint32_t)configCPU_CLOCK_HZ)
+
+/* Performance monitor control register bits. */
+#define TIMESTAMP_PMCR_ENABLE                     (1u << 0)
+#define TIMESTAMP_PMCR_CYCLE_DIV64                (1u << 3)
+#define TIMESTAMP_PMCNTEN_CYCLE                   (1u << 31)
+
+/*******************************************************************************
+ * Function Name: timestamp_init
+ *******************************************************************************
+ * Summary:
+ *  Starts the cycle counter, counting every CPU cycle. The counter is not
+ *  reset, so that other users of the counter are not disturbed.
+ *
+ *******************************************************************************/
+static inline void timestamp_init(void)
+{
+    uint32_t pmcr;
+
+    __asm volatile ("mrc p15, 0, %0, c9, c12, 0" : "=r" (pmcr));
+    pmcr |= TIMESTAMP_PMCR_ENABLE;
+    pmcr &= ~TIMESTAMP_PMCR_CYCLE_DIV64;
+    __asm volatile ("mcr p15, 0, %0, c9, c12, 0" : : "r" (pmcr));
+    __asm volatile ("mcr p15, 0, %0, c9, c12, 1" : : "r" (TIMESTAMP_PMCNTEN_CYCLE));
+}
+
+/*******************************************************************************
+ * Function Name: timestamp_now
+ *******************************************************************************
+ * Summary:
+ *  Returns the current timestamp, in units of 1/TIMESTAMP_HZ seconds.
+ *
+ *******************************************************************************/
+static inline uint32_t timestamp_now(void)
+{
+    uint32_t cycles;
+
+    __asm volatile ("mrc p15, 0, %0, c9, c13, 0" : "=r" (cycles));
+
+    return cycles;
+}
+
+#else
+
+/* POSIX header file */
+#include <time.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Timestamps count nanoseconds of the monotonic clock. */
+#define TIMESTAMP_HZ                              (1000000000u)
+
+static inline void timestamp_init(void)
+{
+}
+
+static inline uint32_t timestamp_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * TIMESTAMP_HZ + (uint64_t)now.tv_nsec);
+}
+
+#endif /* defined(__ARM_ARCH_7R__) */
+
+/*******************************************************************************
+ * Function Name: timestamp_to_ns
+ *******************************************************************************
+ * Summary:
+ *  Converts a difference between two timestamps to nanoseconds, saturating
+ *  at UINT32_MAX (about 4.3 s).
+ *
+ *******************************************************************************/
+static inline uint32_t timestamp_to_ns(uint32_t ticks)
+{
+    uint64_t ns = ((uint64_t)ticks * 1000000000u) / TIMESTAMP_HZ;
+
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+#endif /* TIMESTAMP_H_ */
@@ -0,0 +1,663 @@
+/******************************************************************************
+* File Name:   tlsf_heap.c
+*
+* Description: This file contains the TLSF heap. Every block starts with a
+* header of two pointers: the block before it in memory and the size of the
+* block, whose lowest bit is set while the block is free. A free block holds
+* its free list links in its first bytes. A block is never free next to
+* another free block: a free merges them, so the block after a free block,
+* and the end marker closing the heap, are always in use.
+*
+* An allocation rounds the size up to the next class boundary, so that any
+* block of the first non-empty list at or above the class fits without
+* searching the list; the tail of the block beyond the request is split off
+* and freed when it can hold a block.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_utils.h"
+
+/* Standard C header files */
+#include <string.h>
+
+/* TLSF heap header file. */
+#include "tlsf_heap.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BLOCK_HEADER                              (TLSF_HEAP_ALIGN)
+#define BLOCK_FREE                                ((size_t)1u)
+
+/* Smallest block: room for the free list links. */
+#define BLOCK_SIZE_MIN                            (TLSF_HEAP_ALIGN)
+#define BLOCK_SIZE_MAX                            (((size_t)1u << TLSF_HEAP_MAX_LOG2) - TLSF_HEAP_ALIGN)
+#define SMALL_BLOCK_SIZE                          ((size_t)1u << TLSF_HEAP_FL_SHIFT)
+
+#define ALIGN_UP(size)                            (((size) + (TLSF_HEAP_ALIGN - 1u)) & ~(size_t)(TLSF_HEAP_ALIGN - 1u))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Block header. The free list links lie in the block of a free block. */
+typedef struct tlsf_heap_block
+{
+    struct tlsf_heap_block *prev_phys;  /* Block before this one, NULL for the first. */
+    size_t size;                        /* Headers excluded; BLOCK_FREE while free. */
+    struct tlsf_heap_block *next_free;
+    struct tlsf_heap_block *prev_free;
+} tlsf_heap_block_t;
+
+_Static_assert(offsetof(tlsf_heap_block_t, next_free) == BLOCK_HEADER,
+               "The block header must be TLSF_HEAP_ALIGN bytes");
+_Static_assert(TLSF_HEAP_ALIGN >= _Alignof(max_align_t), "TLSF_HEAP_ALIGN is below the alignment of malloc()");
+_Static_assert(TLSF_HEAP_FL_COUNT <= 32u, "The first-level classes must fit in the bitmap");
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static inline size_t block_size(const tlsf_heap_block_t *block);
+static inline bool block_is_free(const tlsf_heap_block_t *block);
+static inline tlsf_heap_block_t *block_next(const tlsf_heap_block_t *block);
+static inline tlsf_heap_block_t *block_from_ptr(const void *ptr);
+static inline uint32_t find_last_set(uint32_t word);
+static void mapping(size_t size, uint32_t *fl, uint32_t *sl);
+static void insert_free(tlsf_heap_t *heap, tlsf_heap_block_t *block);
+static void remove_free(tlsf_heap_t *heap, tlsf_heap_block_t *block);
+static tlsf_heap_block_t *find_free(const tlsf_heap_t *heap, size_t size);
+static void absorb_next(tlsf_heap_block_t *block);
+static void split(tlsf_heap_t *heap, tlsf_heap_block_t *block, size_t size);
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_init
+ *******************************************************************************
+ * Summary:
+ *  Sets up a heap over caller-provided memory, as a single free block.
+ *
+ * Parameters:
+ *  tlsf_heap_t *heap: Heap to set up
+ *  void *mem: Memory of the heap
+ *  size_t size: Size of the memory in bytes; the part beyond
+ *  2^TLSF_HEAP_MAX_LOG2 bytes is not used
+ *
+ * Return:
+ *  bool: false if the memory is smaller than TLSF_HEAP_MIN_SIZE
+ *
+ *******************************************************************************/
+bool tlsf_heap_init(tlsf_heap_t *heap, void *mem, size_t size)
+{
+    uint8_t *start = (uint8_t *)ALIGN_UP((uintptr_t)mem);
+    size_t usable;
+    tlsf_heap_block_t *block;
+    tlsf_heap_block_t *end;
+
+    memset(heap, 0, sizeof(*heap));
+
+    if((size < TLSF_HEAP_MIN_SIZE) || ((size_t)(start - (uint8_t *)mem) > (size - TLSF_HEAP_MIN_SIZE)))
+    {
+        return false;
+    }
+
+    /* The first block and the end marker. */
+    usable = (size - (size_t)(start - (uint8_t *)mem)) & ~(size_t)(TLSF_HEAP_ALIGN - 1u);
+    if((usable - (2u * BLOCK_HEADER)) > BLOCK_SIZE_MAX)
+    {
+        usable = BLOCK_SIZE_MAX + (2u * BLOCK_HEADER);
+    }
+
+    heap->start = start;
+    heap->end = start + usable;
+    heap->size = (uint32_t)usable;
+
+    block = (tlsf_heap_block_t *)start;
+    block->prev_phys = NULL;
+    block->size = usable - (2u * BLOCK_HEADER);
+
+    end = block_next(block);
+    end->prev_phys = block;
+    end->size = 0;
+
+    insert_free(heap, block);
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_alloc
+ *******************************************************************************
+ * Summary:
+ *  Allocates a block of at least the given size, aligned to TLSF_HEAP_ALIGN.
+ *
+ * Parameters:
+ *  tlsf_heap_t *heap: Heap to allocate from
+ *  size_t size: Requested size in bytes
+ *
+ * Return:
+ *  void *: Block, or NULL if no free block is large enough
+ *
+ *******************************************************************************/
+void *tlsf_heap_alloc(tlsf_heap_t *heap, size_t size)
+{
+    tlsf_heap_block_t *block = NULL;
+
+    if(size <= BLOCK_SIZE_MAX)
+    {
+        size = (size < BLOCK_SIZE_MIN) ? BLOCK_SIZE_MIN : ALIGN_UP(size);
+        block = find_free(heap, size);
+    }
+
+    if(block == NULL)
+    {
+        heap->failures++;
+        return NULL;
+    }
+
+    remove_free(heap, block);
+    split(heap, block, size);
+
+    heap->used_bytes += (uint32_t)block_size(block);
+    heap->used_blocks++;
+    if(heap->used_bytes > heap->peak_bytes)
+    {
+        heap->peak_bytes = heap->used_bytes;
+    }
+
+    return (uint8_t *)block + BLOCK_HEADER;
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_free
+ *******************************************************************************
+ * Summary:
+ *  Returns a block to its heap, merged with its free neighbours.
+ *
+ * Parameters:
+ *  tlsf_heap_t *heap: Heap the block was allocated from
+ *  void *ptr: Block to release, may be NULL
+ *
+ *******************************************************************************/
+void tlsf_heap_free(tlsf_heap_t *heap, void *ptr)
+{
+    tlsf_heap_block_t *block;
+    tlsf_heap_block_t *prev;
+
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+    CY_ASSERT(tlsf_heap_owns(heap, ptr));
+    block = block_from_ptr(ptr);
+    CY_ASSERT(!block_is_free(block));
+
+    heap->used_bytes -= (uint32_t)block_size(block);
+    heap->used_blocks--;
+
+    prev = block->prev_phys;
+    if((prev != NULL) && block_is_free(prev))
+    {
+        remove_free(heap, prev);
+        absorb_next(prev);
+        block = prev;
+    }
+
+    if(block_is_free(block_next(block)))
+    {
+        remove_free(heap, block_next(block));
+        absorb_next(block);
+    }
+
+    insert_free(heap, block);
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_resize
+ *******************************************************************************
+ * Summary:
+ *  Resizes a block in place: it shrinks, giving back its tail, or grows into
+ *  the free block following it. Never moves the block, so it never copies.
+ *
+ * Parameters:
+ *  tlsf_heap_t *heap: Heap the block was allocated from
+ *  void *ptr: Block to resize
+ *  size_t size: New size in bytes
+ *
+ * Return:
+ *  bool: false if the block cannot grow in place, and was left unchanged
+ *
+ *******************************************************************************/
+bool tlsf_heap_resize(tlsf_heap_t *heap, void *ptr, size_t size)
+{
+    tlsf_heap_block_t *block = block_from_ptr(ptr);
+    tlsf_heap_block_t *next = block_next(block);
+    size_t current = block_size(block);
+
+    CY_ASSERT(tlsf_heap_owns(heap, ptr) && !block_is_free(block));
+
+    if(size > BLOCK_SIZE_MAX)
+    {
+        return false;
+    }
+    size = (size < BLOCK_SIZE_MIN) ? BLOCK_SIZE_MIN : ALIGN_UP(size);
+
+    if((size > current) &&
+       (!block_is_free(next) || ((current + BLOCK_HEADER + block_size(next)) < size)))
+    {
+        return false;
+    }
+
+    heap->used_bytes -= (uint32_t)current;
+
+    if(block_is_free(next))
+    {
+        remove_free(heap, next);
+        absorb_next(block);
+    }
+    split(heap, block, size);
+
+    heap->used_bytes += (uint32_t)block_size(block);
+    if(heap->used_bytes > heap->peak_bytes)
+    {
+        heap->peak_bytes = heap->used_bytes;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_owns
+ *******************************************************************************
+ * Summary:
+ *  Returns whether a pointer lies in the memory of a heap.
+ *
+ *******************************************************************************/
+bool tlsf_heap_owns(const tlsf_heap_t *heap, const void *ptr)
+{
+    return ((const uint8_t *)ptr >= heap->start) && ((const uint8_t *)ptr < heap->end);
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_block_size
+ *******************************************************************************
+ * Summary:
+ *  Returns the usable size of an allocated block, at least the size
+ *  requested.
+ *
+ *******************************************************************************/
+size_t tlsf_heap_block_size(const void *ptr)
+{
+    return block_size(block_from_ptr(ptr));
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_get_stats
+ *******************************************************************************
+ * Summary:
+ *  Returns the statistics of a heap. The largest free block is searched for
+ *  in the highest non-empty free list only.
+ *
+ * Parameters:
+ *  const tlsf_heap_t *heap: Heap
+ *  tlsf_heap_stats_t *stats: Set to the statistics of the heap
+ *
+ *******************************************************************************/
+void tlsf_heap_get_stats(const tlsf_heap_t *heap, tlsf_heap_stats_t *stats)
+{
+    const tlsf_heap_block_t *block;
+    uint32_t fl;
+
+    stats->size = heap->size;
+    stats->used_bytes = heap->used_bytes;
+    stats->used_blocks = heap->used_blocks;
+    stats->peak_bytes = heap->peak_bytes;
+    stats->free_bytes = heap->free_bytes;
+    stats->free_blocks = heap->free_blocks;
+    stats->failures = heap->failures;
+    stats->largest_free = 0;
+
+    if(heap->fl_bitmap != 0)
+    {
+        fl = find_last_set(heap->fl_bitmap);
+        block = heap->free_lists[fl][find_last_set(heap->sl_bitmap[fl])];
+        for(; block != NULL; block = block->next_free)
+        {
+            if(block_size(block) > stats->largest_free)
+            {
+                stats->largest_free = (uint32_t)block_size(block);
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: tlsf_heap_check
+ *******************************************************************************
+ * Summary:
+ *  Walks all the blocks of a heap and checks their links, that no two free
+ *  blocks are neighbours, that every free block is in the list of its class,
+ *  and the free counts. Takes a time proportional to the number of blocks;
+ *  meant for tests.
+ *
+ * Return:
+ *  bool: false if the heap is corrupted
+ *
+ *******************************************************************************/
+bool tlsf_heap_check(const tlsf_heap_t *heap)
+{
+    const tlsf_heap_block_t *block = (const tlsf_heap_block_t *)heap->start;
+    const tlsf_heap_block_t *prev = NULL;
+    const tlsf_heap_block_t *entry;
+    uint32_t free_blocks = 0;
+    uint32_t free_bytes = 0;
+    uint32_t listed = 0;
+    uint32_t fl;
+    uint32_t sl;
+
+    while(block_size(block) > 0)
+    {
+        if((block->prev_phys != prev) || ((uint8_t *)block_next(block) >= heap->end))
+        {
+            return false;
+        }
+
+        if(block_is_free(block))
+        {
+            if((prev != NULL) && block_is_free(prev))
+            {
+                return false;
+            }
+
+            mapping(block_size(block), &fl, &sl);
+            for(entry = heap->free_lists[fl][sl]; (entry != NULL) && (entry != block); entry = entry->next_free)
+            {
+            }
+            if(entry == NULL)
+            {
+                return false;
+            }
+
+            free_blocks++;
+            free_bytes += (uint32_t)block_size(block);
+        }
+
+        prev = block;
+        block = block_next(block);
+    }
+
+    for(fl = 0; fl < TLSF_HEAP_FL_COUNT; fl++)
+    {
+        for(sl = 0; sl < TLSF_HEAP_SL_COUNT; sl++)
+        {
+            for(entry = heap->free_lists[fl][sl]; entry != NULL; entry = entry->next_free)
+            {
+                listed++;
+            }
+            if((heap->free_lists[fl][sl] != NULL) != ((heap->sl_bitmap[fl] & (1u << sl)) != 0))
+            {
+                return false;
+            }
+        }
+    }
+
+    return ((uint8_t *)block == (heap->end - BLOCK_HEADER)) && (block->prev_phys == prev) &&
+           (free_blocks == heap->free_blocks) && (free_bytes == heap->free_bytes) && (listed == free_blocks);
+}
+
+/*******************************************************************************
+ * Function Name: block_size
+ *******************************************************************************
+ * Summary:
+ *  Returns the size of a block, headers excluded.
+ *
+ *******************************************************************************/
+static inline size_t block_size(const tlsf_heap_block_t *block)
+{
+    return block->size & ~BLOCK_FREE;
+}
+
+/*******************************************************************************
+ * Function Name: block_is_free
+ *******************************************************************************
+ * Summary:
+ *  Returns whether a block is in a free list.
+ *
+ *******************************************************************************/
+static inline bool block_is_free(const tlsf_heap_block_t *block)
+{
+    return (block->size & BLOCK_FREE) != 0;
+}
+
+/*******************************************************************************
+ * Function Name: block_next
+ *******************************************************************************
+ * Summary:
+ *  Returns the block following a block in memory.
+ *
+ *******************************************************************************/
+static inline tlsf_heap_block_t *block_next(const tlsf_heap_block_t *block)
+{
+    return (tlsf_heap_block_t *)((uint8_t *)block + BLOCK_HEADER + block_size(block));
+}
+
+/*******************************************************************************
+ * Function Name: block_from_ptr
+ *******************************************************************************
+ * Summary:
+ *  Returns the block of a pointer returned by tlsf_heap_alloc().
+ *
+ *******************************************************************************/
+static inline tlsf_heap_block_t *block_from_ptr(const void *ptr)
+{
+    return (tlsf_heap_block_t *)((uint8_t *)ptr - BLOCK_HEADER);
+}
+
+/*******************************************************************************
+ * Function Name: find_last_set
+ *******************************************************************************
+ * Summary:
+ *  Returns the index of the highest bit set in a non-zero word.
+ *
+ *******************************************************************************/
+static inline uint32_t find_last_set(uint32_t word)
+{
+    return 31u - (uint32_t)__builtin_clz(word);
+}
+
+/*******************************************************************************
+ * Function Name: mapping
+ *******************************************************************************
+ * Summary:
+ *  Returns the first and second-level classes of a block size.
+ *
+ * Parameters:
+ *  size_t size: Block size, a multiple of TLSF_HEAP_ALIGN below
+ *  2^TLSF_HEAP_MAX_LOG2
+ *  uint32_t *fl: Set to the first-level class
+ *  uint32_t *sl: Set to the second-level class
+ *
+ *******************************************************************************/
+static void mapping(size_t size, uint32_t *fl, uint32_t *sl)
+{
+    uint32_t msb;
+
+    if(size < SMALL_BLOCK_SIZE)
+    {
+        *fl = 0;
+        *sl = (uint32_t)(size >> TLSF_HEAP_ALIGN_LOG2);
+    }
+    else
+    {
+        msb = find_last_set((uint32_t)size);
+        *fl = msb - TLSF_HEAP_FL_SHIFT + 1u;
+        *sl = (uint32_t)(size >> (msb - TLSF_HEAP_SL_LOG2)) - TLSF_HEAP_SL_COUNT;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: insert_free
+ *******************************************************************************
+ * Summary:
+ *  Marks a block free and puts it at the head of the list of its class.
+ *
+ *******************************************************************************/
+static void insert_free(tlsf_heap_t *heap, tlsf_heap_block_t *block)
+{
+    uint32_t fl;
+    uint32_t sl;
+
+    mapping(block_size(block), &fl, &sl);
+
+    block->size |= BLOCK_FREE;
+    block->prev_free = NULL;
+    block->next_free = heap->free_lists[fl][sl];
+    if(block->next_free != NULL)
+    {
+        block->next_free->prev_free = block;
+    }
+    heap->free_lists[fl][sl] = block;
+    heap->fl_bitmap |= (1u << fl);
+    heap->sl_bitmap[fl] |= (1u << sl);
+
+    heap->free_blocks++;
+    heap->free_bytes += (uint32_t)block_size(block);
+}
+
+/*******************************************************************************
+ * Function Name: remove_free
+ *******************************************************************************
+ * Summary:
+ *  Takes a free block out of the list of its class and marks it in use.
+ *
+ *******************************************************************************/
+static void remove_free(tlsf_heap_t *heap, tlsf_heap_block_t *block)
+{
+    uint32_t fl;
+    uint32_t sl;
+
+    mapping(block_size(block), &fl, &sl);
+
+    if(block->next_free != NULL)
+    {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if(block->prev_free != NULL)
+    {
+        block->prev_free->next_free = block->next_free;
+    }
+    else
+    {
+        heap->free_lists[fl][sl] = block->next_free;
+        if(block->next_free == NULL)
+        {
+            heap->sl_bitmap[fl] &= ~(1u << sl);
+            if(heap->sl_bitmap[fl] == 0)
+            {
+                heap->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+    block->size &= ~BLOCK_FREE;
+
+    heap->free_blocks--;
+    heap->free_bytes -= (uint32_t)block_size(block);
+}
+
+/*******************************************************************************
+ * Function Name: find_free
+ *******************************************************************************
+ * Summary:
+ *  Returns a free block of at least the given size, without searching a
+ *  list: the size is rounded up to the next class boundary, and the head of
+ *  the first non-empty list at or above that class is taken.
+ *
+ * Parameters:
+ *  const tlsf_heap_t *heap: Heap
+ *  size_t size: Block size, a multiple of TLSF_HEAP_ALIGN
+ *
+ * Return:
+ *  tlsf_heap_block_t *: Block, still in its free list, or NULL
+ *
+ *******************************************************************************/
+static tlsf_heap_block_t *find_free(const tlsf_heap_t *heap, size_t size)
+{
+    uint32_t fl;
+    uint32_t sl;
+    uint32_t sl_map;
+    uint32_t fl_map;
+
+    if(size >= SMALL_BLOCK_SIZE)
+    {
+        size += ((size_t)1u << (find_last_set((uint32_t)size) - TLSF_HEAP_SL_LOG2)) - 1u;
+        if(size > BLOCK_SIZE_MAX)
+        {
+            return NULL;
+        }
+    }
+    mapping(size, &fl, &sl);
+
+    sl_map = heap->sl_bitmap[fl] & (~0u << sl);
+    if(sl_map == 0)
+    {
+        fl_map = (fl + 1u < 32u) ? (heap->fl_bitmap & (~0u << (fl + 1u))) : 0;
+        if(fl_map == 0)
+        {
+            return NULL;
+        }
+        fl = (uint32_t)__builtin_ctz(fl_map);
+        sl_map = heap->sl_bitmap[fl];
+    }
+    sl = (uint32_t)__builtin_ctz(sl_map);
+
+    return heap->free_lists[fl][sl];
+}
+
+/*******************************************************************************
+ * Function Name: absorb_next
+ *******************************************************************************
+ * Summary:
+ *  Merges the block following a block, already out of its free list, into
+ *  the block. The block keeps its free list state.
+ *
+ *******************************************************************************/
+static void absorb_next(tlsf_heap_block_t *block)
+{
+    tlsf_heap_block_t *next = block_next(block);
+
+    block->size += BLOCK_HEADER + block_size(next);
+    block_next(block)->prev_phys = block;
+}
+
+/*******************************************************************************
+ * Function Name: split
+ *******************************************************************************
+ * Summary:
+ *  Cuts a block out of any free list down to the given size, freeing the
+ *  tail if it can hold a block. The block following the tail is in use.
+ *
+ *******************************************************************************/
+static void split(tlsf_heap_t *heap, tlsf_heap_block_t *block, size_t size)
+{
+    tlsf_heap_block_t *tail;
+    size_t current = block_size(block);
+
+    if(current < (size + BLOCK_HEADER + BLOCK_SIZE_MIN))
+    {
+        return;
+    }
+
+    tail = (tlsf_heap_block_t *)((uint8_t *)block + BLOCK_HEADER + size);
+    tail->prev_phys = block;
+    tail->size = current - size - BLOCK_HEADER;
+    block_next(tail)->prev_phys = tail;
+    block->size = size;
+
+    insert_free(heap, tail);
+}
+
+/* [] END OF FILE */
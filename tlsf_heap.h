@@ -0,0 +1,115 @@
+/******************************************************************************
+* File Name:   tlsf_heap.h
+*
+* Description: This file contains declaration of the TLSF (two-level
+* segregated fit) heap. The free blocks are kept in lists by size class: a
+* first level of powers of two, each split linearly in TLSF_HEAP_SL_COUNT
+* second-level classes, with a bitmap of the non-empty lists at each level.
+* An allocation finds a list of blocks large enough with two bit scans, and
+* a free merges the block with its free neighbours in memory, so both take a
+* bounded time whatever the state of the heap. Each heap counts its free
+* blocks and bytes as they change, for the fragmentation statistics.
+*
+* The functions are not thread safe: the caller serializes them, e.g. with a
+* critical section, which the bounded time keeps short.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TLSF_HEAP_H_
+#define TLSF_HEAP_H_
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Alignment of the blocks, and size of the block header: two pointers. It is
+ * at least that of malloc() on the 32-bit target and on a 64-bit host.
+ */
+#if(__SIZEOF_POINTER__ == 8)
+#define TLSF_HEAP_ALIGN_LOG2                      (4u)
+#else
+#define TLSF_HEAP_ALIGN_LOG2                      (3u)
+#endif /* __SIZEOF_POINTER__ */
+#define TLSF_HEAP_ALIGN                           (1u << TLSF_HEAP_ALIGN_LOG2)
+
+/* Number of second-level classes of each power of two, as a power of two. */
+#define TLSF_HEAP_SL_LOG2                         (4u)
+#define TLSF_HEAP_SL_COUNT                        (1u << TLSF_HEAP_SL_LOG2)
+
+/* Blocks are smaller than 2^TLSF_HEAP_MAX_LOG2 bytes; a larger heap is cut
+ * down to that size.
+ */
+#ifndef TLSF_HEAP_MAX_LOG2
+#define TLSF_HEAP_MAX_LOG2                        (24u)
+#endif
+
+/* Blocks below 2^TLSF_HEAP_FL_SHIFT bytes all fall in the first of the
+ * first-level classes, split in steps of TLSF_HEAP_ALIGN.
+ */
+#define TLSF_HEAP_FL_SHIFT                        (TLSF_HEAP_SL_LOG2 + TLSF_HEAP_ALIGN_LOG2)
+#define TLSF_HEAP_FL_COUNT                        (TLSF_HEAP_MAX_LOG2 - TLSF_HEAP_FL_SHIFT + 1u)
+
+/* Smallest memory a heap can be set up over: the first block and the end
+ * marker.
+ */
+#define TLSF_HEAP_MIN_SIZE                        (4u * TLSF_HEAP_ALIGN)
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+struct tlsf_heap_block;
+
+/* TLSF heap. */
+typedef struct
+{
+    uint8_t *start;
+    uint8_t *end;
+    uint32_t size;                      /* Bytes usable by the blocks, headers included. */
+    uint32_t fl_bitmap;                 /* Non-empty first-level classes. */
+    uint32_t sl_bitmap[TLSF_HEAP_FL_COUNT];
+    struct tlsf_heap_block *free_lists[TLSF_HEAP_FL_COUNT][TLSF_HEAP_SL_COUNT];
+    uint32_t used_bytes;                /* Block sizes, headers excluded. */
+    uint32_t used_blocks;
+    uint32_t peak_bytes;
+    uint32_t free_bytes;
+    uint32_t free_blocks;
+    uint32_t failures;
+} tlsf_heap_t;
+
+/* Statistics of a heap. The free memory is fragmented to the extent the
+ * largest free block is smaller than the free bytes.
+ */
+typedef struct
+{
+    uint32_t size;
+    uint32_t used_bytes;
+    uint32_t used_blocks;
+    uint32_t peak_bytes;
+    uint32_t free_bytes;
+    uint32_t free_blocks;
+    uint32_t largest_free;
+    uint32_t failures;
+} tlsf_heap_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool tlsf_heap_init(tlsf_heap_t *heap, void *mem, size_t size);
+void *tlsf_heap_alloc(tlsf_heap_t *heap, size_t size);
+void tlsf_heap_free(tlsf_heap_t *heap, void *ptr);
+bool tlsf_heap_resize(tlsf_heap_t *heap, void *ptr, size_t size);
+bool tlsf_heap_owns(const tlsf_heap_t *heap, const void *ptr);
+size_t tlsf_heap_block_size(const void *ptr);
+void tlsf_heap_get_stats(const tlsf_heap_t *heap, tlsf_heap_stats_t *stats);
+bool tlsf_heap_check(const tlsf_heap_t *heap);
+
+#endif /* TLSF_HEAP_H_ */
@@ -0,0 +1,543 @@
+/******************************************************************************
+* File Name:   trace.c
+*
+* Description: This file contains the trace recorder. Records are written
+* into a lock-free multi-producer ring from tasks, interrupt handlers and the
+* scheduler: a writer claims a slot by advancing the head with a
+* compare-and-swap and publishes it by storing its sequence number, so a
+* record costs no critical section. The trace task is the only reader; it
+* drains the ring every TRACE_POLL_MS and sends the records to the connected
+* trace client. Nothing is recorded while no client is connected.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+/* Header file includes */
+#include "cy_retarget_io.h"
+
+/* FreeRTOS header files */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/* Standard C header files */
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Trace recorder header file. */
+#include "trace.h"
+
+/* Timestamp header file. */
+#include "timestamp.h"
+
+/* Deferred logging header file. */
+#include "app_log.h"
+
+/* Static allocation header file. */
+#include "static_alloc.h"
+
+#if(TRACE_ENABLED)
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define TRACE_LISTEN_BACKLOG                      (1u)
+#define TRACE_SEND_TIMEOUT_MS                     (1000u)
+
+/* Records sent at once. */
+#define TRACE_SEND_RECORDS                        (128u)
+
+/* Tasks named in the stream header. */
+#define TRACE_MAX_TASKS                           (16u)
+
+#define TRACE_HEADER_SIZE                         (12u)
+
+#if((TRACE_RING_RECORDS & (TRACE_RING_RECORDS - 1u)) != 0)
+#error "TRACE_RING_RECORDS must be a power of two"
+#endif
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Ring slot. 'seq' is the index of the record plus one once it is written. */
+typedef struct
+{
+    uint32_t seq;
+    trace_record_t record;
+} trace_slot_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static cy_rslt_t trace_connection_handler(cy_socket_t socket_handle, void *arg);
+static void trace_task(void *arg);
+static void stream_to_client(cy_socket_t handle);
+static uint32_t build_header(uint8_t *buf, uint32_t size);
+static uint32_t drain_ring(trace_record_t *records, uint32_t max_records);
+static cy_rslt_t send_all(cy_socket_t handle, const void *data, uint32_t len);
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+static trace_slot_t ring[TRACE_RING_RECORDS];
+static uint32_t ring_head;                  /* Next index to claim. */
+static uint32_t ring_tail;                  /* Next index to read. */
+static uint32_t dropped;
+
+/* Set while a client is connected. */
+static bool streaming;
+
+static cy_socket_t trace_handle;
+static QueueHandle_t accept_queue;
+STATIC_ALLOC_QUEUE_DEFINE(accept_queue, 1, sizeof(cy_socket_t));
+STATIC_ALLOC_TASK_DEFINE(trace_task, TRACE_TASK_STACK_SIZE);
+
+/* Only used by the trace task. */
+static trace_record_t send_records[TRACE_SEND_RECORDS];
+static TaskStatus_t task_status[TRACE_MAX_TASKS];
+static uint8_t header_buf[TRACE_HEADER_SIZE + TRACE_MAX_TASKS * (2u + configMAX_TASK_NAME_LEN)];
+
+/*******************************************************************************
+ * Function Name: trace_start
+ *******************************************************************************
+ * Summary:
+ *  Creates the trace task and starts listening for a trace client on
+ *  TRACE_PORT of the server address.
+ *
+ * Parameters:
+ *  const cy_socket_sockaddr_t *server_addr: Address of the TCP server
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+cy_rslt_t trace_start(const cy_socket_sockaddr_t *server_addr)
+{
+    cy_rslt_t result;
+    cy_socket_sockaddr_t trace_addr = *server_addr;
+    cy_socket_opt_callback_t connection_option;
+
+    accept_queue = STATIC_ALLOC_QUEUE_CREATE(accept_queue, 1, sizeof(cy_socket_t));
+    TRACE_QUEUE_NUMBER(accept_queue, TRACE_QUEUE_TRACE_ACCEPT);
+    if((accept_queue == NULL) ||
+       (STATIC_ALLOC_TASK_CREATE(trace_task, trace_task, "Trace", TRACE_TASK_STACK_SIZE, NULL,
+                                 TRACE_TASK_PRIORITY, NULL) != pdPASS))
+    {
+        printf("Failed to create the trace task\n");
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    result = cy_socket_create(CY_SOCKET_DOMAIN_AF_INET, CY_SOCKET_TYPE_STREAM,
+                              CY_SOCKET_IPPROTO_TCP, &trace_handle);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to create the trace socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    connection_option.callback = trace_connection_handler;
+    connection_option.arg = NULL;
+
+    result = cy_socket_setsockopt(trace_handle, CY_SOCKET_SOL_SOCKET,
+                                  CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK,
+                                  &connection_option, sizeof(cy_socket_opt_callback_t));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Set socket option: CY_SOCKET_SO_CONNECT_REQUEST_CALLBACK failed\n");
+        return result;
+    }
+
+    trace_addr.port = TRACE_PORT;
+    result = cy_socket_bind(trace_handle, &trace_addr, sizeof(trace_addr));
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to bind the trace socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    result = cy_socket_listen(trace_handle, TRACE_LISTEN_BACKLOG);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        printf("Failed to listen on the trace socket! Error code: 0x%08"PRIx32"\n", (uint32_t)result);
+        return result;
+    }
+
+    printf("Streaming the trace on Port: %d\n", TRACE_PORT);
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: trace_record
+ *******************************************************************************
+ * Summary:
+ *  Writes a record for the running task, if a trace client is connected.
+ *  Safe in interrupt context and in the scheduler.
+ *
+ * Parameters:
+ *  trace_event_t type: Record type
+ *  uint16_t arg: Argument of the record
+ *
+ *******************************************************************************/
+void trace_record(trace_event_t type, uint16_t arg)
+{
+    uint32_t timestamp;
+    uint32_t head;
+    trace_slot_t *slot;
+
+    if(!__atomic_load_n(&streaming, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    timestamp = timestamp_now();
+
+    head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    do
+    {
+        if((head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE)) >= TRACE_RING_RECORDS)
+        {
+            (void)__atomic_fetch_add(&dropped, 1u, __ATOMIC_RELAXED);
+            return;
+        }
+    } while(!__atomic_compare_exchange_n(&ring_head, &head, head + 1u, true,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    slot = &ring[head & (TRACE_RING_RECORDS - 1u)];
+    slot->record.timestamp = timestamp;
+    slot->record.type = (uint8_t)type;
+    slot->record.task = (uint8_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+    slot->record.arg = arg;
+    __atomic_store_n(&slot->seq, head + 1u, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * Function Name: trace_task_switched_in
+ *******************************************************************************
+ * Summary:
+ *  Records a context switch. Called by traceTASK_SWITCHED_IN().
+ *
+ *******************************************************************************/
+void trace_task_switched_in(void)
+{
+    trace_record(TRACE_EVENT_TASK_SWITCH, 0);
+}
+
+/*******************************************************************************
+ * Function Name: trace_notify
+ *******************************************************************************
+ * Summary:
+ *  Records a task notification. Called by the traceTASK_NOTIFY() hooks.
+ *
+ * Parameters:
+ *  uint32_t task_number: Number of the task notified
+ *
+ *******************************************************************************/
+void trace_notify(uint32_t task_number)
+{
+    trace_record(TRACE_EVENT_NOTIFY, (uint16_t)task_number);
+}
+
+/*******************************************************************************
+ * Function Name: trace_notify_take
+ *******************************************************************************
+ * Summary:
+ *  Records the running task taking its notification. Called by
+ *  traceTASK_NOTIFY_TAKE().
+ *
+ *******************************************************************************/
+void trace_notify_take(void)
+{
+    trace_record(TRACE_EVENT_NOTIFY_TAKE, 0);
+}
+
+/*******************************************************************************
+ * Function Name: trace_queue_send
+ *******************************************************************************
+ * Summary:
+ *  Records a send to a queue or a semaphore give. Called by the
+ *  traceQUEUE_SEND() hooks.
+ *
+ *******************************************************************************/
+void trace_queue_send(uint32_t queue_number)
+{
+    trace_record(TRACE_EVENT_QUEUE_SEND, (uint16_t)queue_number);
+}
+
+/*******************************************************************************
+ * Function Name: trace_queue_receive
+ *******************************************************************************
+ * Summary:
+ *  Records a receive from a queue or a semaphore take. Called by
+ *  traceQUEUE_RECEIVE().
+ *
+ *******************************************************************************/
+void trace_queue_receive(uint32_t queue_number)
+{
+    trace_record(TRACE_EVENT_QUEUE_RECEIVE, (uint16_t)queue_number);
+}
+
+/*******************************************************************************
+ * Function Name: trace_queue_registered
+ *******************************************************************************
+ * Summary:
+ *  Numbers the timer command queue, which the application has no handle of,
+ *  when the kernel adds it to the queue registry. Called by
+ *  traceQUEUE_REGISTRY_ADD().
+ *
+ * Parameters:
+ *  void *queue: Queue registered
+ *  const char *name: Name it is registered with
+ *
+ *******************************************************************************/
+void trace_queue_registered(void *queue, const char *name)
+{
+    if((name != NULL) && (strcmp(name, "TmrQ") == 0))
+    {
+        TRACE_QUEUE_NUMBER((QueueHandle_t)queue, TRACE_QUEUE_TIMER);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: trace_connection_handler
+ *******************************************************************************
+ * Summary:
+ *  Accepts a trace client and hands it to the trace task. Only one client is
+ *  streamed to at a time; others are closed at once.
+ *
+ *******************************************************************************/
+static cy_rslt_t trace_connection_handler(cy_socket_t socket_handle, void *arg)
+{
+    cy_rslt_t result;
+    cy_socket_t client_handle;
+    cy_socket_sockaddr_t peer_addr;
+    uint32_t peer_addr_len = sizeof(peer_addr);
+
+    result = cy_socket_accept(socket_handle, &peer_addr, &peer_addr_len, &client_handle);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        APP_LOG_ERROR("Failed to accept a trace client. Error code: 0x%08"PRIxPTR, (uint32_t)result);
+        return result;
+    }
+
+    if(__atomic_load_n(&streaming, __ATOMIC_RELAXED) ||
+       (xQueueSend(accept_queue, &client_handle, 0) != pdPASS))
+    {
+        APP_LOG_WARNING("Rejected a trace client: the trace is already streamed");
+        cy_socket_disconnect(client_handle, 0);
+        cy_socket_delete(client_handle);
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: trace_task
+ *******************************************************************************
+ * Summary:
+ *  Streams the trace to the accepted clients, one at a time.
+ *
+ * Parameters:
+ *  void *args : Task parameter defined during task creation (unused)
+ *
+ *******************************************************************************/
+static void trace_task(void *arg)
+{
+    cy_socket_t client_handle;
+
+    while(true)
+    {
+        if(xQueueReceive(accept_queue, &client_handle, portMAX_DELAY) == pdPASS)
+        {
+            APP_LOG_INFO("Trace client connected");
+            stream_to_client(client_handle);
+            cy_socket_disconnect(client_handle, 0);
+            cy_socket_delete(client_handle);
+            APP_LOG_INFO("Trace client disconnected");
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: stream_to_client
+ *******************************************************************************
+ * Summary:
+ *  Sends the stream header, then records the trace and sends the records
+ *  until sending fails, i.e. the client disconnected.
+ *
+ * Parameters:
+ *  cy_socket_t handle: Accepted socket of the trace client
+ *
+ *******************************************************************************/
+static void stream_to_client(cy_socket_t handle)
+{
+    uint32_t send_timeout = TRACE_SEND_TIMEOUT_MS;
+    uint32_t count;
+    uint32_t lost;
+    cy_rslt_t result;
+
+    cy_socket_setsockopt(handle, CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_SNDTIMEO,
+                         &send_timeout, sizeof(send_timeout));
+
+    result = send_all(handle, header_buf, build_header(header_buf, sizeof(header_buf)));
+
+    /* Start with an empty ring. */
+    __atomic_store_n(&ring_tail, __atomic_load_n(&ring_head, __ATOMIC_RELAXED), __ATOMIC_RELEASE);
+    __atomic_store_n(&dropped, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&streaming, true, __ATOMIC_RELEASE);
+
+    while(result == CY_RSLT_SUCCESS)
+    {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_POLL_MS));
+
+        /* Regular records let the client extend the 32-bit timestamps. */
+        trace_record(TRACE_EVENT_SYNC, 0);
+
+        do
+        {
+            count = drain_ring(send_records, TRACE_SEND_RECORDS - 1u);
+
+            lost = __atomic_exchange_n(&dropped, 0u, __ATOMIC_RELAXED);
+            if(lost > 0)
+            {
+                send_records[count].timestamp = timestamp_now();
+                send_records[count].type = TRACE_EVENT_DROPPED;
+                send_records[count].task = 0;
+                send_records[count].arg = (lost > UINT16_MAX) ? UINT16_MAX : (uint16_t)lost;
+                count++;
+            }
+
+            if(count > 0)
+            {
+                result = send_all(handle, send_records, count * sizeof(trace_record_t));
+            }
+        } while((result == CY_RSLT_SUCCESS) && (count == TRACE_SEND_RECORDS - 1u));
+    }
+
+    __atomic_store_n(&streaming, false, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * Function Name: build_header
+ *******************************************************************************
+ * Summary:
+ *  Writes the stream header, naming the tasks. The tasks are numbered with
+ *  vTaskSetTaskNumber() so that the records can refer to them.
+ *
+ * Parameters:
+ *  uint8_t *buf: Header buffer
+ *  uint32_t size: Size of the header buffer
+ *
+ * Return:
+ *  uint32_t: Length of the header
+ *
+ *******************************************************************************/
+static uint32_t build_header(uint8_t *buf, uint32_t size)
+{
+    uint32_t task_count = uxTaskGetSystemState(task_status, TRACE_MAX_TASKS, NULL);
+    uint32_t len = TRACE_HEADER_SIZE;
+    uint32_t hz = TIMESTAMP_HZ;
+    uint32_t name_len;
+
+    memcpy(buf, "FRTR", 4);
+    buf[4] = (uint8_t)TRACE_STREAM_VERSION;
+    buf[5] = 0;
+    buf[6] = (uint8_t)task_count;
+    buf[7] = 0;
+    buf[8] = (uint8_t)hz;
+    buf[9] = (uint8_t)(hz >> 8);
+    buf[10] = (uint8_t)(hz >> 16);
+    buf[11] = (uint8_t)(hz >> 24);
+
+    for(uint32_t i = 0; i < task_count; i++)
+    {
+        vTaskSetTaskNumber(task_status[i].xHandle, task_status[i].xTaskNumber);
+
+        name_len = strnlen(task_status[i].pcTaskName, configMAX_TASK_NAME_LEN);
+        if((len + 2u + name_len) > size)
+        {
+            break;
+        }
+        buf[len++] = (uint8_t)task_status[i].xTaskNumber;
+        buf[len++] = (uint8_t)name_len;
+        memcpy(&buf[len], task_status[i].pcTaskName, name_len);
+        len += name_len;
+    }
+
+    return len;
+}
+
+/*******************************************************************************
+ * Function Name: drain_ring
+ *******************************************************************************
+ * Summary:
+ *  Reads the published records from the ring, in order. Stops at a slot that
+ *  is claimed but not written yet.
+ *
+ * Parameters:
+ *  trace_record_t *records: Set to the records read
+ *  uint32_t max_records: Maximum number of records to read
+ *
+ * Return:
+ *  uint32_t: Number of records read
+ *
+ *******************************************************************************/
+static uint32_t drain_ring(trace_record_t *records, uint32_t max_records)
+{
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    uint32_t count = 0;
+    trace_slot_t *slot;
+
+    while(count < max_records)
+    {
+        slot = &ring[tail & (TRACE_RING_RECORDS - 1u)];
+        if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != (tail + 1u))
+        {
+            break;
+        }
+        records[count++] = slot->record;
+        tail++;
+    }
+
+    __atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: send_all
+ *******************************************************************************
+ * Summary:
+ *  Sends a buffer completely.
+ *
+ * Return:
+ *  cy_result result: Result of the operation
+ *
+ *******************************************************************************/
+static cy_rslt_t send_all(cy_socket_t handle, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t bytes_sent;
+
+    while((result == CY_RSLT_SUCCESS) && (len > 0))
+    {
+        bytes_sent = 0;
+        result = cy_socket_send(handle, bytes, len, CY_SOCKET_FLAGS_NONE, &bytes_sent);
+        if((result == CY_RSLT_SUCCESS) && (bytes_sent == 0))
+        {
+            result = CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT;
+        }
+        bytes += bytes_sent;
+        len -= bytes_sent;
+    }
+
+    return result;
+}
+#endif /* TRACE_ENABLED */
+
+/* [] END OF FILE */
@@ -0,0 +1,179 @@
+/******************************************************************************
+* File Name:   trace.h
+*
+* Description: This file contains declaration of the trace recorder. The
+* FreeRTOS trace hooks and the application write compact time stamped
+* records into a RAM ring, which the trace task streams to a TCP client on
+* TRACE_PORT while one is connected. trace_to_perfetto.py turns the stream
+* into a Chrome/Perfetto timeline.
+*
+* Stream format, little-endian: a header
+*   char magic[4] = "FRTR", uint16_t version, uint16_t task_count,
+*   uint32_t timestamp_hz
+* followed by task_count task names
+*   uint8_t number, uint8_t name_len, char name[name_len]
+* followed by trace_record_t records until the client disconnects.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* $ Copyright 2021-2023 Cypress Semiconductor $
+*******************************************************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* Standard C header file */
+#include <stdint.h>
+
+/* Cypress secure socket header file */
+#include "cy_secure_sockets.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Set to 1, e.g. with 'make DEFINES=TRACE_ENABLED=1', to build the trace
+ * recorder and the FreeRTOS trace hooks.
+ */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED                             (0)
+#endif
+
+/* Port the trace is streamed on. */
+#ifndef TRACE_PORT
+#define TRACE_PORT                                (50081)
+#endif
+
+/* Records buffered between two sends of the trace task. Must be a power of
+ * two; records beyond it are dropped and counted.
+ */
+#ifndef TRACE_RING_RECORDS
+#define TRACE_RING_RECORDS                        (1024u)
+#endif
+
+/* Period at which the trace task drains the ring. */
+#define TRACE_POLL_MS                             (10u)
+
+#define TRACE_TASK_STACK_SIZE                     (1024 * 2)
+#define TRACE_TASK_PRIORITY                       (1)
+
+#define TRACE_STREAM_VERSION                      (1u)
+
+#if(TRACE_ENABLED)
+#define TRACE_EVENT(type, arg)                    trace_record((type), (uint16_t)(arg))
+
+/* Numbers a queue, semaphore or mutex for its records, see trace_queue_t. */
+#define TRACE_QUEUE_NUMBER(queue, number)                                           \
+    do                                                                              \
+    {                                                                               \
+        if((queue) != NULL)                                                         \
+        {                                                                           \
+            vQueueSetQueueNumber((queue), (number));                                \
+        }                                                                           \
+    } while(0)
+
+/* Records a span from here to the end of the enclosing block, whichever way
+ * the block is left.
+ */
+#define TRACE_SPAN_SCOPE(span)                    trace_span_t trace_span_scope_                 \
+                                                  __attribute__((cleanup(trace_span_exit))) =    \
+                                                  trace_span_enter(span)
+#else
+#define TRACE_EVENT(type, arg)                    ((void)0)
+#define TRACE_QUEUE_NUMBER(queue, number)         ((void)0)
+#define TRACE_SPAN_SCOPE(span)                    ((void)0)
+#endif /* TRACE_ENABLED */
+
+#define TRACE_SPAN_BEGIN(span)                    TRACE_EVENT(TRACE_EVENT_SPAN_BEGIN, (span))
+#define TRACE_SPAN_END(span)                      TRACE_EVENT(TRACE_EVENT_SPAN_END, (span))
+#define TRACE_ISR_ENTER(isr)                      TRACE_EVENT(TRACE_EVENT_ISR_ENTER, (isr))
+#define TRACE_ISR_EXIT(isr)                       TRACE_EVENT(TRACE_EVENT_ISR_EXIT, (isr))
+
+/*******************************************************************************
+* Data Structures
+********************************************************************************/
+/* Record types. The task of a record is the task running when it was
+ * written, or interrupted by the ISR that wrote it.
+ */
+typedef enum
+{
+    TRACE_EVENT_SYNC = 0,           /* Written by the trace task every poll. */
+    TRACE_EVENT_TASK_SWITCH,        /* The task was switched in. */
+    TRACE_EVENT_ISR_ENTER,          /* arg: trace_isr_t */
+    TRACE_EVENT_ISR_EXIT,           /* arg: trace_isr_t */
+    TRACE_EVENT_QUEUE_SEND,         /* arg: trace_queue_t */
+    TRACE_EVENT_QUEUE_RECEIVE,      /* arg: trace_queue_t */
+    TRACE_EVENT_NOTIFY,             /* arg: number of the task notified */
+    TRACE_EVENT_NOTIFY_TAKE,        /* The task took its notification. */
+    TRACE_EVENT_SPAN_BEGIN,         /* arg: trace_span_t */
+    TRACE_EVENT_SPAN_END,           /* arg: trace_span_t */
+    TRACE_EVENT_DROPPED             /* arg: records dropped on a full ring */
+} trace_event_t;
+
+/* Traced interrupt handlers. */
+typedef enum
+{
+    TRACE_ISR_BUTTON = 0
+} trace_isr_t;
+
+/* Traced stretches of application code. */
+typedef enum
+{
+    TRACE_SPAN_ACCEPT_CB = 0,       /* Connection callback */
+    TRACE_SPAN_RECV_CB,             /* Receive callback */
+    TRACE_SPAN_DISCONNECT_CB,       /* Disconnection callback */
+    TRACE_SPAN_BUTTON_PRESS,        /* LED command fan-out by the TCP server task */
+    TRACE_SPAN_SEND                 /* cy_socket_send() of the TCP writer */
+} trace_span_t;
+
+/* Traced queues, semaphores and mutexes, numbered when they are created;
+ * the timer command queue when the kernel registers it.
+ */
+typedef enum
+{
+    TRACE_QUEUE_OTHER = 0,          /* Queues of the libraries */
+    TRACE_QUEUE_TIMER,              /* Timer command queue */
+    TRACE_QUEUE_CONN_TABLE,         /* Connection table mutex */
+    TRACE_QUEUE_TASK_STATS,         /* Task statistics snapshot mutex */
+    TRACE_QUEUE_METRICS_ACCEPT,     /* Metrics clients accepted */
+    TRACE_QUEUE_TRACE_ACCEPT        /* Trace clients accepted */
+} trace_queue_t;
+
+/* Record, as streamed. */
+typedef struct
+{
+    uint32_t timestamp;             /* timestamp_now() */
+    uint8_t type;                   /* trace_event_t */
+    uint8_t task;                   /* Task number */
+    uint16_t arg;
+} trace_record_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t trace_start(const cy_socket_sockaddr_t *server_addr);
+void trace_record(trace_event_t type, uint16_t arg);
+
+/* Called by the FreeRTOS trace hooks, see FreeRTOSConfig.h. */
+void trace_task_switched_in(void);
+void trace_notify(uint32_t task_number);
+void trace_notify_take(void);
+void trace_queue_send(uint32_t queue_number);
+void trace_queue_receive(uint32_t queue_number);
+void trace_queue_registered(void *queue, const char *name);
+
+#if(TRACE_ENABLED)
+static inline trace_span_t trace_span_enter(trace_span_t span)
+{
+    trace_record(TRACE_EVENT_SPAN_BEGIN, (uint16_t)span);
+    return span;
+}
+
+static inline void trace_span_exit(const trace_span_t *span)
+{
+    trace_record(TRACE_EVENT_SPAN_END, (uint16_t)*span);
+}
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,184 @@
+#******************************************************************************
+# File Name:   trace_to_perfetto.py
+#
+# Description: Trace client for the TCP server. Connects to the trace port,
+# records the streamed trace for a while and writes it as a Chrome trace
+# event JSON file, which chrome://tracing and ui.perfetto.dev open as a
+# timeline: one track per task with its spans, queue and notification
+# events, a CPU track with the task switches, and an ISR track.
+#
+#******************************************************************************
+# $ Copyright 2021-2023 Cypress Semiconductor $
+#******************************************************************************
+
+#!/usr/bin/env python3
+import json
+import optparse
+import socket
+import struct
+import sys
+import time
+
+from tcp_client import DEFAULT_IP
+
+DEFAULT_TRACE_PORT = 50081
+BUFFER_SIZE        = 4096
+
+HEADER = struct.Struct('<4sHHI')
+RECORD = struct.Struct('<IBBH')
+
+(EV_SYNC, EV_TASK_SWITCH, EV_ISR_ENTER, EV_ISR_EXIT, EV_QUEUE_SEND, EV_QUEUE_RECEIVE,
+ EV_NOTIFY, EV_NOTIFY_TAKE, EV_SPAN_BEGIN, EV_SPAN_END, EV_DROPPED) = range(11)
+
+ISR_NAMES  = ['button']
+SPAN_NAMES = ['accept callback', 'receive callback', 'disconnect callback',
+              'button press', 'send']
+QUEUE_NAMES = ['other queue', 'timer command queue', 'connection table mutex',
+               'task statistics mutex', 'metrics accept queue', 'trace accept queue']
+
+# Process and thread ids of the timeline tracks.
+PID_TASKS = 1
+PID_CPU   = 2
+TID_CPU   = 0
+TID_ISR   = 1
+
+def read_exactly(s, length, buffer):
+    while len(buffer) < length:
+        data = s.recv(BUFFER_SIZE)
+        if not data:
+            raise ConnectionError("Connection closed by the TCP server")
+        buffer += data
+    return buffer[:length], buffer[length:]
+
+def read_header(s):
+    """Returns the timestamp rate, the task names by number and unread data."""
+    buffer = b''
+    header, buffer = read_exactly(s, HEADER.size, buffer)
+    magic, version, task_count, hz = HEADER.unpack(header)
+    if magic != b'FRTR' or version != 1:
+        raise ValueError("Not a trace stream")
+    tasks = {}
+    for _ in range(task_count):
+        entry, buffer = read_exactly(s, 2, buffer)
+        name, buffer = read_exactly(s, entry[1], buffer)
+        tasks[entry[0]] = name.decode('utf-8', 'replace')
+    return hz, tasks, buffer
+
+def record_trace(s, duration):
+    hz, tasks, buffer = read_header(s)
+    records = []
+    stop_at = time.monotonic() + duration
+    s.settimeout(0.5)
+    try:
+        while time.monotonic() < stop_at:
+            try:
+                data = s.recv(BUFFER_SIZE)
+            except socket.timeout:
+                continue
+            if not data:
+                break
+            buffer += data
+            usable = len(buffer) - len(buffer) % RECORD.size
+            records.extend(RECORD.iter_unpack(buffer[:usable]))
+            buffer = buffer[usable:]
+    except KeyboardInterrupt:
+        pass
+    return hz, tasks, records
+
+def to_chrome_trace(hz, tasks, records):
+    events = []
+    def meta(pid, tid, kind, name):
+        events.append({'ph': 'M', 'pid': pid, 'tid': tid, 'name': kind, 'args': {'name': name}})
+
+    meta(PID_TASKS, 0, 'process_name', 'Tasks')
+    meta(PID_CPU, 0, 'process_name', 'CPU')
+    meta(PID_CPU, TID_CPU, 'thread_name', 'Running task')
+    meta(PID_CPU, TID_ISR, 'thread_name', 'ISR')
+    for number, name in sorted(tasks.items()):
+        meta(PID_TASKS, number, 'thread_name', '%s (%d)' % (name, number))
+    if 0 not in tasks:
+        # Records written before the tasks were numbered, or outside any task.
+        meta(PID_TASKS, 0, 'thread_name', 'other (0)')
+
+    def task_name(number):
+        return tasks.get(number, 'task %d' % number)
+
+    # Timestamps are 32-bit and wrap; records are close enough in time to
+    # extend them from their differences.
+    base = None
+    last = 0
+    extended = 0
+    running = None
+    pending_notify = {}
+    flow_id = 0
+    dropped = 0
+
+    for timestamp, kind, task, arg in records:
+        if base is None:
+            base = last = timestamp
+        extended += (timestamp - last + 0x80000000) % 0x100000000 - 0x80000000
+        last = timestamp
+        ts = extended * 1e6 / hz
+
+        if kind == EV_TASK_SWITCH:
+            if running is not None:
+                events.append({'ph': 'X', 'pid': PID_CPU, 'tid': TID_CPU, 'name': task_name(running[0]),
+                               'ts': running[1], 'dur': ts - running[1]})
+            running = (task, ts)
+        elif kind in (EV_ISR_ENTER, EV_ISR_EXIT):
+            name = ISR_NAMES[arg] if arg < len(ISR_NAMES) else 'isr %d' % arg
+            events.append({'ph': 'B' if kind == EV_ISR_ENTER else 'E', 'pid': PID_CPU, 'tid': TID_ISR,
+                           'name': name, 'ts': ts, 'args': {'interrupted': task_name(task)}})
+        elif kind in (EV_SPAN_BEGIN, EV_SPAN_END):
+            name = SPAN_NAMES[arg] if arg < len(SPAN_NAMES) else 'span %d' % arg
+            events.append({'ph': 'B' if kind == EV_SPAN_BEGIN else 'E', 'pid': PID_TASKS, 'tid': task,
+                           'name': name, 'ts': ts})
+        elif kind in (EV_QUEUE_SEND, EV_QUEUE_RECEIVE):
+            name = QUEUE_NAMES[arg] if arg < len(QUEUE_NAMES) else 'queue %d' % arg
+            events.append({'ph': 'i', 's': 't', 'pid': PID_TASKS, 'tid': task, 'ts': ts,
+                           'name': ('send ' if kind == EV_QUEUE_SEND else 'receive ') + name})
+        elif kind == EV_NOTIFY:
+            # An arrow from the notification to the task taking it.
+            flow_id += 1
+            pending_notify[arg] = flow_id
+            events.append({'ph': 'i', 's': 't', 'pid': PID_TASKS, 'tid': task, 'ts': ts,
+                           'name': 'notify %s' % task_name(arg)})
+            events.append({'ph': 's', 'pid': PID_TASKS, 'tid': task, 'ts': ts, 'id': flow_id,
+                           'name': 'notify', 'cat': 'notify'})
+        elif kind == EV_NOTIFY_TAKE:
+            events.append({'ph': 'i', 's': 't', 'pid': PID_TASKS, 'tid': task, 'ts': ts,
+                           'name': 'notified'})
+            if task in pending_notify:
+                events.append({'ph': 'f', 'bp': 'e', 'pid': PID_TASKS, 'tid': task, 'ts': ts,
+                               'id': pending_notify.pop(task), 'name': 'notify', 'cat': 'notify'})
+        elif kind == EV_DROPPED:
+            dropped += arg
+            events.append({'ph': 'i', 's': 'g', 'pid': PID_CPU, 'tid': TID_CPU, 'ts': ts,
+                           'name': '%d records dropped' % arg})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ns'}, dropped
+
+parser = optparse.OptionParser(usage='%prog [options] OUTPUT.json')
+parser.add_option('-a', '--address', dest='ip', default=DEFAULT_IP,
+                  help='IP address of the TCP server [default: %default]')
+parser.add_option('-p', '--port', dest='port', type='int', default=DEFAULT_TRACE_PORT,
+                  help='trace port of the TCP server [default: %default]')
+parser.add_option('-d', '--duration', dest='duration', type='float', default=10,
+                  help='seconds to record, or until Ctrl-C [default: %default]')
+
+if __name__ == '__main__':
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error("the output file is missing")
+
+    s = socket.create_connection((options.ip, options.port))
+    hz, tasks, records = record_trace(s, options.duration)
+    s.close()
+
+    trace, dropped = to_chrome_trace(hz, tasks, records)
+    with open(args[0], 'w') as f:
+        json.dump(trace, f)
+    print("%d records, %d dropped by the server, written to %s" % (len(records), dropped, args[0]))
+    sys.exit(0)
+
+# [] END OF FILE